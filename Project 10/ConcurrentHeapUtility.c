@@ -0,0 +1,484 @@
+#include "ConcurrentHeapUtility.h"
+
+/*
+Name: addConcurrentItem
+Process: adds patient to concurrent heap, takes the next bit reversed leaf
+         under the heap lock, then bubbles up with parent then child node 
+         locks so other inserts and removes proceed on disjoint paths
+Function input/parameters: concurrent heap (ConcurrentHeapType *), 
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated concurrent heap (ConcurrentHeapType *)
+Function output/returned: Boolean result, false if heap is full (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_lock, pthread_mutex_unlock, getBitReversedIndex,
+              makeHeapKey, setPatientFromData, swapConcurrentNodes,
+              sched_yield
+*/
+bool addConcurrentItem( ConcurrentHeapType *heap, const char *nameSet,
+                                              int prioritySet, time_t timeSet )
+  {
+  // variables
+  ConcurrentNodeType *nodes = heap->nodes;
+  uint64_t myTag = atomic_fetch_add( &heap->nextTag, 1 );
+  int index, parentIndex, oldIndex, handle;
+  bool retryFlag = false;
+
+  // take a payload slot first, a free slot means a leaf is free as well
+  // since a remove gives its slot back only after giving up its leaf
+  pthread_mutex_lock( &heap->slotLock );
+
+  if( heap->freeCount == 0 )
+    {
+    pthread_mutex_unlock( &heap->slotLock );
+
+    return false;
+    }
+
+  heap->freeCount--;
+
+  handle = heap->freeSlots[ heap->freeCount ];
+
+  pthread_mutex_unlock( &heap->slotLock );
+
+  // slot is ours alone, fill it before taking any node lock
+  setPatientFromData( &heap->slots[ handle ], nameSet, prioritySet, timeSet );
+
+  // reserve a leaf, only the size counter is under the heap lock
+  pthread_mutex_lock( &heap->heapLock );
+
+  heap->size++;
+
+  index = getBitReversedIndex( heap->size );
+
+  pthread_mutex_lock( &nodes[ index ].lock );
+
+  pthread_mutex_unlock( &heap->heapLock );
+
+  // fill the leaf, the tag marks it as still moving up for this insert
+  nodes[ index ].key = makeHeapKey( prioritySet, 
+                                 atomic_fetch_add( &heap->nextSequence, 1 ) );
+  nodes[ index ].handle = handle;
+  nodes[ index ].tag = myTag;
+
+  pthread_mutex_unlock( &nodes[ index ].lock );
+
+  // bubble up, always lock parent before child
+  while( index > 1 )
+    {
+    parentIndex = index / 2;
+    oldIndex = index;
+
+    pthread_mutex_lock( &nodes[ parentIndex ].lock );
+    pthread_mutex_lock( &nodes[ index ].lock );
+
+    // parent settled and the entry is still ours
+    if( nodes[ parentIndex ].tag == TAG_AVAILABLE 
+                                             && nodes[ index ].tag == myTag )
+      {
+      if( nodes[ index ].key > nodes[ parentIndex ].key )
+        {
+        swapConcurrentNodes( &nodes[ index ], &nodes[ parentIndex ] );
+
+        index = parentIndex;
+        }
+
+      else
+        {
+        nodes[ index ].tag = TAG_AVAILABLE;
+
+        index = 0;
+        }
+      }
+
+    // a remove took the parent's leaf, our entry went to the root settled
+    else if( nodes[ parentIndex ].tag == TAG_EMPTY )
+      {
+      index = 0;
+      }
+
+    // a remove moved our entry up past this node, follow it
+    else if( nodes[ index ].tag != myTag )
+      {
+      index = parentIndex;
+      }
+
+    // otherwise another insert owns the parent, try again
+    else
+      {
+      retryFlag = true;
+      }
+
+    pthread_mutex_unlock( &nodes[ oldIndex ].lock );
+    pthread_mutex_unlock( &nodes[ parentIndex ].lock );
+
+    // give the owning insert the processor, without this an oversubscribed
+    // host can spend whole time slices retrying a parent that cannot move
+    if( retryFlag )
+      {
+      sched_yield();
+
+      retryFlag = false;
+      }
+    }
+
+  // reached the root, settle it if it is still ours
+  if( index == 1 )
+    {
+    pthread_mutex_lock( &nodes[ 1 ].lock );
+
+    if( nodes[ 1 ].tag == myTag )
+      {
+      nodes[ 1 ].tag = TAG_AVAILABLE;
+      }
+
+    pthread_mutex_unlock( &nodes[ 1 ].lock );
+    }
+
+  return true;
+  }
+
+/*
+Name: clearConcurrentHeap
+Process: destroys all locks and frees node and slot arrays,
+         must not be called while other threads use the heap
+Function input/parameters: concurrent heap (ConcurrentHeapType *)
+Function output/parameters: updated concurrent heap (ConcurrentHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_destroy, free
+*/
+void clearConcurrentHeap( ConcurrentHeapType *heap )
+  {
+  // variables
+  int index;
+
+  for( index = 0; index <= heap->lastNode; index++ )
+    {
+    pthread_mutex_destroy( &heap->nodes[ index ].lock );
+    }
+
+  pthread_mutex_destroy( &heap->heapLock );
+  pthread_mutex_destroy( &heap->slotLock );
+
+  free( heap->nodes );
+  free( heap->slots );
+  free( heap->freeSlots );
+
+  heap->nodes = NULL;
+  heap->slots = NULL;
+  heap->freeSlots = NULL;
+
+  heap->size = 0;
+  heap->capacity = 0;
+  heap->lastNode = 0;
+  heap->freeCount = 0;
+  }
+
+/*
+Name: getBitReversedIndex
+Process: maps an insert counter to a 1 based node index on the same level
+         with the bits below the level bit reversed, so consecutive
+         counters land in different subtrees
+Function input/parameters: counter, 1 or more (int)
+Function output/parameters: none
+Function output/returned: node index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getBitReversedIndex( int counter )
+  {
+  // variables
+  int levelBit = 1, reversed = 0, bit;
+
+  // find the highest set bit, it stays in place and picks the level
+  while( levelBit <= counter / 2 )
+    {
+    levelBit *= 2;
+    }
+
+  // reverse the bits below it
+  for( bit = 1; bit < levelBit; bit *= 2 )
+    {
+    reversed *= 2;
+
+    if( counter & bit )
+      {
+      reversed++;
+      }
+    }
+
+  return levelBit | reversed;
+  }
+
+/*
+Name: initializeConcurrentHeap
+Process: allocates a fixed capacity concurrent heap, nodes run to the
+         end of the last level since bit reversed leaves fill levels
+         out of order, initializes every node lock and marks every node empty
+Function input/parameters: concurrent heap (ConcurrentHeapType *), 
+                           capacity (int)
+Function output/parameters: initialized concurrent heap (ConcurrentHeapType *)
+Function output/returned: Boolean result, false if memory is unavailable (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: aligned_alloc, malloc, pthread_mutex_init
+*/
+bool initializeConcurrentHeap( ConcurrentHeapType *heap, int capacity )
+  {
+  // variables
+  int index, lastNode = 1;
+
+  // the level holding the last counter must be complete
+  while( lastNode < capacity )
+    {
+    lastNode = lastNode * 2 + 1;
+    }
+
+  // node 0 is unused so children of i are 2i and 2i + 1
+  heap->nodes = ( ConcurrentNodeType *)aligned_alloc( CACHE_LINE_SIZE,
+                         ( lastNode + 1 ) * sizeof( ConcurrentNodeType ) );
+  heap->slots = ( PatientType *)malloc( capacity * sizeof( PatientType ) );
+  heap->freeSlots = ( int *)malloc( capacity * sizeof( int ) );
+
+  if( heap->nodes == NULL || heap->slots == NULL || heap->freeSlots == NULL )
+    {
+    free( heap->nodes );
+    free( heap->slots );
+    free( heap->freeSlots );
+
+    return false;
+    }
+
+  for( index = 0; index <= lastNode; index++ )
+    {
+    pthread_mutex_init( &heap->nodes[ index ].lock, NULL );
+
+    heap->nodes[ index ].tag = TAG_EMPTY;
+    heap->nodes[ index ].key = 0;
+    heap->nodes[ index ].handle = INVALID_HANDLE;
+    }
+
+  // every payload slot starts free
+  for( index = 0; index < capacity; index++ )
+    {
+    heap->freeSlots[ index ] = capacity - 1 - index;
+    }
+
+  pthread_mutex_init( &heap->heapLock, NULL );
+  pthread_mutex_init( &heap->slotLock, NULL );
+
+  heap->size = 0;
+  heap->capacity = capacity;
+  heap->lastNode = lastNode;
+  heap->freeCount = capacity;
+
+  atomic_init( &heap->nextTag, FIRST_INSERT_TAG );
+  atomic_init( &heap->nextSequence, 0 );
+
+  return true;
+  }
+
+/*
+Name: isConcurrentEmpty
+Process: reports if concurrent heap is empty at the moment of the check
+Function input/parameters: concurrent heap (ConcurrentHeapType *)
+Function output/parameters: none
+Function output/returned: Boolean result of test (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_lock, pthread_mutex_unlock
+*/
+bool isConcurrentEmpty( ConcurrentHeapType *heap )
+  {
+  // variables
+  bool empty;
+
+  pthread_mutex_lock( &heap->heapLock );
+
+  empty = heap->size == 0;
+
+  pthread_mutex_unlock( &heap->heapLock );
+
+  return empty;
+  }
+
+/*
+Name: removeConcurrentItem
+Process: removes the highest priority patient, takes the last leaf 
+         under the heap lock, moves it to the root, then trickles down
+         holding at most a node and its children locked
+Function input/parameters: concurrent heap (ConcurrentHeapType *)
+Function output/parameters: updated concurrent heap (ConcurrentHeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if heap is empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_lock, pthread_mutex_unlock, getBitReversedIndex,
+              setPatientFromStruct, swapConcurrentNodes
+*/
+bool removeConcurrentItem( ConcurrentHeapType *heap, PatientType *removed )
+  {
+  // variables
+  ConcurrentNodeType *nodes = heap->nodes;
+  int bottomIndex, index, leftIndex, rightIndex, childIndex, handle;
+  uint64_t bottomKey;
+  int bottomHandle;
+  bool settled = false;
+
+  // take the last leaf, only the size counter is under the heap lock
+  pthread_mutex_lock( &heap->heapLock );
+
+  if( heap->size == 0 )
+    {
+    pthread_mutex_unlock( &heap->heapLock );
+
+    return false;
+    }
+
+  bottomIndex = getBitReversedIndex( heap->size );
+
+  heap->size--;
+
+  pthread_mutex_lock( &nodes[ bottomIndex ].lock );
+
+  pthread_mutex_unlock( &heap->heapLock );
+
+  bottomKey = nodes[ bottomIndex ].key;
+  bottomHandle = nodes[ bottomIndex ].handle;
+
+  nodes[ bottomIndex ].tag = TAG_EMPTY;
+
+  pthread_mutex_unlock( &nodes[ bottomIndex ].lock );
+
+  // lock the root, if it was the last leaf we already hold the top entry
+  pthread_mutex_lock( &nodes[ 1 ].lock );
+
+  if( nodes[ 1 ].tag == TAG_EMPTY )
+    {
+    pthread_mutex_unlock( &nodes[ 1 ].lock );
+
+    handle = bottomHandle;
+    }
+
+  else
+    {
+    // take the root entry and put the leaf entry in its place
+    handle = nodes[ 1 ].handle;
+
+    nodes[ 1 ].key = bottomKey;
+    nodes[ 1 ].handle = bottomHandle;
+    nodes[ 1 ].tag = TAG_AVAILABLE;
+
+    // trickle down hand over hand
+    index = 1;
+
+    while( !settled && index * 2 <= heap->lastNode )
+      {
+      leftIndex = index * 2;
+      rightIndex = leftIndex + 1;
+
+      pthread_mutex_lock( &nodes[ leftIndex ].lock );
+
+      if( rightIndex <= heap->lastNode )
+        {
+        pthread_mutex_lock( &nodes[ rightIndex ].lock );
+        }
+
+      // no children in use
+      if( nodes[ leftIndex ].tag == TAG_EMPTY )
+        {
+        if( rightIndex <= heap->lastNode )
+          {
+          pthread_mutex_unlock( &nodes[ rightIndex ].lock );
+          }
+
+        pthread_mutex_unlock( &nodes[ leftIndex ].lock );
+
+        settled = true;
+        }
+
+      else
+        {
+        // pick the larger child, release the other
+        if( rightIndex > heap->lastNode 
+                 || nodes[ rightIndex ].tag == TAG_EMPTY
+                 || nodes[ leftIndex ].key > nodes[ rightIndex ].key )
+          {
+          if( rightIndex <= heap->lastNode )
+            {
+            pthread_mutex_unlock( &nodes[ rightIndex ].lock );
+            }
+
+          childIndex = leftIndex;
+          }
+
+        else
+          {
+          pthread_mutex_unlock( &nodes[ leftIndex ].lock );
+
+          childIndex = rightIndex;
+          }
+
+        if( nodes[ childIndex ].key > nodes[ index ].key )
+          {
+          swapConcurrentNodes( &nodes[ childIndex ], &nodes[ index ] );
+
+          pthread_mutex_unlock( &nodes[ index ].lock );
+
+          index = childIndex;
+          }
+
+        else
+          {
+          pthread_mutex_unlock( &nodes[ childIndex ].lock );
+
+          settled = true;
+          }
+        }
+      }
+
+    pthread_mutex_unlock( &nodes[ index ].lock );
+    }
+
+  // copy the patient out, then free its payload slot
+  setPatientFromStruct( removed, heap->slots[ handle ] );
+
+  pthread_mutex_lock( &heap->slotLock );
+
+  heap->freeSlots[ heap->freeCount ] = handle;
+
+  heap->freeCount++;
+
+  pthread_mutex_unlock( &heap->slotLock );
+
+  return true;
+  }
+
+/*
+Name: swapConcurrentNodes
+Process: swaps key, tag, and handle of two nodes, caller holds both locks
+Function input/parameters: two nodes (ConcurrentNodeType *)
+Function output/parameters: updated nodes (ConcurrentNodeType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+void swapConcurrentNodes( ConcurrentNodeType *one, ConcurrentNodeType *other )
+  {
+  // variables
+  uint64_t tempKey = one->key, tempTag = one->tag;
+  int tempHandle = one->handle;
+
+  one->key = other->key;
+  one->tag = other->tag;
+  one->handle = other->handle;
+
+  other->key = tempKey;
+  other->tag = tempTag;
+  other->handle = tempHandle;
+  }
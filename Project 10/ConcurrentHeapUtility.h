@@ -0,0 +1,158 @@
+#ifndef CONCURRENT_HEAP_UTILITY_H
+#define CONCURRENT_HEAP_UTILITY_H
+
+#include "HeapUtility.c"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+// constants
+
+// node tags, any larger tag is the id of the insert moving that node up
+#define TAG_EMPTY 0
+#define TAG_AVAILABLE 1
+#define FIRST_INSERT_TAG 2
+
+// data structures
+
+// one lock per node, padded so neighboring nodes do not share a line
+typedef struct ConcurrentNodeStruct
+   {
+    _Alignas( CACHE_LINE_SIZE ) pthread_mutex_t lock;
+
+    uint64_t key;
+
+    uint64_t tag;
+
+    int handle;
+   } ConcurrentNodeType;
+
+// fixed capacity heap after Hunt et al., nodes are 1 based, 
+// the heap lock only guards size, inserts fill leaves in bit reversed
+// order so consecutive inserts climb disjoint paths
+typedef struct ConcurrentHeapStruct
+   {
+    ConcurrentNodeType *nodes;
+
+    pthread_mutex_t heapLock;
+
+    int size, capacity, lastNode;
+
+    PatientType *slots;
+
+    int *freeSlots;
+
+    int freeCount;
+
+    pthread_mutex_t slotLock;
+
+    atomic_uint_fast64_t nextTag;
+
+    atomic_uint nextSequence;
+   } ConcurrentHeapType;
+
+// function prototypes
+
+/*
+Name: addConcurrentItem
+Process: adds patient to concurrent heap, takes the next bit reversed leaf
+         under the heap lock, then bubbles up with parent then child node 
+         locks so other inserts and removes proceed on disjoint paths
+Function input/parameters: concurrent heap (ConcurrentHeapType *), 
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated concurrent heap (ConcurrentHeapType *)
+Function output/returned: Boolean result, false if heap is full (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_lock, pthread_mutex_unlock, getBitReversedIndex,
+              makeHeapKey, setPatientFromData, swapConcurrentNodes,
+              sched_yield
+*/
+bool addConcurrentItem( ConcurrentHeapType *heap, const char *nameSet,
+                                              int prioritySet, time_t timeSet );
+
+/*
+Name: clearConcurrentHeap
+Process: destroys all locks and frees node and slot arrays,
+         must not be called while other threads use the heap
+Function input/parameters: concurrent heap (ConcurrentHeapType *)
+Function output/parameters: updated concurrent heap (ConcurrentHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_destroy, free
+*/
+void clearConcurrentHeap( ConcurrentHeapType *heap );
+
+/*
+Name: getBitReversedIndex
+Process: maps an insert counter to a 1 based node index on the same level
+         with the bits below the level bit reversed, so consecutive
+         counters land in different subtrees
+Function input/parameters: counter, 1 or more (int)
+Function output/parameters: none
+Function output/returned: node index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getBitReversedIndex( int counter );
+
+/*
+Name: initializeConcurrentHeap
+Process: allocates a fixed capacity concurrent heap, nodes run to the
+         end of the last level since bit reversed leaves fill levels
+         out of order, initializes every node lock and marks every node empty
+Function input/parameters: concurrent heap (ConcurrentHeapType *), 
+                           capacity (int)
+Function output/parameters: initialized concurrent heap (ConcurrentHeapType *)
+Function output/returned: Boolean result, false if memory is unavailable (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: aligned_alloc, malloc, pthread_mutex_init
+*/
+bool initializeConcurrentHeap( ConcurrentHeapType *heap, int capacity );
+
+/*
+Name: isConcurrentEmpty
+Process: reports if concurrent heap is empty at the moment of the check
+Function input/parameters: concurrent heap (ConcurrentHeapType *)
+Function output/parameters: none
+Function output/returned: Boolean result of test (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_lock, pthread_mutex_unlock
+*/
+bool isConcurrentEmpty( ConcurrentHeapType *heap );
+
+/*
+Name: removeConcurrentItem
+Process: removes the highest priority patient, takes the last leaf 
+         under the heap lock, moves it to the root, then trickles down
+         holding at most a node and its children locked
+Function input/parameters: concurrent heap (ConcurrentHeapType *)
+Function output/parameters: updated concurrent heap (ConcurrentHeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if heap is empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_lock, pthread_mutex_unlock, getBitReversedIndex,
+              setPatientFromStruct, swapConcurrentNodes
+*/
+bool removeConcurrentItem( ConcurrentHeapType *heap, PatientType *removed );
+
+/*
+Name: swapConcurrentNodes
+Process: swaps key, tag, and handle of two nodes, caller holds both locks
+Function input/parameters: two nodes (ConcurrentNodeType *)
+Function output/parameters: updated nodes (ConcurrentNodeType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+void swapConcurrentNodes( ConcurrentNodeType *one, ConcurrentNodeType *other );
+
+
+#endif   // CONCURRENT_HEAP_UTILITY_H
@@ -1,399 +1,5277 @@
+// several modules include this file, define it only once
+#ifndef HEAP_UTILITY_C
+#define HEAP_UTILITY_C
+
 #include "HeapUtility.h"
 
 /*
 Name: addHeapItem
-Process: adds item to heap, reports action, updates size,
-         calls bubble up to reset heap
+Process: adds item to heap with an ordering key built from priority
+         and the heap's next arrival sequence
 Function input/parameters: heap data (HeapType *), patient name (char *),
                            patient priority (int), time in (time_t)
 Function output/parameters: updated heap data (HeapType *)
-Function output/returned: none
+Function output/returned: stable handle of patient slot (int)
 Device input/---: none
 Device output/monitor: patient addition action displayed as specified
-Dependencies: checkForResize, setPatientFromData, printf,
-              bubbleUpArrayHeap (recursively)
+Dependencies: addHeapItemWithKey, makeHeapKey, takeNextSequence
 */
-void addHeapItem( HeapType *heap, char *nameSet, 
+int addHeapItem( HeapType *heap, char *nameSet, 
                                               int prioritySet, time_t timeSet )
   {
+  return addHeapItemWithKey( heap, nameSet, timeSet, 
+                     makeHeapKey( prioritySet, takeNextSequence( heap ) ) );
+  }
+
+/*
+Name: addHeapItems
+Process: adds a batch of patients to heap, sizes arrays once for the batch,
+         stores every patient in a slot with keys in batch order,
+         if the batch is at least as large as the current heap the whole 
+         array is heapified bottom up in linear time, 
+         otherwise each new entry is bubbled up, a bucket queue heap
+         pushes each entry onto its level ring instead,
+         reports action and traces it, displays its sift steps,
+         optionally returns the handle of each patient
+Function input/parameters: heap data (HeapType *), 
+                           patients to add (const PatientType *),
+                           number of patients (int)
+Function output/parameters: updated heap data (HeapType *),
+                            handles in batch order, may be NULL,
+                            all INVALID_HANDLE if memory ran out (int *)
+Function output/returned: number of patients added, zero if memory ran
+                          out and none were added (int)
+Device input/---: none
+Device output/monitor: bulk addition action displayed as specified
+Dependencies: getBucketLevel, growBucketRing, growHeap, strnlen, 
+              reserveArenaBytes, reserveNameIndex, advanceHeapMigration, 
+              storePatientInSlot, makeHeapKey, setHeapEntry,
+              takeNextSequence, pushBucketEntry, traceHeapOperation, 
+              heapifyArrayHeap, 
+              bubbleUpArrayHeap, printf, storeHeapFileCounters, showHeapTrace
+*/
+int addHeapItems( HeapType *heap, const PatientType *patients, 
+                                                    int count, int *handles )
+  {
+  // variables
+  int index, handle, level, oldSize = heap->size;
+  int levelCounts[ MAX_BUCKET_LEVELS ] = { 0 };
+  uint32_t nameBytes = 0;
+  HeapEntryType entry;
+  bool ringsFlag = true;
+
+  // display process
+  if( heap->displayFlag )
+    {
+    printf( "\nAdding %d patients in bulk\n\n", count );     
+    }
+
+  for( index = 0; index < count; index++ )
+    {
+    nameBytes += (uint32_t)strnlen( patients[ index ].patientName, 
+                                                         MAX_NAME_LEN ) + 1;
+
+    if( heap->bucketQueue != NULL )
+      {
+      levelCounts[ getBucketLevel( heap->bucketQueue, 
+                                            patients[ index ].priority ) ]++;
+      }
+    }
+
+  // every level ring the batch lands in grows before anything is added
+  for( level = 0; heap->bucketQueue != NULL 
+                               && level < heap->bucketQueue->levelCount; level++ )
+    {
+    ringsFlag = ringsFlag && growBucketRing( heap, 
+                          &heap->bucketQueue->levels[ level ],
+                          heap->bucketQueue->levels[ level ].count 
+                                                     + levelCounts[ level ] );
+    }
+
+  // size the arrays and the name arena once for the whole batch, 
+  // geometrically so a run of batches does not resize on every one
+  if( ( oldSize + count > heap->capacity 
+                                     && !growHeap( heap, oldSize + count ) )
+      || !reserveArenaBytes( heap, nameBytes ) 
+      || !reserveNameIndex( heap, count ) || !ringsFlag )
+    {
+    for( index = 0; handles != NULL && index < count; index++ )
+      {
+      handles[ index ] = INVALID_HANDLE;
+      }
+
+    return 0;
+    }
+
+  if( heap->trace != NULL )
+    {
+    traceHeapOperation( heap, TRACE_BULK_ADD, INVALID_HANDLE, 
+                                                   (uint64_t)count, 0, NULL );
+    }
+
+  // copy the batch into slots and append entries after the current heap,
+  // each patient pays one step of an incremental resize like an add
+  for( index = 0; index < count; index++ )
+    {
+    advanceHeapMigration( heap, 1 );
+
+    handle = storePatientInSlot( heap, patients[ index ].patientName,
+                                                   patients[ index ].timeIn );
+
+    entry.handle = handle;
+    entry.key = makeHeapKey( patients[ index ].priority, 
+                                                takeNextSequence( heap ) );
+
+    if( heap->bucketQueue != NULL )
+      {
+      pushBucketEntry( heap, entry );
+      }
+
+    else
+      {
+      setHeapEntry( heap, oldSize + index, entry );
+      }
+
+    // each patient is traced so a decoder can name it in later steps
+    if( heap->trace != NULL )
+      {
+      traceHeapOperation( heap, TRACE_BULK_PATIENT, handle, entry.key,
+                                          (uint64_t)patients[ index ].timeIn,
+                                          patients[ index ].patientName );
+      }
+
+    if( handles != NULL )
+      {
+      handles[ index ] = handle;
+      }
+    }
+
+  // level rings are already in order
+  if( heap->bucketQueue != NULL )
+    {
+    heap->size = oldSize + count;
+    }
+
+  // large batch, rebuild the whole heap in linear time
+  else if( count >= oldSize )
+    {
+    heap->size = oldSize + count;
+
+    heapifyArrayHeap( heap );
+    }
+
+  // small batch into a large heap, bubble each new entry up
+  else
+    {
+    for( index = 0; index < count; index++ )
+      {
+      bubbleUpArrayHeap( heap, heap->size );
+
+      heap->size++;
+      }
+    }
+
+  storeHeapFileCounters( heap );
+
+  if( heap->displayFlag )
+    {
+    showHeapTrace( heap );
+    }
+
+  return count;
+  }
+
+/*
+Name: addHeapItemWithKey
+Process: adds item to heap with a caller supplied ordering key, 
+         reports action, stores patient in a slot, traces the addition,
+         updates size, calls bubble up to reset heap, or pushes onto
+         the level ring of a bucket queue, displays its steps, used when several heaps share 
+         one arrival sequence or when keys are replayed
+Function input/parameters: heap data (HeapType *), patient name (const char *),
+                           time in (time_t), ordering key (uint64_t)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: stable handle of patient slot, INVALID_HANDLE
+                          if memory ran out for the heap or the name (int)
+Device input/---: none
+Device output/monitor: patient addition action displayed as specified
+Dependencies: sampleHeapTicks, checkForResize, storePatientInSlot, printf, 
+              pushBucketEntry, releaseSlot, setHeapEntry, traceHeapOperation, 
+              bubbleUpArrayHeap, storeHeapFileCounters, recordLatency, 
+              showHeapTrace
+*/
+int addHeapItemWithKey( HeapType *heap, const char *nameSet, 
+                                              time_t timeSet, uint64_t key )
+  {
+  // variables
+  int handle;
+  HeapEntryType entry;
+  uint64_t startTicks = sampleHeapTicks( heap );
+
   // display process
   if( heap->displayFlag )
     {
     printf( "\nAdding new patient: %s\n\n", nameSet );     
     }
   
-  // check if array needs to be resized
-  checkForResize( heap );
+  // check if array needs to be resized, a full heap without memory
+  // turns the patient away
+  if( !checkForResize( heap ) )
+    {
+    return INVALID_HANDLE;
+    }
+  
+  // store the patient once in a stable slot, a name the arena has
+  // no room for turns the patient away
+  handle = storePatientInSlot( heap, nameSet, timeSet );
+
+  if( handle == INVALID_HANDLE )
+    {
+    return INVALID_HANDLE;
+    }
   
-  // add value at size
-  setPatientFromData( &heap->array[ heap->size ], 
-                        nameSet, prioritySet, timeSet  );
+  // add entry at size, only the handle and ordering key live in the heap
+  entry.handle = handle;
+  entry.key = key;
+
+  // a bucket queue appends to the level ring, no sift is needed,
+  // a ring that cannot grow turns the patient away as a full heap does
+  if( heap->bucketQueue != NULL )
+    {
+    if( !pushBucketEntry( heap, entry ) )
+      {
+      releaseSlot( heap, handle );
+
+      return INVALID_HANDLE;
+      }
+    }
+
+  else
+    {
+    setHeapEntry( heap, heap->size, entry );
+    }
+
+  if( heap->trace != NULL )
+    {
+    traceHeapOperation( heap, TRACE_ADD, handle, key, (uint64_t)timeSet, 
+                                                                    nameSet );
+    }
   
   // bubble up and rebalance heap
-  bubbleUpArrayHeap( heap, heap->size );
+  if( heap->bucketQueue == NULL )
+    {
+    bubbleUpArrayHeap( heap, heap->size );
+    }
   
   // increment size by 1
   heap->size++;		
+
+  // keep a file backed heap's header current
+  storeHeapFileCounters( heap );
+
+  if( startTicks != 0 )
+    {
+    recordLatency( &heap->latency->add, startTicks );
+    }
+
+  if( heap->displayFlag )
+    {
+    showHeapTrace( heap );
+    }
+
+  // return the handle to the caller
+  return handle;
+  }
+
+/*
+Name: advanceHeapMigration
+Process: moves the next part of an incremental resize, up to the given
+         number of steps of heap, slot, free slot, and position entries
+         and of name arena bytes, an arena step runs on to the end of
+         a name so no name is split between the blocks, hands the moved
+         pages of the old blocks back, frees each old block once it is
+         all moved and the migration once nothing is left, counts the
+         bytes copied
+Function input/parameters: heap data (HeapType *), steps (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: memcpy, releaseMigratedPages, free
+*/
+void advanceHeapMigration( HeapType *heap, int steps )
+  {
+  // variables
+  HeapMigrationType *migration = heap->migration;
+  int64_t budget;
+  int first, count;
+  uint32_t firstByte, stopByte;
+
+  if( migration == NULL )
+    {
+    return;
+    }
+
+  // the four arrays share one index range still in the old blocks
+  if( migration->array != NULL )
+    {
+    budget = (int64_t)steps * HEAP_MIGRATION_STEP;
+    first = migration->next;
+    count = migration->end - first < budget ? migration->end - first
+                                                                : (int)budget;
+
+    memcpy( &heap->array[ first ], &migration->array[ first ],
+                                       (size_t)count * sizeof( HeapEntryType ) );
+    memcpy( &heap->slots[ first ], &migration->slots[ first ],
+                                     (size_t)count * sizeof( PatientSlotType ) );
+    memcpy( &heap->freeSlots[ first ], &migration->freeSlots[ first ],
+                                                 (size_t)count * sizeof( int ) );
+    memcpy( &heap->positions[ first ], &migration->positions[ first ],
+                                                 (size_t)count * sizeof( int ) );
+
+    heap->counters.bytesCopied += (uint64_t)count * ( sizeof( HeapEntryType )
+                              + sizeof( PatientSlotType ) + 2 * sizeof( int ) );
+
+    migration->next = first + count;
+
+    if( migration->next < migration->end )
+      {
+      releaseMigratedPages( migration, migration->array,
+                          first * sizeof( HeapEntryType ),
+                          migration->next * sizeof( HeapEntryType ) );
+      releaseMigratedPages( migration, migration->slots,
+                          first * sizeof( PatientSlotType ),
+                          migration->next * sizeof( PatientSlotType ) );
+      releaseMigratedPages( migration, migration->freeSlots,
+                          first * sizeof( int ),
+                          migration->next * sizeof( int ) );
+      releaseMigratedPages( migration, migration->positions,
+                          first * sizeof( int ),
+                          migration->next * sizeof( int ) );
+      }
+
+    else
+      {
+      free( migration->arrayBlock );
+      free( migration->slots );
+      free( migration->freeSlots );
+      free( migration->positions );
+
+      migration->array = NULL;
+      migration->arrayBlock = NULL;
+      migration->slots = NULL;
+      migration->freeSlots = NULL;
+      migration->positions = NULL;
+      migration->next = 0;
+      migration->end = 0;
+      }
+    }
+
+  if( migration->nameArena != NULL )
+    {
+    budget = (int64_t)steps * HEAP_MIGRATION_BYTES;
+    firstByte = migration->nextByte;
+    stopByte = migration->endByte - firstByte < budget ? migration->endByte
+                                            : firstByte + (uint32_t)budget;
+
+    // a name is read from one block or the other, never split
+    while( stopByte < migration->endByte
+                          && migration->nameArena[ stopByte - 1 ] != NULL_CHAR )
+      {
+      stopByte++;
+      }
+
+    memcpy( &heap->nameArena[ firstByte ], &migration->nameArena[ firstByte ],
+                                                        stopByte - firstByte );
+
+    heap->counters.bytesCopied += stopByte - firstByte;
+
+    migration->nextByte = stopByte;
+
+    if( migration->nextByte < migration->endByte )
+      {
+      releaseMigratedPages( migration, migration->nameArena, firstByte,
+                                                                  stopByte );
+      }
+
+    else
+      {
+      free( migration->nameArena );
+
+      migration->nameArena = NULL;
+      migration->nextByte = 0;
+      migration->endByte = 0;
+      }
+    }
+
+  if( migration->array == NULL && migration->nameArena == NULL )
+    {
+    free( migration );
+
+    heap->migration = NULL;
+    }
+  }
+
+/*
+Name: allocateHeapArray
+Process: allocates a heap array for the given capacity and arity,
+         shifts the start of the array so every block of sibling
+         entries begins on a cache line boundary
+Function input/parameters: capacity (int), arity (int)
+Function output/parameters: raw allocated block to free later (void **)
+Function output/returned: aligned heap array (HeapEntryType *)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, sizeof
+*/
+HeapEntryType *allocateHeapArray( int capacity, int arity, void **blockPtr )
+  {
+  // variables
+  size_t padEntries = (size_t)( arity - 1 );
+  uintptr_t address;
+  void *block;
+
+  // room for the leading pad entries plus slack to reach a line boundary
+  block = malloc( ( (size_t)capacity + padEntries ) * sizeof( HeapEntryType )
+                                                        + CACHE_LINE_SIZE );
+
+  *blockPtr = block;
+
+  if( block == NULL )
+    {
+    return NULL;
+    }
+
+  // round up to a cache line
+  address = ( (uintptr_t)block + CACHE_LINE_SIZE - 1 ) 
+                                     & ~(uintptr_t)( CACHE_LINE_SIZE - 1 );
+
+  // children of node i start at arity * i + 1, 
+  // skipping arity - 1 entries puts that index on a block boundary
+  return (HeapEntryType *)address + padEntries;
+  }
+
+/*
+Name: allocateSlot
+Process: takes a free patient slot, reusing released slots first,
+         otherwise takes the next unused slot
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: handle of slot (int)
+Device input/---: none
+Device output/---: none
+Dependencies: getFreeSlot, getSlotPosition
+*/
+int allocateSlot( HeapType *heap )
+  {
+  // check for a released slot to reuse
+  if( heap->freeCount > 0 )
+    {
+    heap->freeCount--;
+
+    return *getFreeSlot( heap, heap->freeCount );
+    }
+
+  // otherwise take the next unused slot, not in the heap yet
+  *getSlotPosition( heap, heap->slotCount ) = INVALID_POSITION;
+
+  heap->slotCount++;
+
+  return heap->slotCount - 1;
+  }
+
+/*
+Name: appendArenaName
+Process: appends a name and its terminator to the name arena,
+         truncates names longer than the maximum name length,
+         makes room in the arena first when it is full,
+         records offset and length in slot
+Function input/parameters: heap data (HeapType *), name (const char *),
+                           slot handle (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the arena could not
+                          grow and the name was not stored (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: reserveArenaBytes, getPatientSlot
+*/
+bool appendArenaName( HeapType *heap, const char *name, int handle )
+  {
+  // variables
+  uint32_t length = 0;
+  char *arenaPtr;
+  PatientSlotType *slot;
+
+  // measure the name up to the maximum length
+  while( length < MAX_NAME_LEN && name[ length ] != NULL_CHAR )
+    {
+    length++;
+    }
+
+  // grow or compact the arena first when the name does not fit
+  if( heap->arenaSize + length + 1 > heap->arenaCapacity 
+                                    && !reserveArenaBytes( heap, length + 1 ) )
+    {
+    return false;
+    }
+
+  // copy the name in once
+  arenaPtr = &heap->nameArena[ heap->arenaSize ];
+
+  memcpy( arenaPtr, name, length );
+
+  arenaPtr[ length ] = NULL_CHAR;
+
+  slot = getPatientSlot( heap, handle );
+
+  slot->nameOffset = heap->arenaSize;
+  slot->nameLength = (uint16_t)length;
+
+  heap->arenaSize += length + 1;
+  heap->arenaLiveBytes += length + 1;
+
+  return true;
+  }
+
+/*
+Name: beginArenaMigration
+Process: starts an incremental resize of the name arena, allocates the
+         new arena and leaves the names already stored in the old one
+         to be moved a step at a time, names appended meanwhile go
+         to the new arena past the end of the old names
+Function input/parameters: heap data (HeapType *),
+                           new arena capacity (uint32_t)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the arena is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, createHeapMigration, free
+*/
+bool beginArenaMigration( HeapType *heap, uint32_t newCapacity )
+  {
+  // variables
+  char *newArena = ( char *)malloc( newCapacity );
+
+  if( newArena != NULL && heap->migration == NULL )
+    {
+    heap->migration = createHeapMigration();
+    }
+
+  if( newArena == NULL || heap->migration == NULL )
+    {
+    free( newArena );
+
+    return false;
+    }
+
+  heap->migration->nameArena = heap->nameArena;
+  heap->migration->nextByte = 0;
+  heap->migration->endByte = heap->arenaSize;
+
+  heap->nameArena = newArena;
+  heap->arenaCapacity = newCapacity;
+
+  return true;
+  }
+
+/*
+Name: beginHeapMigration
+Process: starts an incremental resize of the heap, slot, free slot, and
+         position arrays, allocates the new blocks at the new capacity
+         and leaves every index below the slot count in the old blocks
+         to be moved a step at a time, moves the first step at once
+         so the top entry is always in the new array, counts the resize
+         and resets the shrink size as resizeHeap does
+Function input/parameters: heap data (HeapType *), new capacity (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the heap is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: allocateHeapArray, malloc, createHeapMigration, free,
+              advanceHeapMigration
+*/
+bool beginHeapMigration( HeapType *heap, int newCapacity )
+  {
+  // variables
+  HeapMigrationType *migration;
+  HeapEntryType *newArray;
+  void *newBlock;
+  PatientSlotType *newSlots;
+  int *newFreeSlots, *newPositions;
+
+  newArray = allocateHeapArray( newCapacity, heap->arity, &newBlock );
+  newSlots = ( PatientSlotType *)malloc(
+                             (size_t)newCapacity * sizeof( PatientSlotType ) );
+  newFreeSlots = ( int *)malloc( (size_t)newCapacity * sizeof( int ) );
+  newPositions = ( int *)malloc( (size_t)newCapacity * sizeof( int ) );
+
+  if( heap->migration == NULL )
+    {
+    heap->migration = createHeapMigration();
+    }
+
+  migration = heap->migration;
+
+  if( newArray == NULL || newSlots == NULL || newFreeSlots == NULL
+                             || newPositions == NULL || migration == NULL )
+    {
+    free( newBlock );
+    free( newSlots );
+    free( newFreeSlots );
+    free( newPositions );
+
+    return false;
+    }
+
+  // the old blocks keep serving their indices until each is moved
+  migration->array = heap->array;
+  migration->arrayBlock = heap->arrayBlock;
+  migration->slots = heap->slots;
+  migration->freeSlots = heap->freeSlots;
+  migration->positions = heap->positions;
+  migration->next = 0;
+  migration->end = heap->slotCount;
+
+  heap->array = newArray;
+  heap->arrayBlock = newBlock;
+  heap->slots = newSlots;
+  heap->freeSlots = newFreeSlots;
+  heap->positions = newPositions;
+
+  heap->counters.resizes++;
+
+  heap->capacity = newCapacity;
+  heap->shrinkSize = (int)( newCapacity
+                               / ( heap->growthFactor * heap->growthFactor ) );
+
+  advanceHeapMigration( heap, 1 );
+
+  return true;
   }
 
 /*
 Name: bubbleUpArrayHeap
-Process: recursively rebalances heap after new data is added,
-         displays bubble up actions
+Process: iteratively rebalances heap after new data is added,
+         carries a hole up from the current index, moving each lower parent
+         down one level, then writes the new entry once at its final index,
+         records bubble up steps in the heap's trace
 Function input/parameters: heap data (HeapType *), current index (int)
 Function output/parameters: updated heap data (HeapType *)
 Function output/returned: none
 Device input/---: none
-Device output/monitor: bubble up operations displayed as specified
-Dependencies: setPatientFromStruct, comparePriority, getPatientInfo,
-              bubbleUpArrayHeap (recursively), others acceptable
+Device output/---: none
+Dependencies: getHeapEntry, traceHeapStep, setHeapEntry, recordSift
+*/
+void bubbleUpArrayHeap( HeapType *heap, int currentIndex )
+  {
+  // variables
+  HeapEntryType moving = *getHeapEntry( heap, currentIndex );
+  int parentIndex = ( currentIndex - 1 ) / heap->arity;	
+  int levels = 0;
+      	
+  // loop while above the root and the parent has a lower key
+  while( currentIndex > 0 
+                       && getHeapEntry( heap, parentIndex )->key < moving.key )
+    {       
+#if HEAP_TRACE
+    // record the step, display mode prints it when the operation ends
+    if( heap->trace != NULL )
+      {
+      traceHeapStep( heap, TRACE_BUBBLE_UP, moving, currentIndex, 
+                         *getHeapEntry( heap, parentIndex ), parentIndex, 0 );
+      }
+#endif
+
+    // move the parent down into the hole
+    setHeapEntry( heap, currentIndex, *getHeapEntry( heap, parentIndex ) );
+
+    // hole moves up to the parent's index
+    currentIndex = parentIndex;
+    parentIndex = ( currentIndex - 1 ) / heap->arity;
+
+    levels++;
+    }
+
+  // write the new entry once at its final index
+  setHeapEntry( heap, currentIndex, moving );
+
+  // one comparison per level moved, plus the one that stopped the climb
+  recordSift( heap, levels, currentIndex > 0 ? levels + 1 : levels );
+  }
+
+/*
+Name: buildHeapFromArray
+Process: initializes heap with room for exactly the given patients,
+         copies them in, then heapifies bottom up in linear time
+Function input/parameters: heap data (HeapType *), 
+                           patients to load (const PatientType *),
+                           number of patients (int)
+Function output/parameters: initialized heap data (HeapType *),
+                            handles in array order, may be NULL (int *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: initializeHeap, addHeapItems
+*/
+void buildHeapFromArray( HeapType *heap, const PatientType *patients, 
+                                                    int count, int *handles )
+  {
+  // size the heap exactly for the batch
+  initializeHeap( heap, count );
+
+  // empty heap, so the batch is always heapified in one pass
+  addHeapItems( heap, patients, count, handles );
+  }
+
+/*
+Name: checkForResize
+Process: moves one step of any incremental resize under way, 
+         checks for need to resize (increase capacity of) array,
+         if necessary, grows heap by its growth factor
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the heap is full
+                          and memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: advanceHeapMigration, growHeap
+*/
+bool checkForResize( HeapType *heap )
+  {
+  advanceHeapMigration( heap, 1 );
+
+  // check if array is full
+  if( heap->size == heap->capacity )
+    {
+    return growHeap( heap, heap->size + 1 );
+    }	
+
+  return true;
+  }
+
+/*
+Name: checkForShrink
+Process: gives memory back once few patients are left, when the size
+         drops below the shrink size the capacity is cut to the waiting
+         count times the growth factor, never below the initial capacity
+         or the highest handle still waiting, trailing free slots are
+         dropped, the name arena shrinks the same way once mostly empty,
+         a shrink saving less than one growth step waits until half
+         of those waiting have left, file backed heaps keep their size,
+         no shrink starts while an incremental resize is under way
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: compactNameArena, realloc, resizeHeap
+*/
+void checkForShrink( HeapType *heap )
+  {
+  // variables
+  int newCapacity, slotBound = heap->slotCount, index, kept = 0;
+  uint32_t arenaCapacity;
+  char *newArena;
+
+  if( heap->size >= heap->shrinkSize || heap->fileHeader != NULL 
+                                                  || heap->migration != NULL )
+    {
+    return;
+    }
+
+  // mostly empty arena, pack the names then give back the tail
+  if( heap->arenaCapacity > MIN_ARENA_CAPACITY 
+      && heap->arenaLiveBytes * heap->growthFactor * heap->growthFactor 
+                                                      < heap->arenaCapacity )
+    {
+    if( heap->arenaLiveBytes < heap->arenaSize )
+      {
+      compactNameArena( heap );
+      }
+
+    arenaCapacity = (uint32_t)( heap->arenaLiveBytes * heap->growthFactor );
+
+    if( arenaCapacity < MIN_ARENA_CAPACITY )
+      {
+      arenaCapacity = MIN_ARENA_CAPACITY;
+      }
+
+    newArena = ( char *)realloc( heap->nameArena, arenaCapacity );
+
+    if( newArena != NULL )
+      {
+      heap->nameArena = newArena;
+      heap->arenaCapacity = arenaCapacity;
+      }
+    }
+
+  // a waiting patient keeps its handle, only trailing free slots can go
+  while( slotBound > 0 
+                   && heap->positions[ slotBound - 1 ] == INVALID_POSITION )
+    {
+    slotBound--;
+    }
+
+  newCapacity = (int)( heap->size * heap->growthFactor ) + 1;
+
+  if( newCapacity < heap->minCapacity )
+    {
+    newCapacity = heap->minCapacity;
+    }
+
+  if( newCapacity < slotBound )
+    {
+    newCapacity = slotBound;
+    }
+
+  // not worth a resize yet, look again once half of those waiting leave
+  if( newCapacity > heap->capacity / heap->growthFactor )
+    {
+    heap->shrinkSize = ( heap->size + 1 ) / 2;
+
+    return;
+    }
+
+  // drop free handles past the new end of the slots
+  for( index = 0; index < heap->freeCount; index++ )
+    {
+    if( heap->freeSlots[ index ] < slotBound )
+      {
+      heap->freeSlots[ kept ] = heap->freeSlots[ index ];
+
+      kept++;
+      }
+    }
+
+  heap->freeCount = kept;
+  heap->slotCount = slotBound;
+
+  resizeHeap( heap, newCapacity );
+  }
+
+/*
+Name: clearHeap
+Process: frees heap, slot, and position arrays and the name index,
+         a file backed heap instead has its counters written to the
+         file header and is unmapped and closed with its patients kept,
+         frees the latency histograms, the trace ring, any
+         bucket queue levels, and the old blocks of an incremental resize,
+         sets all other data members appropriately
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: storeHeapFileCounters, munmap, close, free, freeHeapTrace
+*/
+void clearHeap( HeapType *heap )
+  {	
+  // variables
+  int index;
+
+  // a file backed heap keeps its patients in the file
+  if( heap->fileHeader != NULL )
+    {
+#ifdef HEAP_FILE_SUPPORT
+    storeHeapFileCounters( heap );
+
+    munmap( heap->fileHeader, heap->mapLength );
+
+    close( heap->fileDescriptor );
+#endif
+
+    heap->fileHeader = NULL;
+    heap->mapLength = 0;
+    heap->fileDescriptor = -1;
+    }
+
+  else
+    {
+    // free the arrays
+    free( heap->arrayBlock );
+    free( heap->slots );
+    free( heap->freeSlots );
+    free( heap->positions );
+
+    // every name goes back to the OS in one call
+    free( heap->nameArena );
+    }
+
+  if( heap->migration != NULL )
+    {
+    free( heap->migration->arrayBlock );
+    free( heap->migration->slots );
+    free( heap->migration->freeSlots );
+    free( heap->migration->positions );
+    free( heap->migration->nameArena );
+    free( heap->migration );
+    }
+
+  free( heap->nameBuckets );
+
+  free( heap->latency );
+
+  freeHeapTrace( heap->trace );
+
+  if( heap->bucketQueue != NULL )
+    {
+    for( index = 0; index < heap->bucketQueue->levelCount; index++ )
+      {
+      free( heap->bucketQueue->levels[ index ].entries );
+      }
+
+    free( heap->bucketQueue->levels );
+    free( heap->bucketQueue );
+    }
+
+  heap->bucketQueue = NULL;
+  heap->migration = NULL;
+  heap->latency = NULL;
+  heap->trace = NULL;
+  heap->nameArena = NULL;
+  heap->arenaSize = 0;
+  heap->arenaCapacity = 0;
+  heap->arenaLiveBytes = 0;
+
+  heap->array = NULL;
+  heap->arrayBlock = NULL;
+  heap->slots = NULL;
+  heap->freeSlots = NULL;
+  heap->positions = NULL;
+  heap->nameBuckets = NULL;
+  
+  // set all other data members appropriatly
+  heap->capacity = 0;
+  heap->size = 0;
+  heap->slotCount = 0;
+  heap->freeCount = 0;
+  heap->nextSequence = 0;
+  heap->nameBucketCount = 0;
+  heap->nameCount = 0;
+  }
+
+/*
+Name: closeHeapFile
+Process: closes a file backed heap through clearHeap so no array is
+         left pointing into the unmapped file and the side blocks are
+         freed, the file keeps every waiting patient for the next
+         openHeapFile, a heap in memory is left as it is
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: clearHeap
+*/
+void closeHeapFile( HeapType *heap )
+  {
+  if( heap->fileHeader != NULL )
+    {
+    clearHeap( heap );
+    }
+  }
+
+/*
+Name: compactNameArena
+Process: slides the names of all waiting patients to the front 
+         of the name arena in arena order, updates their slot offsets,
+         finishes any incremental resize first as every slot is visited
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: finishHeapMigration, malloc, free, memcpy
+*/
+void compactNameArena( HeapType *heap )
+  {
+  // variables
+  char *newArena;
+  uint32_t newSize = 0, length;
+  int handle;
+
+  finishHeapMigration( heap );
+
+  newArena = ( char *)malloc( heap->arenaCapacity );
+
+  // no memory to pack into, the garbage just stays a while longer
+  if( newArena == NULL )
+    {
+    return;
+    }
+
+  // only slots with a heap position own live names
+  for( handle = 0; handle < heap->slotCount; handle++ )
+    {
+    if( heap->positions[ handle ] != INVALID_POSITION )
+      {
+      length = heap->slots[ handle ].nameLength + 1u;
+
+      memcpy( &newArena[ newSize ], 
+                  &heap->nameArena[ heap->slots[ handle ].nameOffset ], length );
+
+      heap->slots[ handle ].nameOffset = newSize;
+
+      newSize += length;
+      }
+    }
+
+  // a mapped arena stays where it is, copy the packed names back
+  if( heap->fileHeader != NULL )
+    {
+    memcpy( heap->nameArena, newArena, newSize );
+
+    free( newArena );
+    }
+
+  else
+    {
+    free( heap->nameArena );
+
+    heap->nameArena = newArena;
+    }
+
+  heap->arenaSize = newSize;
+  heap->arenaLiveBytes = newSize;
+  }
+
+/*
+Name: compareEntryKeys
+Process: orders two heap entries by ordering key, larger key first,
+         for qsort
+Function input/parameters: two heap entries (const void *)
+Function output/parameters: none
+Function output/returned: negative, zero, or positive (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int compareEntryKeys( const void *one, const void *other )
+  {
+  // variables
+  uint64_t oneKey = ( ( const HeapEntryType *)one )->key;
+  uint64_t otherKey = ( ( const HeapEntryType *)other )->key;
+
+  return ( oneKey < otherKey ) - ( oneKey > otherKey );
+  }
+
+/*
+Name: createHeapMigration
+Process: allocates an incremental resize record with nothing to move,
+         notes the page size for handing moved pages back
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: new migration, NULL if memory ran out
+                          (HeapMigrationType *)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, memset, sysconf where available
+*/
+HeapMigrationType *createHeapMigration( void )
+  {
+  // variables
+  HeapMigrationType *migration
+               = ( HeapMigrationType *)malloc( sizeof( HeapMigrationType ) );
+
+  if( migration == NULL )
+    {
+    return NULL;
+    }
+
+  // no blocks and empty ranges until a resize begins
+  memset( migration, 0, sizeof( HeapMigrationType ) );
+
+#ifdef HEAP_FILE_SUPPORT
+  migration->pageSize = (size_t)sysconf( _SC_PAGESIZE );
+#endif
+
+  return migration;
+  }
+
+/*
+Name: disableHeapTrace
+Process: stops tracing and frees the heap's trace ring
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: freeHeapTrace
+*/
+void disableHeapTrace( HeapType *heap )
+  {
+  freeHeapTrace( heap->trace );
+
+  heap->trace = NULL;
+  }
+
+/*
+Name: drainSorted
+Process: removes every patient into a caller buffer in priority order,
+         finishes any incremental resize, then heapsorts the entries
+         in place, moving only the small
+         entries, a bucket queue is popped into the array instead,
+         then copies each patient out of its slot once,
+         leaves the heap empty with all slots free and no indexed names,
+         displays and traces each removal action
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: empty heap data (HeapType *),
+                            patients removed in priority order (PatientType *)
+Function output/returned: number of patients removed (int)
+Device input/---: none
+Device output/monitor: removal actions displayed as specified
+Dependencies: finishHeapMigration, popBucketEntry, sinkToLeafArrayHeap, 
+              getEntryPatient, traceHeapOperation, getPatientInfo, printf, 
+              checkForShrink, storeHeapFileCounters
+*/
+int drainSorted( HeapType *heap, PatientType *removed )
+  {
+  // variables
+  int count = heap->size, index;
+  HeapEntryType top;
+  char returnStr[ HUGE_STR_LEN ];
+
+  // every entry is visited, so the arrays are whole again first
+  finishHeapMigration( heap );
+
+  // a bucket queue pops in order, lay the entries out as heapsort would
+  if( heap->bucketQueue != NULL )
+    {
+    for( index = 0; index < count; index++ )
+      {
+      heap->array[ count - 1 - index ] = popBucketEntry( heap );
+      }
+    }
+
+  // heapsort, move the top past the end of a shrinking heap each pass
+  else while( heap->size > 1 )
+    {
+    top = heap->array[ 0 ];
+
+    heap->size--;
+
+    sinkToLeafArrayHeap( heap, heap->array[ heap->size ] );
+
+    heap->array[ heap->size ] = top;
+    }
+
+  // array now ascends, copy patients out from the highest key down
+  for( index = 0; index < count; index++ )
+    {
+    getEntryPatient( heap, heap->array[ count - 1 - index ], 
+                                                         &removed[ index ] );
+
+    if( heap->trace != NULL )
+      {
+      traceHeapOperation( heap, TRACE_REMOVE, 
+                         heap->array[ count - 1 - index ].handle,
+                         heap->array[ count - 1 - index ].key,
+                         (uint64_t)removed[ index ].timeIn, 
+                                                 removed[ index ].patientName );
+      }
+
+    if( heap->displayFlag )
+      {
+      getPatientInfo( returnStr, removed[ index ] );
+      printf( "\nRemoving patient: %s\n", returnStr );
+      }
+    }
+
+  // every slot is free again
+  heap->size = 0;
+  heap->slotCount = 0;
+  heap->freeCount = 0;
+
+  // no names left, arena starts over
+  heap->arenaSize = 0;
+  heap->arenaLiveBytes = 0;
+
+  // no names left to index
+  for( index = 0; index < heap->nameBucketCount; index++ )
+    {
+    heap->nameBuckets[ index ] = EMPTY_BUCKET;
+    }
+
+  heap->nameCount = 0;
+
+  // give memory back once the heap has emptied out
+  checkForShrink( heap );
+
+  storeHeapFileCounters( heap );
+
+  return count;
+  }
+
+/*
+Name: enableHeapTrace
+Process: attaches a new trace ring of at least the given number of events,
+         replacing any ring already attached, every later add, removal, 
+         priority change and sift step is recorded in it
+Function input/parameters: heap data (HeapType *), event capacity (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if tracing was compiled
+                          out with HEAP_TRACE 0 (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: freeHeapTrace, createHeapTrace
+*/
+bool enableHeapTrace( HeapType *heap, int capacity )
+  {
+#if HEAP_TRACE
+  freeHeapTrace( heap->trace );
+
+  heap->trace = createHeapTrace( capacity );
+
+  return true;
+#else
+  ( void )heap;
+  ( void )capacity;
+
+  return false;
+#endif
+  }
+
+/*
+Name: enableNameIndex
+Process: turns on the name to handle index, sizes it once for
+         every patient currently waiting in the heap, then adds them
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the index is still off (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: resizeNameIndex, getSlotPosition, insertNameIndex
+*/
+bool enableNameIndex( HeapType *heap )
+  {
+  // variables
+  int index, bucketCount = MIN_NAME_BUCKETS;
+
+  // already enabled
+  if( heap->nameBuckets != NULL )
+    {
+    return true;
+    }
+
+  // size the table once for everyone waiting, at most half full
+  while( heap->size * 2 > bucketCount )
+    {
+    bucketCount *= 2;
+    }
+
+  if( !resizeNameIndex( heap, bucketCount ) )
+    {
+    return false;
+    }
+
+  // every slot with a position is waiting, in the array or a level ring
+  for( index = 0; index < heap->slotCount; index++ )
+    {
+    if( *getSlotPosition( heap, index ) != INVALID_POSITION )
+      {
+      insertNameIndex( heap, index );
+      }
+    }
+
+  return true;
+  }
+
+/*
+Name: findBucketEntry
+Process: finds a waiting patient's entry in the ring of its priority
+         level, the position map holds the level in bucket queue mode
+Function input/parameters: heap data (const HeapType *), handle (int)
+Function output/parameters: none
+Function output/returned: entry in its level ring, NULL if not found
+                          (HeapEntryType *)
+Device input/---: none
+Device output/---: none
+Dependencies: getSlotPosition
+*/
+HeapEntryType *findBucketEntry( const HeapType *heap, int handle )
+  {
+  // variables
+  PriorityBucketType *bucket 
+            = &heap->bucketQueue->levels[ *getSlotPosition( heap, handle ) ];
+  int offset;
+
+  for( offset = 0; offset < bucket->count; offset++ )
+    {
+    if( bucket->entries[ ( bucket->head + offset ) & bucket->mask ].handle 
+                                                                   == handle )
+      {
+      return &bucket->entries[ ( bucket->head + offset ) & bucket->mask ];
+      }
+    }
+
+  return NULL;
+  }
+
+/*
+Name: findPatientHandle
+Process: looks up a waiting patient by name in the name index,
+         if several patients share the name, one of their handles is returned
+Function input/parameters: heap data (const HeapType *), 
+                           patient name (const char *)
+Function output/parameters: none
+Function output/returned: handle of patient, 
+                          INVALID_HANDLE if not found or index is off (int)
+Device input/---: none
+Device output/---: none
+Dependencies: hashPatientName, compareString
+*/
+int findPatientHandle( const HeapType *heap, const char *name )
+  {
+  // variables
+  int mask = heap->nameBucketCount - 1, bucket, handle;
+
+  if( heap->nameBuckets == NULL )
+    {
+    return INVALID_HANDLE;
+    }
+
+  // linear probe until the name or an empty bucket is found
+  bucket = (int)( hashPatientName( name ) & (uint32_t)mask );
+  handle = heap->nameBuckets[ bucket ];
+
+  while( handle != EMPTY_BUCKET )
+    {
+    if( compareString( getSlotName( heap, handle ), name ) == 0 )
+      {
+      return handle;
+      }
+
+    bucket = ( bucket + 1 ) & mask;
+    handle = heap->nameBuckets[ bucket ];
+    }
+
+  return INVALID_HANDLE;
+  }
+
+/*
+Name: finishHeapMigration
+Process: moves whatever is left of an incremental resize at once,
+         used before operations that touch every entry anyway
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: advanceHeapMigration
+*/
+void finishHeapMigration( HeapType *heap )
+  {
+  advanceHeapMigration( heap, INT_MAX );
+  }
+
+/*
+Name: gatherHeapEntries
+Process: copies every entry of a heap into a new buffer ordered by key,
+         larger key first, bucket queue levels are read highest first
+         and are then already in order, an array heap is sorted
+Function input/parameters: heap data (const HeapType *)
+Function output/parameters: none
+Function output/returned: new buffer of heap size entries, NULL if
+                          memory ran out (HeapEntryType *)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, memcpy, qsort, compareEntryKeys
+*/
+HeapEntryType *gatherHeapEntries( const HeapType *heap )
+  {
+  // variables
+  HeapEntryType *entries = ( HeapEntryType *)malloc( 
+                               ( heap->size > 0 ? heap->size : 1 ) 
+                                                  * sizeof( HeapEntryType ) );
+  PriorityBucketType *bucket;
+  int level, index, count = 0;
+
+  if( entries == NULL )
+    {
+    return NULL;
+    }
+
+  if( heap->bucketQueue != NULL )
+    {
+    for( level = heap->bucketQueue->levelCount - 1; level >= 0; level-- )
+      {
+      bucket = &heap->bucketQueue->levels[ level ];
+
+      for( index = 0; index < bucket->count; index++ )
+        {
+        entries[ count ] 
+                  = bucket->entries[ ( bucket->head + index ) & bucket->mask ];
+
+        count++;
+        }
+      }
+    }
+
+  else
+    {
+    memcpy( entries, heap->array, heap->size * sizeof( HeapEntryType ) );
+
+    qsort( entries, heap->size, sizeof( HeapEntryType ), compareEntryKeys );
+    }
+
+  return entries;
+  }
+
+/*
+Name: getBestChildSelect
+Process: finds the widest child selection kernel the processor runs,
+         checked at run time so one build serves every x86 machine
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: child selection kernel (int)
+Device input/---: none
+Device output/---: none
+Dependencies: __builtin_cpu_supports where available
+*/
+int getBestChildSelect( void )
+  {
+#ifdef HEAP_SIMD_SUPPORT
+  if( __builtin_cpu_supports( "avx2" ) )
+    {
+    return CHILD_SELECT_AVX2;
+    }
+
+  if( __builtin_cpu_supports( "sse4.2" ) )
+    {
+    return CHILD_SELECT_SSE42;
+    }
+#endif
+
+  return CHILD_SELECT_SCALAR;
+  }
+
+
+/*
+Name: getBucketLevel
+Process: maps a priority to its bucket queue level, priorities outside
+         the range share the lowest or highest level, where key order
+         inside the ring still keeps them exact
+Function input/parameters: bucket queue (const BucketQueueType *), 
+                           priority (int)
+Function output/parameters: none
+Function output/returned: level index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getBucketLevel( const BucketQueueType *queue, int priority )
+  {
+  // variables
+  int level = priority - queue->lowestPriority;
+
+  if( level < 0 )
+    {
+    return 0;
+    }
+
+  if( level >= queue->levelCount )
+    {
+    return queue->levelCount - 1;
+    }
+
+  return level;
+  }
+
+/*
+Name: getEntryPatient
+Process: assembles full patient data for a heap entry, 
+         name from the name arena bounded to the patient name buffer,
+         priority from the ordering key, time in from the slot
+Function input/parameters: heap data (const HeapType *), entry (HeapEntryType)
+Function output/parameters: patient data (PatientType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: copyStringBounded, getSlotName, getKeyPriority, 
+              getPatientSlot
+*/
+void getEntryPatient( const HeapType *heap, HeapEntryType entry, 
+                                                       PatientType *patient )
+  {
+  copyStringBounded( patient->patientName, 
+                               getSlotName( heap, entry.handle ), STD_STR_LEN );
+
+  patient->priority = getKeyPriority( entry.key );
+
+  patient->timeIn = getPatientSlot( heap, entry.handle )->timeIn;
+  }
+
+/*
+Name: getFreeSlot
+Process: finds an entry of the free slot stack, in the old block if
+         an incremental resize has not moved it yet
+Function input/parameters: heap data (const HeapType *), stack index (int)
+Function output/parameters: none
+Function output/returned: free slot stack entry (int *)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int *getFreeSlot( const HeapType *heap, int index )
+  {
+  // variables
+  HeapMigrationType *migration = heap->migration;
+
+  if( migration != NULL && index >= migration->next
+                                                && index < migration->end )
+    {
+    return &migration->freeSlots[ index ];
+    }
+
+  return &heap->freeSlots[ index ];
+  }
+
+/*
+Name: getGrownCapacity
+Process: finds the capacity to grow to, the current capacity times
+         the growth factor, at least one more, and at least the count
+         needed, held to the int range
+Function input/parameters: heap data (const HeapType *), 
+                           entries needed (int)
+Function output/parameters: none
+Function output/returned: new capacity (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getGrownCapacity( const HeapType *heap, int needed )
+  {
+  // variables
+  double grown = heap->capacity * heap->growthFactor;
+
+  if( grown > INT_MAX )
+    {
+    grown = INT_MAX;
+    }
+
+  // a zero or tiny capacity grows by at least one
+  if( (int)grown <= heap->capacity )
+    {
+    grown = heap->capacity + 1.0;
+    }
+
+  return (int)grown > needed ? (int)grown : needed;
+  }
+
+/*
+Name: getHeapEntry
+Process: finds the entry at a heap index, in the old block if an
+         incremental resize has not moved it yet, every sift reads
+         and writes through here
+Function input/parameters: heap data (const HeapType *), heap index (int)
+Function output/parameters: none
+Function output/returned: heap entry (HeapEntryType *)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+HeapEntryType *getHeapEntry( const HeapType *heap, int index )
+  {
+  // variables
+  HeapMigrationType *migration = heap->migration;
+
+  if( migration != NULL && index >= migration->next
+                                                && index < migration->end )
+    {
+    return &migration->array[ index ];
+    }
+
+  return &heap->array[ index ];
+  }
+
+/*
+Name: getHeapPatient
+Process: copies out the data of a waiting patient found by handle
+Function input/parameters: heap data (const HeapType *), handle (int)
+Function output/parameters: patient data (PatientType *)
+Function output/returned: Boolean result, false if handle is not waiting (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getSlotPosition, findBucketEntry, getEntryPatient, 
+              getHeapEntry
+*/
+bool getHeapPatient( const HeapType *heap, int handle, PatientType *patient )
+  {
+  // check for a handle that is not waiting in the heap
+  if( handle < 0 || handle >= heap->slotCount 
+                     || *getSlotPosition( heap, handle ) == INVALID_POSITION )
+    {
+    return false;
+    }
+
+  if( heap->bucketQueue != NULL )
+    {
+    getEntryPatient( heap, *findBucketEntry( heap, handle ), patient );
+    }
+
+  else
+    {
+    getEntryPatient( heap, 
+              *getHeapEntry( heap, *getSlotPosition( heap, handle ) ), patient );
+    }
+
+  return true;
+  }
+
+/*
+Name: getHeapStats
+Process: copies the heap's counters and latency histograms into a
+         snapshot, computes the average sift depth and the counter rate
+Function input/parameters: heap data (const HeapType *)
+Function output/parameters: statistics snapshot (HeapStatsType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: readHeapTicks, readHeapNanoseconds, memset
+*/
+void getHeapStats( const HeapType *heap, HeapStatsType *stats )
+  {
+  // variables
+  double elapsedNs;
+
+  stats->counters = heap->counters;
+
+  stats->averageSiftDepth = heap->counters.siftOperations > 0
+                   ? (double)heap->counters.siftLevels 
+                                        / heap->counters.siftOperations : 0.0;
+
+  if( heap->latency == NULL )
+    {
+    memset( &stats->addLatency, 0, sizeof( LatencyHistogramType ) );
+    memset( &stats->removeLatency, 0, sizeof( LatencyHistogramType ) );
+
+    stats->ticksPerNs = 1.0;
+
+    return;
+    }
+
+  stats->addLatency = heap->latency->add;
+  stats->removeLatency = heap->latency->remove;
+
+  // the longer the heap has lived the closer this rate is
+  elapsedNs = readHeapNanoseconds() - heap->latency->startNs;
+
+  stats->ticksPerNs = elapsedNs > 0.0 
+     ? ( readHeapTicks() - heap->latency->startTicks ) / elapsedNs : 1.0;
+
+  if( stats->ticksPerNs <= 0.0 )
+    {
+    stats->ticksPerNs = 1.0;
+    }
+  }
+
+/*
+Name: getKeyPriority
+Process: recovers patient priority from the high bits of an ordering key
+Function input/parameters: ordering key (uint64_t)
+Function output/parameters: none
+Function output/returned: priority (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getKeyPriority( uint64_t key )
+  {
+  // remove the bias from the high bits
+  return (int)( (uint32_t)( key >> KEY_SEQUENCE_BITS ) ^ KEY_PRIORITY_BIAS );
+  }
+
+/*
+Name: getKeySequence
+Process: recovers the arrival sequence from the low bits of an ordering key
+Function input/parameters: ordering key (uint64_t)
+Function output/parameters: none
+Function output/returned: arrival sequence (uint32_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint32_t getKeySequence( uint64_t key )
+  {
+  // undo the inversion of the low bits
+  return KEY_SEQUENCE_MASK - (uint32_t)( key & KEY_SEQUENCE_MASK );
+  }
+
+/*
+Name: getLatencyBucket
+Process: finds the histogram bucket of a tick count, values below
+         LATENCY_SUB_BUCKETS get a bucket each, larger values keep their
+         top LATENCY_SUB_BUCKET_BITS bits below the leading one
+Function input/parameters: ticks (uint64_t)
+Function output/parameters: none
+Function output/returned: bucket index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: __builtin_clzll where available
+*/
+int getLatencyBucket( uint64_t ticks )
+  {
+  // variables
+  int leadingBit = 0, shift;
+
+  if( ticks < LATENCY_SUB_BUCKETS )
+    {
+    return (int)ticks;
+    }
+
+#if defined( __GNUC__ ) || defined( __clang__ )
+  leadingBit = 63 - __builtin_clzll( ticks );
+#else
+  while( ( ticks >> leadingBit ) > 1 )
+    {
+    leadingBit++;
+    }
+#endif
+
+  // the leading one and the sub bucket bits below it pick the bucket
+  shift = leadingBit - LATENCY_SUB_BUCKET_BITS;
+
+  return ( shift + 1 ) * LATENCY_SUB_BUCKETS 
+                 + (int)( ( ticks >> shift ) & ( LATENCY_SUB_BUCKETS - 1 ) );
+  }
+
+/*
+Name: getLatencyPercentile
+Process: walks a histogram to the bucket holding the given percentile
+Function input/parameters: histogram (const LatencyHistogramType *),
+                           percentile from 0 to 100 (double)
+Function output/parameters: none
+Function output/returned: lower bound of the bucket in ticks,
+                          zero if nothing was recorded (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint64_t getLatencyPercentile( const LatencyHistogramType *histogram,
+                                                          double percentile )
+  {
+  // variables
+  uint64_t target, seen = 0;
+  int bucket, shift;
+
+  if( histogram->count == 0 )
+    {
+    return 0;
+    }
+
+  target = (uint64_t)( histogram->count * percentile / 100.0 );
+
+  if( target >= histogram->count )
+    {
+    target = histogram->count - 1;
+    }
+
+  for( bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++ )
+    {
+    seen += histogram->counts[ bucket ];
+
+    if( seen > target )
+      {
+      break;
+      }
+    }
+
+  if( bucket < LATENCY_SUB_BUCKETS )
+    {
+    return (uint64_t)bucket;
+    }
+
+  // undo getLatencyBucket, the leading one is put back above the sub bits
+  shift = bucket / LATENCY_SUB_BUCKETS - 1;
+
+  return (uint64_t)( LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS )
+                                                                    << shift;
+  }
+
+/*
+Name: getPatientSlot
+Process: finds the patient slot of a handle, in the old block if an
+         incremental resize has not moved it yet
+Function input/parameters: heap data (const HeapType *), handle (int)
+Function output/parameters: none
+Function output/returned: patient slot (PatientSlotType *)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+PatientSlotType *getPatientSlot( const HeapType *heap, int handle )
+  {
+  // variables
+  HeapMigrationType *migration = heap->migration;
+
+  if( migration != NULL && handle >= migration->next
+                                                && handle < migration->end )
+    {
+    return &migration->slots[ handle ];
+    }
+
+  return &heap->slots[ handle ];
+  }
+
+/*
+Name: getSlotName
+Process: finds the name of a slot in the name arena, in the old arena
+         if an incremental resize has not moved it yet
+Function input/parameters: heap data (const HeapType *), handle (int)
+Function output/parameters: none
+Function output/returned: null terminated name (const char *)
+Device input/---: none
+Device output/---: none
+Dependencies: getPatientSlot
+*/
+const char *getSlotName( const HeapType *heap, int handle )
+  {
+  // variables
+  uint32_t offset = getPatientSlot( heap, handle )->nameOffset;
+
+  if( heap->migration != NULL && offset >= heap->migration->nextByte 
+                                         && offset < heap->migration->endByte )
+    {
+    return &heap->migration->nameArena[ offset ];
+    }
+
+  return &heap->nameArena[ offset ];
+  }
+
+/*
+Name: getSlotPosition
+Process: finds the position map entry of a handle, in the old block if
+         an incremental resize has not moved it yet
+Function input/parameters: heap data (const HeapType *), handle (int)
+Function output/parameters: none
+Function output/returned: heap index or level of the slot,
+                          INVALID_POSITION if not waiting (int *)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int *getSlotPosition( const HeapType *heap, int handle )
+  {
+  // variables
+  HeapMigrationType *migration = heap->migration;
+
+  if( migration != NULL && handle >= migration->next
+                                                && handle < migration->end )
+    {
+    return &migration->positions[ handle ];
+    }
+
+  return &heap->positions[ handle ];
+  }
+
+/*
+Name: getTopBucketLevel
+Process: finds the highest non-empty level of a bucket queue,
+         the leading set bit of the occupied bitmap
+Function input/parameters: bucket queue (const BucketQueueType *)
+Function output/parameters: none
+Function output/returned: level index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getTopBucketLevel( const BucketQueueType *queue )
+  {
+  // variables
+  int level = 0;
+
+#if defined( __GNUC__ ) || defined( __clang__ )
+  level = 63 - __builtin_clzll( queue->occupied );
+#else
+  while( ( queue->occupied >> level ) > 1 )
+    {
+    level++;
+    }
+#endif
+
+  return level;
+  }
+
+/*
+Name: getTopHeapEntry
+Process: reads the entry removeItem would take next without removing it,
+         the oldest entry of the highest level of a bucket queue, 
+         otherwise the root of the array heap, heap must not be empty
+Function input/parameters: heap data (const HeapType *)
+Function output/parameters: none
+Function output/returned: top entry (HeapEntryType)
+Device input/---: none
+Device output/---: none
+Dependencies: getTopBucketLevel, getHeapEntry
+*/
+HeapEntryType getTopHeapEntry( const HeapType *heap )
+  {
+  // variables
+  const PriorityBucketType *bucket;
+
+  if( heap->bucketQueue != NULL )
+    {
+    bucket = &heap->bucketQueue->levels[ 
+                                   getTopBucketLevel( heap->bucketQueue ) ];
+
+    return bucket->entries[ bucket->head ];
+    }
+
+  return *getHeapEntry( heap, 0 );
+  }
+
+/*
+Name: growBucketRing
+Process: doubles a level ring until it holds the needed number of 
+         entries, unwraps the waiting entries to the front of the new 
+         ring, counts the resize and the entries copied
+Function input/parameters: heap data (HeapType *), 
+                           level ring (PriorityBucketType *),
+                           entries needed (int)
+Function output/parameters: updated heap data (HeapType *),
+                            updated level ring (PriorityBucketType *)
+Function output/returned: Boolean result, false if memory ran out 
+                          and the ring is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, free
+*/
+bool growBucketRing( HeapType *heap, PriorityBucketType *bucket, 
+                                                                  int needed )
+  {
+  // variables
+  HeapEntryType *newEntries;
+  int offset, capacity = bucket->mask + 1, newCapacity = capacity;
+
+  if( needed <= capacity )
+    {
+    return true;
+    }
+
+  while( newCapacity < needed )
+    {
+    newCapacity *= 2;
+    }
+
+  newEntries = ( HeapEntryType *)malloc( 
+                               (size_t)newCapacity * sizeof( HeapEntryType ) );
+
+  if( newEntries == NULL )
+    {
+    return false;
+    }
+
+  // unwrap the ring into the front of the new one
+  for( offset = 0; offset < bucket->count; offset++ )
+    {
+    newEntries[ offset ] 
+                  = bucket->entries[ ( bucket->head + offset ) & bucket->mask ];
+    }
+
+  free( bucket->entries );
+
+  bucket->entries = newEntries;
+  bucket->head = 0;
+  bucket->mask = newCapacity - 1;
+
+  heap->counters.resizes++;
+  heap->counters.bytesCopied += (uint64_t)bucket->count 
+                                                    * sizeof( HeapEntryType );
+
+  return true;
+  }
+
+/*
+Name: growHeap
+Process: grows the heap by its growth factor to hold at least the
+         needed count, in incremental mode moves to new blocks a step
+         at a time instead of resizing at once, an incremental resize
+         still under way is finished first, which only happens when
+         adds outrun its steps, resizes at once if the new blocks
+         cannot be allocated
+Function input/parameters: heap data (HeapType *), entries needed (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the capacity is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getGrownCapacity, finishHeapMigration, beginHeapMigration,
+              resizeHeap
+*/
+bool growHeap( HeapType *heap, int needed )
+  {
+  // variables
+  int newCapacity = getGrownCapacity( heap, needed );
+
+  if( heap->incrementalFlag )
+    {
+    if( heap->migration != NULL && heap->migration->array != NULL )
+      {
+      finishHeapMigration( heap );
+      }
+
+    if( beginHeapMigration( heap, newCapacity ) )
+      {
+      return true;
+      }
+    }
+
+  return resizeHeap( heap, newCapacity );
+  }
+
+/*
+Name: hashPatientName
+Process: hashes a patient name for the name index (FNV-1a)
+Function input/parameters: patient name (const char *)
+Function output/parameters: none
+Function output/returned: hash value (uint32_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint32_t hashPatientName( const char *name )
+  {
+  // variables
+  uint32_t hash = 2166136261u;
+  int index = 0;
+
+  while( name[ index ] != NULL_CHAR )
+    {
+    hash ^= (unsigned char)name[ index ];
+    hash *= 16777619u;
+
+    index++;
+    }
+
+  return hash;
+  }
+
+/*
+Name: heapifyArrayHeap
+Process: restores heap order over the whole array bottom up (Floyd),
+         trickles down every parent from the last one to the root,
+         runs in linear time, finishes any incremental resize first
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: finishHeapMigration, trickleDownArrayHeap
+*/
+void heapifyArrayHeap( HeapType *heap )
+  {
+  // variables
+  int index;
+
+  // every parent is visited, so the array is whole again first
+  finishHeapMigration( heap );
+
+  // leaves already satisfy heap order, start at the last parent
+  for( index = ( heap->size - 2 ) / heap->arity; 
+                                          heap->size > 1 && index >= 0; index-- )
+    {
+    trickleDownArrayHeap( heap, index );
+    }
+  }
+
+/*
+Name: initializeBucketHeap
+Process: initializes heap as with initializeHeap, but keeps waiting 
+         patients in a bucket queue, one FIFO ring per priority from 
+         lowest to highest and a bitmap of non-empty levels, adds and 
+         removes are constant time and leave the heap array unused,
+         the range holds at most MAX_BUCKET_LEVELS priorities,
+         not for file backed heaps, if memory runs out the heap is 
+         left as an array heap
+Function input/parameters: heap data (HeapType *), initial capacity (int),
+                           lowest and highest priority (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          for the bucket queue (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: initializeHeap, malloc, calloc, free
+*/
+bool initializeBucketHeap( HeapType *heapPtr, int initialCapacity, 
+                                    int lowestPriority, int highestPriority )
+  {
+  // variables
+  BucketQueueType *queue;
+  int level;
+
+  initializeHeap( heapPtr, initialCapacity );
+
+  // keep the range within one bit per level
+  if( highestPriority < lowestPriority )
+    {
+    highestPriority = lowestPriority;
+    }
+
+  else if( highestPriority - lowestPriority >= MAX_BUCKET_LEVELS )
+    {
+    highestPriority = lowestPriority + MAX_BUCKET_LEVELS - 1;
+    }
+
+  queue = ( BucketQueueType *)malloc( sizeof( BucketQueueType ) );
+
+  if( queue == NULL )
+    {
+    return false;
+    }
+
+  queue->lowestPriority = lowestPriority;
+  queue->levelCount = highestPriority - lowestPriority + 1;
+  queue->occupied = 0;
+
+  // zeroed so a partly built queue frees only the rings it has
+  queue->levels = ( PriorityBucketType *)calloc( queue->levelCount, 
+                                                sizeof( PriorityBucketType ) );
+
+  for( level = 0; queue->levels != NULL && level < queue->levelCount; 
+                                                                     level++ )
+    {
+    queue->levels[ level ].entries = ( HeapEntryType *)malloc( 
+                              MIN_BUCKET_CAPACITY * sizeof( HeapEntryType ) );
+    queue->levels[ level ].head = 0;
+    queue->levels[ level ].count = 0;
+    queue->levels[ level ].mask = MIN_BUCKET_CAPACITY - 1;
+
+    if( queue->levels[ level ].entries == NULL )
+      {
+      while( level > 0 )
+        {
+        level--;
+
+        free( queue->levels[ level ].entries );
+        }
+
+      free( queue->levels );
+
+      queue->levels = NULL;
+      }
+    }
+
+  if( queue->levels == NULL )
+    {
+    free( queue );
+
+    return false;
+    }
+
+  heapPtr->bucketQueue = queue;
+
+  return true;
+  }
+
+/*
+Name: initializeHeap
+Process: initializes heap, creates heap and slot arrays from given capacity,
+         uses the default arity, sets other heap members appropriately,
+         display flag is set to false
+Function input/parameters: heap data (HeapType *), initial capacity (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: initializeHeapWithArity
+*/
+void initializeHeap( HeapType *heapPtr, int initialCapacity )
+  {
+  // use the build time arity
+  initializeHeapWithArity( heapPtr, initialCapacity, DEFAULT_HEAP_ARITY );
+  }
+
+/*
+Name: initializeHeapWithArity
+Process: initializes heap as with initializeHeap, 
+         but with the given number of children per node,
+         arity is kept between the minimum and maximum supported
+Function input/parameters: heap data (HeapType *), initial capacity (int),
+                           children per node (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: allocateHeapArray, malloc, sizeof, setDisplayFlag,
+              resetHeapStats
+*/
+void initializeHeapWithArity( HeapType *heapPtr, 
+                                         int initialCapacity, int arity )
+  {
+  // keep arity within the supported range
+  if( arity < MIN_HEAP_ARITY )
+    {
+    arity = MIN_HEAP_ARITY;
+    }
+
+  else if( arity > MAX_HEAP_ARITY )
+    {
+    arity = MAX_HEAP_ARITY;
+    }
+
+  // set the other heap memebers appropriatly
+  heapPtr->size = 0;
+  heapPtr->capacity = initialCapacity;
+  heapPtr->arity = arity;
+  heapPtr->growthFactor = DEFAULT_GROWTH_FACTOR;
+  heapPtr->minCapacity = initialCapacity;
+  heapPtr->shrinkSize = (int)( initialCapacity 
+                        / ( DEFAULT_GROWTH_FACTOR * DEFAULT_GROWTH_FACTOR ) );
+  heapPtr->slotCount = 0;
+  heapPtr->freeCount = 0;
+  heapPtr->nextSequence = 0;
+
+  // nothing is traced until asked for
+  heapPtr->trace = NULL;
+
+  // array heap unless initializeBucketHeap asks for level rings
+  heapPtr->bucketQueue = NULL;
+
+  // resizes copy at once until setIncrementalResize
+  heapPtr->migration = NULL;
+  heapPtr->incrementalFlag = false;
+  heapPtr->childSelect = CHILD_SELECT_SCALAR;
+  
+  // set display flag to false with function	
+  setDisplayFlag( heapPtr, false );
+  
+  // allocate memory of arrays
+  heapPtr->array = allocateHeapArray( initialCapacity, arity, 
+                                                   &heapPtr->arrayBlock );
+  heapPtr->slots = ( PatientSlotType *)malloc( 
+               initialCapacity * sizeof( PatientSlotType ) );
+  heapPtr->freeSlots = ( int *)malloc( initialCapacity * sizeof( int ) );
+  heapPtr->positions = ( int *)malloc( initialCapacity * sizeof( int ) );
+
+  // name arena is allocated on the first name
+  heapPtr->nameArena = NULL;
+  heapPtr->arenaSize = 0;
+  heapPtr->arenaCapacity = 0;
+  heapPtr->arenaLiveBytes = 0;
+
+  // name index stays off until requested
+  heapPtr->nameBuckets = NULL;
+  heapPtr->nameBucketCount = 0;
+  heapPtr->nameCount = 0;
+
+  // heap memory is not file backed unless opened with openHeapFile
+  heapPtr->fileHeader = NULL;
+  heapPtr->mapLength = 0;
+  heapPtr->fileDescriptor = -1;
+
+  // counters start at zero, histograms live in their own block
+  heapPtr->latency = ( HeapLatencyType *)malloc( sizeof( HeapLatencyType ) );
+
+  resetHeapStats( heapPtr );
+  }
+
+/*
+Name: insertNameIndex
+Process: adds the name held in a slot to the name index, 
+         doubles the bucket table first if it would pass half full
+Function input/parameters: heap data (HeapType *), handle (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the name was not indexed (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: reserveNameIndex, hashPatientName
+*/
+bool insertNameIndex( HeapType *heap, int handle )
+  {
+  // variables
+  int mask, bucket;
+
+  if( !reserveNameIndex( heap, 1 ) )
+    {
+    return false;
+    }
+
+  mask = heap->nameBucketCount - 1;
+  bucket = (int)( hashPatientName( getSlotName( heap, handle ) ) 
+                                                          & (uint32_t)mask );
+
+  // linear probe to the first empty bucket
+  while( heap->nameBuckets[ bucket ] != EMPTY_BUCKET )
+    {
+    bucket = ( bucket + 1 ) & mask;
+    }
+
+  heap->nameBuckets[ bucket ] = handle;
+  heap->nameCount++;
+
+  return true;
+  }
+
+/*
+Name: isEmpty
+Process: reports if heap is empty
+Function input/parameters: heap data (const HeapType)
+Function output/parameters: none
+Function output/returned: Boolean result of test (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+bool isEmpty( const HeapType heap )
+  {
+  // return if the heap tree is empty	
+  return heap.size == 0;
+  }
+
+/*
+Name: makeHeapKey
+Process: packs priority and arrival sequence into one ordering key,
+         a larger key is always served first, so heap comparisons are
+         a single unsigned compare with strict first in first out order 
+         within a priority
+Function input/parameters: priority (int), arrival sequence (uint32_t)
+Function output/parameters: none
+Function output/returned: ordering key (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint64_t makeHeapKey( int priority, uint32_t sequence )
+  {
+  // bias priority so signed order matches unsigned order,
+  // invert sequence so earlier arrivals have the larger key
+  return ( (uint64_t)( (uint32_t)priority ^ KEY_PRIORITY_BIAS ) 
+                                                      << KEY_SEQUENCE_BITS )
+         | (uint64_t)( KEY_SEQUENCE_MASK - sequence );
+  }
+
+/*
+Name: mapHeapRegions
+Process: points the heap, slot, free slot, position, and name arrays at 
+         their regions of the mapped file using the header offsets
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+void mapHeapRegions( HeapType *heap )
+  {
+  // variables
+  char *base = ( char *)heap->fileHeader;
+
+  // same pad as allocateHeapArray, region start is cache line aligned
+  heap->array = (HeapEntryType *)( base + heap->fileHeader->arrayOffset ) 
+                                                         + ( heap->arity - 1 );
+  heap->slots = (PatientSlotType *)( base + heap->fileHeader->slotsOffset );
+  heap->freeSlots = (int *)( base + heap->fileHeader->freeSlotsOffset );
+  heap->positions = (int *)( base + heap->fileHeader->positionsOffset );
+  heap->nameArena = base + heap->fileHeader->arenaOffset;
+  heap->arrayBlock = NULL;
+  }
+
+/*
+Name: mergeBucketLevels
+Process: merges runs of entries ordered by key, larger first, into the
+         level rings of a bucket queue, each level's ring and run are
+         merged in one pass into the new ring set aside for that level,
+         which replaces the old ring, records each level in the position
+         map
+Function input/parameters: heap data (HeapType *),
+                           entries ordered by key (const HeapEntryType *),
+                           entry count (int),
+                           new ring for each level given entries
+                           (HeapEntryType **)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: getBucketLevel, getKeyPriority, getSlotPosition, free
+*/
+void mergeBucketLevels( HeapType *heap, const HeapEntryType *entries,
+                                          int count, HeapEntryType **newRings )
+  {
+  // variables
+  BucketQueueType *queue = heap->bucketQueue;
+  PriorityBucketType *bucket;
+  HeapEntryType *ring, *older;
+  int level, start = 0, end, index, fromRing, merged, capacity;
+
+  while( start < count )
+    {
+    level = getBucketLevel( queue, getKeyPriority( entries[ start ].key ) );
+    bucket = &queue->levels[ level ];
+    ring = newRings[ level ];
+
+    // a higher key never maps to a lower level, so the run is contiguous
+    for( end = start; end < count 
+            && getBucketLevel( queue, getKeyPriority( entries[ end ].key ) )
+                                                         == level; end++ )
+      {
+      *getSlotPosition( heap, entries[ end ].handle ) = level;
+      }
+
+    fromRing = 0;
+    index = start;
+
+    for( merged = 0; fromRing < bucket->count || index < end; merged++ )
+      {
+      older = fromRing < bucket->count 
+             ? &bucket->entries[ ( bucket->head + fromRing ) & bucket->mask ]
+                                                                       : NULL;
+
+      // the entry already waiting wins a tie
+      if( older != NULL && ( index == end 
+                                    || older->key >= entries[ index ].key ) )
+        {
+        ring[ merged ] = *older;
+
+        fromRing++;
+        }
+
+      else
+        {
+        ring[ merged ] = entries[ index ];
+
+        index++;
+        }
+
+      heap->counters.comparisons++;
+      heap->counters.moves++;
+      }
+
+    capacity = bucket->mask + 1;
+
+    heap->counters.resizes++;
+    heap->counters.bytesCopied 
+                      += (uint64_t)bucket->count * sizeof( HeapEntryType );
+
+    // the new ring is sized for the merged level, a power of two
+    while( capacity < merged )
+      {
+      capacity *= 2;
+      }
+
+    free( bucket->entries );
+
+    bucket->entries = ring;
+    bucket->head = 0;
+    bucket->count = merged;
+    bucket->mask = capacity - 1;
+
+    queue->occupied |= (uint64_t)1 << level;
+
+    start = end;
+    }
+  }
+
+/*
+Name: mergeHeaps
+Process: moves every waiting patient of the source heap into the
+         destination heap and leaves the source empty, sizes the arrays
+         once, copies each patient into a destination slot keeping its
+         ordering key, if the source is at least as large as the
+         destination the whole array is heapified bottom up in linear
+         time, otherwise each moved entry is bubbled up, a bucket queue
+         destination instead gathers the source entries in key order
+         and merges each level's ring with its run in one pass,
+         heaps that share one arrival sequence merge in arrival order,
+         a source under incremental resize finishes it first, each moved
+         patient pays one step of the destination's,
+         optionally returns the new handle of each moved patient
+Function input/parameters: destination heap (HeapType *),
+                           source heap (HeapType *)
+Function output/parameters: updated destination heap (HeapType *),
+                            empty source heap (HeapType *),
+                            new handles indexed by source handle,
+                            may be NULL (int *)
+Function output/returned: Boolean result, false if memory ran out,
+                          both heaps unchanged (bool)
+Device input/---: none
+Device output/monitor: merge action displayed as specified
+Dependencies: printf, finishHeapMigration, growHeap, reserveArenaBytes,
+              reserveNameIndex, traceHeapOperation, advanceHeapMigration, 
+              storePatientInSlot, getSlotName, releaseSlot, gatherHeapEntries,
+              reserveBucketLevels, mergeBucketLevels, setHeapEntry,
+              heapifyArrayHeap, bubbleUpArrayHeap, storeHeapFileCounters,
+              showHeapTrace, malloc, free
+*/
+bool mergeHeaps( HeapType *dest, HeapType *src, int *handles )
+  {
+  // variables
+  int index, handle, level, slot, count = src->size, levelCount = 1;
+  int oldSize = dest->size, moved = 0;
+  HeapEntryType *entries, entry, *sorted = NULL, **newRings = NULL;
+  PriorityBucketType *bucket = NULL;
+
+  if( dest == src || src->size == 0 )
+    {
+    return true;
+    }
+
+  // the source is read straight from its arrays
+  finishHeapMigration( src );
+
+  entries = src->array;
+
+  // display process
+  if( dest->displayFlag )
+    {
+    printf( "\nMerging %d patients\n\n", src->size );
+    }
+
+  // a bucket queue destination takes the source in key order, with
+  // every level's new ring set aside before anything moves
+  if( dest->bucketQueue != NULL )
+    {
+    sorted = gatherHeapEntries( src );
+
+    if( sorted != NULL )
+      {
+      newRings = reserveBucketLevels( dest, sorted, src->size );
+      }
+
+    if( newRings == NULL )
+      {
+      free( sorted );
+
+      return false;
+      }
+
+    entries = sorted;
+    }
+
+  // size the arrays and the name arena once for the whole source
+  if( ( oldSize + src->size > dest->capacity 
+                                   && !growHeap( dest, oldSize + src->size ) )
+      || !reserveArenaBytes( dest, src->arenaLiveBytes )
+      || !reserveNameIndex( dest, src->size ) )
+    {
+    if( newRings != NULL )
+      {
+      for( level = 0; level < dest->bucketQueue->levelCount; level++ )
+        {
+        free( newRings[ level ] );
+        }
+      }
+
+    free( newRings );
+    free( sorted );
+
+    return false;
+    }
+
+  if( dest->trace != NULL )
+    {
+    traceHeapOperation( dest, TRACE_BULK_ADD, INVALID_HANDLE,
+                                              (uint64_t)src->size, 0, NULL );
+    }
+
+  // later arrivals in the destination stay behind every moved patient
+  if( src->nextSequence > dest->nextSequence )
+    {
+    dest->nextSequence = src->nextSequence;
+    }
+
+  // a bucket queue source keeps its entries in one ring per level,
+  // unless they were already gathered
+  if( src->bucketQueue != NULL && sorted == NULL )
+    {
+    levelCount = src->bucketQueue->levelCount;
+    }
+
+  for( level = 0; level < levelCount; level++ )
+    {
+    if( src->bucketQueue != NULL && sorted == NULL )
+      {
+      bucket = &src->bucketQueue->levels[ level ];
+      entries = bucket->entries;
+      count = bucket->count;
+      }
+
+    for( index = 0; index < count; index++ )
+      {
+      slot = bucket != NULL ? ( bucket->head + index ) & bucket->mask 
+                                                                   : index;
+      entry = entries[ slot ];
+
+      advanceHeapMigration( dest, 1 );
+
+      handle = storePatientInSlot( dest, getSlotName( src, entry.handle ),
+                                          src->slots[ entry.handle ].timeIn );
+
+      if( dest->trace != NULL )
+        {
+        traceHeapOperation( dest, TRACE_BULK_PATIENT, handle, entry.key,
+                          (uint64_t)src->slots[ entry.handle ].timeIn,
+                                          getSlotName( src, entry.handle ) );
+        }
+
+      if( handles != NULL )
+        {
+        handles[ entry.handle ] = handle;
+        }
+
+      releaseSlot( src, entry.handle );
+
+      entry.handle = handle;
+
+      // gathered entries keep their order and take their new handles
+      if( sorted != NULL )
+        {
+        sorted[ index ] = entry;
+        }
+
+      else
+        {
+        setHeapEntry( dest, oldSize + moved, entry );
+        }
+
+      moved++;
+      }
+    }
+
+  src->size = 0;
+
+  if( src->bucketQueue != NULL )
+    {
+    for( level = 0; level < src->bucketQueue->levelCount; level++ )
+      {
+      src->bucketQueue->levels[ level ].head = 0;
+      src->bucketQueue->levels[ level ].count = 0;
+      }
+
+    src->bucketQueue->occupied = 0;
+    }
+
+  // each level's ring and run merge in one pass
+  if( dest->bucketQueue != NULL )
+    {
+    mergeBucketLevels( dest, sorted, moved, newRings );
+
+    free( newRings );
+    free( sorted );
+
+    dest->size = oldSize + moved;
+    }
+
+  // source as large as the destination, rebuild in linear time
+  else if( moved >= oldSize )
+    {
+    dest->size = oldSize + moved;
+
+    heapifyArrayHeap( dest );
+    }
+
+  // small source into a large heap, bubble each moved entry up
+  else
+    {
+    for( index = 0; index < moved; index++ )
+      {
+      bubbleUpArrayHeap( dest, dest->size );
+
+      dest->size++;
+      }
+    }
+
+  storeHeapFileCounters( src );
+  storeHeapFileCounters( dest );
+
+  if( dest->displayFlag )
+    {
+    showHeapTrace( dest );
+    }
+
+  return true;
+  }
+
+/*
+Name: nextHeapTraceEvent
+Process: claims the next trace event, in display mode a full ring is
+         printed first so no step is overwritten before it is shown
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: slot for the next event (HeapTraceEventType *)
+Device input/---: none
+Device output/monitor: sift steps displayed as specified
+Dependencies: atomic_load_explicit, showHeapTrace, claimTraceEvent
+*/
+HeapTraceEventType *nextHeapTraceEvent( HeapType *heap )
+  {
+  // variables
+  HeapTraceType *trace = heap->trace;
+  uint64_t head = atomic_load_explicit( &trace->head, memory_order_relaxed );
+
+  if( heap->displayFlag && head - trace->displayCursor > trace->mask )
+    {
+    showHeapTrace( heap );
+    }
+
+  return claimTraceEvent( trace );
+  }
+
+/*
+Name: openHeapFile
+Process: backs the heap with a memory mapped file, an existing file is
+         mapped and its header checked without reading any entries,
+         a missing or empty file is created with the given capacity and 
+         arity, heap memory then lives in the file and survives restarts
+Function input/parameters: heap data (HeapType *), file name (const char *),
+                           initial capacity and arity for a new file (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the file cannot be 
+                          opened, mapped, or fails validation (bool)
+Device input/---: heap file
+Device output/---: heap file
+Dependencies: open, fstat, ftruncate, mmap, munmap, close, 
+              setHeapFileLayout, validateHeapFile, initializeHeapWithArity,
+              mapHeapRegions
+*/
+bool openHeapFile( HeapType *heap, const char *fileName, 
+                                         int initialCapacity, int arity )
+  {
+#ifdef HEAP_FILE_SUPPORT
+  // variables
+  HeapFileHeaderType layout, *header;
+  struct stat fileStatus;
+  size_t mapLength;
+  int fileDescriptor;
+  void *mapping;
+
+  fileDescriptor = open( fileName, O_RDWR | O_CREAT, 0644 );
+
+  if( fileDescriptor < 0 || fstat( fileDescriptor, &fileStatus ) != 0 )
+    {
+    if( fileDescriptor >= 0 )
+      {
+      close( fileDescriptor );
+      }
+
+    return false;
+    }
+
+  // keep arity within the supported range
+  if( arity < MIN_HEAP_ARITY )
+    {
+    arity = MIN_HEAP_ARITY;
+    }
+
+  else if( arity > MAX_HEAP_ARITY )
+    {
+    arity = MAX_HEAP_ARITY;
+    }
+
+  // a new file holds an empty heap of the initial capacity
+  if( fileStatus.st_size == 0 )
+    {
+    setHeapFileLayout( &layout, initialCapacity, arity, 0 );
+
+    mapLength = (size_t)layout.fileLength;
+
+    if( ftruncate( fileDescriptor, (off_t)mapLength ) != 0 )
+      {
+      close( fileDescriptor );
+
+      return false;
+      }
+    }
+
+  else
+    {
+    mapLength = (size_t)fileStatus.st_size;
+    }
+
+  mapping = mmap( NULL, mapLength, PROT_READ | PROT_WRITE, MAP_SHARED, 
+                                                         fileDescriptor, 0 );
+
+  if( mapping == MAP_FAILED )
+    {
+    close( fileDescriptor );
+
+    return false;
+    }
+
+  header = ( HeapFileHeaderType *)mapping;
+
+  if( fileStatus.st_size == 0 )
+    {
+    *header = layout;
+    }
+
+  // only the header is read, restart cost does not grow with the heap
+  else if( mapLength < sizeof( HeapFileHeaderType ) 
+                                  || !validateHeapFile( header, mapLength ) )
+    {
+    munmap( mapping, mapLength );
+
+    close( fileDescriptor );
+
+    return false;
+    }
+
+  // start from an empty heap, then adopt the file's counters and regions
+  initializeHeapWithArity( heap, 0, header->arity );
+
+  free( heap->arrayBlock );
+  free( heap->slots );
+  free( heap->freeSlots );
+  free( heap->positions );
+
+  heap->fileHeader = header;
+  heap->mapLength = mapLength;
+  heap->fileDescriptor = fileDescriptor;
+
+  heap->capacity = header->capacity;
+  heap->size = header->size;
+  heap->slotCount = header->slotCount;
+  heap->freeCount = header->freeCount;
+  heap->nextSequence = header->nextSequence;
+  heap->arenaSize = header->arenaSize;
+  heap->arenaCapacity = header->arenaCapacity;
+  heap->arenaLiveBytes = header->arenaLiveBytes;
+
+  mapHeapRegions( heap );
+
+  return true;
+#else
+  // no memory mapping on this platform
+  ( void )heap;
+  ( void )fileName;
+  ( void )initialCapacity;
+  ( void )arity;
+
+  return false;
+#endif
+  }
+
+/*
+Name: popBucketEntry
+Process: takes the oldest entry of the highest non-empty level
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: removed entry (HeapEntryType)
+Device input/---: none
+Device output/---: none
+Dependencies: getTopBucketLevel
+*/
+HeapEntryType popBucketEntry( HeapType *heap )
+  {
+  // variables
+  BucketQueueType *queue = heap->bucketQueue;
+  PriorityBucketType *bucket;
+  HeapEntryType entry;
+  int level = getTopBucketLevel( queue );
+
+  bucket = &queue->levels[ level ];
+  entry = bucket->entries[ bucket->head ];
+
+  bucket->head = ( bucket->head + 1 ) & bucket->mask;
+  bucket->count--;
+
+  if( bucket->count == 0 )
+    {
+    queue->occupied &= ~( (uint64_t)1 << level );
+    }
+
+  return entry;
+  }
+
+/*
+Name: prefetchHeapLevel
+Process: hints the processor to load the block of grandchildren below
+         a node, so the next trickle down level is already in cache,
+         does nothing on compilers without a prefetch builtin
+Function input/parameters: heap data (const HeapType *), node index (int)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: __builtin_prefetch where available, getHeapEntry
+*/
+void prefetchHeapLevel( const HeapType *heap, int nodeIndex )
+  {
+  // variables
+  int firstGrandchildIndex = nodeIndex * heap->arity + 1;
+  int endIndex = firstGrandchildIndex + heap->arity * heap->arity;
+  int entriesPerLine = CACHE_LINE_SIZE / (int)sizeof( HeapEntryType );
+  int index;
+
+  // protect against going off the end of the array
+  if( endIndex > heap->size )
+    {
+    endIndex = heap->size;
+    }
+
+  // touch each cache line of the grandchild blocks once
+  for( index = firstGrandchildIndex; index < endIndex; 
+                                                  index += entriesPerLine )
+    {
+    HEAP_PREFETCH( getHeapEntry( heap, index ) );
+    }
+  }
+
+/*
+Name: pushBucketEntry
+Process: appends an entry to the ring of its priority level, doubling
+         the ring when full, an entry older than the back of the ring,
+         replayed or given a new priority, is shifted into key order,
+         records the level in the position map
+Function input/parameters: heap data (HeapType *), entry (HeapEntryType)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the entry was not added (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getBucketLevel, getKeyPriority, growBucketRing, 
+              getSlotPosition
+*/
+bool pushBucketEntry( HeapType *heap, HeapEntryType entry )
+  {
+  // variables
+  BucketQueueType *queue = heap->bucketQueue;
+  int level = getBucketLevel( queue, getKeyPriority( entry.key ) );
+  PriorityBucketType *bucket = &queue->levels[ level ];
+  int offset;
+
+  // full ring, unwrap it into one twice the size
+  if( !growBucketRing( heap, bucket, bucket->count + 1 ) )
+    {
+    return false;
+    }
+
+  // later arrivals have lower keys and stop at the back at once
+  offset = bucket->count;
+
+  while( offset > 0 && bucket->entries[ ( bucket->head + offset - 1 ) 
+                                             & bucket->mask ].key < entry.key )
+    {
+    bucket->entries[ ( bucket->head + offset ) & bucket->mask ]
+             = bucket->entries[ ( bucket->head + offset - 1 ) & bucket->mask ];
+
+    offset--;
+
+    heap->counters.comparisons++;
+    heap->counters.moves++;
+    }
+
+  bucket->entries[ ( bucket->head + offset ) & bucket->mask ] = entry;
+  bucket->count++;
+
+  queue->occupied |= (uint64_t)1 << level;
+
+  *getSlotPosition( heap, entry.handle ) = level;
+
+  heap->counters.comparisons++;
+  heap->counters.moves++;
+
+  return true;
+  }
+
+/*
+Name: readHeapNanoseconds
+Process: reads the wall clock in nanoseconds for tick calibration
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: nanoseconds (double)
+Device input/---: none
+Device output/---: none
+Dependencies: timespec_get
+*/
+double readHeapNanoseconds( void )
+  {
+  // variables
+  struct timespec now;
+
+  timespec_get( &now, TIME_UTC );
+
+  return now.tv_sec * 1e9 + now.tv_nsec;
+  }
+
+/*
+Name: readHeapTicks
+Process: reads the latency counter, the time stamp counter where there
+         is one, otherwise the clock in nanoseconds, zero when latency
+         statistics are compiled out
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: counter ticks (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: __rdtsc or readHeapNanoseconds
+*/
+uint64_t readHeapTicks( void )
+  {
+#if !HEAP_LATENCY_STATS
+  return 0;
+#elif defined( HEAP_TICK_COUNTER )
+  return __rdtsc();
+#else
+  return (uint64_t)readHeapNanoseconds();
+#endif
+  }
+
+/*
+Name: reallocateHeapArray
+Process: resizes the heap array block in place where the allocator can,
+         large blocks are remapped by the allocator rather than copied,
+         if the block moved to a different offset from a cache line the
+         entries are shifted back onto the boundary in one move,
+         counts any bytes copied
+Function input/parameters: heap data (HeapType *), new capacity (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the block is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc, memmove
+*/
+bool reallocateHeapArray( HeapType *heap, int newCapacity )
+  {
+  // variables
+  size_t padEntries = (size_t)( heap->arity - 1 ), oldOffset, liveBytes;
+  char *block;
+  uintptr_t address;
+
+  oldOffset = (size_t)( ( char *)( heap->array - padEntries ) 
+                                              - ( char *)heap->arrayBlock );
+  liveBytes = heap->bucketQueue == NULL 
+                            ? (size_t)heap->size * sizeof( HeapEntryType ) : 0;
+
+  block = ( char *)realloc( heap->arrayBlock, ( (size_t)newCapacity 
+                      + padEntries ) * sizeof( HeapEntryType ) + CACHE_LINE_SIZE );
+
+  if( block == NULL )
+    {
+    return false;
+    }
+
+  if( block != heap->arrayBlock )
+    {
+    heap->counters.bytesCopied += liveBytes;
+    }
+
+  address = ( (uintptr_t)block + CACHE_LINE_SIZE - 1 ) 
+                                     & ~(uintptr_t)( CACHE_LINE_SIZE - 1 );
+
+  // the allocator keeps bytes, not alignment, line the entries up again
+  if( address - (uintptr_t)block != oldOffset )
+    {
+    memmove( (HeapEntryType *)address + padEntries, 
+                   block + oldOffset + padEntries * sizeof( HeapEntryType ),
+                                                                  liveBytes );
+
+    heap->counters.bytesCopied += liveBytes;
+    }
+
+  heap->arrayBlock = block;
+  heap->array = (HeapEntryType *)address + padEntries;
+
+  return true;
+  }
+
+/*
+Name: reallocateHeapRegion
+Process: resizes one slot, free slot, or position block in place where
+         the allocator can, counts the live bytes if the block moved
+Function input/parameters: heap data (HeapType *), block (void *),
+                           new size in bytes (size_t), 
+                           bytes in use (size_t)
+Function output/parameters: updated copy counter (HeapType *)
+Function output/returned: resized block, NULL if memory ran out
+                          and the block is unchanged (void *)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc
+*/
+void *reallocateHeapRegion( HeapType *heap, void *block, size_t newBytes,
+                                                            size_t liveBytes )
+  {
+  // variables
+  void *newBlock = realloc( block, newBytes );
+
+  if( newBlock != NULL && newBlock != block )
+    {
+    heap->counters.bytesCopied += liveBytes;
+    }
+
+  return newBlock;
+  }
+
+/*
+Name: rebaseHeapSequences
+Process: shifts arrival sequences of all entries down by the oldest
+         sequence still in the heap, keeps relative order of all keys,
+         used when the sequence counter runs out, finishes any
+         incremental resize first as every entry is visited
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: finishHeapMigration, makeHeapKey, getKeyPriority, 
+              getKeySequence
+*/
+void rebaseHeapSequences( HeapType *heap )
+  {
+  // variables
+  uint32_t oldestSequence = heap->nextSequence, sequence;
+  int index, level, slot, pass, count = heap->size, levelCount = 1;
+  HeapEntryType *entries = heap->array;
+  PriorityBucketType *bucket = NULL;
+
+  finishHeapMigration( heap );
+
+  // a bucket queue keeps its entries in one ring per level
+  if( heap->bucketQueue != NULL )
+    {
+    levelCount = heap->bucketQueue->levelCount;
+    }
+
+  // first pass finds the oldest sequence still waiting, the second
+  // shifts every sequence down, relative order and heap shape are unchanged
+  for( pass = 0; pass < 2; pass++ )
+    {
+    for( level = 0; level < levelCount; level++ )
+      {
+      if( heap->bucketQueue != NULL )
+        {
+        bucket = &heap->bucketQueue->levels[ level ];
+        entries = bucket->entries;
+        count = bucket->count;
+        }
+
+      for( index = 0; index < count; index++ )
+        {
+        slot = bucket != NULL ? ( bucket->head + index ) & bucket->mask 
+                                                                     : index;
+        sequence = getKeySequence( entries[ slot ].key );
+
+        if( pass == 0 && sequence < oldestSequence )
+          {
+          oldestSequence = sequence;
+          }
+
+        else if( pass == 1 )
+          {
+          entries[ slot ].key = makeHeapKey( 
+                                       getKeyPriority( entries[ slot ].key ),
+                                                 sequence - oldestSequence );
+          }
+        }
+      }
+    }
+
+  heap->nextSequence -= oldestSequence;
+  }
+
+/*
+Name: recordLatency
+Process: adds one sampled operation's elapsed ticks to a histogram
+Function input/parameters: histogram (LatencyHistogramType *),
+                           start ticks (uint64_t)
+Function output/parameters: updated histogram (LatencyHistogramType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: readHeapTicks, getLatencyBucket
+*/
+void recordLatency( LatencyHistogramType *histogram, uint64_t startTicks )
+  {
+#if HEAP_LATENCY_STATS
+  // variables
+  uint64_t ticks = readHeapTicks() - startTicks;
+
+  histogram->counts[ getLatencyBucket( ticks ) ]++;
+  histogram->count++;
+  histogram->totalTicks += ticks;
+
+  if( ticks > histogram->maxTicks )
+    {
+    histogram->maxTicks = ticks;
+    }
+#else
+  ( void )histogram;
+  ( void )startTicks;
+#endif
+  }
+
+/*
+Name: recordSift
+Process: adds one sift's levels moved and key comparisons to the counters
+Function input/parameters: heap data (HeapType *), levels (int),
+                           comparisons (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+void recordSift( HeapType *heap, int levels, int comparisons )
+  {
+  heap->counters.comparisons += (uint64_t)comparisons;
+  heap->counters.siftOperations++;
+  heap->counters.siftLevels += (uint64_t)levels;
+
+  if( levels > heap->counters.maxSiftDepth )
+    {
+    heap->counters.maxSiftDepth = levels;
+    }
+  }
+
+/*
+Name: releaseMigratedPages
+Process: hands the whole pages of an old block that an incremental
+         resize has moved back to the operating system, so freeing the
+         block at the end unmaps almost nothing, a step moves less
+         than a page so the page holding the step's start goes once the
+         step reaches past it, the block's first page is kept for the
+         allocator, does nothing without POSIX memory mapping
+Function input/parameters: migration (const HeapMigrationType *),
+                           old block (void *),
+                           moved byte range start and end (size_t), (size_t)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: madvise where available
+*/
+void releaseMigratedPages( const HeapMigrationType *migration, void *block,
+                                          size_t fromBytes, size_t toBytes )
+  {
+#ifdef HEAP_FILE_SUPPORT
+  // variables
+  uintptr_t mask = (uintptr_t)migration->pageSize - 1, start, end, first;
+
+  // earlier steps released up to the page holding this step's start,
+  // the first page is shared with the allocator's header below the block
+  first = ( (uintptr_t)block + mask ) & ~mask;
+  start = ( (uintptr_t)block + fromBytes ) & ~mask;
+  end = ( (uintptr_t)block + toBytes ) & ~mask;
+
+  if( start < first )
+    {
+    start = first;
+    }
+
+  if( end > start )
+    {
+    madvise( (void *)start, end - start, MADV_DONTNEED );
+    }
+#else
+  ( void )migration;
+  ( void )block;
+  ( void )fromBytes;
+  ( void )toBytes;
+#endif
+  }
+
+/*
+Name: releaseSlot
+Process: returns a patient slot to the free slot stack for reuse,
+         marks it out of the heap, drops it from the name index if enabled,
+         counts its name bytes as garbage in the name arena
+Function input/parameters: heap data (HeapType *), handle (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: removeNameIndex, getSlotPosition, getPatientSlot, getFreeSlot
+*/
+void releaseSlot( HeapType *heap, int handle )
+  {
+  // drop the name while the slot still holds it
+  if( heap->nameBuckets != NULL )
+    {
+    removeNameIndex( heap, handle );
+    }
+
+  // slot is no longer in the heap
+  *getSlotPosition( heap, handle ) = INVALID_POSITION;
+
+  // name bytes become garbage, the arena starts over once no names are 
+  // live, unless old names are still moving to a new arena
+  heap->arenaLiveBytes -= getPatientSlot( heap, handle )->nameLength + 1u;
+
+  if( heap->arenaLiveBytes == 0 
+          && ( heap->migration == NULL || heap->migration->nameArena == NULL ) )
+    {
+    heap->arenaSize = 0;
+    }
+
+  // push the handle onto the free slot stack
+  *getFreeSlot( heap, heap->freeCount ) = handle;
+
+  heap->freeCount++;
+  }
+
+/*
+Name: remapHeapFile
+Process: sets the heap file to a new length and maps it again at that 
+         length, the mapping may move, region pointers are reset after
+Function input/parameters: heap data (HeapType *), new length (size_t)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the file could not
+                          be resized or mapped, heap is unchanged (bool)
+Device input/---: none
+Device output/---: heap file
+Dependencies: ftruncate, mremap or munmap and mmap, mapHeapRegions
+*/
+bool remapHeapFile( HeapType *heap, size_t newLength )
+  {
+#ifdef HEAP_FILE_SUPPORT
+  // variables
+  void *mapping;
+
+  if( ftruncate( heap->fileDescriptor, (off_t)newLength ) != 0 )
+    {
+    return false;
+    }
+
+#ifdef MREMAP_MAYMOVE
+  // Linux can grow the mapping in place or move it without a copy
+  mapping = mremap( heap->fileHeader, heap->mapLength, newLength, 
+                                                          MREMAP_MAYMOVE );
+#else
+  // elsewhere map again, the shared file keeps the contents
+  munmap( heap->fileHeader, heap->mapLength );
+
+  mapping = mmap( NULL, newLength, PROT_READ | PROT_WRITE, MAP_SHARED, 
+                                                   heap->fileDescriptor, 0 );
+#endif
+
+  if( mapping == MAP_FAILED )
+    {
+    return false;
+    }
+
+  heap->fileHeader = ( HeapFileHeaderType *)mapping;
+  heap->mapLength = newLength;
+
+  mapHeapRegions( heap );
+
+  return true;
+#else
+  ( void )heap;
+  ( void )newLength;
+
+  return false;
+#endif
+  }
+
+/*
+Name: removeBucketEntry
+Process: takes a waiting patient's entry out of its level ring,
+         closes the gap by moving the later entries forward
+Function input/parameters: heap data (HeapType *), handle (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: removed entry (HeapEntryType)
+Device input/---: none
+Device output/---: none
+Dependencies: findBucketEntry
+*/
+HeapEntryType removeBucketEntry( HeapType *heap, int handle )
+  {
+  // variables
+  int level = *getSlotPosition( heap, handle );
+  PriorityBucketType *bucket = &heap->bucketQueue->levels[ level ];
+  HeapEntryType *found = findBucketEntry( heap, handle );
+  HeapEntryType entry = *found;
+  int offset = (int)( found - bucket->entries - bucket->head ) & bucket->mask;
+
+  for( ; offset < bucket->count - 1; offset++ )
+    {
+    bucket->entries[ ( bucket->head + offset ) & bucket->mask ]
+             = bucket->entries[ ( bucket->head + offset + 1 ) & bucket->mask ];
+
+    heap->counters.moves++;
+    }
+
+  bucket->count--;
+
+  if( bucket->count == 0 )
+    {
+    heap->bucketQueue->occupied &= ~( (uint64_t)1 << level );
+    }
+
+  return entry;
+  }
+
+/*
+Name: removeByHandle
+Process: removes a waiting patient found by handle from anywhere in the heap,
+         traces the removal, fills its index with the last entry, then 
+         bubbles up or trickles down from there, a bucket queue removes
+         it from its level ring instead, releases the patient slot,
+         displays its sift steps
+Function input/parameters: heap data (HeapType *), handle (int)
+Function output/parameters: updated heap data (HeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if handle is not waiting (bool)
+Device input/---: none
+Device output/monitor: removal action displayed as specified
+Dependencies: sampleHeapTicks, getSlotPosition, advanceHeapMigration, 
+              removeBucketEntry, getHeapEntry, getEntryPatient, 
+              getPatientInfo, printf, traceHeapOperation, releaseSlot, 
+              setHeapEntry, bubbleUpArrayHeap, trickleDownArrayHeap, 
+              checkForShrink, storeHeapFileCounters, recordLatency, 
+              showHeapTrace
+*/
+bool removeByHandle( HeapType *heap, int handle, PatientType *removed )
+  {
+  // variables
+  int index;
+  HeapEntryType entry;
+  uint64_t removedKey, startTicks = sampleHeapTicks( heap );
+  char returnStr[ HUGE_STR_LEN ];
+
+  // check for a handle that is not waiting in the heap
+  if( handle < 0 || handle >= heap->slotCount 
+                     || *getSlotPosition( heap, handle ) == INVALID_POSITION )
+    {
+    return false;
+    }
+
+  advanceHeapMigration( heap, 1 );
+
+  index = *getSlotPosition( heap, handle );
+
+  // a bucket queue closes the gap in the patient's level ring
+  if( heap->bucketQueue != NULL )
+    {
+    entry = removeBucketEntry( heap, handle );
+    }
+
+  else
+    {
+    entry = *getHeapEntry( heap, index );
+    }
+
+  removedKey = entry.key;
+
+  getEntryPatient( heap, entry, removed );
+
+  if( heap->displayFlag )
+    {
+    getPatientInfo( returnStr, *removed );
+    printf( "\nRemoving patient: %s\n", returnStr );
+    }
+
+  if( heap->trace != NULL )
+    {
+    traceHeapOperation( heap, TRACE_REMOVE, handle, removedKey, 
+                               (uint64_t)removed->timeIn, removed->patientName );
+    }
+
+  releaseSlot( heap, handle );
+
+  heap->size--;
+
+  // fill the index with the last entry unless it was the last one
+  if( heap->bucketQueue == NULL && index < heap->size )
+    {
+    *getHeapEntry( heap, index ) = *getHeapEntry( heap, heap->size );
+
+    if( getHeapEntry( heap, index )->key > removedKey )
+      {
+      bubbleUpArrayHeap( heap, index );
+      }
+
+    else
+      {
+      trickleDownArrayHeap( heap, index );
+      }
+    }
+
+  // give memory back once the heap has emptied out
+  checkForShrink( heap );
+
+  storeHeapFileCounters( heap );
+
+  if( startTicks != 0 )
+    {
+    recordLatency( &heap->latency->remove, startTicks );
+    }
+
+  if( heap->displayFlag )
+    {
+    showHeapTrace( heap );
+    }
+
+  return true;
+  }
+
+/*
+Name: removeItem
+Process: removes item from heap, reports removal action, adjusts data, 
+         displays and traces removal action, updates size, releases patient 
+         slot, calls trickle down to reset heap, a bucket queue pops its
+         highest level ring instead, displays its sift steps
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: none
+Device input/---: none
+Device output/monitor: removal action displayed as specified
+Dependencies: sampleHeapTicks, advanceHeapMigration, popBucketEntry, 
+              getHeapEntry, getEntryPatient, 
+              getPatientInfo, printf, traceHeapOperation, releaseSlot, 
+              trickleDownArrayHeap, checkForShrink, storeHeapFileCounters, 
+              recordLatency, 
+              showHeapTrace, others acceptable
+*/
+void removeItem( PatientType *removed, HeapType *heap )
+  {
+  // variables
+  char returnStr[ HUGE_STR_LEN ];   
+  int handle;
+  HeapEntryType top;
+  uint64_t startTicks = sampleHeapTicks( heap );
+    
+  if( heap->size > 0 )
+    {
+    advanceHeapMigration( heap, 1 );
+
+    // a bucket queue hands over its top, otherwise it stays at index 0
+    top = heap->bucketQueue != NULL ? popBucketEntry( heap ) 
+                                                  : *getHeapEntry( heap, 0 );
+
+    // copy the top patient out of its slot once
+    handle = top.handle;
+
+    getEntryPatient( heap, top, removed );       	  
+   
+    // check if verbose is true  
+    if( heap->displayFlag )
+      {
+      // display operation    
+      getPatientInfo( returnStr , *removed );
+      printf( "\nRemoving patient: %s\n", returnStr );
+      }  
+
+    if( heap->trace != NULL )
+      {
+      traceHeapOperation( heap, TRACE_REMOVE, handle, top.key,
+                               (uint64_t)removed->timeIn, removed->patientName );
+      }
+
+    // slot can now be reused by a later patient
+    releaseSlot( heap, handle );
+      
+    // decrement size
+    heap->size--;      
+
+    if( heap->bucketQueue == NULL && heap->size > 0 )
+      {
+      // grab entry at size and put into index 0     
+      *getHeapEntry( heap, 0 ) = *getHeapEntry( heap, heap->size );
+  
+      // now trickle down and restructure the max heap 
+      trickleDownArrayHeap( heap, 0 );	
+      }
+
+    // give memory back once the heap has emptied out
+    checkForShrink( heap );
+
+    storeHeapFileCounters( heap );
+
+    if( startTicks != 0 )
+      {
+      recordLatency( &heap->latency->remove, startTicks );
+      }
+
+    if( heap->displayFlag )
+      {
+      showHeapTrace( heap );
+      }
+    }
+  }
+
+/*
+Name: removeNameIndex
+Process: removes a slot's handle from the name index, shifts later
+         entries of the same probe run back so no tombstones are needed
+Function input/parameters: heap data (HeapType *), handle (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: hashPatientName
+*/
+void removeNameIndex( HeapType *heap, int handle )
+  {
+  // variables
+  int mask = heap->nameBucketCount - 1, holeBucket, bucket, homeBucket;
+  bool inRun;
+
+  // find the bucket holding this handle
+  holeBucket = (int)( hashPatientName( getSlotName( heap, handle ) ) 
+                                                          & (uint32_t)mask );
+
+  while( heap->nameBuckets[ holeBucket ] != handle )
+    {
+    // handle was never indexed
+    if( heap->nameBuckets[ holeBucket ] == EMPTY_BUCKET )
+      {
+      return;
+      }
+
+    holeBucket = ( holeBucket + 1 ) & mask;
+    }
+
+  heap->nameBuckets[ holeBucket ] = EMPTY_BUCKET;
+  heap->nameCount--;
+
+  // shift back any later entry whose home bucket is not between hole and it
+  bucket = ( holeBucket + 1 ) & mask;
+
+  while( heap->nameBuckets[ bucket ] != EMPTY_BUCKET )
+    {
+    homeBucket = (int)( hashPatientName( 
+                          getSlotName( heap, heap->nameBuckets[ bucket ] ) ) 
+                                                          & (uint32_t)mask );
+
+    // true when home lies cyclically in ( hole, bucket ]
+    if( holeBucket <= bucket )
+      {
+      inRun = homeBucket > holeBucket && homeBucket <= bucket;
+      }
+
+    else
+      {
+      inRun = homeBucket > holeBucket || homeBucket <= bucket;
+      }
+
+    if( !inRun )
+      {
+      heap->nameBuckets[ holeBucket ] = heap->nameBuckets[ bucket ];
+      heap->nameBuckets[ bucket ] = EMPTY_BUCKET;
+
+      holeBucket = bucket;
+      }
+
+    bucket = ( bucket + 1 ) & mask;
+    }
+  }
+
+/*
+Name: removeTopK
+Process: removes up to k highest priority patients in order into a 
+         caller buffer, each removal refills the root with a bottom up
+         sift or pops a bucket queue, displays and traces each removal action
+Function input/parameters: heap data (HeapType *), 
+                           number of patients wanted (int)
+Function output/parameters: updated heap data (HeapType *),
+                            patients removed in priority order (PatientType *)
+Function output/returned: number of patients removed (int)
+Device input/---: none
+Device output/monitor: removal actions displayed as specified
+Dependencies: advanceHeapMigration, popBucketEntry, getHeapEntry, 
+              getEntryPatient, traceHeapOperation, 
+              sinkToLeafArrayHeap, releaseSlot, getPatientInfo, printf, 
+              checkForShrink, storeHeapFileCounters
+*/
+int removeTopK( HeapType *heap, int k, PatientType *removed )
+  {
+  // variables
+  int index;
+  HeapEntryType top;
+  char returnStr[ HUGE_STR_LEN ];
+
+  // protect against asking for more than the heap holds
+  if( k > heap->size )
+    {
+    k = heap->size;
+    }
+
+  for( index = 0; index < k; index++ )
+    {
+    advanceHeapMigration( heap, 1 );
+
+    top = heap->bucketQueue != NULL ? popBucketEntry( heap ) 
+                                                  : *getHeapEntry( heap, 0 );
+
+    // copy the patient out of its slot straight into the buffer
+    getEntryPatient( heap, top, &removed[ index ] );
+
+    if( heap->trace != NULL )
+      {
+      traceHeapOperation( heap, TRACE_REMOVE, top.handle, top.key,
+                                          (uint64_t)removed[ index ].timeIn,
+                                                 removed[ index ].patientName );
+      }
+
+    // shrink first so the refill only sees the remaining entries
+    heap->size--;
+
+    if( heap->bucketQueue == NULL && heap->size > 0 )
+      {
+      sinkToLeafArrayHeap( heap, *getHeapEntry( heap, heap->size ) );
+      }
+
+    releaseSlot( heap, top.handle );
+
+    if( heap->displayFlag )
+      {
+      getPatientInfo( returnStr, removed[ index ] );
+      printf( "\nRemoving patient: %s\n", returnStr );
+      }
+    }
+
+  // give memory back once the heap has emptied out
+  checkForShrink( heap );
+
+  storeHeapFileCounters( heap );
+
+  return k;
+  }
+
+/*
+Name: reserveArenaBytes
+Process: makes room for the given number of bytes past the end of the
+         name arena, finishes names still moving from the last growth,
+         compacts the arena when at least half of it is garbage,
+         otherwise doubles it until the bytes fit, in incremental mode by
+         moving the names to the new arena a step at a time
+Function input/parameters: heap data (HeapType *), bytes needed (uint32_t)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out or the
+                          heap file could not grow, the arena keeps its
+                          capacity (bool)
+Device input/---: none
+Device output/---: heap file
+Dependencies: finishHeapMigration, compactNameArena, resizeHeapFile, 
+              beginArenaMigration, realloc
+*/
+bool reserveArenaBytes( HeapType *heap, uint32_t bytes )
+  {
+  // variables
+  uint32_t needed = heap->arenaSize + bytes, newCapacity;
+  char *newArena;
+
+  if( needed <= heap->arenaCapacity )
+    {
+    return true;
+    }
+
+  // names still moving from the last growth finish before the next,
+  // only a large batch outruns the steps
+  if( heap->migration != NULL && heap->migration->nameArena != NULL )
+    {
+    finishHeapMigration( heap );
+    }
+
+  // mostly garbage, squeeze out removed names instead of growing
+  if( heap->arenaLiveBytes * 2 <= heap->arenaSize )
+    {
+    compactNameArena( heap );
+
+    needed = heap->arenaSize + bytes;
+    }
+
+  if( needed <= heap->arenaCapacity )
+    {
+    return true;
+    }
+
+  newCapacity = heap->arenaCapacity * 2;
+
+  if( newCapacity < MIN_ARENA_CAPACITY )
+    {
+    newCapacity = MIN_ARENA_CAPACITY;
+    }
+
+  while( newCapacity < needed )
+    {
+    newCapacity *= 2;
+    }
+
+  // offsets stay valid wherever the block moves
+  if( heap->fileHeader != NULL )
+    {
+    return resizeHeapFile( heap, heap->capacity, newCapacity );
+    }
+
+  if( heap->incrementalFlag && beginArenaMigration( heap, newCapacity ) )
+    {
+    return true;
+    }
+
+  // the old arena is kept if the block cannot grow
+  newArena = ( char *)realloc( heap->nameArena, newCapacity );
+
+  if( newArena == NULL )
+    {
+    return false;
+    }
+
+  heap->nameArena = newArena;
+  heap->arenaCapacity = newCapacity;
+
+  return true;
+  }
+
+/*
+Name: reserveBucketLevels
+Process: sets aside a new ring for each level of a bucket queue that
+         entries ordered by key will be merged into, each one a power
+         of two large enough for the level and its new entries
+Function input/parameters: heap data (const HeapType *),
+                           entries ordered by key (const HeapEntryType *),
+                           entry count (int)
+Function output/parameters: none
+Function output/returned: new ring for each level, NULL for levels
+                          without entries, NULL if memory ran out and
+                          nothing is set aside (HeapEntryType **)
+Device input/---: none
+Device output/---: none
+Dependencies: calloc, malloc, free, getBucketLevel, getKeyPriority
+*/
+HeapEntryType **reserveBucketLevels( const HeapType *heap, 
+                                  const HeapEntryType *entries, int count )
+  {
+  // variables
+  BucketQueueType *queue = heap->bucketQueue;
+  HeapEntryType **newRings = ( HeapEntryType **)calloc( queue->levelCount,
+                                                   sizeof( HeapEntryType * ) );
+  int level, start = 0, end, capacity;
+  bool failedFlag = newRings == NULL;
+
+  while( !failedFlag && start < count )
+    {
+    level = getBucketLevel( queue, getKeyPriority( entries[ start ].key ) );
+
+    end = start;
+
+    while( end < count 
+            && getBucketLevel( queue, getKeyPriority( entries[ end ].key ) )
+                                                                    == level )
+      {
+      end++;
+      }
+
+    capacity = queue->levels[ level ].mask + 1;
+
+    while( capacity < queue->levels[ level ].count + end - start )
+      {
+      capacity *= 2;
+      }
+
+    newRings[ level ] 
+             = ( HeapEntryType *)malloc( capacity * sizeof( HeapEntryType ) );
+
+    failedFlag = newRings[ level ] == NULL;
+
+    start = end;
+    }
+
+  if( failedFlag && newRings != NULL )
+    {
+    for( level = 0; level < queue->levelCount; level++ )
+      {
+      free( newRings[ level ] );
+      }
+
+    free( newRings );
+
+    newRings = NULL;
+    }
+
+  return newRings;
+  }
+
+/*
+Name: reserveNameIndex
+Process: makes room in the name index for the given number of names,
+         doubling the bucket table until it stays at most half full,
+         does nothing if the index is off
+Function input/parameters: heap data (HeapType *), names to add (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the index is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: resizeNameIndex
+*/
+bool reserveNameIndex( HeapType *heap, int count )
+  {
+  // variables
+  int bucketCount = heap->nameBucketCount;
+
+  if( heap->nameBuckets == NULL )
+    {
+    return true;
+    }
+
+  // keep the table at most half full so probes stay short
+  while( ( heap->nameCount + count ) * 2 > bucketCount )
+    {
+    bucketCount *= 2;
+    }
+
+  return bucketCount == heap->nameBucketCount 
+                                      || resizeNameIndex( heap, bucketCount );
+  }
+
+/*
+Name: resetHeapStats
+Process: zeroes the operation counters and latency histograms,
+         restarts the tick calibration
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: memset, readHeapTicks, readHeapNanoseconds
+*/
+void resetHeapStats( HeapType *heap )
+  {
+  memset( &heap->counters, 0, sizeof( HeapCountersType ) );
+
+  if( heap->latency != NULL )
+    {
+    memset( heap->latency, 0, sizeof( HeapLatencyType ) );
+
+    heap->latency->startTicks = readHeapTicks();
+    heap->latency->startNs = readHeapNanoseconds();
+    }
+  }
+
+/*
+Name: resizeHeap
+Process: grows or shrinks the heap, slot, free slot, and position arrays
+         to the given capacity in place where the allocator can, moving
+         each block in one piece when it cannot, counts the resize and 
+         the bytes copied, resets the shrink size for the new capacity,
+         capacity is never taken below the current size or slot count,
+         a file backed heap resizes its file instead,
+         any incremental resize under way is finished first
+Function input/parameters: heap data (HeapType *), new capacity (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out while
+                          growing and the capacity is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: finishHeapMigration, resizeHeapFile, reallocateHeapArray, 
+              reallocateHeapRegion
+*/
+bool resizeHeap( HeapType *heap, int newCapacity )
+  {
+  // variables
+  PatientSlotType *newSlots;
+  int *newFreeSlots, *newPositions;
+  bool successFlag;
+
+  finishHeapMigration( heap );
+
+  // protect against dropping live entries or slots
+  if( newCapacity < heap->size || newCapacity < heap->slotCount )
+    {
+    newCapacity = heap->size > heap->slotCount ? heap->size : heap->slotCount;
+    }
+
+  // a file backed heap grows its file in place instead of copying
+  if( heap->fileHeader != NULL )
+    {
+    return resizeHeapFile( heap, newCapacity, heap->arenaCapacity );
+    }
+
+  // a block that could not grow stays as it was, one that did is kept
+  // even if a later one fails, so every block holds the old capacity
+  successFlag = reallocateHeapArray( heap, newCapacity );
+
+  newSlots = ( PatientSlotType *)reallocateHeapRegion( heap, heap->slots,
+                          (size_t)newCapacity * sizeof( PatientSlotType ),
+                          (size_t)heap->slotCount * sizeof( PatientSlotType ) );
+  newFreeSlots = ( int *)reallocateHeapRegion( heap, heap->freeSlots,
+                          (size_t)newCapacity * sizeof( int ),
+                          (size_t)heap->freeCount * sizeof( int ) );
+  newPositions = ( int *)reallocateHeapRegion( heap, heap->positions,
+                          (size_t)newCapacity * sizeof( int ),
+                          (size_t)heap->slotCount * sizeof( int ) );
+
+  if( newSlots != NULL )
+    {
+    heap->slots = newSlots;
+    }
+
+  if( newFreeSlots != NULL )
+    {
+    heap->freeSlots = newFreeSlots;
+    }
+
+  if( newPositions != NULL )
+    {
+    heap->positions = newPositions;
+    }
+
+  successFlag = successFlag && newSlots != NULL && newFreeSlots != NULL 
+                                                     && newPositions != NULL;
+
+  // a shrink that failed leaves blocks larger than needed, which is fine
+  if( !successFlag && newCapacity > heap->capacity )
+    {
+    return false;
+    }
+
+  heap->counters.resizes++;
+
+  heap->capacity = newCapacity;
+  heap->shrinkSize = (int)( newCapacity 
+                               / ( heap->growthFactor * heap->growthFactor ) );
+
+  return true;
+  }
+
+/*
+Name: resizeHeapFile
+Process: changes the capacity and name arena size of a file backed heap,
+         grows the file before sliding regions toward the end, 
+         or slides regions toward the front before shrinking the file,
+         only used parts of each region are moved and counted
+Function input/parameters: heap data (HeapType *), new capacity (int),
+                           new name arena capacity (uint32_t)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the file could not
+                          be resized (bool)
+Device input/---: none
+Device output/---: heap file
+Dependencies: setHeapFileLayout, remapHeapFile, memmove, 
+              storeHeapFileCounters
+*/
+bool resizeHeapFile( HeapType *heap, int newCapacity, 
+                                               uint32_t newArenaCapacity )
+  {
+  // variables
+  HeapFileHeaderType oldLayout = *heap->fileHeader, newLayout;
+  char *base;
+  bool growFlag;
+
+  setHeapFileLayout( &newLayout, newCapacity, heap->arity, newArenaCapacity );
+
+  growFlag = newLayout.fileLength >= oldLayout.fileLength;
+
+  if( growFlag && !remapHeapFile( heap, (size_t)newLayout.fileLength ) )
+    {
+    return false;
+    }
+
+  base = ( char *)heap->fileHeader;
+
+  // every region moves the same way, move the far end first on growth
+  if( growFlag )
+    {
+    memmove( base + newLayout.arenaOffset, base + oldLayout.arenaOffset, 
+                                                           heap->arenaSize );
+    memmove( base + newLayout.positionsOffset, 
+                                  base + oldLayout.positionsOffset,
+                                  (size_t)heap->slotCount * sizeof( int ) );
+    memmove( base + newLayout.freeSlotsOffset, 
+                                  base + oldLayout.freeSlotsOffset,
+                                  (size_t)heap->freeCount * sizeof( int ) );
+    memmove( base + newLayout.slotsOffset, base + oldLayout.slotsOffset,
+                       (size_t)heap->slotCount * sizeof( PatientSlotType ) );
+    }
+
+  else
+    {
+    memmove( base + newLayout.slotsOffset, base + oldLayout.slotsOffset,
+                       (size_t)heap->slotCount * sizeof( PatientSlotType ) );
+    memmove( base + newLayout.freeSlotsOffset, 
+                                  base + oldLayout.freeSlotsOffset,
+                                  (size_t)heap->freeCount * sizeof( int ) );
+    memmove( base + newLayout.positionsOffset, 
+                                  base + oldLayout.positionsOffset,
+                                  (size_t)heap->slotCount * sizeof( int ) );
+    memmove( base + newLayout.arenaOffset, base + oldLayout.arenaOffset, 
+                                                           heap->arenaSize );
+    }
+
+  // regions slide within the mapping, the heap array stays put
+  heap->counters.resizes++;
+  heap->counters.bytesCopied += heap->arenaSize + (uint64_t)heap->slotCount 
+                             * ( sizeof( PatientSlotType ) + sizeof( int ) )
+                           + (uint64_t)heap->freeCount * sizeof( int );
+
+  // the header now describes the new layout
+  newLayout.size = oldLayout.size;
+  newLayout.slotCount = oldLayout.slotCount;
+  newLayout.freeCount = oldLayout.freeCount;
+  newLayout.nextSequence = oldLayout.nextSequence;
+  newLayout.arenaSize = oldLayout.arenaSize;
+  newLayout.arenaLiveBytes = oldLayout.arenaLiveBytes;
+
+  *heap->fileHeader = newLayout;
+
+  heap->capacity = newCapacity;
+  heap->arenaCapacity = newArenaCapacity;
+
+  // if the file cannot shrink the larger mapping still holds every region
+  if( !growFlag )
+    {
+    remapHeapFile( heap, (size_t)newLayout.fileLength );
+    }
+
+  mapHeapRegions( heap );
+
+  storeHeapFileCounters( heap );
+
+  return true;
+  }
+
+/*
+Name: resizeNameIndex
+Process: creates a new bucket table of the given power of two size,
+         re-inserts all indexed handles, frees the old table,
+         keeps the old table if the new one cannot be allocated
+Function input/parameters: heap data (HeapType *), bucket count (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the index is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, free, hashPatientName
+*/
+bool resizeNameIndex( HeapType *heap, int bucketCount )
+  {
+  // variables
+  int *oldBuckets = heap->nameBuckets, *newBuckets;
+  int oldCount = heap->nameBucketCount, index, bucket, mask = bucketCount - 1;
+
+  newBuckets = ( int *)malloc( (size_t)bucketCount * sizeof( int ) );
+
+  if( newBuckets == NULL )
+    {
+    return false;
+    }
+
+  heap->nameBuckets = newBuckets;
+  heap->nameBucketCount = bucketCount;
+
+  for( index = 0; index < bucketCount; index++ )
+    {
+    heap->nameBuckets[ index ] = EMPTY_BUCKET;
+    }
+
+  // re-insert every handle from the old table
+  for( index = 0; index < oldCount; index++ )
+    {
+    if( oldBuckets[ index ] != EMPTY_BUCKET )
+      {
+      bucket = (int)( hashPatientName( 
+                                    getSlotName( heap, oldBuckets[ index ] ) ) 
+                                                          & (uint32_t)mask );
+
+      while( heap->nameBuckets[ bucket ] != EMPTY_BUCKET )
+        {
+        bucket = ( bucket + 1 ) & mask;
+        }
+
+      heap->nameBuckets[ bucket ] = oldBuckets[ index ];
+      }
+    }
+
+  free( oldBuckets );
+
+  return true;
+  }
+
+/*
+Name: roundToCacheLine
+Process: rounds a byte count or offset up to a whole cache line
+Function input/parameters: byte count (uint64_t)
+Function output/parameters: none
+Function output/returned: rounded byte count (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint64_t roundToCacheLine( uint64_t bytes )
+  {
+  return ( bytes + CACHE_LINE_SIZE - 1 ) & ~(uint64_t)( CACHE_LINE_SIZE - 1 );
+  }
+
+/*
+Name: sampleHeapTicks
+Process: counts an add or remove toward the latency sample interval,
+         reads the latency counter when this operation is sampled
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated sample counter (HeapType *)
+Function output/returned: start ticks, zero if not sampled (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: readHeapTicks
+*/
+uint64_t sampleHeapTicks( HeapType *heap )
+  {
+#if HEAP_LATENCY_STATS
+  if( heap->latency != NULL && ( ++heap->latency->sampleCounter 
+                             & ( HEAP_LATENCY_SAMPLE_INTERVAL - 1 ) ) == 0 )
+    {
+    return readHeapTicks();
+    }
+#else
+  ( void )heap;
+#endif
+
+  return 0;
+  }
+
+/*
+Name: saveHeapTrace
+Process: writes the events still in the heap's trace ring to a file
+         for tracedecoder, with the counter rate for the timestamps
+Function input/parameters: heap data (const HeapType *), 
+                           file name (const char *)
+Function output/parameters: none
+Function output/returned: Boolean result, false if the heap has no
+                          trace or the file is not written (bool)
+Device input/---: none
+Device output/---: trace file
+Dependencies: getHeapStats, writeTraceFile
+*/
+bool saveHeapTrace( const HeapType *heap, const char *fileName )
+  {
+  // variables
+  HeapStatsType stats;
+
+  if( heap->trace == NULL )
+    {
+    return false;
+    }
+
+  getHeapStats( heap, &stats );
+
+  return writeTraceFile( heap->trace, fileName, stats.ticksPerNs );
+  }
+
+/*
+Name: selectLargerChild
+Process: finds the child with the largest key in a block of siblings,
+         ties go to the earliest child, uses the heap's vector kernel
+         when the block fills whole vectors and sits in one array,
+         otherwise scans with selects that compile to conditional moves
+Function input/parameters: heap data (const HeapType *), 
+                           first child index (int), end child index (int)
+Function output/parameters: none
+Function output/returned: index of the larger child (int)
+Device input/---: none
+Device output/---: none
+Dependencies: selectLargerChildAvx2, selectLargerChildSse42, getHeapEntry
+*/
+int selectLargerChild( const HeapType *heap, int firstIndex, int endIndex )
+  {
+  // variables
+  int count = endIndex - firstIndex, childIndex, largerIndex = firstIndex;
+  uint64_t largerKey, childKey;
+
+  // an incremental resize may leave a block split over two arrays
+  if( heap->childSelect != CHILD_SELECT_SCALAR && heap->migration == NULL )
+    {
+    if( heap->childSelect == CHILD_SELECT_AVX2 && count % 4 == 0 )
+      {
+      return firstIndex + selectLargerChildAvx2( &heap->array[ firstIndex ], 
+                                                                      count );
+      }
+
+    if( count % 2 == 0 )
+      {
+      return firstIndex + selectLargerChildSse42( &heap->array[ firstIndex ],
+                                                                      count );
+      }
+    }
+
+  largerKey = getHeapEntry( heap, firstIndex )->key;
+
+  for( childIndex = firstIndex + 1; childIndex < endIndex; childIndex++ )
+    {
+    childKey = getHeapEntry( heap, childIndex )->key;
+
+    largerIndex = childKey > largerKey ? childIndex : largerIndex;
+    largerKey = childKey > largerKey ? childKey : largerKey;
+    }
+
+  return largerIndex;
+  }
+
+
+/*
+Name: selectLargerChildAvx2
+Process: finds the child with the largest key with AVX2, gathers four
+         keys per vector from pairs of entries, flips the sign bits so
+         the signed compare orders them unsigned, reduces to the maximum
+         and takes the first lane holding it, scans where AVX2 is
+         not compiled in
+Function input/parameters: child block (const HeapEntryType *), 
+                           count, a multiple of four up to 
+                           MAX_HEAP_ARITY (int)
+Function output/parameters: none
+Function output/returned: offset of the larger child in the block (int)
+Device input/---: none
+Device output/---: none
+Dependencies: AVX2 intrinsics, __builtin_ctz where available
+*/
+HEAP_TARGET( "avx2" ) int selectLargerChildAvx2( 
+                               const HeapEntryType *children, int count )
+  {
+#ifdef HEAP_SIMD_SUPPORT
+  // variables
+  const __m256i signBit = _mm256_set1_epi64x( INT64_MIN );
+  __m256i keys[ MAX_HEAP_ARITY / 4 ], larger, swapped, greater, low, high;
+  int group, groupCount = count / 4, mask;
+
+  // a flipped key is never below the sign bit alone
+  larger = signBit;
+
+  // the low half of each entry is its key, the permute restores child 
+  // order, then a lane wise maximum over the groups
+  for( group = 0; group < groupCount; group++ )
+    {
+    low = _mm256_loadu_si256( ( const __m256i *)&children[ 4 * group ] );
+    high = _mm256_loadu_si256( ( const __m256i *)&children[ 4 * group + 2 ] );
+
+    keys[ group ] = _mm256_xor_si256( _mm256_permute4x64_epi64( 
+                          _mm256_unpacklo_epi64( low, high ), 0xD8 ), signBit );
+
+    greater = _mm256_cmpgt_epi64( keys[ group ], larger );
+    larger = _mm256_blendv_epi8( larger, keys[ group ], greater );
+    }
+
+  // then across the lanes, swapping halves and then neighbors
+  swapped = _mm256_permute4x64_epi64( larger, 0x4E );
+  greater = _mm256_cmpgt_epi64( swapped, larger );
+  larger = _mm256_blendv_epi8( larger, swapped, greater );
+
+  swapped = _mm256_shuffle_epi32( larger, 0x4E );
+  greater = _mm256_cmpgt_epi64( swapped, larger );
+  larger = _mm256_blendv_epi8( larger, swapped, greater );
+
+  for( group = 0; group < groupCount; group++ )
+    {
+    mask = _mm256_movemask_pd( _mm256_castsi256_pd( 
+                              _mm256_cmpeq_epi64( keys[ group ], larger ) ) );
+
+    if( mask != 0 )
+      {
+      return 4 * group + __builtin_ctz( mask );
+      }
+    }
+
+  return 0;
+#else
+  // variables
+  int childIndex, largerIndex = 0;
+
+  for( childIndex = 1; childIndex < count; childIndex++ )
+    {
+    if( children[ childIndex ].key > children[ largerIndex ].key )
+      {
+      largerIndex = childIndex;
+      }
+    }
+
+  return largerIndex;
+#endif
+  }
+
+
+/*
+Name: selectLargerChildSse42
+Process: finds the child with the largest key with the SSE4.2 64 bit
+         compare, two keys per vector, otherwise as the AVX2 kernel,
+         scans where SSE4.2 is not compiled in
+Function input/parameters: child block (const HeapEntryType *), 
+                           count, a multiple of two up to 
+                           MAX_HEAP_ARITY (int)
+Function output/parameters: none
+Function output/returned: offset of the larger child in the block (int)
+Device input/---: none
+Device output/---: none
+Dependencies: SSE4.2 intrinsics, __builtin_ctz where available
+*/
+HEAP_TARGET( "sse4.2" ) int selectLargerChildSse42( 
+                               const HeapEntryType *children, int count )
+  {
+#ifdef HEAP_SIMD_SUPPORT
+  // variables
+  const __m128i signBit = _mm_set1_epi64x( INT64_MIN );
+  __m128i keys[ MAX_HEAP_ARITY / 2 ], larger, swapped, greater;
+  int group, groupCount = count / 2, mask;
+
+  larger = signBit;
+
+  // one entry per load, the low halves of two entries make a vector
+  for( group = 0; group < groupCount; group++ )
+    {
+    keys[ group ] = _mm_xor_si128( _mm_unpacklo_epi64( 
+              _mm_loadu_si128( ( const __m128i *)&children[ 2 * group ] ),
+              _mm_loadu_si128( ( const __m128i *)&children[ 2 * group + 1 ] ) ),
+                                                                    signBit );
+
+    greater = _mm_cmpgt_epi64( keys[ group ], larger );
+    larger = _mm_blendv_epi8( larger, keys[ group ], greater );
+    }
+
+  swapped = _mm_shuffle_epi32( larger, 0x4E );
+  greater = _mm_cmpgt_epi64( swapped, larger );
+  larger = _mm_blendv_epi8( larger, swapped, greater );
+
+  for( group = 0; group < groupCount; group++ )
+    {
+    mask = _mm_movemask_pd( _mm_castsi128_pd( 
+                                    _mm_cmpeq_epi64( keys[ group ], larger ) ) );
+
+    if( mask != 0 )
+      {
+      return 2 * group + __builtin_ctz( mask );
+      }
+    }
+
+  return 0;
+#else
+  // variables
+  int childIndex, largerIndex = 0;
+
+  for( childIndex = 1; childIndex < count; childIndex++ )
+    {
+    if( children[ childIndex ].key > children[ largerIndex ].key )
+      {
+      largerIndex = childIndex;
+      }
+    }
+
+  return largerIndex;
+#endif
+  }
+
+
+/*
+Name: setChildSelect
+Process: chooses the kernel that picks the larger child while sifting
+         down, refused if the processor cannot run it
+Function input/parameters: heap data (HeapType *), kernel (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the kernel is not
+                          supported here (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getBestChildSelect
+*/
+bool setChildSelect( HeapType *heap, int kernel )
+  {
+  if( kernel < CHILD_SELECT_SCALAR || kernel > getBestChildSelect() )
+    {
+    return false;
+    }
+
+  heap->childSelect = kernel;
+
+  return true;
+  }
+
+/*
+Name: setDisplayFlag
+Process: sets Boolean flag to drive bubble up, trickle down displays,
+         turning it on attaches a trace ring if the heap has none,
+         with HEAP_TRACE 0 only additions and removals are displayed
+Function input/parameters: heap data (HeapType *), flag (bool)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: enableHeapTrace, atomic_load
+*/
+void setDisplayFlag( HeapType *heap, bool flagSet )
+  {
+  // set display flag    
+  heap->displayFlag = flagSet;		
+
+  // sift steps are displayed from the trace, starting with the next one
+  if( flagSet && heap->trace == NULL )
+    {
+    enableHeapTrace( heap, DEFAULT_TRACE_EVENTS );
+    }
+
+  else if( flagSet )
+    {
+    heap->trace->displayCursor = atomic_load( &heap->trace->head );
+    }
+  }
+
+/*
+Name: setGrowthFactor
+Process: sets the factor capacity grows by when full, which also sets
+         how far the size must fall before the heap shrinks
+Function input/parameters: heap data (HeapType *), growth factor (double)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the factor is outside
+                          MIN_GROWTH_FACTOR to MAX_GROWTH_FACTOR (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+bool setGrowthFactor( HeapType *heap, double factor )
+  {
+  if( factor < MIN_GROWTH_FACTOR || factor > MAX_GROWTH_FACTOR )
+    {
+    return false;
+    }
+
+  heap->growthFactor = factor;
+  heap->shrinkSize = (int)( heap->capacity / ( factor * factor ) );
+
+  return true;
+  }
+
+/*
+Name: setHeapEntry
+Process: writes an entry at a heap index and records that index
+         in the position map of its slot, every sift move goes through here
+         and is counted
+Function input/parameters: heap data (HeapType *), heap index (int),
+                           entry (HeapEntryType)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: getHeapEntry, getSlotPosition
+*/
+void setHeapEntry( HeapType *heap, int index, HeapEntryType entry )
+  {
+  *getHeapEntry( heap, index ) = entry;
+
+  *getSlotPosition( heap, entry.handle ) = index;
+
+  heap->counters.moves++;
+  }
+
+/*
+Name: setHeapFileLayout
+Process: fills a heap file header for an empty heap with the given
+         capacity, arity, and name arena size, each region starts on
+         a cache line, the name arena is last so it can grow alone
+Function input/parameters: capacity (int), arity (int), 
+                           name arena capacity (uint32_t)
+Function output/parameters: heap file header (HeapFileHeaderType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: roundToCacheLine
+*/
+void setHeapFileLayout( HeapFileHeaderType *header, int capacity, 
+                                       int arity, uint32_t arenaCapacity )
+  {
+  // variables
+  uint64_t offset;
+
+  header->magic = HEAP_FILE_MAGIC;
+  header->version = HEAP_FILE_VERSION;
+  header->entrySize = (uint32_t)sizeof( HeapEntryType );
+  header->slotSize = (uint32_t)sizeof( PatientSlotType );
+
+  header->capacity = capacity;
+  header->arity = arity;
+  header->size = 0;
+  header->slotCount = 0;
+  header->freeCount = 0;
+  header->nextSequence = 0;
+  header->arenaSize = 0;
+  header->arenaCapacity = arenaCapacity;
+  header->arenaLiveBytes = 0;
+
+  // heap array keeps the pad entries that line up sibling blocks
+  offset = roundToCacheLine( sizeof( HeapFileHeaderType ) );
+  header->arrayOffset = offset;
+
+  offset = roundToCacheLine( offset + ( (uint64_t)capacity + arity - 1 ) 
+                                                  * sizeof( HeapEntryType ) );
+  header->slotsOffset = offset;
+
+  offset = roundToCacheLine( offset 
+                           + (uint64_t)capacity * sizeof( PatientSlotType ) );
+  header->freeSlotsOffset = offset;
+
+  offset = roundToCacheLine( offset + (uint64_t)capacity * sizeof( int ) );
+  header->positionsOffset = offset;
+
+  offset = roundToCacheLine( offset + (uint64_t)capacity * sizeof( int ) );
+  header->arenaOffset = offset;
+
+  header->fileLength = offset + arenaCapacity;
+  }
+
+/*
+Name: setIncrementalResize
+Process: turns incremental resizing on or off, when on a full heap
+         allocates its new blocks up front and each later operation
+         moves a bounded step of entries over, reads are served from
+         both blocks until the move is done, so no single add pays for
+         copying the heap, turning it off finishes any move under way,
+         a file backed heap grows its file in place instead
+Function input/parameters: heap data (HeapType *), incremental flag (bool)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the heap is
+                          file backed (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: finishHeapMigration
+*/
+bool setIncrementalResize( HeapType *heap, bool incrementalSet )
+  {
+  if( incrementalSet && heap->fileHeader != NULL )
+    {
+    return false;
+    }
+
+  if( !incrementalSet )
+    {
+    finishHeapMigration( heap );
+    }
+
+  heap->incrementalFlag = incrementalSet;
+
+  return true;
+  }
+
+/*
+Name: showArray
+Process: displays array as is, from lowest index to highest,
+         a bucket queue is shown level by level in removal order
+Function input/parameters: heap data (HeapType)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/monitor: array displayed as specified
+Dependencies: getPatientInfo, printf
+*/
+void showArray( HeapType heap )
+  {
+  // variables
+  int index, level;
+  PriorityBucketType *bucket;
+  PatientType patient;
+  char data[ HUGE_STR_LEN ];
+
+  // a bucket queue shows its level rings from the highest, oldest first
+  if( heap.bucketQueue != NULL )
+    {
+    for( level = heap.bucketQueue->levelCount - 1; level >= 0; level-- )
+      {
+      bucket = &heap.bucketQueue->levels[ level ];
+
+      for( index = 0; index < bucket->count; index++ )
+        {
+        getEntryPatient( &heap, 
+                   bucket->entries[ ( bucket->head + index ) & bucket->mask ],
+                                                                   &patient );
+        getPatientInfo( data, patient );
+
+        printf( "%s\n ", data );	
+        }
+      }
+
+    return;
+    }
+  
+  // iterate through array
+  for( index = 0; index < heap.size; index++ )
+    {
+    // display patient data for the slot at index
+    getEntryPatient( &heap, *getHeapEntry( &heap, index ), &patient );
+    getPatientInfo( data, patient );
+    
+    printf( "%s\n ", data );	
+    }		
+  }
+
+/*
+Name: showHeapTrace
+Process: prints the bubble up and trickle down steps recorded since the
+         last call, names and times in come from the live patient slots,
+         additions and removals are printed by their operations
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated display cursor (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/monitor: sift steps displayed as specified
+Dependencies: readTraceEvents, getEntryPatient, formatTraceEvent, printf
 */
-void bubbleUpArrayHeap( HeapType *heap, int currentIndex )
+void showHeapTrace( HeapType *heap )
   {
   // variables
-  int parentIndex;	
-  PatientType child, parent;	
-  char parentStr[ STD_STR_LEN ], childStr[STD_STR_LEN];
-      	
-  // check for current index greater than 0
-  if( currentIndex > 0 )
-    {       
-    // calculate parent's index
-    parentIndex = (( currentIndex - 1 ) / 2);
+  HeapTraceEventType events[ TRACE_READ_BATCH ];
+  HeapEntryType entry;
+  PatientType patient, other;
+  char text[ MAX_TRACE_TEXT ];
+  int count, index;
 
-    // set the child and parent variables
-    setPatientFromStruct( &child, heap->array[ currentIndex ] );
-    setPatientFromStruct( &parent, heap->array[ parentIndex ] );
-
-    // check if current child's value is less than parent value
-    if( comparePriority( parent, child ) < 0 )
-      { 	
-      // set childs data to parents data
-      setPatientFromStruct( &heap->array[currentIndex], heap->array[ parentIndex] );
+  if( heap->trace == NULL )
+    {
+    return;
+    }
 
-      // overwrite parents data with child
-      setPatientFromStruct( &heap->array[parentIndex], child );
+  do
+    {
+    count = readTraceEvents( heap->trace, &heap->trace->displayCursor, 
+                                                     events, TRACE_READ_BATCH );
 
-      // check if display verbose is true
-      if( heap->displayFlag )
+    for( index = 0; index < count; index++ )
+      {
+      if( events[ index ].op == TRACE_BUBBLE_UP 
+                                  || events[ index ].op == TRACE_TRICKLE_DOWN )
         {
-        // grab the strings from nodes
-        getPatientInfo( parentStr, parent );
-        getPatientInfo( childStr, child );    
-               
-        // display operation
-        printf( "   - Bubble up:\n" );
-        printf( "     - Swapping parent: %s\n", parentStr );
-        printf( "     - with child: %s\n\n", childStr );    
-        }
+        entry.handle = events[ index ].handle;
+        entry.key = events[ index ].data.step.key;
+
+        getEntryPatient( heap, entry, &patient );
+
+        entry.handle = events[ index ].data.step.otherHandle;
+        entry.key = events[ index ].data.step.otherKey;
+
+        getEntryPatient( heap, entry, &other );
+
+        formatTraceEvent( text, &events[ index ], patient, other );
 
-      // call the function recursively with the parent's index
-      bubbleUpArrayHeap( heap, parentIndex );
+        printf( "%s", text );
+        }
       }
     }
+  while( count == TRACE_READ_BATCH );
   }
 
 /*
-Name: checkForResize
-Process: checks for need to resize (increase capacity of) array,
-         if necessary, creates new array with double the previous capacity,
-         updates array, then returns previous data memory to OS
-Function input/parameters: heap data (HeapType *)
+Name: sinkToLeafArrayHeap
+Process: fills the hole at the root after the top entry is taken,
+         walks the hole down the larger child path to a leaf without
+         comparing against the moving entry, then climbs back up until
+         the moving entry fits, the moving entry usually belongs near 
+         the bottom so this saves a compare per level over trickle down
+Function input/parameters: heap data (HeapType *), 
+                           entry to place (HeapEntryType)
 Function output/parameters: updated heap data (HeapType *)
 Function output/returned: none
 Device input/---: none
 Device output/---: none
-Dependencies: malloc, sizeof, setPatientFromStruct, free
+Dependencies: prefetchHeapLevel, selectLargerChild, getHeapEntry, 
+              setHeapEntry, recordSift
 */
-void checkForResize( HeapType *heap )
+void sinkToLeafArrayHeap( HeapType *heap, HeapEntryType moving )
   {
   // variables
-  PatientType *newArray;
-  int newCapacity, index;
-  
-  // check if array is full
-  if( heap->size == heap->capacity )
+  int arity = heap->arity, size = heap->size;
+  int holeIndex = 0, firstChildIndex = 1, parentIndex;
+  int endIndex, largerIndex;
+  int levels = 0, comparisons = 0;
+
+  // walk the hole down to a leaf along the larger children
+  while( firstChildIndex < size )
     {
-    // double capacity
-	newCapacity = heap->capacity * 2;	
-    heap->capacity = newCapacity;
-    	
-    // create new array
-    newArray = ( PatientType *)malloc( newCapacity * sizeof( PatientType ) );
-    
-    // copy data into new array
-    for( index = 0; index < heap->size; index++ )
-      {
-      // copy current node from old array to new array	
-      setPatientFromStruct( &newArray[ index ], heap->array[ index ] );
-      }
-	
-    // free the memory of old array
-    free( heap->array );
-	
-    // link new array to heap
-    heap->array = newArray;
-    }	
+    prefetchHeapLevel( heap, firstChildIndex );
+
+    endIndex = firstChildIndex + arity;
+
+    if( endIndex > size )
+      {
+      endIndex = size;
+      }
+
+    largerIndex = selectLargerChild( heap, firstChildIndex, endIndex );
+
+    comparisons += endIndex - firstChildIndex - 1;
+
+    setHeapEntry( heap, holeIndex, *getHeapEntry( heap, largerIndex ) );
+
+    holeIndex = largerIndex;
+    firstChildIndex = holeIndex * arity + 1;
+
+    levels++;
+    }
+
+  // climb back up while the parent is lower than the moving entry
+  parentIndex = ( holeIndex - 1 ) / arity;
+
+  while( holeIndex > 0 && getHeapEntry( heap, parentIndex )->key < moving.key )
+    {
+    setHeapEntry( heap, holeIndex, *getHeapEntry( heap, parentIndex ) );
+
+    holeIndex = parentIndex;
+    parentIndex = ( holeIndex - 1 ) / arity;
+
+    comparisons++;
+    levels++;
+    }
+
+  setHeapEntry( heap, holeIndex, moving );
+
+  // the climb's last test compared too unless it reached the root
+  recordSift( heap, levels, holeIndex > 0 ? comparisons + 1 : comparisons );
   }
 
 /*
-Name: clearHeap
-Process: frees heap array, sets all other data members appropriately
+Name: storeHeapFileCounters
+Process: copies the heap counters into the file header so the file 
+         always describes a whole heap between operations,
+         does nothing for a heap that is not file backed
 Function input/parameters: heap data (HeapType *)
-Function output/parameters: updated heap data (HeapType *)
+Function output/parameters: updated heap file header (HeapType *)
 Function output/returned: none
 Device input/---: none
 Device output/---: none
-Dependencies: free
+Dependencies: none
 */
-void clearHeap( HeapType *heap )
-  {	
-  // free the array
-  free( heap->array );
-  
-  // set all other data members appropriatly
-  heap->capacity = 0;
-  heap->size = 0;
+void storeHeapFileCounters( HeapType *heap )
+  {
+  if( heap->fileHeader != NULL )
+    {
+    heap->fileHeader->size = heap->size;
+    heap->fileHeader->slotCount = heap->slotCount;
+    heap->fileHeader->freeCount = heap->freeCount;
+    heap->fileHeader->nextSequence = heap->nextSequence;
+    heap->fileHeader->arenaSize = heap->arenaSize;
+    heap->fileHeader->arenaLiveBytes = heap->arenaLiveBytes;
+    }
   }
 
 /*
-Name: initializeHeap
-Process: initializes heap, creates heap array from given capacity,
-         sets other heap members appropriately,
-         display flag is set to false
-Function input/parameters: heap data (HeapType *), initial capacity (int)
+Name: storePatientInSlot
+Process: takes a free slot, appends the name to the name arena, 
+         records time in, adds the name to the name index if enabled,
+         making room in the index first, gives the slot back if 
+         the name arena could not grow
+Function input/parameters: heap data (HeapType *), patient name (const char *),
+                           time in (time_t)
 Function output/parameters: updated heap data (HeapType *)
-Function output/returned: none
+Function output/returned: handle of slot, INVALID_HANDLE if memory ran
+                          out (int)
 Device input/---: none
 Device output/---: none
-Dependencies: malloc, sizeof
+Dependencies: reserveNameIndex, allocateSlot, appendArenaName, getFreeSlot, 
+              getPatientSlot, insertNameIndex
 */
-void initializeHeap( HeapType *heapPtr, int initialCapacity )
+int storePatientInSlot( HeapType *heap, const char *nameSet, time_t timeSet )
   {
-  // set the other heap memebers appropriatly
-  heapPtr->size = 0;
-  heapPtr->capacity = initialCapacity;
-  
-  // set display flag to false with function	
-  setDisplayFlag( heapPtr, false );
-  
-  // allocate memory of array
-  heapPtr->array = ( PatientType *)malloc( 
-               initialCapacity * sizeof( PatientType ) );
+  // variables
+  int handle;
+
+  // with room made first, indexing the name below cannot fail
+  if( !reserveNameIndex( heap, 1 ) )
+    {
+    return INVALID_HANDLE;
+    }
+
+  handle = allocateSlot( heap );
+
+  // growing the name arena may move a file backed heap's slots,
+  // so the slot is found by handle rather than held by address,
+  // a name with no room puts the slot back on the free stack
+  if( !appendArenaName( heap, nameSet, handle ) )
+    {
+    *getFreeSlot( heap, heap->freeCount ) = handle;
+
+    heap->freeCount++;
+
+    return INVALID_HANDLE;
+    }
+
+  getPatientSlot( heap, handle )->timeIn = timeSet;
+
+  if( heap->nameBuckets != NULL )
+    {
+    insertNameIndex( heap, handle );
+    }
+
+  return handle;
   }
 
 /*
-Name: isEmpty
-Process: reports if heap is empty
-Function input/parameters: heap data (const HeapType)
-Function output/parameters: none
-Function output/returned: Boolean result of test (bool)
+Name: syncHeapFile
+Process: writes the heap counters to the file header and flushes the
+         mapping to disk, the file then survives a machine crash
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap file (HeapType *)
+Function output/returned: Boolean result, false if not file backed or
+                          the flush failed (bool)
 Device input/---: none
-Device output/---: none
-Dependencies: none
+Device output/---: heap file
+Dependencies: storeHeapFileCounters, msync
 */
-bool isEmpty( const HeapType heap )
+bool syncHeapFile( HeapType *heap )
   {
-  // return if the heap tree is empty	
-  return heap.size == 0;
+  if( heap->fileHeader == NULL )
+    {
+    return false;
+    }
+
+  storeHeapFileCounters( heap );
+
+#ifdef HEAP_FILE_SUPPORT
+  return msync( heap->fileHeader, heap->mapLength, MS_SYNC ) == 0;
+#else
+  return false;
+#endif
   }
 
 /*
-Name: removeItem
-Process: removes item from heap, reports removal action, adjusts data, 
-         displays removal action, updates size, calls trickle down to reset heap
+Name: takeNextSequence
+Process: hands out the next arrival sequence of the heap,
+         rebases sequences if the counter would wrap
 Function input/parameters: heap data (HeapType *)
-Function output/parameters: updated heap data (HeapType *),
-                            patient data removed (PatientType *)
-Function output/returned: none
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: arrival sequence (uint32_t)
 Device input/---: none
-Device output/monitor: removal action displayed as specified
-Dependencies: setPatientFromStruct, getPatientInfo, printf,
-              trickleDownArrayHeap, others acceptable
+Device output/---: none
+Dependencies: rebaseHeapSequences
 */
-void removeItem( PatientType *removed, HeapType *heap )
+uint32_t takeNextSequence( HeapType *heap )
   {
-  // variables
-  char returnStr[ STD_STR_LEN ];   
-    
-  if( heap->size > 0 )
+  // check for the counter about to wrap
+  if( heap->nextSequence == KEY_SEQUENCE_MASK )
     {
-    // assign value at index 0 to the remove pointer 
-    setPatientFromStruct( removed, heap->array[0] );       	  
-   
-    // check if verbose is true  
-    if( heap->displayFlag )
+    rebaseHeapSequences( heap );
+
+    // oldest patient has waited the whole range, later arrivals tie
+    if( heap->nextSequence == KEY_SEQUENCE_MASK )
       {
-      // display operation    
-      getPatientInfo( returnStr , *removed );
-      printf( "\nRemoving patient: %s\n", returnStr );
-      }  
-      
-    // grab value at size -1 and put into index 0     
-    setPatientFromStruct( &heap->array[0], heap->array[ heap->size - 1 ] );    
-  
-    // decrement size
-    heap->size--;      
-  
-    // now trickle down and restructure the max heap 
-    trickleDownArrayHeap( heap, 0 );	
+      return heap->nextSequence;
+      }
     }
+
+  heap->nextSequence++;
+
+  return heap->nextSequence - 1;
   }
 
 /*
-Name: setDisplayFlag
-Process: sets Boolean flag to drive bubble up, trickle down displays
-Function input/parameters: heap data (HeapType *), flag (bool)
+Name: traceHeapOperation
+Process: records an add, removal, bulk add or priority change, stamps
+         the operation once so its sift steps need no counter reads,
+         a name is carried in the name events that follow
+Function input/parameters: heap data (HeapType *), event kind (int),
+                           handle (int), key (uint64_t), 
+                           time in, old key, or zero (uint64_t),
+                           patient name, may be NULL (const char *)
 Function output/parameters: updated heap data (HeapType *)
 Function output/returned: none
 Device input/---: none
 Device output/---: none
-Dependencies: none
+Dependencies: readHeapTicks, strlen, nextHeapTraceEvent, memcpy,
+              publishTraceEvent
 */
-void setDisplayFlag( HeapType *heap, bool flagSet )
+void traceHeapOperation( HeapType *heap, int op, int handle, uint64_t key,
+                                      uint64_t otherKey, const char *name )
   {
-  // set display flag    
-  heap->displayFlag = flagSet;		
+  // variables
+  HeapTraceEventType *event;
+  int length = name != NULL ? (int)strlen( name ) : 0, offset;
+
+  heap->trace->timestamp = readHeapTicks();
+
+  if( length > MAX_NAME_LEN )
+    {
+    length = MAX_NAME_LEN;
+    }
+
+  event = nextHeapTraceEvent( heap );
+
+  event->timestamp = heap->trace->timestamp;
+  event->op = (uint8_t)op;
+  event->length = (uint8_t)length;
+  event->arity = (uint16_t)heap->arity;
+  event->handle = handle;
+  event->data.step.key = key;
+  event->data.step.otherKey = otherKey;
+  event->data.step.index = INVALID_POSITION;
+  event->data.step.otherIndex = INVALID_POSITION;
+  event->data.step.otherHandle = INVALID_HANDLE;
+  event->data.step.childOffset = 0;
+
+  publishTraceEvent( heap->trace );
+
+  // name follows in fixed size chunks
+  for( offset = 0; offset < length; offset += TRACE_NAME_CHUNK )
+    {
+    event = nextHeapTraceEvent( heap );
+
+    event->timestamp = heap->trace->timestamp;
+    event->op = TRACE_NAME;
+    event->length = (uint8_t)( length - offset < TRACE_NAME_CHUNK 
+                                       ? length - offset : TRACE_NAME_CHUNK );
+    event->arity = (uint16_t)heap->arity;
+    event->handle = handle;
+
+    memcpy( event->data.text, &name[ offset ], event->length );
+
+    publishTraceEvent( heap->trace );
+    }
   }
 
 /*
-Name: showArray
-Process: displays array as is, from lowest index to highest
-Function input/parameters: heap data (HeapType)
-Function output/parameters: none
+Name: traceHeapStep
+Process: records one bubble up or trickle down step, the entry that moves
+         and the parent or child it trades places with, with their indices
+Function input/parameters: heap data (HeapType *), event kind (int),
+                           moving entry (HeapEntryType), its index (int),
+                           other entry (HeapEntryType), its index (int),
+                           child offset within the child block (int)
+Function output/parameters: updated heap data (HeapType *)
 Function output/returned: none
 Device input/---: none
-Device output/monitor: array displayed as specified
-Dependencies: getPatientInfo, printf
+Device output/---: none
+Dependencies: nextHeapTraceEvent, publishTraceEvent
 */
-void showArray( HeapType heap )
+void traceHeapStep( HeapType *heap, int op, HeapEntryType entry, int index,
+                  HeapEntryType other, int otherIndex, int childOffset )
   {
   // variables
-  int index;
-  char data[STD_STR_LEN];
-  
-  // iterate through array
-  for( index = 0; index < heap.size; index++ )
-    {
-    // display patient data at index
-    getPatientInfo( data, heap.array[index] );
-    
-    printf( "%s\n ", data );	
-    }		
+  HeapTraceEventType *event = nextHeapTraceEvent( heap );
+
+  event->timestamp = heap->trace->timestamp;
+  event->op = (uint8_t)op;
+  event->length = 0;
+  event->arity = (uint16_t)heap->arity;
+  event->handle = entry.handle;
+  event->data.step.key = entry.key;
+  event->data.step.otherKey = other.key;
+  event->data.step.index = index;
+  event->data.step.otherIndex = otherIndex;
+  event->data.step.otherHandle = other.handle;
+  event->data.step.childOffset = childOffset;
+
+  publishTraceEvent( heap->trace );
   }
 
 /*
 Name: trickleDownArrayHeap
-Process: recursively rebalances heap after data removal,
+Process: iteratively rebalances heap after data removal,
          every child has a lower priority or later arrival time than its parent,
-         displays trickle down actions to screen
+         carries a hole down from the current index, picks the highest of
+         up to arity children with the heap's child selection kernel,
+         prefetches the next level, moves that child up one level,
+         then writes the displaced entry once at its final index,
+         records trickle down steps in the heap's trace
 Function input/parameters: heap data (HeapType *), current index (int)
 Function output/parameters: updated heap data (HeapType *)
 Function output/returned: none
 Device input/---: none
-Device output/monitor: trickle down operations displayed as specified
-Dependencies: setPatientFromStruct, comparePriority, getPatientInfo,
-              printf, trickleDownArrayHeap (recursively), others acceptable
+Device output/---: none
+Dependencies: getHeapEntry, prefetchHeapLevel, selectLargerChild, 
+              traceHeapStep, setHeapEntry, recordSift
 */
-void trickleDownArrayHeap( HeapType *heap, int currentIndex ) 
+void trickleDownArrayHeap( HeapType *heap, int currentIndex )
   {		
   // variables
-  PatientType leftChild, rightChild, parent;
-  int leftChildIndex = currentIndex * 2 + 1, rightChildIndex = currentIndex * 2 + 2;
-  char parentStr[ STD_STR_LEN ], 
-        leftChildStr[ STD_STR_LEN ], rightChildStr[ STD_STR_LEN ];
-  bool leftLarger = false, rightLarger = false;
+  HeapEntryType moving = *getHeapEntry( heap, currentIndex );
+  int arity = heap->arity, size = heap->size;
+  int firstChildIndex = currentIndex * arity + 1;
+  int endIndex, largerIndex;
+  int levels = 0, comparisons = 0;
+  uint64_t largerKey;
+  bool holeSettled = false;
   
-  // grab the data from parent pointer and assign to a temp
-  setPatientFromStruct( &parent, heap->array[ currentIndex ] );
-    
-  // check right child index is within size
-  if( rightChildIndex < heap->size )
+  // loop while the hole still has children within size
+  while( !holeSettled && firstChildIndex < size )
     {
-    // assign right and left childrens data to temp storage
-    setPatientFromStruct( &rightChild, heap->array[ rightChildIndex ] );
-    setPatientFromStruct( &leftChild, heap->array[ leftChildIndex ] );
-    
-    // check if right child has higher priority than left and parent
-    if( comparePriority( parent, rightChild ) < 0 && comparePriority( leftChild, rightChild ) < 0 )
+    // start loading the level below while this level is compared
+    prefetchHeapLevel( heap, firstChildIndex );
+
+    // protect against going off the end of the array
+    endIndex = firstChildIndex + arity;
+
+    if( endIndex > size )
       {
-      // set right child bool to true
-      rightLarger = true;
-      
-      // set left child bool to false    
-      leftLarger = false;
+      endIndex = size;
       }
-      
-    // otherwise check if left is larger than parent and right
-    else if( comparePriority( parent, leftChild ) < 0 && comparePriority( rightChild, leftChild ) < 0 )
+
+    largerIndex = selectLargerChild( heap, firstChildIndex, endIndex );
+    largerKey = getHeapEntry( heap, largerIndex )->key;
+
+    // every other child against the first, then the winner against moving
+    comparisons += endIndex - firstChildIndex;
+
+    // check if larger child has higher priority than the moving entry
+    if( moving.key < largerKey )
       {
-      // set left to true
-      leftLarger = true;
-      
-      // set right to false
-      rightLarger = false;
+#if HEAP_TRACE
+      // record the step, display mode prints it when the operation ends
+      if( heap->trace != NULL )
+        {
+        traceHeapStep( heap, TRACE_TRICKLE_DOWN, moving, currentIndex,
+                            *getHeapEntry( heap, largerIndex ), largerIndex, 
+                                                largerIndex - firstChildIndex );
+        }
+#endif
+
+      // move the larger child up into the hole
+      setHeapEntry( heap, currentIndex, *getHeapEntry( heap, largerIndex ) );
+
+      // hole moves down to the child's index
+      currentIndex = largerIndex;
+      firstChildIndex = currentIndex * arity + 1;
+
+      levels++;
       }
-    }
-    
-  // otherwise check if left index is within size
-  else if( leftChildIndex < heap->size )
-    {
-    // set the left child data to temp storage
-    setPatientFromStruct( &leftChild, heap->array[ leftChildIndex ] );
-    
-    // check if left is larger than parent
-    if( comparePriority( parent, leftChild ) < 0 )
+
+    // otherwise the hole is where the moving entry belongs
+    else
       {
-      // set left to true
-      leftLarger = true;   
+      holeSettled = true;
       }
     }
-    
-  // check if right was the largest
-  if( rightLarger )
+
+  // write the displaced entry once at its final index
+  setHeapEntry( heap, currentIndex, moving );
+
+  recordSift( heap, levels, comparisons );
+  }
+
+/*
+Name: updatePriority
+Process: changes the priority of a waiting patient found by handle,
+         keeps the original arrival sequence, traces the change, then
+         bubbles up or trickles down from the patient's current index 
+         in the position map, a bucket queue moves the entry into the
+         ring of its new level instead, keeping it at its old priority 
+         if that ring cannot grow, displays its sift steps
+Function input/parameters: heap data (HeapType *), handle (int),
+                           new priority (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if handle is not waiting
+                          or memory ran out (bool)
+Device input/---: none
+Device output/monitor: sift operations displayed as specified
+Dependencies: getSlotPosition, advanceHeapMigration, removeBucketEntry, 
+              getHeapEntry, makeHeapKey, getKeySequence, 
+              traceHeapOperation, pushBucketEntry, bubbleUpArrayHeap, 
+              trickleDownArrayHeap, showHeapTrace
+*/
+bool updatePriority( HeapType *heap, int handle, int newPriority )
+  {
+  // variables
+  int index;
+  uint64_t oldKey, newKey;
+  HeapEntryType entry;
+
+  // check for a handle that is not waiting in the heap
+  if( handle < 0 || handle >= heap->slotCount 
+                     || *getSlotPosition( heap, handle ) == INVALID_POSITION )
     {
-    // check if verbose is true
-    if( heap->displayFlag )
-      {
-      // get the data at the node
-      getPatientInfo( parentStr, parent );
-      getPatientInfo( rightChildStr, rightChild );    
-               
-      // display operations
-      printf( "   - Trickling down\n" );
-      printf( "     - moving down parent: %s\n", parentStr );
-      printf( "     - moving left child: %s\n\n", rightChildStr );
-      }
-    
-    // swap data of parent with right child
-    setPatientFromStruct( &heap->array[currentIndex], rightChild );
-    setPatientFromStruct( &heap->array[rightChildIndex], parent );
-    
-    // recurse with right child
-    trickleDownArrayHeap( heap, rightChildIndex );
+    return false;
     }
-    
-  // otherwise check if the left was the largest
-  else if( leftLarger )
+
+  advanceHeapMigration( heap, 1 );
+
+  index = *getSlotPosition( heap, handle );
+
+  // a bucket queue moves the entry to the ring of its new level
+  if( heap->bucketQueue != NULL )
     {
-    // check if verbose is true
-    if( heap->displayFlag )
+    entry = removeBucketEntry( heap, handle );
+    oldKey = entry.key;
+    }
+
+  else
+    {
+    oldKey = getHeapEntry( heap, index )->key;
+    }
+
+  // same arrival sequence, new priority
+  newKey = makeHeapKey( newPriority, getKeySequence( oldKey ) );
+
+  // a new level ring that cannot grow leaves the patient where it was,
+  // its old ring has just given up a place
+  if( heap->bucketQueue != NULL )
+    {
+    entry.key = newKey;
+
+    if( !pushBucketEntry( heap, entry ) )
       {
-      // get the data at the node
-      getPatientInfo( parentStr, parent );
-      getPatientInfo( leftChildStr, leftChild );    
-               
-      // display operations
-      printf( "   - Trickling down\n" );
-      printf( "     - moving down parent: %s\n", parentStr );
-      printf( "     - moving left child: %s\n\n", leftChildStr );
+      entry.key = oldKey;
+
+      pushBucketEntry( heap, entry );
+
+      return false;
       }
-    
-    // swap data of parent with left child
-    setPatientFromStruct( &heap->array[currentIndex], leftChild );
-    setPatientFromStruct( &heap->array[leftChildIndex], parent );
-    
-    // recurse with left child
-    trickleDownArrayHeap( heap, leftChildIndex );   
     }
+
+  if( heap->trace != NULL )
+    {
+    traceHeapOperation( heap, TRACE_UPDATE, handle, newKey, oldKey, NULL );
+    }
+
+  // higher key moves toward the root, lower key toward the leaves,
+  // a bucket queue entry is already in its new ring
+  if( heap->bucketQueue == NULL && newKey > oldKey )
+    {
+    getHeapEntry( heap, index )->key = newKey;
+
+    bubbleUpArrayHeap( heap, index );
+    }
+
+  else if( heap->bucketQueue == NULL )
+    {
+    getHeapEntry( heap, index )->key = newKey;
+
+    trickleDownArrayHeap( heap, index );
+    }
+
+  if( heap->displayFlag )
+    {
+    showHeapTrace( heap );
+    }
+
+  return true;
+  }
+
+
+/*
+Name: validateHeapFile
+Process: checks a mapped heap file header, magic number, version, entry
+         sizes, counter ranges, and that the regions match the layout 
+         for the stored capacity and fit in the file, reads no entries
+Function input/parameters: heap file header (const HeapFileHeaderType *),
+                           mapped file length (size_t)
+Function output/parameters: none
+Function output/returned: Boolean result, true if file can be used (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: setHeapFileLayout
+*/
+bool validateHeapFile( const HeapFileHeaderType *header, size_t fileLength )
+  {
+  // variables
+  HeapFileHeaderType layout;
+
+  if( header->magic != HEAP_FILE_MAGIC 
+      || header->version != HEAP_FILE_VERSION
+      || header->entrySize != sizeof( HeapEntryType )
+      || header->slotSize != sizeof( PatientSlotType )
+      || header->arity < MIN_HEAP_ARITY || header->arity > MAX_HEAP_ARITY 
+      || header->capacity < 0 )
+    {
+    return false;
+    }
+
+  // waiting entries need slots, free slots are a subset of used slots
+  if( header->size < 0 || header->size > header->slotCount 
+      || header->slotCount > header->capacity 
+      || header->freeCount < 0 || header->freeCount > header->slotCount
+      || header->size + header->freeCount != header->slotCount
+      || header->arenaLiveBytes > header->arenaSize 
+      || header->arenaSize > header->arenaCapacity )
+    {
+    return false;
+    }
+
+  setHeapFileLayout( &layout, header->capacity, header->arity, 
+                                                     header->arenaCapacity );
+
+  return layout.arrayOffset == header->arrayOffset
+         && layout.slotsOffset == header->slotsOffset
+         && layout.freeSlotsOffset == header->freeSlotsOffset
+         && layout.positionsOffset == header->positionsOffset
+         && layout.arenaOffset == header->arenaOffset
+         && layout.fileLength == header->fileLength
+         && header->fileLength <= fileLength;
   }
+
+
+#endif   // HEAP_UTILITY_C
@@ -2,159 +2,2022 @@
 #define HEAP_UTILITY_H
 
 #include "PatientUtility.c"
+#include "TraceUtility.c"
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+
+// file backed heaps need POSIX memory mapping, which also lets an
+// incremental resize hand moved pages back before freeing a block
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define HEAP_FILE_SUPPORT
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // constants
 
+// handle value returned when no patient slot is available
+#define INVALID_HANDLE -1
+
+// position stored for a slot that is not in the heap
+#define INVALID_POSITION -1
+
+// name index bucket states and sizing, load is kept at or below one half
+#define EMPTY_BUCKET -1
+#define MIN_NAME_BUCKETS 16
+
+// longest name kept in the name arena, longer names are truncated,
+// every name stored fits the patient record it is copied back out to
+#define MAX_NAME_LEN ( STD_STR_LEN - 1 )
+
+// first size of the name arena in bytes
+#define MIN_ARENA_CAPACITY 1024
+
+// capacity is multiplied by the growth factor when full, once fewer than
+// capacity over the factor squared are waiting it shrinks to the waiting
+// count times the factor, the gap keeps a heap near one size from
+// resizing back and forth
+#define DEFAULT_GROWTH_FACTOR 2.0
+#define MIN_GROWTH_FACTOR 1.125
+#define MAX_GROWTH_FACTOR 4.0
+
+// incremental resizing moves this many heap indices and this many name
+// arena bytes per operation, enough to finish before adds fill the new
+// blocks at the smallest growth factor with the longest names
+#ifndef HEAP_MIGRATION_STEP
+#define HEAP_MIGRATION_STEP 32
+#endif
+
+#define HEAP_MIGRATION_BYTES ( 2 * HUGE_STR_LEN )
+
+// ordering key layout, biased priority in high bits, 
+// inverted arrival sequence in low bits so earlier arrivals sort higher
+#define KEY_SEQUENCE_BITS 32
+#define KEY_SEQUENCE_MASK 0xFFFFFFFFu
+#define KEY_PRIORITY_BIAS 0x80000000u
+
+// children per node, override at build time or choose with 
+// initializeHeapWithArity, 4 or 8 keeps each child block in one cache line
+#ifndef DEFAULT_HEAP_ARITY
+#define DEFAULT_HEAP_ARITY 2
+#endif
+
+#define MIN_HEAP_ARITY 2
+#define MAX_HEAP_ARITY 16
+
+// alignment used for the heap array so child blocks never split lines
+#define CACHE_LINE_SIZE 64
+
+// kernels picking the larger child while sifting down, the vector ones
+// are compiled for x86 by GCC and clang and chosen at run time with
+// setChildSelect, scalar stays the default as the next level waits on
+// the pick and the vector reductions take longer to finish one
+#if ( defined( __x86_64__ ) || defined( __i386__ ) ) \
+                           && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#define HEAP_SIMD_SUPPORT
+#define HEAP_TARGET( isa ) __attribute__( ( target( isa ) ) )
+#else
+#define HEAP_TARGET( isa )
+#endif
+
+#define CHILD_SELECT_SCALAR 0
+#define CHILD_SELECT_SSE42 1
+#define CHILD_SELECT_AVX2 2
+
+// heap file identification, "HEAP" read as little endian bytes,
+// bump the version whenever the header or a region layout changes
+#define HEAP_FILE_MAGIC 0x50414548u
+#define HEAP_FILE_VERSION 1
+
+// latency timing, 0 at build time drops the counter reads from every add
+// and remove, operation counters are always kept
+#ifndef HEAP_LATENCY_STATS
+#define HEAP_LATENCY_STATS 1
+#endif
+
+// one add or remove in this many is timed, a power of two, 
+// 1 times them all at the cost of two counter reads per operation
+#ifndef HEAP_LATENCY_SAMPLE_INTERVAL
+#define HEAP_LATENCY_SAMPLE_INTERVAL 16
+#endif
+
+// time stamp counter where there is one, latency ticks are nanoseconds
+// everywhere else
+#if defined( __x86_64__ ) || defined( __i386__ )
+#if defined( _MSC_VER )
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define HEAP_TICK_COUNTER
+#endif
+
+// latency histograms are log linear like HDR histograms, each power of
+// two range of ticks splits into LATENCY_SUB_BUCKETS equal buckets,
+// so any recorded value is within 1/8 of its bucket's lower bound
+#define LATENCY_SUB_BUCKET_BITS 3
+#define LATENCY_SUB_BUCKETS ( 1 << LATENCY_SUB_BUCKET_BITS )
+#define LATENCY_BUCKET_COUNT ( 64 * LATENCY_SUB_BUCKETS )
+
+// bucket queue backend, one bit of the occupied map per priority level,
+// each level ring starts at a power of two and doubles when full
+#define MAX_BUCKET_LEVELS 64
+#define MIN_BUCKET_CAPACITY 16
+
+// software prefetch of the next sift level where the compiler supports it
+#if defined( __GNUC__ ) || defined( __clang__ )
+#define HEAP_PREFETCH( address ) __builtin_prefetch( ( address ), 0, 3 )
+#else
+#define HEAP_PREFETCH( address ) ( (void)( address ) )
+#endif
+
 // data structures
+
+// heap node, holds only the slot handle and the precomputed ordering key,
+// sifts read nothing else, so four nodes share a cache line and the
+// patient payload below is touched only as a patient arrives or leaves,
+// keys and handles stay together since every move writes both
+typedef struct HeapEntryStruct
+   {
+    uint64_t key;
+
+    int handle;
+   } HeapEntryType;
+
+// patient payload, the name lives in the heap's name arena
+// and priority is read back from the ordering key
+typedef struct PatientSlotStruct
+   {
+    time_t timeIn;
+
+    uint32_t nameOffset;
+
+    uint16_t nameLength;
+   } PatientSlotType;
+
+// first bytes of a heap file, counters mirror the heap after every
+// operation, offsets locate each region within the mapping
+typedef struct HeapFileHeaderStruct
+   {
+    uint32_t magic, version;
+
+    uint32_t entrySize, slotSize;
+
+    int32_t capacity, arity, size, slotCount, freeCount;
+
+    uint32_t nextSequence;
+
+    uint32_t arenaSize, arenaCapacity, arenaLiveBytes;
+
+    uint64_t arrayOffset, slotsOffset, freeSlotsOffset, positionsOffset;
+
+    uint64_t arenaOffset, fileLength;
+   } HeapFileHeaderType;
+
+// running operation counters, a sift is one bubble up or trickle down
+typedef struct HeapCountersStruct
+   {
+    uint64_t comparisons, moves;
+
+    uint64_t resizes, bytesCopied;
+
+    uint64_t siftOperations, siftLevels;
+
+    int maxSiftDepth;
+   } HeapCountersType;
+
+// latency distribution of one operation kind in counter ticks,
+// holding every HEAP_LATENCY_SAMPLE_INTERVAL-th operation
+typedef struct LatencyHistogramStruct
+   {
+    uint64_t counts[ LATENCY_BUCKET_COUNT ];
+
+    uint64_t count, totalTicks, maxTicks;
+   } LatencyHistogramType;
+
+// histograms kept apart from the heap so copies of HeapType stay small,
+// the start readings let a snapshot convert ticks to nanoseconds
+typedef struct HeapLatencyStruct
+   {
+    LatencyHistogramType add, remove;
+
+    uint32_t sampleCounter;
+
+    uint64_t startTicks;
+
+    double startNs;
+   } HeapLatencyType;
+
+// FIFO ring of one priority level, count entries from head in key order,
+// so patients of equal priority leave in arrival order
+typedef struct PriorityBucketStruct
+   {
+    HeapEntryType *entries;
+
+    int head, count, mask;
+   } PriorityBucketType;
+
+// bucket queue backend for a small bounded priority range, bit n of 
+// occupied is set while level n, priority lowest plus n, holds entries
+typedef struct BucketQueueStruct
+   {
+    PriorityBucketType *levels;
+
+    int lowestPriority, levelCount;
+
+    uint64_t occupied;
+   } BucketQueueType;
+
+// snapshot returned by getHeapStats
+typedef struct HeapStatsStruct
+   {
+    HeapCountersType counters;
+
+    double averageSiftDepth;
+
+    // counter ticks per nanosecond since the heap was initialized
+    double ticksPerNs;
+
+    LatencyHistogramType addLatency, removeLatency;
+   } HeapStatsType;
+
+// old blocks of an incremental resize, index next up to end of the
+// heap, slot, free slot, and position arrays and arena bytes nextByte
+// up to endByte are still read and written here, a block is NULL
+// once all of it has moved
+typedef struct HeapMigrationStruct
+   {
+    HeapEntryType *array;
+
+    void *arrayBlock;
+
+    PatientSlotType *slots;
+
+    int *freeSlots, *positions;
+
+    int next, end;
+
+    char *nameArena;
+
+    uint32_t nextByte, endByte;
+
+    size_t pageSize;
+   } HeapMigrationType;
+
 typedef struct HeapStruct
    {
-    PatientType *array;    
+    HeapEntryType *array;    
+
+    void *arrayBlock;
+
+    PatientSlotType *slots;
+
+    char *nameArena;
+
+    uint32_t arenaSize, arenaCapacity, arenaLiveBytes;
+
+    int *freeSlots;
+
+    int *positions;
+
+    int *nameBuckets;
+
+    int nameBucketCount, nameCount;
 
-    int size, capacity;
+    int size, capacity, arity;
 
-    bool displayFlag;
+    // kernel picking the larger child, CHILD_SELECT_SCALAR unless set
+    int childSelect;
+
+    // growth factor, capacity never shrunk below, and the size
+    // below which the next shrink is tried
+    double growthFactor;
+
+    int minCapacity, shrinkSize;
+
+    int slotCount, freeCount;
+
+    uint32_t nextSequence;
+
+    HeapCountersType counters;
+
+    HeapLatencyType *latency;
+
+    // sift trace ring, NULL unless tracing or display mode is on
+    HeapTraceType *trace;
+
+    // level rings used in place of the array, NULL for the array heap,
+    // positions then hold each waiting patient's level
+    BucketQueueType *bucketQueue;
+
+    // incremental resize under way, NULL when none is
+    HeapMigrationType *migration;
+
+    HeapFileHeaderType *fileHeader;
+
+    size_t mapLength;
+
+    int fileDescriptor;
+
+    bool displayFlag, incrementalFlag;
    } HeapType;
 
 // function prototypes
 
 /*
 Name: addHeapItem
-Process: adds item to heap, reports action, updates size,
-         calls bubble up to reset heap
+Process: adds item to heap with an ordering key built from priority
+         and the heap's next arrival sequence
 Function input/parameters: heap data (HeapType *), patient name (char *),
                            patient priority (int), time in (time_t)
 Function output/parameters: updated heap data (HeapType *)
-Function output/returned: none
+Function output/returned: stable handle of patient slot (int)
 Device input/---: none
 Device output/monitor: patient addition action displayed as specified
-Dependencies: checkForResize, setPatientFromData, printf,
-              bubbleUpArrayHeap (recursively)
+Dependencies: addHeapItemWithKey, makeHeapKey, takeNextSequence
 */
-void addHeapItem( HeapType *heap, char *nameSet, 
+int addHeapItem( HeapType *heap, char *nameSet, 
                                               int prioritySet, time_t timeSet );
 
+/*
+Name: addHeapItems
+Process: adds a batch of patients to heap, sizes arrays once for the batch,
+         stores every patient in a slot with keys in batch order,
+         if the batch is at least as large as the current heap the whole 
+         array is heapified bottom up in linear time, 
+         otherwise each new entry is bubbled up, a bucket queue heap
+         pushes each entry onto its level ring instead,
+         reports action and traces it, displays its sift steps,
+         optionally returns the handle of each patient
+Function input/parameters: heap data (HeapType *), 
+                           patients to add (const PatientType *),
+                           number of patients (int)
+Function output/parameters: updated heap data (HeapType *),
+                            handles in batch order, may be NULL,
+                            all INVALID_HANDLE if memory ran out (int *)
+Function output/returned: number of patients added, zero if memory ran
+                          out and none were added (int)
+Device input/---: none
+Device output/monitor: bulk addition action displayed as specified
+Dependencies: getBucketLevel, growBucketRing, growHeap, strnlen, 
+              reserveArenaBytes, reserveNameIndex, advanceHeapMigration, 
+              storePatientInSlot, makeHeapKey, setHeapEntry,
+              takeNextSequence, pushBucketEntry, traceHeapOperation, 
+              heapifyArrayHeap, 
+              bubbleUpArrayHeap, printf, storeHeapFileCounters, showHeapTrace
+*/
+int addHeapItems( HeapType *heap, const PatientType *patients, 
+                                                    int count, int *handles );
+
+/*
+Name: addHeapItemWithKey
+Process: adds item to heap with a caller supplied ordering key, 
+         reports action, stores patient in a slot, traces the addition,
+         updates size, calls bubble up to reset heap, or pushes onto
+         the level ring of a bucket queue, displays its steps, used when several heaps share 
+         one arrival sequence or when keys are replayed
+Function input/parameters: heap data (HeapType *), patient name (const char *),
+                           time in (time_t), ordering key (uint64_t)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: stable handle of patient slot, INVALID_HANDLE
+                          if memory ran out for the heap or the name (int)
+Device input/---: none
+Device output/monitor: patient addition action displayed as specified
+Dependencies: sampleHeapTicks, checkForResize, storePatientInSlot, printf, 
+              pushBucketEntry, releaseSlot, setHeapEntry, traceHeapOperation, 
+              bubbleUpArrayHeap, storeHeapFileCounters, recordLatency, 
+              showHeapTrace
+*/
+int addHeapItemWithKey( HeapType *heap, const char *nameSet, 
+                                              time_t timeSet, uint64_t key );
+
+/*
+Name: advanceHeapMigration
+Process: moves the next part of an incremental resize, up to the given
+         number of steps of heap, slot, free slot, and position entries
+         and of name arena bytes, an arena step runs on to the end of
+         a name so no name is split between the blocks, hands the moved
+         pages of the old blocks back, frees each old block once it is
+         all moved and the migration once nothing is left, counts the
+         bytes copied
+Function input/parameters: heap data (HeapType *), steps (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: memcpy, releaseMigratedPages, free
+*/
+void advanceHeapMigration( HeapType *heap, int steps );
+
+/*
+Name: allocateHeapArray
+Process: allocates a heap array for the given capacity and arity,
+         shifts the start of the array so every block of sibling
+         entries begins on a cache line boundary
+Function input/parameters: capacity (int), arity (int)
+Function output/parameters: raw allocated block to free later (void **)
+Function output/returned: aligned heap array (HeapEntryType *)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, sizeof
+*/
+HeapEntryType *allocateHeapArray( int capacity, int arity, void **blockPtr );
+
+/*
+Name: allocateSlot
+Process: takes a free patient slot, reusing released slots first,
+         otherwise takes the next unused slot
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: handle of slot (int)
+Device input/---: none
+Device output/---: none
+Dependencies: getFreeSlot, getSlotPosition
+*/
+int allocateSlot( HeapType *heap );
+
+/*
+Name: appendArenaName
+Process: appends a name and its terminator to the name arena,
+         truncates names longer than the maximum name length,
+         makes room in the arena first when it is full,
+         records offset and length in slot
+Function input/parameters: heap data (HeapType *), name (const char *),
+                           slot handle (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the arena could not
+                          grow and the name was not stored (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: reserveArenaBytes, getPatientSlot
+*/
+bool appendArenaName( HeapType *heap, const char *name, int handle );
+
+/*
+Name: beginArenaMigration
+Process: starts an incremental resize of the name arena, allocates the
+         new arena and leaves the names already stored in the old one
+         to be moved a step at a time, names appended meanwhile go
+         to the new arena past the end of the old names
+Function input/parameters: heap data (HeapType *),
+                           new arena capacity (uint32_t)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the arena is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, createHeapMigration, free
+*/
+bool beginArenaMigration( HeapType *heap, uint32_t newCapacity );
+
+/*
+Name: beginHeapMigration
+Process: starts an incremental resize of the heap, slot, free slot, and
+         position arrays, allocates the new blocks at the new capacity
+         and leaves every index below the slot count in the old blocks
+         to be moved a step at a time, moves the first step at once
+         so the top entry is always in the new array, counts the resize
+         and resets the shrink size as resizeHeap does
+Function input/parameters: heap data (HeapType *), new capacity (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the heap is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: allocateHeapArray, malloc, createHeapMigration, free,
+              advanceHeapMigration
+*/
+bool beginHeapMigration( HeapType *heap, int newCapacity );
+
 /*
 Name: bubbleUpArrayHeap
-Process: recursively rebalances heap after new data is added,
-         displays bubble up actions
+Process: iteratively rebalances heap after new data is added,
+         carries a hole up from the current index, moving each lower parent
+         down one level, then writes the new entry once at its final index,
+         records bubble up steps in the heap's trace
 Function input/parameters: heap data (HeapType *), current index (int)
 Function output/parameters: updated heap data (HeapType *)
 Function output/returned: none
 Device input/---: none
-Device output/monitor: bubble up operations displayed as specified
-Dependencies: setPatientFromStruct, comparePriority, getPatientInfo,
-              bubbleUpArrayHeap (recursively), others acceptable
+Device output/---: none
+Dependencies: getHeapEntry, traceHeapStep, setHeapEntry, recordSift
 */
 void bubbleUpArrayHeap( HeapType *heap, int currentIndex );
 
+/*
+Name: buildHeapFromArray
+Process: initializes heap with room for exactly the given patients,
+         copies them in, then heapifies bottom up in linear time
+Function input/parameters: heap data (HeapType *), 
+                           patients to load (const PatientType *),
+                           number of patients (int)
+Function output/parameters: initialized heap data (HeapType *),
+                            handles in array order, may be NULL (int *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: initializeHeap, addHeapItems
+*/
+void buildHeapFromArray( HeapType *heap, const PatientType *patients, 
+                                                    int count, int *handles );
+
 /*
 Name: checkForResize
-Process: checks for need to resize (increase capacity of) array,
-         if necessary, creates new array with double the previous capacity,
-         updates array, then returns previous data memory to OS
+Process: moves one step of any incremental resize under way, 
+         checks for need to resize (increase capacity of) array,
+         if necessary, grows heap by its growth factor
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the heap is full
+                          and memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: advanceHeapMigration, growHeap
+*/
+bool checkForResize( HeapType *heap );
+
+/*
+Name: checkForShrink
+Process: gives memory back once few patients are left, when the size
+         drops below the shrink size the capacity is cut to the waiting
+         count times the growth factor, never below the initial capacity
+         or the highest handle still waiting, trailing free slots are
+         dropped, the name arena shrinks the same way once mostly empty,
+         a shrink saving less than one growth step waits until half
+         of those waiting have left, file backed heaps keep their size,
+         no shrink starts while an incremental resize is under way
 Function input/parameters: heap data (HeapType *)
 Function output/parameters: updated heap data (HeapType *)
 Function output/returned: none
 Device input/---: none
 Device output/---: none
-Dependencies: malloc, sizeof, setPatientFromStruct, free
+Dependencies: compactNameArena, realloc, resizeHeap
 */
-void checkForResize( HeapType *heap );
+void checkForShrink( HeapType *heap );
 
 /*
 Name: clearHeap
-Process: frees heap array, sets all other data members appropriately
+Process: frees heap, slot, and position arrays and the name index,
+         a file backed heap instead has its counters written to the
+         file header and is unmapped and closed with its patients kept,
+         frees the latency histograms, the trace ring, any
+         bucket queue levels, and the old blocks of an incremental resize,
+         sets all other data members appropriately
 Function input/parameters: heap data (HeapType *)
 Function output/parameters: updated heap data (HeapType *)
 Function output/returned: none
 Device input/---: none
 Device output/---: none
-Dependencies: free
+Dependencies: storeHeapFileCounters, munmap, close, free, freeHeapTrace
 */
 void clearHeap( HeapType *heap );
 
 /*
-Name: initializeHeap
-Process: initializes heap, creates heap array from given capacity,
-         sets other heap members appropriately,
-         display flag is set to false
-Function input/parameters: heap data (HeapType *), initial capacity (int)
+Name: closeHeapFile
+Process: closes a file backed heap through clearHeap so no array is
+         left pointing into the unmapped file and the side blocks are
+         freed, the file keeps every waiting patient for the next
+         openHeapFile, a heap in memory is left as it is
+Function input/parameters: heap data (HeapType *)
 Function output/parameters: updated heap data (HeapType *)
 Function output/returned: none
 Device input/---: none
 Device output/---: none
-Dependencies: malloc, sizeof
+Dependencies: clearHeap
 */
-void initializeHeap( HeapType *heapPtr, int initialCapacity );
+void closeHeapFile( HeapType *heap );
 
 /*
-Name: isEmpty
-Process: reports if heap is empty
-Function input/parameters: heap data (const HeapType)
+Name: compactNameArena
+Process: slides the names of all waiting patients to the front 
+         of the name arena in arena order, updates their slot offsets,
+         finishes any incremental resize first as every slot is visited
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: finishHeapMigration, malloc, free, memcpy
+*/
+void compactNameArena( HeapType *heap );
+
+/*
+Name: compareEntryKeys
+Process: orders two heap entries by ordering key, larger key first,
+         for qsort
+Function input/parameters: two heap entries (const void *)
 Function output/parameters: none
-Function output/returned: Boolean result of test (bool)
+Function output/returned: negative, zero, or positive (int)
 Device input/---: none
 Device output/---: none
 Dependencies: none
 */
-bool isEmpty( const HeapType heap );
+int compareEntryKeys( const void *one, const void *other );
 
 /*
-Name: removeItem
-Process: removes item from heap, reports removal action, adjusts data, 
-         displays removal action, updates size, calls trickle down to reset heap
+Name: createHeapMigration
+Process: allocates an incremental resize record with nothing to move,
+         notes the page size for handing moved pages back
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: new migration, NULL if memory ran out
+                          (HeapMigrationType *)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, memset, sysconf where available
+*/
+HeapMigrationType *createHeapMigration( void );
+
+/*
+Name: disableHeapTrace
+Process: stops tracing and frees the heap's trace ring
 Function input/parameters: heap data (HeapType *)
-Function output/parameters: updated heap data (HeapType *),
-                            patient data removed (PatientType *)
+Function output/parameters: updated heap data (HeapType *)
 Function output/returned: none
 Device input/---: none
-Device output/monitor: removal action displayed as specified
-Dependencies: setPatientFromStruct, getPatientInfo, printf,
-              trickleDownArrayHeap, others acceptable
+Device output/---: none
+Dependencies: freeHeapTrace
 */
-void removeItem( PatientType *removed, HeapType *heap );
+void disableHeapTrace( HeapType *heap );
 
 /*
-Name: setDisplayFlag
-Process: sets Boolean flag to drive bubble up, trickle down displays
-Function input/parameters: heap data (HeapType *), flag (bool)
+Name: drainSorted
+Process: removes every patient into a caller buffer in priority order,
+         finishes any incremental resize, then heapsorts the entries
+         in place, moving only the small
+         entries, a bucket queue is popped into the array instead,
+         then copies each patient out of its slot once,
+         leaves the heap empty with all slots free and no indexed names,
+         displays and traces each removal action
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: empty heap data (HeapType *),
+                            patients removed in priority order (PatientType *)
+Function output/returned: number of patients removed (int)
+Device input/---: none
+Device output/monitor: removal actions displayed as specified
+Dependencies: finishHeapMigration, popBucketEntry, sinkToLeafArrayHeap, 
+              getEntryPatient, traceHeapOperation, getPatientInfo, printf, 
+              checkForShrink, storeHeapFileCounters
+*/
+int drainSorted( HeapType *heap, PatientType *removed );
+
+/*
+Name: enableHeapTrace
+Process: attaches a new trace ring of at least the given number of events,
+         replacing any ring already attached, every later add, removal, 
+         priority change and sift step is recorded in it
+Function input/parameters: heap data (HeapType *), event capacity (int)
 Function output/parameters: updated heap data (HeapType *)
-Function output/returned: none
+Function output/returned: Boolean result, false if tracing was compiled
+                          out with HEAP_TRACE 0 (bool)
 Device input/---: none
 Device output/---: none
-Dependencies: none
+Dependencies: freeHeapTrace, createHeapTrace
 */
-void setDisplayFlag( HeapType *heap, bool flagSet );
+bool enableHeapTrace( HeapType *heap, int capacity );
 
 /*
-Name: showArray
-Process: displays array as is, from lowest index to highest
-Function input/parameters: heap data (HeapType)
+Name: enableNameIndex
+Process: turns on the name to handle index, sizes it once for
+         every patient currently waiting in the heap, then adds them
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the index is still off (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: resizeNameIndex, getSlotPosition, insertNameIndex
+*/
+bool enableNameIndex( HeapType *heap );
+
+/*
+Name: findBucketEntry
+Process: finds a waiting patient's entry in the ring of its priority
+         level, the position map holds the level in bucket queue mode
+Function input/parameters: heap data (const HeapType *), handle (int)
 Function output/parameters: none
-Function output/returned: none
+Function output/returned: entry in its level ring, NULL if not found
+                          (HeapEntryType *)
 Device input/---: none
-Device output/monitor: array displayed as specified
-Dependencies: getPatientInfo, printf
+Device output/---: none
+Dependencies: getSlotPosition
 */
-void showArray( HeapType heap );
+HeapEntryType *findBucketEntry( const HeapType *heap, int handle );
 
 /*
-Name: trickleDownArrayHeap
-Process: recursively rebalances heap after data removal,
-         every child has a lower priority or later arrival time than its parent,
-         displays trickle down actions to screen
-Function input/parameters: heap data (HeapType *), current index (int)
+Name: findPatientHandle
+Process: looks up a waiting patient by name in the name index,
+         if several patients share the name, one of their handles is returned
+Function input/parameters: heap data (const HeapType *), 
+                           patient name (const char *)
+Function output/parameters: none
+Function output/returned: handle of patient, 
+                          INVALID_HANDLE if not found or index is off (int)
+Device input/---: none
+Device output/---: none
+Dependencies: hashPatientName, compareString
+*/
+int findPatientHandle( const HeapType *heap, const char *name );
+
+/*
+Name: finishHeapMigration
+Process: moves whatever is left of an incremental resize at once,
+         used before operations that touch every entry anyway
+Function input/parameters: heap data (HeapType *)
 Function output/parameters: updated heap data (HeapType *)
 Function output/returned: none
 Device input/---: none
-Device output/monitor: trickle down operations displayed as specified
-Dependencies: setPatientFromStruct, comparePriority, getPatientInfo,
-              printf, trickleDownArrayHeap (recursively), others acceptable
+Device output/---: none
+Dependencies: advanceHeapMigration
 */
-void trickleDownArrayHeap( HeapType *heap, int currentIndex );
+void finishHeapMigration( HeapType *heap );
 
+/*
+Name: gatherHeapEntries
+Process: copies every entry of a heap into a new buffer ordered by key,
+         larger key first, bucket queue levels are read highest first
+         and are then already in order, an array heap is sorted
+Function input/parameters: heap data (const HeapType *)
+Function output/parameters: none
+Function output/returned: new buffer of heap size entries, NULL if
+                          memory ran out (HeapEntryType *)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, memcpy, qsort, compareEntryKeys
+*/
+HeapEntryType *gatherHeapEntries( const HeapType *heap );
 
-#endif   // HEAP_UTILITY_H
+/*
+Name: getBestChildSelect
+Process: finds the widest child selection kernel the processor runs,
+         checked at run time so one build serves every x86 machine
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: child selection kernel (int)
+Device input/---: none
+Device output/---: none
+Dependencies: __builtin_cpu_supports where available
+*/
+int getBestChildSelect( void );
+
+/*
+Name: getBucketLevel
+Process: maps a priority to its bucket queue level, priorities outside
+         the range share the lowest or highest level, where key order
+         inside the ring still keeps them exact
+Function input/parameters: bucket queue (const BucketQueueType *), 
+                           priority (int)
+Function output/parameters: none
+Function output/returned: level index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getBucketLevel( const BucketQueueType *queue, int priority );
+
+/*
+Name: getEntryPatient
+Process: assembles full patient data for a heap entry, 
+         name from the name arena bounded to the patient name buffer,
+         priority from the ordering key, time in from the slot
+Function input/parameters: heap data (const HeapType *), entry (HeapEntryType)
+Function output/parameters: patient data (PatientType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: copyStringBounded, getSlotName, getKeyPriority, 
+              getPatientSlot
+*/
+void getEntryPatient( const HeapType *heap, HeapEntryType entry, 
+                                                       PatientType *patient );
 
+/*
+Name: getFreeSlot
+Process: finds an entry of the free slot stack, in the old block if
+         an incremental resize has not moved it yet
+Function input/parameters: heap data (const HeapType *), stack index (int)
+Function output/parameters: none
+Function output/returned: free slot stack entry (int *)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int *getFreeSlot( const HeapType *heap, int index );
+
+/*
+Name: getGrownCapacity
+Process: finds the capacity to grow to, the current capacity times
+         the growth factor, at least one more, and at least the count
+         needed, held to the int range
+Function input/parameters: heap data (const HeapType *), 
+                           entries needed (int)
+Function output/parameters: none
+Function output/returned: new capacity (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getGrownCapacity( const HeapType *heap, int needed );
+
+/*
+Name: getHeapEntry
+Process: finds the entry at a heap index, in the old block if an
+         incremental resize has not moved it yet, every sift reads
+         and writes through here
+Function input/parameters: heap data (const HeapType *), heap index (int)
+Function output/parameters: none
+Function output/returned: heap entry (HeapEntryType *)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+HeapEntryType *getHeapEntry( const HeapType *heap, int index );
+
+/*
+Name: getHeapPatient
+Process: copies out the data of a waiting patient found by handle
+Function input/parameters: heap data (const HeapType *), handle (int)
+Function output/parameters: patient data (PatientType *)
+Function output/returned: Boolean result, false if handle is not waiting (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getSlotPosition, findBucketEntry, getEntryPatient, 
+              getHeapEntry
+*/
+bool getHeapPatient( const HeapType *heap, int handle, PatientType *patient );
+
+/*
+Name: getHeapStats
+Process: copies the heap's counters and latency histograms into a
+         snapshot, computes the average sift depth and the counter rate
+Function input/parameters: heap data (const HeapType *)
+Function output/parameters: statistics snapshot (HeapStatsType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: readHeapTicks, readHeapNanoseconds, memset
+*/
+void getHeapStats( const HeapType *heap, HeapStatsType *stats );
+
+/*
+Name: getKeyPriority
+Process: recovers patient priority from the high bits of an ordering key
+Function input/parameters: ordering key (uint64_t)
+Function output/parameters: none
+Function output/returned: priority (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getKeyPriority( uint64_t key );
+
+/*
+Name: getKeySequence
+Process: recovers the arrival sequence from the low bits of an ordering key
+Function input/parameters: ordering key (uint64_t)
+Function output/parameters: none
+Function output/returned: arrival sequence (uint32_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint32_t getKeySequence( uint64_t key );
+
+/*
+Name: getLatencyBucket
+Process: finds the histogram bucket of a tick count, values below
+         LATENCY_SUB_BUCKETS get a bucket each, larger values keep their
+         top LATENCY_SUB_BUCKET_BITS bits below the leading one
+Function input/parameters: ticks (uint64_t)
+Function output/parameters: none
+Function output/returned: bucket index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: __builtin_clzll where available
+*/
+int getLatencyBucket( uint64_t ticks );
+
+/*
+Name: getLatencyPercentile
+Process: walks a histogram to the bucket holding the given percentile
+Function input/parameters: histogram (const LatencyHistogramType *),
+                           percentile from 0 to 100 (double)
+Function output/parameters: none
+Function output/returned: lower bound of the bucket in ticks,
+                          zero if nothing was recorded (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint64_t getLatencyPercentile( const LatencyHistogramType *histogram,
+                                                         double percentile );
+
+/*
+Name: getPatientSlot
+Process: finds the patient slot of a handle, in the old block if an
+         incremental resize has not moved it yet
+Function input/parameters: heap data (const HeapType *), handle (int)
+Function output/parameters: none
+Function output/returned: patient slot (PatientSlotType *)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+PatientSlotType *getPatientSlot( const HeapType *heap, int handle );
+
+/*
+Name: getSlotName
+Process: finds the name of a slot in the name arena, in the old arena
+         if an incremental resize has not moved it yet
+Function input/parameters: heap data (const HeapType *), handle (int)
+Function output/parameters: none
+Function output/returned: null terminated name (const char *)
+Device input/---: none
+Device output/---: none
+Dependencies: getPatientSlot
+*/
+const char *getSlotName( const HeapType *heap, int handle );
+
+/*
+Name: getSlotPosition
+Process: finds the position map entry of a handle, in the old block if
+         an incremental resize has not moved it yet
+Function input/parameters: heap data (const HeapType *), handle (int)
+Function output/parameters: none
+Function output/returned: heap index or level of the slot,
+                          INVALID_POSITION if not waiting (int *)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int *getSlotPosition( const HeapType *heap, int handle );
+
+/*
+Name: getTopBucketLevel
+Process: finds the highest non-empty level of a bucket queue,
+         the leading set bit of the occupied bitmap
+Function input/parameters: bucket queue (const BucketQueueType *)
+Function output/parameters: none
+Function output/returned: level index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getTopBucketLevel( const BucketQueueType *queue );
+
+/*
+Name: getTopHeapEntry
+Process: reads the entry removeItem would take next without removing it,
+         the oldest entry of the highest level of a bucket queue, 
+         otherwise the root of the array heap, heap must not be empty
+Function input/parameters: heap data (const HeapType *)
+Function output/parameters: none
+Function output/returned: top entry (HeapEntryType)
+Device input/---: none
+Device output/---: none
+Dependencies: getTopBucketLevel, getHeapEntry
+*/
+HeapEntryType getTopHeapEntry( const HeapType *heap );
+
+/*
+Name: growBucketRing
+Process: doubles a level ring until it holds the needed number of 
+         entries, unwraps the waiting entries to the front of the new 
+         ring, counts the resize and the entries copied
+Function input/parameters: heap data (HeapType *), 
+                           level ring (PriorityBucketType *),
+                           entries needed (int)
+Function output/parameters: updated heap data (HeapType *),
+                            updated level ring (PriorityBucketType *)
+Function output/returned: Boolean result, false if memory ran out 
+                          and the ring is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, free
+*/
+bool growBucketRing( HeapType *heap, PriorityBucketType *bucket, 
+                                                                 int needed );
+
+/*
+Name: growHeap
+Process: grows the heap by its growth factor to hold at least the
+         needed count, in incremental mode moves to new blocks a step
+         at a time instead of resizing at once, an incremental resize
+         still under way is finished first, which only happens when
+         adds outrun its steps, resizes at once if the new blocks
+         cannot be allocated
+Function input/parameters: heap data (HeapType *), entries needed (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the capacity is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getGrownCapacity, finishHeapMigration, beginHeapMigration,
+              resizeHeap
+*/
+bool growHeap( HeapType *heap, int needed );
+
+/*
+Name: hashPatientName
+Process: hashes a patient name for the name index (FNV-1a)
+Function input/parameters: patient name (const char *)
+Function output/parameters: none
+Function output/returned: hash value (uint32_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint32_t hashPatientName( const char *name );
+
+/*
+Name: heapifyArrayHeap
+Process: restores heap order over the whole array bottom up (Floyd),
+         trickles down every parent from the last one to the root,
+         runs in linear time, finishes any incremental resize first
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: finishHeapMigration, trickleDownArrayHeap
+*/
+void heapifyArrayHeap( HeapType *heap );
+
+/*
+Name: initializeBucketHeap
+Process: initializes heap as with initializeHeap, but keeps waiting 
+         patients in a bucket queue, one FIFO ring per priority from 
+         lowest to highest and a bitmap of non-empty levels, adds and 
+         removes are constant time and leave the heap array unused,
+         the range holds at most MAX_BUCKET_LEVELS priorities,
+         not for file backed heaps, if memory runs out the heap is 
+         left as an array heap
+Function input/parameters: heap data (HeapType *), initial capacity (int),
+                           lowest and highest priority (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          for the bucket queue (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: initializeHeap, malloc, calloc, free
+*/
+bool initializeBucketHeap( HeapType *heapPtr, int initialCapacity, 
+                                    int lowestPriority, int highestPriority );
+
+/*
+Name: initializeHeap
+Process: initializes heap, creates heap and slot arrays from given capacity,
+         uses the default arity, sets other heap members appropriately,
+         display flag is set to false
+Function input/parameters: heap data (HeapType *), initial capacity (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: initializeHeapWithArity
+*/
+void initializeHeap( HeapType *heapPtr, int initialCapacity );
+
+/*
+Name: initializeHeapWithArity
+Process: initializes heap as with initializeHeap, 
+         but with the given number of children per node,
+         arity is kept between the minimum and maximum supported
+Function input/parameters: heap data (HeapType *), initial capacity (int),
+                           children per node (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: allocateHeapArray, malloc, sizeof, setDisplayFlag,
+              resetHeapStats
+*/
+void initializeHeapWithArity( HeapType *heapPtr, 
+                                         int initialCapacity, int arity );
+
+/*
+Name: insertNameIndex
+Process: adds the name held in a slot to the name index, 
+         doubles the bucket table first if it would pass half full
+Function input/parameters: heap data (HeapType *), handle (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the name was not indexed (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: reserveNameIndex, hashPatientName
+*/
+bool insertNameIndex( HeapType *heap, int handle );
+
+/*
+Name: isEmpty
+Process: reports if heap is empty
+Function input/parameters: heap data (const HeapType)
+Function output/parameters: none
+Function output/returned: Boolean result of test (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+bool isEmpty( const HeapType heap );
+
+/*
+Name: makeHeapKey
+Process: packs priority and arrival sequence into one ordering key,
+         a larger key is always served first, so heap comparisons are
+         a single unsigned compare with strict first in first out order 
+         within a priority
+Function input/parameters: priority (int), arrival sequence (uint32_t)
+Function output/parameters: none
+Function output/returned: ordering key (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint64_t makeHeapKey( int priority, uint32_t sequence );
+
+/*
+Name: mapHeapRegions
+Process: points the heap, slot, free slot, position, and name arrays at 
+         their regions of the mapped file using the header offsets
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+void mapHeapRegions( HeapType *heap );
+
+/*
+Name: mergeBucketLevels
+Process: merges runs of entries ordered by key, larger first, into the
+         level rings of a bucket queue, each level's ring and run are
+         merged in one pass into the new ring set aside for that level,
+         which replaces the old ring, records each level in the position
+         map
+Function input/parameters: heap data (HeapType *),
+                           entries ordered by key (const HeapEntryType *),
+                           entry count (int),
+                           new ring for each level given entries
+                           (HeapEntryType **)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: getBucketLevel, getKeyPriority, getSlotPosition, free
+*/
+void mergeBucketLevels( HeapType *heap, const HeapEntryType *entries,
+                                          int count, HeapEntryType **newRings );
+
+/*
+Name: mergeHeaps
+Process: moves every waiting patient of the source heap into the
+         destination heap and leaves the source empty, sizes the arrays
+         once, copies each patient into a destination slot keeping its
+         ordering key, if the source is at least as large as the
+         destination the whole array is heapified bottom up in linear
+         time, otherwise each moved entry is bubbled up, a bucket queue
+         destination instead gathers the source entries in key order
+         and merges each level's ring with its run in one pass,
+         heaps that share one arrival sequence merge in arrival order,
+         a source under incremental resize finishes it first, each moved
+         patient pays one step of the destination's,
+         optionally returns the new handle of each moved patient
+Function input/parameters: destination heap (HeapType *),
+                           source heap (HeapType *)
+Function output/parameters: updated destination heap (HeapType *),
+                            empty source heap (HeapType *),
+                            new handles indexed by source handle,
+                            may be NULL (int *)
+Function output/returned: Boolean result, false if memory ran out,
+                          both heaps unchanged (bool)
+Device input/---: none
+Device output/monitor: merge action displayed as specified
+Dependencies: printf, finishHeapMigration, growHeap, reserveArenaBytes,
+              reserveNameIndex, traceHeapOperation, advanceHeapMigration, 
+              storePatientInSlot, getSlotName, releaseSlot, gatherHeapEntries,
+              reserveBucketLevels, mergeBucketLevels, setHeapEntry,
+              heapifyArrayHeap, bubbleUpArrayHeap, storeHeapFileCounters,
+              showHeapTrace, malloc, free
+*/
+bool mergeHeaps( HeapType *dest, HeapType *src, int *handles );
+
+/*
+Name: nextHeapTraceEvent
+Process: claims the next trace event, in display mode a full ring is
+         printed first so no step is overwritten before it is shown
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: slot for the next event (HeapTraceEventType *)
+Device input/---: none
+Device output/monitor: sift steps displayed as specified
+Dependencies: atomic_load_explicit, showHeapTrace, claimTraceEvent
+*/
+HeapTraceEventType *nextHeapTraceEvent( HeapType *heap );
+
+/*
+Name: openHeapFile
+Process: backs the heap with a memory mapped file, an existing file is
+         mapped and its header checked without reading any entries,
+         a missing or empty file is created with the given capacity and 
+         arity, heap memory then lives in the file and survives restarts
+Function input/parameters: heap data (HeapType *), file name (const char *),
+                           initial capacity and arity for a new file (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the file cannot be 
+                          opened, mapped, or fails validation (bool)
+Device input/---: heap file
+Device output/---: heap file
+Dependencies: open, fstat, ftruncate, mmap, munmap, close, 
+              setHeapFileLayout, validateHeapFile, initializeHeapWithArity,
+              mapHeapRegions
+*/
+bool openHeapFile( HeapType *heap, const char *fileName, 
+                                         int initialCapacity, int arity );
+
+/*
+Name: popBucketEntry
+Process: takes the oldest entry of the highest non-empty level
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: removed entry (HeapEntryType)
+Device input/---: none
+Device output/---: none
+Dependencies: getTopBucketLevel
+*/
+HeapEntryType popBucketEntry( HeapType *heap );
+
+/*
+Name: prefetchHeapLevel
+Process: hints the processor to load the block of grandchildren below
+         a node, so the next trickle down level is already in cache,
+         does nothing on compilers without a prefetch builtin
+Function input/parameters: heap data (const HeapType *), node index (int)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: __builtin_prefetch where available, getHeapEntry
+*/
+void prefetchHeapLevel( const HeapType *heap, int nodeIndex );
+
+/*
+Name: pushBucketEntry
+Process: appends an entry to the ring of its priority level, doubling
+         the ring when full, an entry older than the back of the ring,
+         replayed or given a new priority, is shifted into key order,
+         records the level in the position map
+Function input/parameters: heap data (HeapType *), entry (HeapEntryType)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the entry was not added (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getBucketLevel, getKeyPriority, growBucketRing, 
+              getSlotPosition
+*/
+bool pushBucketEntry( HeapType *heap, HeapEntryType entry );
+
+/*
+Name: readHeapNanoseconds
+Process: reads the wall clock in nanoseconds for tick calibration
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: nanoseconds (double)
+Device input/---: none
+Device output/---: none
+Dependencies: timespec_get
+*/
+double readHeapNanoseconds( void );
+
+/*
+Name: readHeapTicks
+Process: reads the latency counter, the time stamp counter where there
+         is one, otherwise the clock in nanoseconds, zero when latency
+         statistics are compiled out
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: counter ticks (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: __rdtsc or readHeapNanoseconds
+*/
+uint64_t readHeapTicks( void );
+
+/*
+Name: reallocateHeapArray
+Process: resizes the heap array block in place where the allocator can,
+         large blocks are remapped by the allocator rather than copied,
+         if the block moved to a different offset from a cache line the
+         entries are shifted back onto the boundary in one move,
+         counts any bytes copied
+Function input/parameters: heap data (HeapType *), new capacity (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the block is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc, memmove
+*/
+bool reallocateHeapArray( HeapType *heap, int newCapacity );
+
+/*
+Name: reallocateHeapRegion
+Process: resizes one slot, free slot, or position block in place where
+         the allocator can, counts the live bytes if the block moved
+Function input/parameters: heap data (HeapType *), block (void *),
+                           new size in bytes (size_t), 
+                           bytes in use (size_t)
+Function output/parameters: updated copy counter (HeapType *)
+Function output/returned: resized block, NULL if memory ran out
+                          and the block is unchanged (void *)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc
+*/
+void *reallocateHeapRegion( HeapType *heap, void *block, size_t newBytes,
+                                                            size_t liveBytes );
+
+/*
+Name: rebaseHeapSequences
+Process: shifts arrival sequences of all entries down by the oldest
+         sequence still in the heap, keeps relative order of all keys,
+         used when the sequence counter runs out, finishes any
+         incremental resize first as every entry is visited
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: finishHeapMigration, makeHeapKey, getKeyPriority, 
+              getKeySequence
+*/
+void rebaseHeapSequences( HeapType *heap );
+
+/*
+Name: recordLatency
+Process: adds one sampled operation's elapsed ticks to a histogram
+Function input/parameters: histogram (LatencyHistogramType *),
+                           start ticks (uint64_t)
+Function output/parameters: updated histogram (LatencyHistogramType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: readHeapTicks, getLatencyBucket
+*/
+void recordLatency( LatencyHistogramType *histogram, uint64_t startTicks );
+
+/*
+Name: recordSift
+Process: adds one sift's levels moved and key comparisons to the counters
+Function input/parameters: heap data (HeapType *), levels (int),
+                           comparisons (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+void recordSift( HeapType *heap, int levels, int comparisons );
+
+/*
+Name: releaseMigratedPages
+Process: hands the whole pages of an old block that an incremental
+         resize has moved back to the operating system, so freeing the
+         block at the end unmaps almost nothing, a step moves less
+         than a page so the page holding the step's start goes once the
+         step reaches past it, the block's first page is kept for the
+         allocator, does nothing without POSIX memory mapping
+Function input/parameters: migration (const HeapMigrationType *),
+                           old block (void *),
+                           moved byte range start and end (size_t), (size_t)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: madvise where available
+*/
+void releaseMigratedPages( const HeapMigrationType *migration, void *block,
+                                          size_t fromBytes, size_t toBytes );
+
+/*
+Name: releaseSlot
+Process: returns a patient slot to the free slot stack for reuse,
+         marks it out of the heap, drops it from the name index if enabled,
+         counts its name bytes as garbage in the name arena
+Function input/parameters: heap data (HeapType *), handle (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: removeNameIndex, getSlotPosition, getPatientSlot, getFreeSlot
+*/
+void releaseSlot( HeapType *heap, int handle );
+
+/*
+Name: remapHeapFile
+Process: sets the heap file to a new length and maps it again at that 
+         length, the mapping may move, region pointers are reset after
+Function input/parameters: heap data (HeapType *), new length (size_t)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the file could not
+                          be resized or mapped, heap is unchanged (bool)
+Device input/---: none
+Device output/---: heap file
+Dependencies: ftruncate, mremap or munmap and mmap, mapHeapRegions
+*/
+bool remapHeapFile( HeapType *heap, size_t newLength );
+
+/*
+Name: removeBucketEntry
+Process: takes a waiting patient's entry out of its level ring,
+         closes the gap by moving the later entries forward
+Function input/parameters: heap data (HeapType *), handle (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: removed entry (HeapEntryType)
+Device input/---: none
+Device output/---: none
+Dependencies: findBucketEntry
+*/
+HeapEntryType removeBucketEntry( HeapType *heap, int handle );
+
+/*
+Name: removeByHandle
+Process: removes a waiting patient found by handle from anywhere in the heap,
+         traces the removal, fills its index with the last entry, then 
+         bubbles up or trickles down from there, a bucket queue removes
+         it from its level ring instead, releases the patient slot,
+         displays its sift steps
+Function input/parameters: heap data (HeapType *), handle (int)
+Function output/parameters: updated heap data (HeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if handle is not waiting (bool)
+Device input/---: none
+Device output/monitor: removal action displayed as specified
+Dependencies: sampleHeapTicks, getSlotPosition, advanceHeapMigration, 
+              removeBucketEntry, getHeapEntry, getEntryPatient, 
+              getPatientInfo, printf, traceHeapOperation, releaseSlot, 
+              setHeapEntry, bubbleUpArrayHeap, trickleDownArrayHeap, 
+              checkForShrink, storeHeapFileCounters, recordLatency, 
+              showHeapTrace
+*/
+bool removeByHandle( HeapType *heap, int handle, PatientType *removed );
+
+/*
+Name: removeItem
+Process: removes item from heap, reports removal action, adjusts data, 
+         displays and traces removal action, updates size, releases patient 
+         slot, calls trickle down to reset heap, a bucket queue pops its
+         highest level ring instead, displays its sift steps
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: none
+Device input/---: none
+Device output/monitor: removal action displayed as specified
+Dependencies: sampleHeapTicks, advanceHeapMigration, popBucketEntry, 
+              getHeapEntry, getEntryPatient, 
+              getPatientInfo, printf, traceHeapOperation, releaseSlot, 
+              trickleDownArrayHeap, checkForShrink, storeHeapFileCounters, 
+              recordLatency, 
+              showHeapTrace, others acceptable
+*/
+void removeItem( PatientType *removed, HeapType *heap );
+
+/*
+Name: removeNameIndex
+Process: removes a slot's handle from the name index, shifts later
+         entries of the same probe run back so no tombstones are needed
+Function input/parameters: heap data (HeapType *), handle (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: hashPatientName
+*/
+void removeNameIndex( HeapType *heap, int handle );
+
+/*
+Name: removeTopK
+Process: removes up to k highest priority patients in order into a 
+         caller buffer, each removal refills the root with a bottom up
+         sift or pops a bucket queue, displays and traces each removal action
+Function input/parameters: heap data (HeapType *), 
+                           number of patients wanted (int)
+Function output/parameters: updated heap data (HeapType *),
+                            patients removed in priority order (PatientType *)
+Function output/returned: number of patients removed (int)
+Device input/---: none
+Device output/monitor: removal actions displayed as specified
+Dependencies: advanceHeapMigration, popBucketEntry, getHeapEntry, 
+              getEntryPatient, traceHeapOperation, 
+              sinkToLeafArrayHeap, releaseSlot, getPatientInfo, printf, 
+              checkForShrink, storeHeapFileCounters
+*/
+int removeTopK( HeapType *heap, int k, PatientType *removed );
+
+/*
+Name: reserveArenaBytes
+Process: makes room for the given number of bytes past the end of the
+         name arena, finishes names still moving from the last growth,
+         compacts the arena when at least half of it is garbage,
+         otherwise doubles it until the bytes fit, in incremental mode by
+         moving the names to the new arena a step at a time
+Function input/parameters: heap data (HeapType *), bytes needed (uint32_t)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out or the
+                          heap file could not grow, the arena keeps its
+                          capacity (bool)
+Device input/---: none
+Device output/---: heap file
+Dependencies: finishHeapMigration, compactNameArena, resizeHeapFile, 
+              beginArenaMigration, realloc
+*/
+bool reserveArenaBytes( HeapType *heap, uint32_t bytes );
+
+/*
+Name: reserveBucketLevels
+Process: sets aside a new ring for each level of a bucket queue that
+         entries ordered by key will be merged into, each one a power
+         of two large enough for the level and its new entries
+Function input/parameters: heap data (const HeapType *),
+                           entries ordered by key (const HeapEntryType *),
+                           entry count (int)
+Function output/parameters: none
+Function output/returned: new ring for each level, NULL for levels
+                          without entries, NULL if memory ran out and
+                          nothing is set aside (HeapEntryType **)
+Device input/---: none
+Device output/---: none
+Dependencies: calloc, malloc, free, getBucketLevel, getKeyPriority
+*/
+HeapEntryType **reserveBucketLevels( const HeapType *heap, 
+                                  const HeapEntryType *entries, int count );
+
+/*
+Name: reserveNameIndex
+Process: makes room in the name index for the given number of names,
+         doubling the bucket table until it stays at most half full,
+         does nothing if the index is off
+Function input/parameters: heap data (HeapType *), names to add (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the index is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: resizeNameIndex
+*/
+bool reserveNameIndex( HeapType *heap, int count );
+
+/*
+Name: resetHeapStats
+Process: zeroes the operation counters and latency histograms,
+         restarts the tick calibration
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: memset, readHeapTicks, readHeapNanoseconds
+*/
+void resetHeapStats( HeapType *heap );
+
+/*
+Name: resizeHeap
+Process: grows or shrinks the heap, slot, free slot, and position arrays
+         to the given capacity in place where the allocator can, moving
+         each block in one piece when it cannot, counts the resize and 
+         the bytes copied, resets the shrink size for the new capacity,
+         capacity is never taken below the current size or slot count,
+         a file backed heap resizes its file instead,
+         any incremental resize under way is finished first
+Function input/parameters: heap data (HeapType *), new capacity (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out while
+                          growing and the capacity is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: finishHeapMigration, resizeHeapFile, reallocateHeapArray, 
+              reallocateHeapRegion
+*/
+bool resizeHeap( HeapType *heap, int newCapacity );
+
+/*
+Name: resizeHeapFile
+Process: changes the capacity and name arena size of a file backed heap,
+         grows the file before sliding regions toward the end, 
+         or slides regions toward the front before shrinking the file,
+         only used parts of each region are moved and counted
+Function input/parameters: heap data (HeapType *), new capacity (int),
+                           new name arena capacity (uint32_t)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the file could not
+                          be resized (bool)
+Device input/---: none
+Device output/---: heap file
+Dependencies: setHeapFileLayout, remapHeapFile, memmove, 
+              storeHeapFileCounters
+*/
+bool resizeHeapFile( HeapType *heap, int newCapacity, 
+                                               uint32_t newArenaCapacity );
+
+/*
+Name: resizeNameIndex
+Process: creates a new bucket table of the given power of two size,
+         re-inserts all indexed handles, frees the old table,
+         keeps the old table if the new one cannot be allocated
+Function input/parameters: heap data (HeapType *), bucket count (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the index is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, free, hashPatientName
+*/
+bool resizeNameIndex( HeapType *heap, int bucketCount );
+
+/*
+Name: roundToCacheLine
+Process: rounds a byte count or offset up to a whole cache line
+Function input/parameters: byte count (uint64_t)
+Function output/parameters: none
+Function output/returned: rounded byte count (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint64_t roundToCacheLine( uint64_t bytes );
+
+/*
+Name: sampleHeapTicks
+Process: counts an add or remove toward the latency sample interval,
+         reads the latency counter when this operation is sampled
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated sample counter (HeapType *)
+Function output/returned: start ticks, zero if not sampled (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: readHeapTicks
+*/
+uint64_t sampleHeapTicks( HeapType *heap );
+
+/*
+Name: saveHeapTrace
+Process: writes the events still in the heap's trace ring to a file
+         for tracedecoder, with the counter rate for the timestamps
+Function input/parameters: heap data (const HeapType *), 
+                           file name (const char *)
+Function output/parameters: none
+Function output/returned: Boolean result, false if the heap has no
+                          trace or the file is not written (bool)
+Device input/---: none
+Device output/---: trace file
+Dependencies: getHeapStats, writeTraceFile
+*/
+bool saveHeapTrace( const HeapType *heap, const char *fileName );
+
+/*
+Name: selectLargerChild
+Process: finds the child with the largest key in a block of siblings,
+         ties go to the earliest child, uses the heap's vector kernel
+         when the block fills whole vectors and sits in one array,
+         otherwise scans with selects that compile to conditional moves
+Function input/parameters: heap data (const HeapType *), 
+                           first child index (int), end child index (int)
+Function output/parameters: none
+Function output/returned: index of the larger child (int)
+Device input/---: none
+Device output/---: none
+Dependencies: selectLargerChildAvx2, selectLargerChildSse42, getHeapEntry
+*/
+int selectLargerChild( const HeapType *heap, int firstIndex, int endIndex );
+
+/*
+Name: selectLargerChildAvx2
+Process: finds the child with the largest key with AVX2, gathers four
+         keys per vector from pairs of entries, flips the sign bits so
+         the signed compare orders them unsigned, reduces to the maximum
+         and takes the first lane holding it, scans where AVX2 is
+         not compiled in
+Function input/parameters: child block (const HeapEntryType *), 
+                           count, a multiple of four up to 
+                           MAX_HEAP_ARITY (int)
+Function output/parameters: none
+Function output/returned: offset of the larger child in the block (int)
+Device input/---: none
+Device output/---: none
+Dependencies: AVX2 intrinsics, __builtin_ctz where available
+*/
+int selectLargerChildAvx2( const HeapEntryType *children, int count );
+
+/*
+Name: selectLargerChildSse42
+Process: finds the child with the largest key with the SSE4.2 64 bit
+         compare, two keys per vector, otherwise as the AVX2 kernel,
+         scans where SSE4.2 is not compiled in
+Function input/parameters: child block (const HeapEntryType *), 
+                           count, a multiple of two up to 
+                           MAX_HEAP_ARITY (int)
+Function output/parameters: none
+Function output/returned: offset of the larger child in the block (int)
+Device input/---: none
+Device output/---: none
+Dependencies: SSE4.2 intrinsics, __builtin_ctz where available
+*/
+int selectLargerChildSse42( const HeapEntryType *children, int count );
+
+/*
+Name: setChildSelect
+Process: chooses the kernel that picks the larger child while sifting
+         down, refused if the processor cannot run it
+Function input/parameters: heap data (HeapType *), kernel (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the kernel is not
+                          supported here (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getBestChildSelect
+*/
+bool setChildSelect( HeapType *heap, int kernel );
+
+/*
+Name: setDisplayFlag
+Process: sets Boolean flag to drive bubble up, trickle down displays,
+         turning it on attaches a trace ring if the heap has none,
+         with HEAP_TRACE 0 only additions and removals are displayed
+Function input/parameters: heap data (HeapType *), flag (bool)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: enableHeapTrace, atomic_load
+*/
+void setDisplayFlag( HeapType *heap, bool flagSet );
+
+/*
+Name: setGrowthFactor
+Process: sets the factor capacity grows by when full, which also sets
+         how far the size must fall before the heap shrinks
+Function input/parameters: heap data (HeapType *), growth factor (double)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the factor is outside
+                          MIN_GROWTH_FACTOR to MAX_GROWTH_FACTOR (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+bool setGrowthFactor( HeapType *heap, double factor );
+
+/*
+Name: setHeapEntry
+Process: writes an entry at a heap index and records that index
+         in the position map of its slot, every sift move goes through here
+         and is counted
+Function input/parameters: heap data (HeapType *), heap index (int),
+                           entry (HeapEntryType)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: getHeapEntry, getSlotPosition
+*/
+void setHeapEntry( HeapType *heap, int index, HeapEntryType entry );
+
+/*
+Name: setHeapFileLayout
+Process: fills a heap file header for an empty heap with the given
+         capacity, arity, and name arena size, each region starts on
+         a cache line, the name arena is last so it can grow alone
+Function input/parameters: capacity (int), arity (int), 
+                           name arena capacity (uint32_t)
+Function output/parameters: heap file header (HeapFileHeaderType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: roundToCacheLine
+*/
+void setHeapFileLayout( HeapFileHeaderType *header, int capacity, 
+                                       int arity, uint32_t arenaCapacity );
+
+/*
+Name: setIncrementalResize
+Process: turns incremental resizing on or off, when on a full heap
+         allocates its new blocks up front and each later operation
+         moves a bounded step of entries over, reads are served from
+         both blocks until the move is done, so no single add pays for
+         copying the heap, turning it off finishes any move under way,
+         a file backed heap grows its file in place instead
+Function input/parameters: heap data (HeapType *), incremental flag (bool)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if the heap is
+                          file backed (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: finishHeapMigration
+*/
+bool setIncrementalResize( HeapType *heap, bool incrementalSet );
+
+/*
+Name: showArray
+Process: displays array as is, from lowest index to highest,
+         a bucket queue is shown level by level in removal order
+Function input/parameters: heap data (HeapType)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/monitor: array displayed as specified
+Dependencies: getPatientInfo, printf
+*/
+void showArray( HeapType heap );
+
+/*
+Name: showHeapTrace
+Process: prints the bubble up and trickle down steps recorded since the
+         last call, names and times in come from the live patient slots,
+         additions and removals are printed by their operations
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated display cursor (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/monitor: sift steps displayed as specified
+Dependencies: readTraceEvents, getEntryPatient, formatTraceEvent, printf
+*/
+void showHeapTrace( HeapType *heap );
+
+/*
+Name: sinkToLeafArrayHeap
+Process: fills the hole at the root after the top entry is taken,
+         walks the hole down the larger child path to a leaf without
+         comparing against the moving entry, then climbs back up until
+         the moving entry fits, the moving entry usually belongs near 
+         the bottom so this saves a compare per level over trickle down
+Function input/parameters: heap data (HeapType *), 
+                           entry to place (HeapEntryType)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: prefetchHeapLevel, selectLargerChild, getHeapEntry, 
+              setHeapEntry, recordSift
+*/
+void sinkToLeafArrayHeap( HeapType *heap, HeapEntryType moving );
+
+/*
+Name: storeHeapFileCounters
+Process: copies the heap counters into the file header so the file 
+         always describes a whole heap between operations,
+         does nothing for a heap that is not file backed
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap file header (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+void storeHeapFileCounters( HeapType *heap );
+
+/*
+Name: storePatientInSlot
+Process: takes a free slot, appends the name to the name arena, 
+         records time in, adds the name to the name index if enabled,
+         making room in the index first, gives the slot back if 
+         the name arena could not grow
+Function input/parameters: heap data (HeapType *), patient name (const char *),
+                           time in (time_t)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: handle of slot, INVALID_HANDLE if memory ran
+                          out (int)
+Device input/---: none
+Device output/---: none
+Dependencies: reserveNameIndex, allocateSlot, appendArenaName, getFreeSlot, 
+              getPatientSlot, insertNameIndex
+*/
+int storePatientInSlot( HeapType *heap, const char *nameSet, time_t timeSet );
+
+/*
+Name: syncHeapFile
+Process: writes the heap counters to the file header and flushes the
+         mapping to disk, the file then survives a machine crash
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap file (HeapType *)
+Function output/returned: Boolean result, false if not file backed or
+                          the flush failed (bool)
+Device input/---: none
+Device output/---: heap file
+Dependencies: storeHeapFileCounters, msync
+*/
+bool syncHeapFile( HeapType *heap );
+
+/*
+Name: takeNextSequence
+Process: hands out the next arrival sequence of the heap,
+         rebases sequences if the counter would wrap
+Function input/parameters: heap data (HeapType *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: arrival sequence (uint32_t)
+Device input/---: none
+Device output/---: none
+Dependencies: rebaseHeapSequences
+*/
+uint32_t takeNextSequence( HeapType *heap );
+
+/*
+Name: traceHeapOperation
+Process: records an add, removal, bulk add or priority change, stamps
+         the operation once so its sift steps need no counter reads,
+         a name is carried in the name events that follow
+Function input/parameters: heap data (HeapType *), event kind (int),
+                           handle (int), key (uint64_t), 
+                           time in, old key, or zero (uint64_t),
+                           patient name, may be NULL (const char *)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: readHeapTicks, strlen, nextHeapTraceEvent, memcpy,
+              publishTraceEvent
+*/
+void traceHeapOperation( HeapType *heap, int op, int handle, uint64_t key,
+                                      uint64_t otherKey, const char *name );
+
+/*
+Name: traceHeapStep
+Process: records one bubble up or trickle down step, the entry that moves
+         and the parent or child it trades places with, with their indices
+Function input/parameters: heap data (HeapType *), event kind (int),
+                           moving entry (HeapEntryType), its index (int),
+                           other entry (HeapEntryType), its index (int),
+                           child offset within the child block (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: nextHeapTraceEvent, publishTraceEvent
+*/
+void traceHeapStep( HeapType *heap, int op, HeapEntryType entry, int index,
+                  HeapEntryType other, int otherIndex, int childOffset );
+
+/*
+Name: trickleDownArrayHeap
+Process: iteratively rebalances heap after data removal,
+         every child has a lower priority or later arrival time than its parent,
+         carries a hole down from the current index, picks the highest of
+         up to arity children with the heap's child selection kernel,
+         prefetches the next level, moves that child up one level,
+         then writes the displaced entry once at its final index,
+         records trickle down steps in the heap's trace
+Function input/parameters: heap data (HeapType *), current index (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: getHeapEntry, prefetchHeapLevel, selectLargerChild, 
+              traceHeapStep, setHeapEntry, recordSift
+*/
+void trickleDownArrayHeap( HeapType *heap, int currentIndex );
+
+
+/*
+Name: updatePriority
+Process: changes the priority of a waiting patient found by handle,
+         keeps the original arrival sequence, traces the change, then
+         bubbles up or trickles down from the patient's current index 
+         in the position map, a bucket queue moves the entry into the
+         ring of its new level instead, keeping it at its old priority 
+         if that ring cannot grow, displays its sift steps
+Function input/parameters: heap data (HeapType *), handle (int),
+                           new priority (int)
+Function output/parameters: updated heap data (HeapType *)
+Function output/returned: Boolean result, false if handle is not waiting
+                          or memory ran out (bool)
+Device input/---: none
+Device output/monitor: sift operations displayed as specified
+Dependencies: getSlotPosition, advanceHeapMigration, removeBucketEntry, 
+              getHeapEntry, makeHeapKey, getKeySequence, 
+              traceHeapOperation, pushBucketEntry, bubbleUpArrayHeap, 
+              trickleDownArrayHeap, showHeapTrace
+*/
+bool updatePriority( HeapType *heap, int handle, int newPriority );
+
+/*
+Name: validateHeapFile
+Process: checks a mapped heap file header, magic number, version, entry
+         sizes, counter ranges, and that the regions match the layout 
+         for the stored capacity and fit in the file, reads no entries
+Function input/parameters: heap file header (const HeapFileHeaderType *),
+                           mapped file length (size_t)
+Function output/parameters: none
+Function output/returned: Boolean result, true if file can be used (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: setHeapFileLayout
+*/
+bool validateHeapFile( const HeapFileHeaderType *header, size_t fileLength );
+
+#endif   // HEAP_UTILITY_H
@@ -0,0 +1,606 @@
+#include "IngestUtility.h"
+
+/*
+Name: encodeBinaryPatient
+Process: encodes one patient as a packed binary record,
+         names longer than MAX_NAME_LEN are truncated
+Function input/parameters: patient name (const char *), priority (int),
+                           time in (time_t)
+Function output/parameters: encoded record (unsigned char *)
+Function output/returned: record size (size_t)
+Device input/---: none
+Device output/---: none
+Dependencies: strlen, memcpy
+*/
+size_t encodeBinaryPatient( unsigned char *record, const char *name,
+                                               int priority, time_t timeIn )
+  {
+  // variables
+  int64_t time64 = (int64_t)timeIn;
+  int32_t priority32 = (int32_t)priority;
+  size_t length = strlen( name );
+
+  if( length > MAX_NAME_LEN )
+    {
+    length = MAX_NAME_LEN;
+    }
+
+  memcpy( record, &time64, sizeof( time64 ) );
+  memcpy( &record[ 8 ], &priority32, sizeof( priority32 ) );
+
+  record[ 12 ] = (unsigned char)length;
+
+  memcpy( &record[ BINARY_RECORD_FIXED_SIZE ], name, length );
+
+  return BINARY_RECORD_FIXED_SIZE + length;
+  }
+
+/*
+Name: encodePatientFileHeader
+Process: encodes the header of a packed binary patient file,
+         a zero record count means the count is unknown
+Function input/parameters: record count (uint64_t)
+Function output/parameters: encoded header (unsigned char *)
+Function output/returned: header size (size_t)
+Device input/---: none
+Device output/---: none
+Dependencies: memcpy
+*/
+size_t encodePatientFileHeader( unsigned char *header, uint64_t recordCount )
+  {
+  // variables
+  uint32_t magic = PATIENT_FILE_MAGIC, version = PATIENT_FILE_VERSION;
+
+  memcpy( header, &magic, sizeof( magic ) );
+  memcpy( &header[ 4 ], &version, sizeof( version ) );
+  memcpy( &header[ 8 ], &recordCount, sizeof( recordCount ) );
+
+  return PATIENT_FILE_HEADER_SIZE;
+  }
+
+/*
+Name: fillIngestReader
+Process: moves unparsed bytes to the front of the buffer,
+         then reads as much of the file as fits behind them
+Function input/parameters: reader (IngestReaderType *)
+Function output/parameters: updated reader (IngestReaderType *)
+Function output/returned: Boolean result, false if no bytes were added (bool)
+Device input/---: patient file
+Device output/---: none
+Dependencies: memmove, fread
+*/
+bool fillIngestReader( IngestReaderType *reader )
+  {
+  // variables
+  size_t count;
+
+  if( reader->endFlag )
+    {
+    return false;
+    }
+
+  // only a partial record or line is ever left to move
+  if( reader->start > 0 )
+    {
+    memmove( reader->buffer, &reader->buffer[ reader->start ],
+                                               reader->end - reader->start );
+
+    reader->end -= reader->start;
+    reader->start = 0;
+    }
+
+  count = fread( &reader->buffer[ reader->end ], 1,
+                                      INGEST_BUFFER_SIZE - reader->end,
+                                                             reader->file );
+
+  // a full buffer reads nothing without being at the end of the file
+  if( count == 0 && reader->end < INGEST_BUFFER_SIZE )
+    {
+    reader->endFlag = true;
+    }
+
+  reader->end += count;
+  reader->byteCount += count;
+
+  return count > 0;
+  }
+
+/*
+Name: flushIngestBatch
+Process: hands a batch of parsed patients to the bulk add path,
+         which grows the heap geometrically, counts the patients it 
+         added, empties the batch
+Function input/parameters: heap data (HeapType *),
+                           patients (const PatientType *),
+                           number of patients (int *)
+Function output/parameters: updated heap data (HeapType *),
+                            emptied number of patients (int *),
+                            updated ingest results (IngestStatsType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the batch was dropped (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: addHeapItems
+*/
+bool flushIngestBatch( HeapType *heap, const PatientType *patients,
+                                         int *count, IngestStatsType *stats )
+  {
+  // variables
+  int added;
+
+  if( *count == 0 )
+    {
+    return true;
+    }
+
+  // a batch is added whole or not at all
+  added = addHeapItems( heap, patients, *count, NULL );
+
+  stats->recordCount += added;
+
+  *count = 0;
+
+  return added > 0;
+  }
+
+/*
+Name: ingestBinaryRecords
+Process: parses packed binary records straight out of the reader buffer,
+         presizes the heap from the header count, stops at a truncated
+         record, which is counted as rejected, stops at a batch the heap
+         has no memory for
+Function input/parameters: heap data (HeapType *), reader (IngestReaderType *)
+Function output/parameters: updated heap data (HeapType *),
+                            updated reader (IngestReaderType *),
+                            updated ingest results (IngestStatsType *)
+Function output/returned: Boolean result, false if the header is invalid 
+                          or memory ran out (bool)
+Device input/---: patient file
+Device output/---: none
+Dependencies: fillIngestReader, memcpy, resizeHeap, malloc, 
+              flushIngestBatch, free
+*/
+bool ingestBinaryRecords( HeapType *heap, IngestReaderType *reader,
+                                                      IngestStatsType *stats )
+  {
+  // variables
+  PatientType *batch;
+  const unsigned char *recordPtr;
+  uint32_t magic, version;
+  uint64_t headerCount;
+  int64_t time64;
+  int32_t priority32;
+  size_t available, nameLength, copyLength;
+  int count = 0;
+  bool addedFlag = true;
+
+  if( reader->end - reader->start < PATIENT_FILE_HEADER_SIZE )
+    {
+    fillIngestReader( reader );
+    }
+
+  if( reader->end - reader->start < PATIENT_FILE_HEADER_SIZE )
+    {
+    return false;
+    }
+
+  recordPtr = (const unsigned char *)&reader->buffer[ reader->start ];
+
+  memcpy( &magic, recordPtr, sizeof( magic ) );
+  memcpy( &version, &recordPtr[ 4 ], sizeof( version ) );
+  memcpy( &headerCount, &recordPtr[ 8 ], sizeof( headerCount ) );
+
+  if( magic != PATIENT_FILE_MAGIC || version != PATIENT_FILE_VERSION )
+    {
+    return false;
+    }
+
+  reader->start += PATIENT_FILE_HEADER_SIZE;
+
+  // the count is known up front, size the heap for it once,
+  // a heap that cannot hold the file fails before anything is added
+  if( headerCount > 0 && headerCount < (uint64_t)( INT_MAX - heap->size )
+                      && heap->size + (int)headerCount > heap->capacity 
+                      && !resizeHeap( heap, heap->size + (int)headerCount ) )
+    {
+    return false;
+    }
+
+  batch = ( PatientType *)malloc( INGEST_BATCH_SIZE * sizeof( PatientType ) );
+
+  if( batch == NULL )
+    {
+    return false;
+    }
+
+  while( addedFlag )
+    {
+    available = reader->end - reader->start;
+    recordPtr = (const unsigned char *)&reader->buffer[ reader->start ];
+
+    // refill once the next record is not wholly in the buffer
+    if( available < BINARY_RECORD_FIXED_SIZE
+             || available < (size_t)BINARY_RECORD_FIXED_SIZE + recordPtr[ 12 ] )
+      {
+      if( fillIngestReader( reader ) )
+        {
+        continue;
+        }
+
+      // bytes left with no more to read are a torn final record
+      if( available > 0 )
+        {
+        stats->rejectCount++;
+        }
+
+      break;
+      }
+
+    nameLength = recordPtr[ 12 ];
+    copyLength = nameLength < STD_STR_LEN - 1 ? nameLength : STD_STR_LEN - 1;
+
+    memcpy( &time64, recordPtr, sizeof( time64 ) );
+    memcpy( &priority32, &recordPtr[ 8 ], sizeof( priority32 ) );
+
+    memcpy( batch[ count ].patientName,
+                        &recordPtr[ BINARY_RECORD_FIXED_SIZE ], copyLength );
+
+    batch[ count ].patientName[ copyLength ] = NULL_CHAR;
+    batch[ count ].priority = priority32;
+    batch[ count ].timeIn = (time_t)time64;
+
+    reader->start += BINARY_RECORD_FIXED_SIZE + nameLength;
+
+    count++;
+
+    if( count == INGEST_BATCH_SIZE )
+      {
+      addedFlag = flushIngestBatch( heap, batch, &count, stats );
+      }
+    }
+
+  addedFlag = addedFlag && flushIngestBatch( heap, batch, &count, stats );
+
+  free( batch );
+
+  return addedFlag;
+  }
+
+/*
+Name: ingestCsvRecords
+Process: splits the reader buffer into lines in place, parses each one,
+         a first line that does not parse is taken as a header row,
+         later lines that do not parse are counted as rejected,
+         stops at a batch the heap has no memory for
+Function input/parameters: heap data (HeapType *), reader (IngestReaderType *)
+Function output/parameters: updated heap data (HeapType *),
+                            updated reader (IngestReaderType *),
+                            updated ingest results (IngestStatsType *)
+Function output/returned: Boolean result, false if memory ran out (bool)
+Device input/---: patient file
+Device output/---: none
+Dependencies: malloc, memchr, fillIngestReader, parseCsvPatient, 
+              flushIngestBatch, free
+*/
+bool ingestCsvRecords( HeapType *heap, IngestReaderType *reader,
+                                                      IngestStatsType *stats )
+  {
+  // variables
+  PatientType *batch;
+  char *linePtr, *newlinePtr;
+  size_t lineLength;
+  bool firstFlag = true, addedFlag = true;
+  int count = 0;
+
+  batch = ( PatientType *)malloc( INGEST_BATCH_SIZE * sizeof( PatientType ) );
+
+  if( batch == NULL )
+    {
+    return false;
+    }
+
+  while( addedFlag )
+    {
+    linePtr = &reader->buffer[ reader->start ];
+    newlinePtr = ( char *)memchr( linePtr, NEWLINE_CHAR,
+                                               reader->end - reader->start );
+
+    if( newlinePtr == NULL )
+      {
+      if( fillIngestReader( reader ) )
+        {
+        continue;
+        }
+
+      if( reader->start == reader->end )
+        {
+        break;
+        }
+
+      // last line without a newline, or a line longer than the buffer,
+      // the failed fill may still have moved it to the front
+      linePtr = &reader->buffer[ reader->start ];
+      newlinePtr = &reader->buffer[ reader->end ];
+      }
+
+    lineLength = (size_t)( newlinePtr - linePtr );
+
+    reader->start += lineLength < reader->end - reader->start
+                                                 ? lineLength + 1 : lineLength;
+
+    if( lineLength > 0 && linePtr[ lineLength - 1 ] == CARRIAGE_RETURN_CHAR )
+      {
+      lineLength--;
+      }
+
+    // blank lines are skipped, not rejected
+    if( lineLength == 0 )
+      {
+      continue;
+      }
+
+    if( parseCsvPatient( linePtr, lineLength, &batch[ count ] ) )
+      {
+      count++;
+
+      if( count == INGEST_BATCH_SIZE )
+        {
+        addedFlag = flushIngestBatch( heap, batch, &count, stats );
+        }
+      }
+
+    else if( !firstFlag )
+      {
+      stats->rejectCount++;
+      }
+
+    firstFlag = false;
+    }
+
+  addedFlag = addedFlag && flushIngestBatch( heap, batch, &count, stats );
+
+  free( batch );
+
+  return addedFlag;
+  }
+
+/*
+Name: ingestPatientFile
+Process: streams a csv or packed binary patient file into the heap,
+         the format is chosen by the file's first bytes,
+         times the whole ingest
+Function input/parameters: heap data (HeapType *), file name (const char *)
+Function output/parameters: updated heap data (HeapType *),
+                            ingest results (IngestStatsType *)
+Function output/returned: Boolean result, false if the file cannot be read,
+                          a binary header is invalid, or memory ran out
+                          before every record was added (bool)
+Device input/---: patient file
+Device output/---: none
+Dependencies: clock_gettime, fopen, setvbuf, malloc, fillIngestReader,
+              memcpy, ingestBinaryRecords, ingestCsvRecords, fclose, free
+*/
+bool ingestPatientFile( HeapType *heap, const char *fileName,
+                                                      IngestStatsType *stats )
+  {
+  // variables
+  IngestReaderType reader;
+  struct timespec startTime, endTime;
+  uint32_t magic = 0;
+  bool successFlag = true;
+
+  clock_gettime( CLOCK_MONOTONIC, &startTime );
+
+  stats->recordCount = 0;
+  stats->rejectCount = 0;
+  stats->byteCount = 0;
+  stats->seconds = 0.0;
+
+  reader.file = fopen( fileName, "rb" );
+
+  if( reader.file == NULL )
+    {
+    return false;
+    }
+
+  // reads land directly in the parse buffer, no stdio copy between
+  setvbuf( reader.file, NULL, _IONBF, 0 );
+
+  reader.buffer = ( char *)malloc( INGEST_BUFFER_SIZE );
+  reader.start = 0;
+  reader.end = 0;
+  reader.byteCount = 0;
+  reader.endFlag = false;
+
+  fillIngestReader( &reader );
+
+  if( reader.end >= sizeof( magic ) )
+    {
+    memcpy( &magic, reader.buffer, sizeof( magic ) );
+    }
+
+  if( magic == PATIENT_FILE_MAGIC )
+    {
+    successFlag = ingestBinaryRecords( heap, &reader, stats );
+    }
+
+  else
+    {
+    successFlag = ingestCsvRecords( heap, &reader, stats );
+    }
+
+  fclose( reader.file );
+
+  free( reader.buffer );
+
+  clock_gettime( CLOCK_MONOTONIC, &endTime );
+
+  stats->byteCount = reader.byteCount;
+  stats->seconds = ( endTime.tv_sec - startTime.tv_sec )
+                 + ( endTime.tv_nsec - startTime.tv_nsec ) / 1e9;
+
+  return successFlag;
+  }
+
+/*
+Name: parseCsvInteger
+Process: parses an optionally signed decimal field,
+         surrounding spaces are allowed
+Function input/parameters: field text (const char *), field length (size_t)
+Function output/parameters: value (long long *)
+Function output/returned: Boolean result, false if not a number (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+bool parseCsvInteger( const char *field, size_t length, long long *value )
+  {
+  // variables
+  size_t index = 0, firstDigit;
+  long long result = 0;
+  int digit;
+  bool negativeFlag = false;
+
+  while( index < length && field[ index ] == SPACE )
+    {
+    index++;
+    }
+
+  if( index < length && ( field[ index ] == DASH || field[ index ] == '+' ) )
+    {
+    negativeFlag = field[ index ] == DASH;
+
+    index++;
+    }
+
+  firstDigit = index;
+
+  while( index < length && field[ index ] >= '0' && field[ index ] <= '9' )
+    {
+    digit = field[ index ] - '0';
+
+    // reject values that do not fit rather than wrap
+    if( result > ( LLONG_MAX - digit ) / 10 )
+      {
+      return false;
+      }
+
+    result = result * 10 + digit;
+
+    index++;
+    }
+
+  if( index == firstDigit )
+    {
+    return false;
+    }
+
+  while( index < length && field[ index ] == SPACE )
+    {
+    index++;
+    }
+
+  *value = negativeFlag ? -result : result;
+
+  return index == length;
+  }
+
+/*
+Name: parseCsvPatient
+Process: parses one line, name then priority then time in, the last
+         two commas end the name so "Last, First" needs no quotes,
+         a quoted name is also accepted, names hold at most
+         STD_STR_LEN - 1 characters and longer names are truncated
+Function input/parameters: line text (const char *),
+                           line length without newline (size_t)
+Function output/parameters: patient data (PatientType *)
+Function output/returned: Boolean result, false if the line is malformed (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: parseCsvInteger
+*/
+bool parseCsvPatient( const char *line, size_t length, PatientType *patient )
+  {
+  // variables
+  size_t timeComma = length, priorityComma, index, nameEnd;
+  int nameLength = 0;
+  long long priority, timeIn;
+  bool quotedFlag = false;
+
+  // find the last two commas, the numeric fields never hold one
+  while( timeComma > 0 && line[ timeComma - 1 ] != COMMA )
+    {
+    timeComma--;
+    }
+
+  if( timeComma == 0 )
+    {
+    return false;
+    }
+
+  timeComma--;
+  priorityComma = timeComma;
+
+  while( priorityComma > 0 && line[ priorityComma - 1 ] != COMMA )
+    {
+    priorityComma--;
+    }
+
+  if( priorityComma == 0 )
+    {
+    return false;
+    }
+
+  priorityComma--;
+
+  if( !parseCsvInteger( &line[ priorityComma + 1 ],
+                              timeComma - priorityComma - 1, &priority )
+          || !parseCsvInteger( &line[ timeComma + 1 ],
+                                      length - timeComma - 1, &timeIn )
+          || priority < INT_MIN || priority > INT_MAX )
+    {
+    return false;
+    }
+
+  index = 0;
+  nameEnd = priorityComma;
+
+  // quoted name, strip the quotes and undouble inner ones
+  if( nameEnd >= 2 && line[ 0 ] == QUOTE_CHAR
+                                      && line[ nameEnd - 1 ] == QUOTE_CHAR )
+    {
+    index = 1;
+    nameEnd--;
+
+    quotedFlag = true;
+    }
+
+  while( index < nameEnd )
+    {
+    if( nameLength < STD_STR_LEN - 1 )
+      {
+      patient->patientName[ nameLength ] = line[ index ];
+
+      nameLength++;
+      }
+
+    if( quotedFlag && line[ index ] == QUOTE_CHAR && index + 1 < nameEnd
+                                       && line[ index + 1 ] == QUOTE_CHAR )
+      {
+      index++;
+      }
+
+    index++;
+    }
+
+  if( nameLength == 0 )
+    {
+    return false;
+    }
+
+  patient->patientName[ nameLength ] = NULL_CHAR;
+  patient->priority = (int)priority;
+  patient->timeIn = (time_t)timeIn;
+
+  return true;
+  }
@@ -0,0 +1,214 @@
+#ifndef INGEST_UTILITY_H
+#define INGEST_UTILITY_H
+
+#include "HeapUtility.c"
+#include <limits.h>
+
+// constants
+
+// packed binary patient file identification, "PREC" read as little
+// endian bytes, header is magic, version, then the record count
+#define PATIENT_FILE_MAGIC 0x43455250u
+#define PATIENT_FILE_VERSION 1
+#define PATIENT_FILE_HEADER_SIZE 16
+
+// binary record, time in (int64), priority (int32), name length (uint8),
+// then the name without a terminator, all in native byte order
+#define BINARY_RECORD_FIXED_SIZE 13
+#define MAX_BINARY_RECORD_SIZE ( BINARY_RECORD_FIXED_SIZE + MAX_NAME_LEN )
+
+// bytes read from the file per call, records are parsed in place
+#define INGEST_BUFFER_SIZE 4194304
+
+// patients parsed before each hand off to the bulk add path
+#define INGEST_BATCH_SIZE 8192
+
+// csv name fields may be quoted, a doubled quote inside is one quote
+#define QUOTE_CHAR '"'
+
+// data structures
+
+// streaming reader, unparsed bytes run from start to end of the buffer
+typedef struct IngestReaderStruct
+   {
+    FILE *file;
+
+    char *buffer;
+
+    size_t start, end;
+
+    uint64_t byteCount;
+
+    bool endFlag;
+   } IngestReaderType;
+
+// results of one ingest, records added and lines or records rejected
+typedef struct IngestStatsStruct
+   {
+    long recordCount, rejectCount;
+
+    uint64_t byteCount;
+
+    double seconds;
+   } IngestStatsType;
+
+// function prototypes
+
+/*
+Name: encodeBinaryPatient
+Process: encodes one patient as a packed binary record,
+         names longer than MAX_NAME_LEN are truncated
+Function input/parameters: patient name (const char *), priority (int),
+                           time in (time_t)
+Function output/parameters: encoded record (unsigned char *)
+Function output/returned: record size (size_t)
+Device input/---: none
+Device output/---: none
+Dependencies: strlen, memcpy
+*/
+size_t encodeBinaryPatient( unsigned char *record, const char *name,
+                                              int priority, time_t timeIn );
+
+/*
+Name: encodePatientFileHeader
+Process: encodes the header of a packed binary patient file,
+         a zero record count means the count is unknown
+Function input/parameters: record count (uint64_t)
+Function output/parameters: encoded header (unsigned char *)
+Function output/returned: header size (size_t)
+Device input/---: none
+Device output/---: none
+Dependencies: memcpy
+*/
+size_t encodePatientFileHeader( unsigned char *header, uint64_t recordCount );
+
+/*
+Name: fillIngestReader
+Process: moves unparsed bytes to the front of the buffer,
+         then reads as much of the file as fits behind them
+Function input/parameters: reader (IngestReaderType *)
+Function output/parameters: updated reader (IngestReaderType *)
+Function output/returned: Boolean result, false if no bytes were added (bool)
+Device input/---: patient file
+Device output/---: none
+Dependencies: memmove, fread
+*/
+bool fillIngestReader( IngestReaderType *reader );
+
+/*
+Name: flushIngestBatch
+Process: hands a batch of parsed patients to the bulk add path,
+         which grows the heap geometrically, counts the patients it 
+         added, empties the batch
+Function input/parameters: heap data (HeapType *),
+                           patients (const PatientType *),
+                           number of patients (int *)
+Function output/parameters: updated heap data (HeapType *),
+                            emptied number of patients (int *),
+                            updated ingest results (IngestStatsType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the batch was dropped (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: addHeapItems
+*/
+bool flushIngestBatch( HeapType *heap, const PatientType *patients,
+                                        int *count, IngestStatsType *stats );
+
+/*
+Name: ingestBinaryRecords
+Process: parses packed binary records straight out of the reader buffer,
+         presizes the heap from the header count, stops at a truncated
+         record, which is counted as rejected, stops at a batch the heap
+         has no memory for
+Function input/parameters: heap data (HeapType *), reader (IngestReaderType *)
+Function output/parameters: updated heap data (HeapType *),
+                            updated reader (IngestReaderType *),
+                            updated ingest results (IngestStatsType *)
+Function output/returned: Boolean result, false if the header is invalid 
+                          or memory ran out (bool)
+Device input/---: patient file
+Device output/---: none
+Dependencies: fillIngestReader, memcpy, resizeHeap, malloc, 
+              flushIngestBatch, free
+*/
+bool ingestBinaryRecords( HeapType *heap, IngestReaderType *reader,
+                                                     IngestStatsType *stats );
+
+/*
+Name: ingestCsvRecords
+Process: splits the reader buffer into lines in place, parses each one,
+         a first line that does not parse is taken as a header row,
+         later lines that do not parse are counted as rejected,
+         stops at a batch the heap has no memory for
+Function input/parameters: heap data (HeapType *), reader (IngestReaderType *)
+Function output/parameters: updated heap data (HeapType *),
+                            updated reader (IngestReaderType *),
+                            updated ingest results (IngestStatsType *)
+Function output/returned: Boolean result, false if memory ran out (bool)
+Device input/---: patient file
+Device output/---: none
+Dependencies: malloc, memchr, fillIngestReader, parseCsvPatient, 
+              flushIngestBatch, free
+*/
+bool ingestCsvRecords( HeapType *heap, IngestReaderType *reader,
+                                                     IngestStatsType *stats );
+
+/*
+Name: ingestPatientFile
+Process: streams a csv or packed binary patient file into the heap,
+         the format is chosen by the file's first bytes,
+         times the whole ingest
+Function input/parameters: heap data (HeapType *), file name (const char *)
+Function output/parameters: updated heap data (HeapType *),
+                            ingest results (IngestStatsType *)
+Function output/returned: Boolean result, false if the file cannot be read,
+                          a binary header is invalid, or memory ran out
+                          before every record was added (bool)
+Device input/---: patient file
+Device output/---: none
+Dependencies: clock_gettime, fopen, setvbuf, malloc, fillIngestReader,
+              memcpy, ingestBinaryRecords, ingestCsvRecords, fclose, free
+*/
+bool ingestPatientFile( HeapType *heap, const char *fileName,
+                                                     IngestStatsType *stats );
+
+/*
+Name: parseCsvInteger
+Process: parses an optionally signed decimal field,
+         surrounding spaces are allowed
+Function input/parameters: field text (const char *), field length (size_t)
+Function output/parameters: value (long long *)
+Function output/returned: Boolean result, false if not a number (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+bool parseCsvInteger( const char *field, size_t length, long long *value );
+
+/*
+Name: parseCsvPatient
+Process: parses one line, name then priority then time in, the last
+         two commas end the name so "Last, First" needs no quotes,
+         a quoted name is also accepted, names hold at most
+         STD_STR_LEN - 1 characters and longer names are truncated
+Function input/parameters: line text (const char *),
+                           line length without newline (size_t)
+Function output/parameters: patient data (PatientType *)
+Function output/returned: Boolean result, false if the line is malformed (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: parseCsvInteger
+*/
+bool parseCsvPatient( const char *line, size_t length, PatientType *patient );
+
+
+
+
+
+
+
+
+
+
+#endif   // INGEST_UTILITY_H
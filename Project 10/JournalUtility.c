@@ -0,0 +1,1566 @@
+#include "JournalUtility.h"
+
+/*
+Name: appendJournalBytes
+Process: appends bytes to a record buffer, doubling it when full
+Function input/parameters: record buffer (JournalBufferType *),
+                           bytes (const void *), byte count (size_t)
+Function output/parameters: updated record buffer (JournalBufferType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: realloc, memcpy
+*/
+void appendJournalBytes( JournalBufferType *buffer,
+                                          const void *bytes, size_t size )
+  {
+  // variables
+  size_t newCapacity = buffer->capacity;
+
+  if( buffer->size + size > buffer->capacity )
+    {
+    if( newCapacity < MIN_JOURNAL_BUFFER )
+      {
+      newCapacity = MIN_JOURNAL_BUFFER;
+      }
+
+    while( newCapacity < buffer->size + size )
+      {
+      newCapacity *= 2;
+      }
+
+    buffer->bytes = ( unsigned char *)realloc( buffer->bytes, newCapacity );
+    buffer->capacity = newCapacity;
+    }
+
+  memcpy( &buffer->bytes[ buffer->size ], bytes, size );
+
+  buffer->size += size;
+  }
+
+/*
+Name: appendJournalRecord
+Process: adds an encoded record to the active buffer, wakes the
+         background writer once the batch size is reached,
+         caller holds the heap lock
+Function input/parameters: journaled heap (JournaledHeapType *),
+                           encoded record (const unsigned char *),
+                           record size (size_t)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: appendJournalBytes, pthread_cond_signal
+*/
+void appendJournalRecord( JournaledHeapType *journaled,
+                               const unsigned char *record, size_t size )
+  {
+  appendJournalBytes( &journaled->activeBuffer, record, size );
+
+  journaled->recordCount++;
+
+  // a full batch is written now instead of at the end of the window
+  if( journaled->config.syncBatchBytes > 0
+      && (long)( journaled->activeBuffer.size - FRAME_HEADER_SIZE )
+                                         >= journaled->config.syncBatchBytes )
+    {
+    pthread_cond_signal( &journaled->wakeCondition );
+    }
+  }
+
+/*
+Name: closeJournaledHeap
+Process: stops the background writer, writes and syncs buffered records,
+         closes the journal, frees the heap and buffers
+Function input/parameters: journaled heap (JournaledHeapType *)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: journal file
+Dependencies: pthread_cond_signal, pthread_join, syncJournal, close,
+              clearHeap, free, pthread_mutex_destroy, pthread_cond_destroy
+*/
+void closeJournaledHeap( JournaledHeapType *journaled )
+  {
+  if( journaled->backgroundFlag )
+    {
+    pthread_mutex_lock( &journaled->heapLock );
+
+    journaled->stopFlag = true;
+
+    pthread_cond_signal( &journaled->wakeCondition );
+
+    pthread_mutex_unlock( &journaled->heapLock );
+
+    pthread_join( journaled->backgroundThread, NULL );
+
+    journaled->backgroundFlag = false;
+    }
+
+  // nothing buffered is lost on a clean close
+  syncJournal( journaled );
+
+  if( journaled->journalFile >= 0 )
+    {
+    close( journaled->journalFile );
+    }
+
+  journaled->journalFile = -1;
+
+  clearHeap( &journaled->heap );
+
+  free( journaled->activeBuffer.bytes );
+  free( journaled->flushBuffer.bytes );
+
+  journaled->activeBuffer.bytes = NULL;
+  journaled->flushBuffer.bytes = NULL;
+
+  pthread_mutex_destroy( &journaled->heapLock );
+  pthread_mutex_destroy( &journaled->fileLock );
+  pthread_mutex_destroy( &journaled->snapshotLock );
+  pthread_cond_destroy( &journaled->wakeCondition );
+  }
+
+/*
+Name: encodeAddRecord
+Process: encodes an add record, key, time in, name length, and name
+Function input/parameters: key (uint64_t), time in (time_t),
+                           name (const char *)
+Function output/parameters: encoded record (unsigned char *)
+Function output/returned: record size (size_t)
+Device input/---: none
+Device output/---: none
+Dependencies: memcpy, strlen
+*/
+size_t encodeAddRecord( unsigned char *record, uint64_t key,
+                                         time_t timeIn, const char *name )
+  {
+  // variables
+  int64_t timeValue = (int64_t)timeIn;
+  size_t length = strlen( name );
+  uint16_t nameLength;
+
+  // the arena already bounds names, keep records bounded the same way
+  if( length > MAX_NAME_LEN )
+    {
+    length = MAX_NAME_LEN;
+    }
+
+  nameLength = (uint16_t)length;
+
+  record[ 0 ] = JOURNAL_ADD;
+
+  memcpy( &record[ 1 ], &key, sizeof( key ) );
+  memcpy( &record[ 9 ], &timeValue, sizeof( timeValue ) );
+  memcpy( &record[ 17 ], &nameLength, sizeof( nameLength ) );
+  memcpy( &record[ ADD_RECORD_SIZE ], name, length );
+
+  record[ ADD_RECORD_SIZE + length ] = NULL_CHAR;
+
+  return ADD_RECORD_SIZE + length + 1;
+  }
+
+/*
+Name: findReplayEntry
+Process: looks up a waiting patient by ordering key in the replay table
+Function input/parameters: replay table (const ReplayTableType *),
+                           key (uint64_t)
+Function output/parameters: none
+Function output/returned: bucket of patient, EMPTY_BUCKET if absent (long)
+Device input/---: none
+Device output/---: none
+Dependencies: hashReplayKey
+*/
+long findReplayEntry( const ReplayTableType *table, uint64_t key )
+  {
+  // variables
+  long mask = table->bucketCount - 1;
+  long bucket = hashReplayKey( key, mask );
+
+  // linear probe until the key or an empty bucket is found
+  while( table->buckets[ bucket ].name != NULL )
+    {
+    if( table->buckets[ bucket ].key == key )
+      {
+      return bucket;
+      }
+
+    bucket = ( bucket + 1 ) & mask;
+    }
+
+  return EMPTY_BUCKET;
+  }
+
+/*
+Name: getJournalFileName
+Process: builds the journal file name for a generation
+Function input/parameters: base name (const char *), generation (uint32_t)
+Function output/parameters: file name (char *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: snprintf
+*/
+void getJournalFileName( char *fileName, const char *baseName,
+                                                      uint32_t generation )
+  {
+  snprintf( fileName, MAX_JOURNAL_PATH, "%s.journal.%u",
+                                             baseName, (unsigned)generation );
+  }
+
+/*
+Name: hashJournalBytes
+Process: computes an FNV-1a style checksum of a frame payload, 
+         mixes eight bytes per step so checking keeps up with replay,
+         folds the result to 32 bits
+Function input/parameters: bytes (const unsigned char *), count (size_t)
+Function output/parameters: none
+Function output/returned: checksum (uint32_t)
+Device input/---: none
+Device output/---: none
+Dependencies: memcpy
+*/
+uint32_t hashJournalBytes( const unsigned char *bytes, size_t size )
+  {
+  // variables
+  uint64_t hash = 14695981039346656037u, word;
+  size_t index = 0;
+
+  for( index = 0; index + sizeof( word ) <= size; index += sizeof( word ) )
+    {
+    memcpy( &word, &bytes[ index ], sizeof( word ) );
+
+    hash ^= word;
+    hash *= 1099511628211u;
+    }
+
+  // leftover bytes one at a time
+  while( index < size )
+    {
+    hash ^= bytes[ index ];
+    hash *= 1099511628211u;
+
+    index++;
+    }
+
+  return (uint32_t)( hash ^ ( hash >> 32 ) );
+  }
+
+/*
+Name: hashReplayKey
+Process: mixes the arrival sequence of an ordering key into a replay
+         table bucket index, a priority change keeps the same bucket
+Function input/parameters: key (uint64_t), bucket mask (long)
+Function output/parameters: none
+Function output/returned: bucket index (long)
+Device input/---: none
+Device output/---: none
+Dependencies: getKeySequence
+*/
+long hashReplayKey( uint64_t key, long mask )
+  {
+  // variables
+  uint64_t mixed = getKeySequence( key );
+
+  // consecutive sequences must not fill consecutive buckets
+  mixed *= 0x9E3779B97F4A7C15u;
+
+  // scale the high bits to the table, a doubled table keeps bucket order
+  // so resizing sweeps both tables front to back
+  return (long)( ( ( mixed >> 32 ) * (uint64_t)( mask + 1 ) ) >> 32 );
+  }
+
+/*
+Name: insertReplayEntry
+Process: adds a waiting patient to the replay table, doubles the table
+         first if it would pass half full
+Function input/parameters: replay table (ReplayTableType *), key (uint64_t),
+                           time in (int64_t), name (const char *)
+Function output/parameters: updated replay table (ReplayTableType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: resizeReplayTable, hashReplayKey
+*/
+void insertReplayEntry( ReplayTableType *table, uint64_t key,
+                                          int64_t timeIn, const char *name )
+  {
+  // variables
+  long mask, bucket;
+
+  // keep the table at most half full so probes stay short
+  if( ( table->liveCount + 1 ) * 2 > table->bucketCount )
+    {
+    resizeReplayTable( table, table->bucketCount * 2 );
+    }
+
+  mask = table->bucketCount - 1;
+  bucket = hashReplayKey( key, mask );
+
+  while( table->buckets[ bucket ].name != NULL )
+    {
+    bucket = ( bucket + 1 ) & mask;
+    }
+
+  table->buckets[ bucket ].key = key;
+  table->buckets[ bucket ].timeIn = timeIn;
+  table->buckets[ bucket ].name = name;
+
+  table->liveCount++;
+  }
+
+/*
+Name: journalAddItem
+Process: adds patient to the heap and logs the add with the key used,
+         logs a sequence rebase first if the add caused one, a patient
+         turned away for lack of memory is not logged and gives its
+         arrival sequence back
+Function input/parameters: journaled heap (JournaledHeapType *),
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: stable handle of patient slot, INVALID_HANDLE
+                          if memory ran out (int)
+Device input/---: none
+Device output/---: journal file when syncing every record
+Dependencies: pthread_mutex_lock, takeNextSequence, makeHeapKey,
+              addHeapItemWithKey, encodeAddRecord, appendJournalRecord,
+              getSlotName, pthread_mutex_unlock, syncJournal
+*/
+int journalAddItem( JournaledHeapType *journaled, const char *nameSet,
+                                              int prioritySet, time_t timeSet )
+  {
+  // variables
+  unsigned char record[ ADD_RECORD_SIZE + MAX_NAME_LEN + 1 ];
+  uint32_t oldNextSequence, sequence, oldestSequence;
+  uint64_t key;
+  size_t size;
+  int handle;
+
+  pthread_mutex_lock( &journaled->heapLock );
+
+  oldNextSequence = journaled->heap.nextSequence;
+  sequence = takeNextSequence( &journaled->heap );
+
+  // a rebase shifted every waiting key, replay must shift them too,
+  // whether or not the patient below is added
+  if( sequence != oldNextSequence )
+    {
+    oldestSequence = oldNextSequence - sequence;
+
+    record[ 0 ] = JOURNAL_REBASE;
+
+    memcpy( &record[ 1 ], &oldestSequence, sizeof( oldestSequence ) );
+
+    appendJournalRecord( journaled, record, REBASE_RECORD_SIZE );
+    }
+
+  key = makeHeapKey( prioritySet, sequence );
+
+  handle = addHeapItemWithKey( &journaled->heap, nameSet, timeSet, key );
+
+  // a patient turned away is never logged, so replay cannot bring it
+  // back, and the next arrival takes its sequence
+  if( handle == INVALID_HANDLE )
+    {
+    journaled->heap.nextSequence = sequence;
+    }
+
+  else
+    {
+    // log the name as stored, already truncated to the arena limit
+    size = encodeAddRecord( record, key, timeSet,
+                                      getSlotName( &journaled->heap, handle ) );
+
+    appendJournalRecord( journaled, record, size );
+    }
+
+  pthread_mutex_unlock( &journaled->heapLock );
+
+  if( handle != INVALID_HANDLE && journaled->config.syncIntervalMs == 0 )
+    {
+    syncJournal( journaled );
+    }
+
+  return handle;
+  }
+
+/*
+Name: journalRemoveByHandle
+Process: removes a waiting patient by handle and logs its key
+Function input/parameters: journaled heap (JournaledHeapType *),
+                           handle (int)
+Function output/parameters: updated journaled heap (JournaledHeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if handle is not waiting (bool)
+Device input/---: none
+Device output/---: journal file when syncing every record
+Dependencies: pthread_mutex_lock, getSlotPosition, getHeapEntry, 
+              removeByHandle, appendJournalRecord,
+              pthread_mutex_unlock, syncJournal
+*/
+bool journalRemoveByHandle( JournaledHeapType *journaled, int handle,
+                                                       PatientType *removed )
+  {
+  // variables
+  unsigned char record[ REMOVE_RECORD_SIZE ];
+  HeapType *heap = &journaled->heap;
+  uint64_t key = 0;
+  bool removedFlag;
+
+  pthread_mutex_lock( &journaled->heapLock );
+
+  // read the key while the position is still valid
+  if( handle >= 0 && handle < heap->slotCount
+                   && *getSlotPosition( heap, handle ) != INVALID_POSITION )
+    {
+    key = getHeapEntry( heap, *getSlotPosition( heap, handle ) )->key;
+    }
+
+  removedFlag = removeByHandle( heap, handle, removed );
+
+  if( removedFlag )
+    {
+    record[ 0 ] = JOURNAL_REMOVE;
+
+    memcpy( &record[ 1 ], &key, sizeof( key ) );
+
+    appendJournalRecord( journaled, record, REMOVE_RECORD_SIZE );
+    }
+
+  pthread_mutex_unlock( &journaled->heapLock );
+
+  if( removedFlag && journaled->config.syncIntervalMs == 0 )
+    {
+    syncJournal( journaled );
+    }
+
+  return removedFlag;
+  }
+
+/*
+Name: journalRemoveItem
+Process: removes the highest priority patient and logs its key
+Function input/parameters: journaled heap (JournaledHeapType *)
+Function output/parameters: updated journaled heap (JournaledHeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if heap is empty (bool)
+Device input/---: none
+Device output/---: journal file when syncing every record
+Dependencies: pthread_mutex_lock, removeItem, appendJournalRecord,
+              pthread_mutex_unlock, syncJournal
+*/
+bool journalRemoveItem( JournaledHeapType *journaled, PatientType *removed )
+  {
+  // variables
+  unsigned char record[ REMOVE_RECORD_SIZE ];
+  uint64_t key;
+
+  pthread_mutex_lock( &journaled->heapLock );
+
+  if( journaled->heap.size == 0 )
+    {
+    pthread_mutex_unlock( &journaled->heapLock );
+
+    return false;
+    }
+
+  key = journaled->heap.array[ 0 ].key;
+
+  removeItem( removed, &journaled->heap );
+
+  record[ 0 ] = JOURNAL_REMOVE;
+
+  memcpy( &record[ 1 ], &key, sizeof( key ) );
+
+  appendJournalRecord( journaled, record, REMOVE_RECORD_SIZE );
+
+  pthread_mutex_unlock( &journaled->heapLock );
+
+  if( journaled->config.syncIntervalMs == 0 )
+    {
+    syncJournal( journaled );
+    }
+
+  return true;
+  }
+
+/*
+Name: journalUpdatePriority
+Process: changes the priority of a waiting patient, logs old and new keys
+Function input/parameters: journaled heap (JournaledHeapType *),
+                           handle (int), new priority (int)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: Boolean result, false if handle is not waiting (bool)
+Device input/---: none
+Device output/---: journal file when syncing every record
+Dependencies: pthread_mutex_lock, getSlotPosition, getHeapEntry, 
+              updatePriority, appendJournalRecord,
+              pthread_mutex_unlock, syncJournal
+*/
+bool journalUpdatePriority( JournaledHeapType *journaled, int handle,
+                                                           int newPriority )
+  {
+  // variables
+  unsigned char record[ UPDATE_RECORD_SIZE ];
+  HeapType *heap = &journaled->heap;
+  uint64_t oldKey = 0, newKey;
+  bool updatedFlag;
+
+  pthread_mutex_lock( &journaled->heapLock );
+
+  if( handle >= 0 && handle < heap->slotCount
+                   && *getSlotPosition( heap, handle ) != INVALID_POSITION )
+    {
+    oldKey = getHeapEntry( heap, *getSlotPosition( heap, handle ) )->key;
+    }
+
+  updatedFlag = updatePriority( heap, handle, newPriority );
+
+  if( updatedFlag )
+    {
+    // the sift has moved the entry, find it again through the position map
+    newKey = getHeapEntry( heap, *getSlotPosition( heap, handle ) )->key;
+
+    record[ 0 ] = JOURNAL_UPDATE;
+
+    memcpy( &record[ 1 ], &oldKey, sizeof( oldKey ) );
+    memcpy( &record[ 9 ], &newKey, sizeof( newKey ) );
+
+    appendJournalRecord( journaled, record, UPDATE_RECORD_SIZE );
+    }
+
+  pthread_mutex_unlock( &journaled->heapLock );
+
+  if( updatedFlag && journaled->config.syncIntervalMs == 0 )
+    {
+    syncJournal( journaled );
+    }
+
+  return updatedFlag;
+  }
+
+/*
+Name: loadReplayTable
+Process: stores every replayed patient in a slot with its logged key,
+         places the entries in array order, then heapifies once
+Function input/parameters: replay table (const ReplayTableType *)
+Function output/parameters: loaded heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          before every patient was loaded (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: resizeHeap, storePatientInSlot, setHeapEntry,
+              heapifyArrayHeap, storeHeapFileCounters
+*/
+bool loadReplayTable( const ReplayTableType *table, HeapType *heap )
+  {
+  // variables
+  const ReplayEntryType *replayed;
+  HeapEntryType entry;
+  long bucket;
+
+  // size the arrays once for every waiting patient
+  if( heap->size + table->liveCount > heap->capacity 
+                && !resizeHeap( heap, (int)( heap->size + table->liveCount ) ) )
+    {
+    return false;
+    }
+
+  for( bucket = 0; bucket < table->bucketCount; bucket++ )
+    {
+    replayed = &table->buckets[ bucket ];
+
+    // names are scattered over the loaded files, start fetching ahead
+    if( bucket + REPLAY_PREFETCH_DISTANCE < table->bucketCount
+        && table->buckets[ bucket + REPLAY_PREFETCH_DISTANCE ].name != NULL )
+      {
+      HEAP_PREFETCH( table->buckets[ bucket + REPLAY_PREFETCH_DISTANCE ].name );
+      }
+
+    if( replayed->name != NULL )
+      {
+      entry.handle = storePatientInSlot( heap, replayed->name,
+                                                   (time_t)replayed->timeIn );
+      entry.key = replayed->key;
+
+      if( entry.handle == INVALID_HANDLE )
+        {
+        return false;
+        }
+
+      setHeapEntry( heap, heap->size, entry );
+
+      heap->size++;
+      }
+    }
+
+  // one linear pass instead of a sift per record
+  heapifyArrayHeap( heap );
+
+  heap->nextSequence = table->nextSequence;
+
+  storeHeapFileCounters( heap );
+
+  return true;
+  }
+
+/*
+Name: openJournaledHeap
+Process: recovers the heap from the latest snapshot and every journal
+         generation after it, then snapshots the result to start a clean
+         generation, removes older journals, starts the background writer
+Function input/parameters: journaled heap (JournaledHeapType *),
+                           base name of journal files (const char *),
+                           durability settings (JournalConfigType),
+                           initial capacity (int)
+Function output/parameters: recovered journaled heap (JournaledHeapType *)
+Function output/returned: Boolean result, false if the snapshot is damaged,
+                          memory ran out loading the recovered patients,
+                          or the journal cannot be created (bool)
+Device input/---: snapshot and journal files
+Device output/---: snapshot and journal files
+Dependencies: clock_gettime, initializeHeap, copyStringBounded, 
+              pthread_mutex_init, pthread_cond_init, malloc, 
+              readJournalFile, replayRecords,
+              replayJournalFrames, getJournalFileName, loadReplayTable,
+              snapshotJournaledHeap, unlink, pthread_create, free
+*/
+bool openJournaledHeap( JournaledHeapType *journaled, const char *baseName,
+                             JournalConfigType config, int initialCapacity )
+  {
+  // variables
+  char fileName[ MAX_JOURNAL_PATH ];
+  unsigned char **loadedFiles = NULL, *bytes;
+  int loadedCount = 0, index;
+  size_t size;
+  uint32_t magic = 0, version = 0, firstGeneration = 0, generation;
+  uint32_t patientCount = 0, checksum = 0;
+  ReplayTableType table;
+  bool recoveredFlag = true, intactFlag = true;
+  long bucketCount = MIN_REPLAY_BUCKETS;
+  struct timespec startTime, endTime;
+
+  clock_gettime( CLOCK_MONOTONIC, &startTime );
+
+  initializeHeap( &journaled->heap, initialCapacity );
+
+  copyStringBounded( journaled->baseName, baseName, HUGE_STR_LEN );
+
+  pthread_mutex_init( &journaled->heapLock, NULL );
+  pthread_mutex_init( &journaled->fileLock, NULL );
+  pthread_mutex_init( &journaled->snapshotLock, NULL );
+  pthread_cond_init( &journaled->wakeCondition, NULL );
+
+  journaled->config = config;
+  journaled->backgroundFlag = false;
+  journaled->stopFlag = false;
+  journaled->journalFile = -1;
+  journaled->recordCount = 0;
+  journaled->syncCount = 0;
+  journaled->snapshotCount = 0;
+  journaled->replayCount = 0;
+  journaled->replaySeconds = 0.0;
+
+  // both buffers keep room for the frame header at the front
+  journaled->activeBuffer.bytes = ( unsigned char *)malloc(
+                                                         MIN_JOURNAL_BUFFER );
+  journaled->activeBuffer.capacity = MIN_JOURNAL_BUFFER;
+  journaled->activeBuffer.size = FRAME_HEADER_SIZE;
+
+  journaled->flushBuffer.bytes = ( unsigned char *)malloc(
+                                                         MIN_JOURNAL_BUFFER );
+  journaled->flushBuffer.capacity = MIN_JOURNAL_BUFFER;
+  journaled->flushBuffer.size = FRAME_HEADER_SIZE;
+
+  // start from an empty replay table
+  table.buckets = NULL;
+  table.bucketCount = 0;
+  table.liveCount = 0;
+  table.recordCount = 0;
+  table.nextSequence = 0;
+
+  // the snapshot names the first journal generation still needed
+  snprintf( fileName, MAX_JOURNAL_PATH, "%s.snapshot", baseName );
+
+  bytes = readJournalFile( fileName, &size );
+
+  if( bytes != NULL )
+    {
+    if( size >= SNAPSHOT_HEADER_SIZE )
+      {
+      memcpy( &magic, &bytes[ 0 ], sizeof( magic ) );
+      memcpy( &version, &bytes[ 4 ], sizeof( version ) );
+      memcpy( &firstGeneration, &bytes[ 8 ], sizeof( firstGeneration ) );
+      memcpy( &table.nextSequence, &bytes[ 12 ], sizeof( uint32_t ) );
+      memcpy( &patientCount, &bytes[ 16 ], sizeof( patientCount ) );
+      memcpy( &checksum, &bytes[ 20 ], sizeof( checksum ) );
+      }
+
+    recoveredFlag = size >= SNAPSHOT_HEADER_SIZE
+                    && magic == SNAPSHOT_MAGIC && version == SNAPSHOT_VERSION
+                    && checksum == hashJournalBytes(
+                                            &bytes[ SNAPSHOT_HEADER_SIZE ],
+                                            size - SNAPSHOT_HEADER_SIZE );
+
+    // size the table once for the snapshot so it never doubles mid load
+    while( recoveredFlag && bucketCount < 2L * patientCount )
+      {
+      bucketCount *= 2;
+      }
+    }
+
+  resizeReplayTable( &table, bucketCount );
+
+  if( bytes != NULL )
+    {
+    loadedFiles = ( unsigned char **)malloc( sizeof( unsigned char * ) );
+    loadedFiles[ loadedCount ] = bytes;
+    loadedCount++;
+
+    recoveredFlag = recoveredFlag && replayRecords( &table,
+                &bytes[ SNAPSHOT_HEADER_SIZE ], size - SNAPSHOT_HEADER_SIZE );
+    }
+
+  // a damaged snapshot cannot be repaired from the journals after it
+  if( !recoveredFlag )
+    {
+    for( index = 0; index < loadedCount; index++ )
+      {
+      free( loadedFiles[ index ] );
+      }
+
+    free( loadedFiles );
+    free( table.buckets );
+
+    closeJournaledHeap( journaled );
+
+    return false;
+    }
+
+  // replay generations in order until one is missing or torn,
+  // names stay in the loaded bytes until the heap is loaded
+  generation = firstGeneration;
+
+  while( intactFlag )
+    {
+    getJournalFileName( fileName, baseName, generation );
+
+    bytes = readJournalFile( fileName, &size );
+
+    if( bytes == NULL )
+      {
+      intactFlag = false;
+      }
+
+    else
+      {
+      loadedFiles = ( unsigned char **)realloc( loadedFiles,
+                         ( loadedCount + 1 ) * sizeof( unsigned char * ) );
+      loadedFiles[ loadedCount ] = bytes;
+      loadedCount++;
+
+      // records after a torn frame were never acknowledged as synced
+      intactFlag = replayJournalFrames( &table, bytes, size );
+
+      generation++;
+      }
+    }
+
+  recoveredFlag = loadReplayTable( &table, &journaled->heap );
+
+  journaled->replayCount = table.recordCount;
+
+  // the snapshot below is compaction, not part of the replay
+  clock_gettime( CLOCK_MONOTONIC, &endTime );
+
+  journaled->replaySeconds = ( endTime.tv_sec - startTime.tv_sec )
+                           + ( endTime.tv_nsec - startTime.tv_nsec ) / 1e9;
+
+  for( index = 0; index < loadedCount; index++ )
+    {
+    free( loadedFiles[ index ] );
+    }
+
+  free( loadedFiles );
+  free( table.buckets );
+
+  // the next snapshot starts a fresh generation past every replayed one
+  journaled->generation = generation;
+
+  // a partly loaded heap is never snapshotted, the journals it came
+  // from stay on disk for the next attempt
+  if( !recoveredFlag || !snapshotJournaledHeap( journaled ) )
+    {
+    closeJournaledHeap( journaled );
+
+    return false;
+    }
+
+  // everything replayed is now in the snapshot
+  while( firstGeneration < generation )
+    {
+    getJournalFileName( fileName, baseName, firstGeneration );
+
+    unlink( fileName );
+
+    firstGeneration++;
+    }
+
+  // sync every record keeps no writer, unless snapshots are wanted
+  if( config.syncIntervalMs > 0 || config.snapshotIntervalMs > 0 )
+    {
+    journaled->backgroundFlag = pthread_create( &journaled->backgroundThread,
+                               NULL, runJournalBackground, journaled ) == 0;
+    }
+
+  return true;
+  }
+
+/*
+Name: prefetchReplayRecord
+Process: finds the size of the encoded record at the front of the bytes
+         and starts loading the replay bucket its key hashes to, so the
+         cache miss overlaps with applying earlier records
+Function input/parameters: replay table (const ReplayTableType *),
+                           record bytes (const unsigned char *),
+                           byte count (size_t)
+Function output/parameters: none
+Function output/returned: record size, zero if the record is cut short 
+                          or of unknown type (size_t)
+Device input/---: none
+Device output/---: none
+Dependencies: memcpy, hashReplayKey
+*/
+size_t prefetchReplayRecord( const ReplayTableType *table,
+                                   const unsigned char *bytes, size_t size )
+  {
+  // variables
+  size_t recordSize = 0;
+  uint64_t key;
+  uint16_t nameLength;
+
+  if( size >= ADD_RECORD_SIZE && bytes[ 0 ] == JOURNAL_ADD )
+    {
+    memcpy( &nameLength, &bytes[ 17 ], sizeof( nameLength ) );
+
+    recordSize = ADD_RECORD_SIZE + nameLength + 1;
+    }
+
+  else if( size >= REMOVE_RECORD_SIZE && bytes[ 0 ] == JOURNAL_REMOVE )
+    {
+    recordSize = REMOVE_RECORD_SIZE;
+    }
+
+  else if( size >= UPDATE_RECORD_SIZE && bytes[ 0 ] == JOURNAL_UPDATE )
+    {
+    recordSize = UPDATE_RECORD_SIZE;
+    }
+
+  // a rebase rehashes the whole table, there is nothing to fetch
+  else if( size >= REBASE_RECORD_SIZE && bytes[ 0 ] == JOURNAL_REBASE )
+    {
+    return REBASE_RECORD_SIZE;
+    }
+
+  if( recordSize == 0 || recordSize > size )
+    {
+    return 0;
+    }
+
+  memcpy( &key, &bytes[ 1 ], sizeof( key ) );
+
+  HEAP_PREFETCH( &table->buckets[ hashReplayKey( key, 
+                                                 table->bucketCount - 1 ) ] );
+
+  return recordSize;
+  }
+
+/*
+Name: readJournalFile
+Process: reads a whole journal or snapshot file into memory
+Function input/parameters: file name (const char *)
+Function output/parameters: file size (size_t *)
+Function output/returned: file bytes to free later,
+                          NULL if the file does not exist (unsigned char *)
+Device input/---: journal or snapshot file
+Device output/---: none
+Dependencies: open, fstat, malloc, read, close
+*/
+unsigned char *readJournalFile( const char *fileName, size_t *size )
+  {
+  // variables
+  struct stat fileStatus;
+  unsigned char *bytes;
+  size_t total = 0;
+  ssize_t count = 1;
+  int fileDescriptor = open( fileName, O_RDONLY );
+
+  *size = 0;
+
+  if( fileDescriptor < 0 )
+    {
+    return NULL;
+    }
+
+  if( fstat( fileDescriptor, &fileStatus ) != 0 )
+    {
+    close( fileDescriptor );
+
+    return NULL;
+    }
+
+  // one spare byte so an empty file still gets a buffer
+  bytes = ( unsigned char *)malloc( (size_t)fileStatus.st_size + 1 );
+
+  // one large read per call, short reads just continue
+  while( count > 0 && total < (size_t)fileStatus.st_size )
+    {
+    count = read( fileDescriptor, &bytes[ total ],
+                                     (size_t)fileStatus.st_size - total );
+
+    if( count > 0 )
+      {
+      total += (size_t)count;
+      }
+    }
+
+  close( fileDescriptor );
+
+  *size = total;
+
+  return bytes;
+  }
+
+/*
+Name: removeReplayEntry
+Process: removes the patient in a bucket, shifts later entries of the
+         same probe run back so no tombstones are needed
+Function input/parameters: replay table (ReplayTableType *), bucket (long)
+Function output/parameters: updated replay table (ReplayTableType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: hashReplayKey
+*/
+void removeReplayEntry( ReplayTableType *table, long bucket )
+  {
+  // variables
+  long mask = table->bucketCount - 1, holeBucket = bucket, homeBucket;
+  bool inRun;
+
+  table->buckets[ holeBucket ].name = NULL;
+  table->liveCount--;
+
+  // shift back any later entry whose home bucket is not between hole and it
+  bucket = ( holeBucket + 1 ) & mask;
+
+  while( table->buckets[ bucket ].name != NULL )
+    {
+    homeBucket = hashReplayKey( table->buckets[ bucket ].key, mask );
+
+    // true when home lies cyclically in ( hole, bucket ]
+    if( holeBucket <= bucket )
+      {
+      inRun = homeBucket > holeBucket && homeBucket <= bucket;
+      }
+
+    else
+      {
+      inRun = homeBucket > holeBucket || homeBucket <= bucket;
+      }
+
+    if( !inRun )
+      {
+      table->buckets[ holeBucket ] = table->buckets[ bucket ];
+      table->buckets[ bucket ].name = NULL;
+
+      holeBucket = bucket;
+      }
+
+    bucket = ( bucket + 1 ) & mask;
+    }
+  }
+
+/*
+Name: replayJournalFrames
+Process: checks each frame of a journal and replays its records,
+         stops at the first torn or damaged frame
+Function input/parameters: journal bytes (const unsigned char *),
+                           byte count (size_t)
+Function output/parameters: updated replay table (ReplayTableType *)
+Function output/returned: Boolean result, false if replay stopped early (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: hashJournalBytes, replayRecords
+*/
+bool replayJournalFrames( ReplayTableType *table,
+                                   const unsigned char *bytes, size_t size )
+  {
+  // variables
+  size_t offset = 0;
+  uint32_t payloadSize, checksum;
+
+  while( offset < size )
+    {
+    // a crash during a write can leave part of a header
+    if( size - offset < FRAME_HEADER_SIZE )
+      {
+      return false;
+      }
+
+    memcpy( &payloadSize, &bytes[ offset ], sizeof( payloadSize ) );
+    memcpy( &checksum, &bytes[ offset + 4 ], sizeof( checksum ) );
+
+    offset += FRAME_HEADER_SIZE;
+
+    // a frame is applied whole or not at all
+    if( payloadSize > size - offset
+        || hashJournalBytes( &bytes[ offset ], payloadSize ) != checksum
+        || !replayRecords( table, &bytes[ offset ], payloadSize ) )
+      {
+      return false;
+      }
+
+    offset += payloadSize;
+    }
+
+  return true;
+  }
+
+/*
+Name: replayRecords
+Process: applies encoded records to the replay table in order, an add
+         inserts, a remove deletes, an update rekeys, a rebase shifts
+         every waiting key, no heap work is done per record
+Function input/parameters: record bytes (const unsigned char *),
+                           byte count (size_t)
+Function output/parameters: updated replay table (ReplayTableType *)
+Function output/returned: Boolean result, false on a damaged record (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: prefetchReplayRecord, memcpy, insertReplayEntry, 
+              findReplayEntry, removeReplayEntry, makeHeapKey, getKeyPriority,
+              getKeySequence, resizeReplayTable
+*/
+bool replayRecords( ReplayTableType *table,
+                                   const unsigned char *bytes, size_t size )
+  {
+  // variables
+  size_t offset = 0, aheadOffset = 0, aheadSize;
+  uint64_t key, newKey;
+  int64_t timeIn;
+  uint16_t nameLength;
+  uint32_t sequence, oldestSequence;
+  ReplayEntryType moved;
+  long bucket;
+
+  while( offset < size )
+    {
+    // keep a window of bucket fetches running ahead of the applied record
+    aheadSize = 1;
+
+    while( aheadSize > 0 && aheadOffset < size
+                           && aheadOffset - offset < REPLAY_PREFETCH_BYTES )
+      {
+      aheadSize = prefetchReplayRecord( table, &bytes[ aheadOffset ],
+                                                       size - aheadOffset );
+
+      aheadOffset += aheadSize;
+      }
+
+    if( bytes[ offset ] == JOURNAL_ADD && size - offset >= ADD_RECORD_SIZE )
+      {
+      memcpy( &key, &bytes[ offset + 1 ], sizeof( key ) );
+      memcpy( &timeIn, &bytes[ offset + 9 ], sizeof( timeIn ) );
+      memcpy( &nameLength, &bytes[ offset + 17 ], sizeof( nameLength ) );
+
+      // the name and its terminator must be inside the payload
+      if( size - offset < (size_t)ADD_RECORD_SIZE + nameLength + 1
+          || bytes[ offset + ADD_RECORD_SIZE + nameLength ] != NULL_CHAR )
+        {
+        return false;
+        }
+
+      insertReplayEntry( table, key, timeIn,
+                         ( const char *)&bytes[ offset + ADD_RECORD_SIZE ] );
+
+      // the heap resumes handing out sequences after the newest seen
+      sequence = getKeySequence( key );
+
+      if( sequence >= table->nextSequence && sequence < KEY_SEQUENCE_MASK )
+        {
+        table->nextSequence = sequence + 1;
+        }
+
+      offset += ADD_RECORD_SIZE + nameLength + 1;
+      }
+
+    else if( bytes[ offset ] == JOURNAL_REMOVE
+                                       && size - offset >= REMOVE_RECORD_SIZE )
+      {
+      memcpy( &key, &bytes[ offset + 1 ], sizeof( key ) );
+
+      bucket = findReplayEntry( table, key );
+
+      if( bucket != EMPTY_BUCKET )
+        {
+        removeReplayEntry( table, bucket );
+        }
+
+      offset += REMOVE_RECORD_SIZE;
+      }
+
+    else if( bytes[ offset ] == JOURNAL_UPDATE
+                                       && size - offset >= UPDATE_RECORD_SIZE )
+      {
+      memcpy( &key, &bytes[ offset + 1 ], sizeof( key ) );
+      memcpy( &newKey, &bytes[ offset + 9 ], sizeof( newKey ) );
+
+      bucket = findReplayEntry( table, key );
+
+      // same sequence keeps the same bucket, rekey in place
+      if( bucket != EMPTY_BUCKET 
+                          && getKeySequence( newKey ) == getKeySequence( key ) )
+        {
+        table->buckets[ bucket ].key = newKey;
+        }
+
+      // otherwise the key decides the bucket, so reinsert under the new key
+      else if( bucket != EMPTY_BUCKET )
+        {
+        moved = table->buckets[ bucket ];
+
+        removeReplayEntry( table, bucket );
+
+        insertReplayEntry( table, newKey, moved.timeIn, moved.name );
+        }
+
+      offset += UPDATE_RECORD_SIZE;
+      }
+
+    else if( bytes[ offset ] == JOURNAL_REBASE
+                                       && size - offset >= REBASE_RECORD_SIZE )
+      {
+      memcpy( &oldestSequence, &bytes[ offset + 1 ],
+                                                 sizeof( oldestSequence ) );
+
+      // same shift as rebaseHeapSequences, then rehash every moved key
+      for( bucket = 0; bucket < table->bucketCount; bucket++ )
+        {
+        if( table->buckets[ bucket ].name != NULL )
+          {
+          key = table->buckets[ bucket ].key;
+
+          table->buckets[ bucket ].key = makeHeapKey( getKeyPriority( key ),
+                                   getKeySequence( key ) - oldestSequence );
+          }
+        }
+
+      resizeReplayTable( table, table->bucketCount );
+
+      table->nextSequence -= oldestSequence;
+
+      offset += REBASE_RECORD_SIZE;
+      }
+
+    // unknown type or a record cut short
+    else
+      {
+      return false;
+      }
+
+    table->recordCount++;
+    }
+
+  return true;
+  }
+
+/*
+Name: resizeReplayTable
+Process: creates a replay table of the given power of two size,
+         re-inserts every waiting patient, frees the old buckets
+Function input/parameters: replay table (ReplayTableType *),
+                           bucket count (long)
+Function output/parameters: updated replay table (ReplayTableType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: calloc, free, hashReplayKey
+*/
+void resizeReplayTable( ReplayTableType *table, long bucketCount )
+  {
+  // variables
+  ReplayEntryType *oldBuckets = table->buckets;
+  long oldCount = table->bucketCount, index, bucket, mask = bucketCount - 1;
+
+  // zeroed buckets have a NULL name, so every bucket starts empty
+  table->buckets = ( ReplayEntryType *)calloc( (size_t)bucketCount,
+                                                  sizeof( ReplayEntryType ) );
+  table->bucketCount = bucketCount;
+
+  for( index = 0; index < oldCount; index++ )
+    {
+    if( oldBuckets[ index ].name != NULL )
+      {
+      bucket = hashReplayKey( oldBuckets[ index ].key, mask );
+
+      while( table->buckets[ bucket ].name != NULL )
+        {
+        bucket = ( bucket + 1 ) & mask;
+        }
+
+      table->buckets[ bucket ] = oldBuckets[ index ];
+      }
+    }
+
+  free( oldBuckets );
+  }
+
+/*
+Name: runJournalBackground
+Process: background writer, syncs buffered records every sync interval
+         or when woken by a full batch, takes a snapshot every snapshot
+         interval, runs until the journaled heap is closed
+Function input/parameters: journaled heap (void *)
+Function output/parameters: none
+Function output/returned: none (void *)
+Device input/---: none
+Device output/---: snapshot and journal files
+Dependencies: clock_gettime, pthread_mutex_lock, pthread_cond_timedwait,
+              pthread_mutex_unlock, syncJournal, snapshotJournaledHeap
+*/
+void *runJournalBackground( void *journaledPtr )
+  {
+  // variables
+  JournaledHeapType *journaled = ( JournaledHeapType *)journaledPtr;
+  JournalConfigType config = journaled->config;
+  struct timespec now, deadline;
+  long long nowMs, waitMs, nextSnapshotMs;
+  bool batchFullFlag;
+
+  clock_gettime( CLOCK_REALTIME, &now );
+
+  nowMs = now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+  nextSnapshotMs = nowMs + config.snapshotIntervalMs;
+
+  pthread_mutex_lock( &journaled->heapLock );
+
+  while( !journaled->stopFlag )
+    {
+    // sleep until the group commit window or the next snapshot ends
+    waitMs = config.syncIntervalMs > 0 ? config.syncIntervalMs
+                                                : config.snapshotIntervalMs;
+
+    if( config.snapshotIntervalMs > 0 && nextSnapshotMs - nowMs < waitMs )
+      {
+      waitMs = nextSnapshotMs > nowMs ? nextSnapshotMs - nowMs : 0;
+      }
+
+    deadline.tv_sec = (time_t)( ( nowMs + waitMs ) / 1000 );
+    deadline.tv_nsec = (long)( ( nowMs + waitMs ) % 1000 ) * 1000000L;
+
+    // a batch that filled while the last sync ran is written right away
+    batchFullFlag = config.syncBatchBytes > 0
+                    && (long)( journaled->activeBuffer.size
+                             - FRAME_HEADER_SIZE ) >= config.syncBatchBytes;
+
+    if( !batchFullFlag )
+      {
+      pthread_cond_timedwait( &journaled->wakeCondition,
+                                           &journaled->heapLock, &deadline );
+      }
+
+    pthread_mutex_unlock( &journaled->heapLock );
+
+    // records from every operation in the window share one fsync
+    if( config.syncIntervalMs > 0 )
+      {
+      syncJournal( journaled );
+      }
+
+    clock_gettime( CLOCK_REALTIME, &now );
+
+    nowMs = now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+
+    if( config.snapshotIntervalMs > 0 && nowMs >= nextSnapshotMs )
+      {
+      snapshotJournaledHeap( journaled );
+
+      nextSnapshotMs = nowMs + config.snapshotIntervalMs;
+      }
+
+    pthread_mutex_lock( &journaled->heapLock );
+    }
+
+  pthread_mutex_unlock( &journaled->heapLock );
+
+  return NULL;
+  }
+
+/*
+Name: snapshotJournaledHeap
+Process: under the heap lock encodes every waiting patient as an add
+         record and switches to the next journal generation, then syncs
+         the last records of the old journal, writes the snapshot to a
+         temporary file, syncs and renames it over the old snapshot,
+         and removes the old journal
+Function input/parameters: journaled heap (JournaledHeapType *)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: Boolean result, false if a file write failed (bool)
+Device input/---: none
+Device output/---: snapshot and journal files
+Dependencies: pthread_mutex_lock, getHeapEntry, encodeAddRecord, 
+              appendJournalBytes, getPatientSlot,
+              getSlotName, pthread_mutex_unlock, writeJournalFrame, fsync,
+              close, getJournalFileName, open, writeJournalBytes,
+              hashJournalBytes, rename, unlink, free
+*/
+bool snapshotJournaledHeap( JournaledHeapType *journaled )
+  {
+  // variables
+  char fileName[ MAX_JOURNAL_PATH ], tempName[ MAX_JOURNAL_PATH ];
+  unsigned char record[ ADD_RECORD_SIZE + MAX_NAME_LEN + 1 ];
+  JournalBufferType snapshot = { NULL, 0, 0 }, swapBuffer;
+  HeapType *heap = &journaled->heap;
+  HeapEntryType entry;
+  uint32_t oldGeneration, newGeneration, patientCount, checksum;
+  uint32_t magic = SNAPSHOT_MAGIC, version = SNAPSHOT_VERSION;
+  int oldJournal, newJournal, snapshotFile, index;
+  bool writtenFlag = true;
+
+  pthread_mutex_lock( &journaled->snapshotLock );
+
+  // no journal write may land between the switch and the old tail sync
+  pthread_mutex_lock( &journaled->fileLock );
+
+  oldGeneration = journaled->generation;
+  newGeneration = oldGeneration + 1;
+
+  getJournalFileName( fileName, journaled->baseName, newGeneration );
+
+  newJournal = open( fileName, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND,
+                                                                      0644 );
+
+  if( newJournal < 0 )
+    {
+    pthread_mutex_unlock( &journaled->fileLock );
+    pthread_mutex_unlock( &journaled->snapshotLock );
+
+    return false;
+    }
+
+  // header fields are filled in once the payload is known
+  appendJournalBytes( &snapshot, record, SNAPSHOT_HEADER_SIZE );
+
+  pthread_mutex_lock( &journaled->heapLock );
+
+  for( index = 0; index < heap->size; index++ )
+    {
+    entry = *getHeapEntry( heap, index );
+
+    appendJournalBytes( &snapshot, record, encodeAddRecord( record, entry.key,
+                                  getPatientSlot( heap, entry.handle )->timeIn,
+                                  getSlotName( heap, entry.handle ) ) );
+    }
+
+  patientCount = (uint32_t)heap->size;
+
+  memcpy( &snapshot.bytes[ 12 ], &heap->nextSequence, sizeof( uint32_t ) );
+
+  // records before this point go to the old journal, later ones to the new
+  swapBuffer = journaled->activeBuffer;
+  journaled->activeBuffer = journaled->flushBuffer;
+  journaled->flushBuffer = swapBuffer;
+
+  oldJournal = journaled->journalFile;
+
+  journaled->journalFile = newJournal;
+  journaled->generation = newGeneration;
+
+  pthread_mutex_unlock( &journaled->heapLock );
+
+  // finish the old journal so it is whole if the snapshot never lands
+  if( oldJournal >= 0 )
+    {
+    writtenFlag = writeJournalFrame( oldJournal, &journaled->flushBuffer )
+                  && fsync( oldJournal ) == 0;
+
+    close( oldJournal );
+    }
+
+  else
+    {
+    journaled->flushBuffer.size = FRAME_HEADER_SIZE;
+    }
+
+  pthread_mutex_unlock( &journaled->fileLock );
+
+  // write the snapshot beside the old one, then swap it in atomically
+  memcpy( &snapshot.bytes[ 0 ], &magic, sizeof( magic ) );
+  memcpy( &snapshot.bytes[ 4 ], &version, sizeof( version ) );
+  memcpy( &snapshot.bytes[ 8 ], &newGeneration, sizeof( newGeneration ) );
+  memcpy( &snapshot.bytes[ 16 ], &patientCount, sizeof( patientCount ) );
+
+  checksum = hashJournalBytes( &snapshot.bytes[ SNAPSHOT_HEADER_SIZE ],
+                                      snapshot.size - SNAPSHOT_HEADER_SIZE );
+
+  memcpy( &snapshot.bytes[ 20 ], &checksum, sizeof( checksum ) );
+
+  snprintf( fileName, MAX_JOURNAL_PATH, "%s.snapshot", journaled->baseName );
+  snprintf( tempName, MAX_JOURNAL_PATH, "%s.snapshot.tmp",
+                                                        journaled->baseName );
+
+  snapshotFile = open( tempName, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+
+  writtenFlag = writtenFlag && snapshotFile >= 0
+                && writeJournalBytes( snapshotFile, snapshot.bytes,
+                                                             snapshot.size )
+                && fsync( snapshotFile ) == 0;
+
+  if( snapshotFile >= 0 )
+    {
+    close( snapshotFile );
+    }
+
+  // the old journal is only dropped once the new snapshot covers it
+  if( writtenFlag && rename( tempName, fileName ) == 0 )
+    {
+    getJournalFileName( fileName, journaled->baseName, oldGeneration );
+
+    unlink( fileName );
+
+    journaled->snapshotCount++;
+    }
+
+  else
+    {
+    unlink( tempName );
+
+    writtenFlag = false;
+    }
+
+  free( snapshot.bytes );
+
+  pthread_mutex_unlock( &journaled->snapshotLock );
+
+  return writtenFlag;
+  }
+
+/*
+Name: syncJournal
+Process: swaps out the active buffer and writes it as one frame, then
+         syncs the journal, records from every thread since the last
+         sync share the one fsync
+Function input/parameters: journaled heap (JournaledHeapType *)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: Boolean result, false if the write failed (bool)
+Device input/---: none
+Device output/---: journal file
+Dependencies: pthread_mutex_lock, pthread_mutex_unlock, writeJournalFrame,
+              fsync
+*/
+bool syncJournal( JournaledHeapType *journaled )
+  {
+  // variables
+  JournalBufferType swapBuffer;
+  bool syncedFlag = true;
+
+  pthread_mutex_lock( &journaled->fileLock );
+
+  // operations keep appending to the other buffer while this one is written
+  pthread_mutex_lock( &journaled->heapLock );
+
+  swapBuffer = journaled->activeBuffer;
+  journaled->activeBuffer = journaled->flushBuffer;
+  journaled->flushBuffer = swapBuffer;
+
+  pthread_mutex_unlock( &journaled->heapLock );
+
+  // a caller that arrives after another thread's sync finds nothing to do
+  if( journaled->flushBuffer.size > FRAME_HEADER_SIZE )
+    {
+    syncedFlag = journaled->journalFile >= 0
+                 && writeJournalFrame( journaled->journalFile,
+                                                   &journaled->flushBuffer )
+                 && fsync( journaled->journalFile ) == 0;
+
+    journaled->flushBuffer.size = FRAME_HEADER_SIZE;
+
+    journaled->syncCount++;
+    }
+
+  pthread_mutex_unlock( &journaled->fileLock );
+
+  return syncedFlag;
+  }
+
+/*
+Name: writeJournalBytes
+Process: writes all bytes to a file, retrying short writes
+Function input/parameters: file descriptor (int),
+                           bytes (const unsigned char *), count (size_t)
+Function output/parameters: none
+Function output/returned: Boolean result, false if the write failed (bool)
+Device input/---: none
+Device output/---: journal or snapshot file
+Dependencies: write
+*/
+bool writeJournalBytes( int fileDescriptor,
+                                   const unsigned char *bytes, size_t size )
+  {
+  // variables
+  ssize_t count;
+
+  while( size > 0 )
+    {
+    count = write( fileDescriptor, bytes, size );
+
+    if( count <= 0 )
+      {
+      return false;
+      }
+
+    bytes += count;
+    size -= (size_t)count;
+    }
+
+  return true;
+  }
+
+/*
+Name: writeJournalFrame
+Process: fills in the reserved frame header of a record buffer, writes
+         the frame, then empties the buffer, an empty buffer writes nothing
+Function input/parameters: file descriptor (int),
+                           record buffer (JournalBufferType *)
+Function output/parameters: emptied record buffer (JournalBufferType *)
+Function output/returned: Boolean result, false if the write failed (bool)
+Device input/---: none
+Device output/---: journal file
+Dependencies: hashJournalBytes, memcpy, writeJournalBytes
+*/
+bool writeJournalFrame( int fileDescriptor, JournalBufferType *buffer )
+  {
+  // variables
+  uint32_t payloadSize = (uint32_t)( buffer->size - FRAME_HEADER_SIZE );
+  uint32_t checksum;
+  bool writtenFlag = true;
+
+  if( payloadSize > 0 )
+    {
+    checksum = hashJournalBytes( &buffer->bytes[ FRAME_HEADER_SIZE ],
+                                                              payloadSize );
+
+    memcpy( &buffer->bytes[ 0 ], &payloadSize, sizeof( payloadSize ) );
+    memcpy( &buffer->bytes[ 4 ], &checksum, sizeof( checksum ) );
+
+    // one write per frame, replay drops it whole if it is torn
+    writtenFlag = writeJournalBytes( fileDescriptor, buffer->bytes,
+                                                              buffer->size );
+    }
+
+  buffer->size = FRAME_HEADER_SIZE;
+
+  return writtenFlag;
+  }
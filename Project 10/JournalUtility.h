@@ -0,0 +1,539 @@
+#ifndef JOURNAL_UTILITY_H
+#define JOURNAL_UTILITY_H
+
+#include "HeapUtility.c"
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// constants
+
+// record types, every record is its type byte followed by its fields
+// in native byte order
+#define JOURNAL_ADD 1
+#define JOURNAL_REMOVE 2
+#define JOURNAL_UPDATE 3
+#define JOURNAL_REBASE 4
+
+// encoded record sizes, an add also carries its name and terminator
+#define ADD_RECORD_SIZE 19
+#define REMOVE_RECORD_SIZE 9
+#define UPDATE_RECORD_SIZE 17
+#define REBASE_RECORD_SIZE 5
+
+// every write is one frame, payload length and checksum then records,
+// replay stops at the first torn or damaged frame
+#define FRAME_HEADER_SIZE 8
+
+// snapshot file identification, "JSNP" read as little endian bytes
+#define SNAPSHOT_MAGIC 0x504E534Au
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER_SIZE 24
+
+// first size of each record buffer in bytes
+#define MIN_JOURNAL_BUFFER 65536
+
+// first size of the replay table, load is kept at or below one half
+#define MIN_REPLAY_BUCKETS 1024
+
+// record bytes whose buckets are fetched ahead of the applied record,
+// and buckets ahead whose names are fetched while loading the heap
+#define REPLAY_PREFETCH_BYTES 512
+#define REPLAY_PREFETCH_DISTANCE 16
+
+// longest journal or snapshot file name
+#define MAX_JOURNAL_PATH ( HUGE_STR_LEN + MIN_STR_LEN )
+
+// defaults for the group commit window, batch trigger, and snapshots
+#define DEFAULT_SYNC_INTERVAL_MS 5
+#define DEFAULT_SYNC_BATCH_BYTES 1048576
+#define DEFAULT_SNAPSHOT_INTERVAL_MS 60000
+
+// data structures
+
+// durability settings, a zero sync interval syncs every record before
+// the operation returns, longer intervals batch records into one fsync
+typedef struct JournalConfigStruct
+   {
+    int syncIntervalMs;
+
+    // buffered bytes that wake the writer early, zero for time only
+    long syncBatchBytes;
+
+    // time between background snapshots, zero turns them off
+    int snapshotIntervalMs;
+   } JournalConfigType;
+
+// growable byte buffer, the frame header is reserved at the front
+typedef struct JournalBufferStruct
+   {
+    unsigned char *bytes;
+
+    size_t size, capacity;
+   } JournalBufferType;
+
+// heap whose changes are logged to a journal file per generation,
+// a snapshot starts each generation and replaces the one before it,
+// lock order is snapshot lock, file lock, then heap lock
+typedef struct JournaledHeapStruct
+   {
+    HeapType heap;
+
+    pthread_mutex_t heapLock, fileLock, snapshotLock;
+
+    pthread_cond_t wakeCondition;
+
+    pthread_t backgroundThread;
+
+    bool backgroundFlag, stopFlag;
+
+    JournalConfigType config;
+
+    JournalBufferType activeBuffer, flushBuffer;
+
+    char baseName[ HUGE_STR_LEN ];
+
+    int journalFile;
+
+    uint32_t generation;
+
+    long recordCount, syncCount, snapshotCount;
+
+    // records applied by the last recovery, snapshot and journal,
+    // and the seconds spent reading, replaying and heapifying them
+    long replayCount;
+
+    double replaySeconds;
+   } JournaledHeapType;
+
+// patient still waiting during replay, the name points into the
+// loaded snapshot or journal bytes, NULL marks an empty bucket
+typedef struct ReplayEntryStruct
+   {
+    uint64_t key;
+
+    int64_t timeIn;
+
+    const char *name;
+   } ReplayEntryType;
+
+// open addressing table of waiting patients by ordering key
+typedef struct ReplayTableStruct
+   {
+    ReplayEntryType *buckets;
+
+    long bucketCount, liveCount;
+
+    long recordCount;
+
+    uint32_t nextSequence;
+   } ReplayTableType;
+
+// function prototypes
+
+/*
+Name: appendJournalBytes
+Process: appends bytes to a record buffer, doubling it when full
+Function input/parameters: record buffer (JournalBufferType *),
+                           bytes (const void *), byte count (size_t)
+Function output/parameters: updated record buffer (JournalBufferType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: realloc, memcpy
+*/
+void appendJournalBytes( JournalBufferType *buffer,
+                                          const void *bytes, size_t size );
+
+/*
+Name: appendJournalRecord
+Process: adds an encoded record to the active buffer, wakes the
+         background writer once the batch size is reached,
+         caller holds the heap lock
+Function input/parameters: journaled heap (JournaledHeapType *),
+                           encoded record (const unsigned char *),
+                           record size (size_t)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: appendJournalBytes, pthread_cond_signal
+*/
+void appendJournalRecord( JournaledHeapType *journaled,
+                               const unsigned char *record, size_t size );
+
+/*
+Name: closeJournaledHeap
+Process: stops the background writer, writes and syncs buffered records,
+         closes the journal, frees the heap and buffers
+Function input/parameters: journaled heap (JournaledHeapType *)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: journal file
+Dependencies: pthread_cond_signal, pthread_join, syncJournal, close,
+              clearHeap, free, pthread_mutex_destroy, pthread_cond_destroy
+*/
+void closeJournaledHeap( JournaledHeapType *journaled );
+
+/*
+Name: encodeAddRecord
+Process: encodes an add record, key, time in, name length, and name
+Function input/parameters: key (uint64_t), time in (time_t),
+                           name (const char *)
+Function output/parameters: encoded record (unsigned char *)
+Function output/returned: record size (size_t)
+Device input/---: none
+Device output/---: none
+Dependencies: memcpy, strlen
+*/
+size_t encodeAddRecord( unsigned char *record, uint64_t key,
+                                         time_t timeIn, const char *name );
+
+/*
+Name: findReplayEntry
+Process: looks up a waiting patient by ordering key in the replay table
+Function input/parameters: replay table (const ReplayTableType *),
+                           key (uint64_t)
+Function output/parameters: none
+Function output/returned: bucket of patient, EMPTY_BUCKET if absent (long)
+Device input/---: none
+Device output/---: none
+Dependencies: hashReplayKey
+*/
+long findReplayEntry( const ReplayTableType *table, uint64_t key );
+
+/*
+Name: getJournalFileName
+Process: builds the journal file name for a generation
+Function input/parameters: base name (const char *), generation (uint32_t)
+Function output/parameters: file name (char *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: snprintf
+*/
+void getJournalFileName( char *fileName, const char *baseName,
+                                                      uint32_t generation );
+
+/*
+Name: hashJournalBytes
+Process: computes an FNV-1a style checksum of a frame payload, 
+         mixes eight bytes per step so checking keeps up with replay,
+         folds the result to 32 bits
+Function input/parameters: bytes (const unsigned char *), count (size_t)
+Function output/parameters: none
+Function output/returned: checksum (uint32_t)
+Device input/---: none
+Device output/---: none
+Dependencies: memcpy
+*/
+uint32_t hashJournalBytes( const unsigned char *bytes, size_t size );
+
+/*
+Name: hashReplayKey
+Process: mixes the arrival sequence of an ordering key into a replay
+         table bucket index, a priority change keeps the same bucket
+Function input/parameters: key (uint64_t), bucket mask (long)
+Function output/parameters: none
+Function output/returned: bucket index (long)
+Device input/---: none
+Device output/---: none
+Dependencies: getKeySequence
+*/
+long hashReplayKey( uint64_t key, long mask );
+
+/*
+Name: insertReplayEntry
+Process: adds a waiting patient to the replay table, doubles the table
+         first if it would pass half full
+Function input/parameters: replay table (ReplayTableType *), key (uint64_t),
+                           time in (int64_t), name (const char *)
+Function output/parameters: updated replay table (ReplayTableType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: resizeReplayTable, hashReplayKey
+*/
+void insertReplayEntry( ReplayTableType *table, uint64_t key,
+                                         int64_t timeIn, const char *name );
+
+/*
+Name: journalAddItem
+Process: adds patient to the heap and logs the add with the key used,
+         logs a sequence rebase first if the add caused one, a patient
+         turned away for lack of memory is not logged and gives its
+         arrival sequence back
+Function input/parameters: journaled heap (JournaledHeapType *),
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: stable handle of patient slot, INVALID_HANDLE
+                          if memory ran out (int)
+Device input/---: none
+Device output/---: journal file when syncing every record
+Dependencies: pthread_mutex_lock, takeNextSequence, makeHeapKey,
+              addHeapItemWithKey, encodeAddRecord, appendJournalRecord,
+              getSlotName, pthread_mutex_unlock, syncJournal
+*/
+int journalAddItem( JournaledHeapType *journaled, const char *nameSet,
+                                              int prioritySet, time_t timeSet );
+
+/*
+Name: journalRemoveByHandle
+Process: removes a waiting patient by handle and logs its key
+Function input/parameters: journaled heap (JournaledHeapType *),
+                           handle (int)
+Function output/parameters: updated journaled heap (JournaledHeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if handle is not waiting (bool)
+Device input/---: none
+Device output/---: journal file when syncing every record
+Dependencies: pthread_mutex_lock, getSlotPosition, getHeapEntry, 
+              removeByHandle, appendJournalRecord,
+              pthread_mutex_unlock, syncJournal
+*/
+bool journalRemoveByHandle( JournaledHeapType *journaled, int handle,
+                                                       PatientType *removed );
+
+/*
+Name: journalRemoveItem
+Process: removes the highest priority patient and logs its key
+Function input/parameters: journaled heap (JournaledHeapType *)
+Function output/parameters: updated journaled heap (JournaledHeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if heap is empty (bool)
+Device input/---: none
+Device output/---: journal file when syncing every record
+Dependencies: pthread_mutex_lock, removeItem, appendJournalRecord,
+              pthread_mutex_unlock, syncJournal
+*/
+bool journalRemoveItem( JournaledHeapType *journaled, PatientType *removed );
+
+/*
+Name: journalUpdatePriority
+Process: changes the priority of a waiting patient, logs old and new keys
+Function input/parameters: journaled heap (JournaledHeapType *),
+                           handle (int), new priority (int)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: Boolean result, false if handle is not waiting (bool)
+Device input/---: none
+Device output/---: journal file when syncing every record
+Dependencies: pthread_mutex_lock, getSlotPosition, getHeapEntry, 
+              updatePriority, appendJournalRecord,
+              pthread_mutex_unlock, syncJournal
+*/
+bool journalUpdatePriority( JournaledHeapType *journaled, int handle,
+                                                          int newPriority );
+
+/*
+Name: loadReplayTable
+Process: stores every replayed patient in a slot with its logged key,
+         places the entries in array order, then heapifies once
+Function input/parameters: replay table (const ReplayTableType *)
+Function output/parameters: loaded heap data (HeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          before every patient was loaded (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: resizeHeap, storePatientInSlot, setHeapEntry,
+              heapifyArrayHeap, storeHeapFileCounters
+*/
+bool loadReplayTable( const ReplayTableType *table, HeapType *heap );
+
+/*
+Name: openJournaledHeap
+Process: recovers the heap from the latest snapshot and every journal
+         generation after it, then snapshots the result to start a clean
+         generation, removes older journals, starts the background writer
+Function input/parameters: journaled heap (JournaledHeapType *),
+                           base name of journal files (const char *),
+                           durability settings (JournalConfigType),
+                           initial capacity (int)
+Function output/parameters: recovered journaled heap (JournaledHeapType *)
+Function output/returned: Boolean result, false if the snapshot is damaged,
+                          memory ran out loading the recovered patients,
+                          or the journal cannot be created (bool)
+Device input/---: snapshot and journal files
+Device output/---: snapshot and journal files
+Dependencies: clock_gettime, initializeHeap, copyStringBounded, 
+              pthread_mutex_init, pthread_cond_init, malloc, 
+              readJournalFile, replayRecords,
+              replayJournalFrames, getJournalFileName, loadReplayTable,
+              snapshotJournaledHeap, unlink, pthread_create, free
+*/
+bool openJournaledHeap( JournaledHeapType *journaled, const char *baseName,
+                             JournalConfigType config, int initialCapacity );
+
+/*
+Name: prefetchReplayRecord
+Process: finds the size of the encoded record at the front of the bytes
+         and starts loading the replay bucket its key hashes to, so the
+         cache miss overlaps with applying earlier records
+Function input/parameters: replay table (const ReplayTableType *),
+                           record bytes (const unsigned char *),
+                           byte count (size_t)
+Function output/parameters: none
+Function output/returned: record size, zero if the record is cut short 
+                          or of unknown type (size_t)
+Device input/---: none
+Device output/---: none
+Dependencies: memcpy, hashReplayKey
+*/
+size_t prefetchReplayRecord( const ReplayTableType *table,
+                                   const unsigned char *bytes, size_t size );
+
+/*
+Name: readJournalFile
+Process: reads a whole journal or snapshot file into memory
+Function input/parameters: file name (const char *)
+Function output/parameters: file size (size_t *)
+Function output/returned: file bytes to free later,
+                          NULL if the file does not exist (unsigned char *)
+Device input/---: journal or snapshot file
+Device output/---: none
+Dependencies: open, fstat, malloc, read, close
+*/
+unsigned char *readJournalFile( const char *fileName, size_t *size );
+
+/*
+Name: removeReplayEntry
+Process: removes the patient in a bucket, shifts later entries of the
+         same probe run back so no tombstones are needed
+Function input/parameters: replay table (ReplayTableType *), bucket (long)
+Function output/parameters: updated replay table (ReplayTableType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: hashReplayKey
+*/
+void removeReplayEntry( ReplayTableType *table, long bucket );
+
+/*
+Name: replayJournalFrames
+Process: checks each frame of a journal and replays its records,
+         stops at the first torn or damaged frame
+Function input/parameters: journal bytes (const unsigned char *),
+                           byte count (size_t)
+Function output/parameters: updated replay table (ReplayTableType *)
+Function output/returned: Boolean result, false if replay stopped early (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: hashJournalBytes, replayRecords
+*/
+bool replayJournalFrames( ReplayTableType *table,
+                                   const unsigned char *bytes, size_t size );
+
+/*
+Name: replayRecords
+Process: applies encoded records to the replay table in order, an add
+         inserts, a remove deletes, an update rekeys, a rebase shifts
+         every waiting key, no heap work is done per record
+Function input/parameters: record bytes (const unsigned char *),
+                           byte count (size_t)
+Function output/parameters: updated replay table (ReplayTableType *)
+Function output/returned: Boolean result, false on a damaged record (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: prefetchReplayRecord, memcpy, insertReplayEntry, 
+              findReplayEntry, removeReplayEntry, makeHeapKey, getKeyPriority,
+              getKeySequence, resizeReplayTable
+*/
+bool replayRecords( ReplayTableType *table,
+                                   const unsigned char *bytes, size_t size );
+
+/*
+Name: resizeReplayTable
+Process: creates a replay table of the given power of two size,
+         re-inserts every waiting patient, frees the old buckets
+Function input/parameters: replay table (ReplayTableType *),
+                           bucket count (long)
+Function output/parameters: updated replay table (ReplayTableType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: calloc, free, hashReplayKey
+*/
+void resizeReplayTable( ReplayTableType *table, long bucketCount );
+
+/*
+Name: runJournalBackground
+Process: background writer, syncs buffered records every sync interval
+         or when woken by a full batch, takes a snapshot every snapshot
+         interval, runs until the journaled heap is closed
+Function input/parameters: journaled heap (void *)
+Function output/parameters: none
+Function output/returned: none (void *)
+Device input/---: none
+Device output/---: snapshot and journal files
+Dependencies: clock_gettime, pthread_mutex_lock, pthread_cond_timedwait,
+              pthread_mutex_unlock, syncJournal, snapshotJournaledHeap
+*/
+void *runJournalBackground( void *journaledPtr );
+
+/*
+Name: snapshotJournaledHeap
+Process: under the heap lock encodes every waiting patient as an add
+         record and switches to the next journal generation, then syncs
+         the last records of the old journal, writes the snapshot to a
+         temporary file, syncs and renames it over the old snapshot,
+         and removes the old journal
+Function input/parameters: journaled heap (JournaledHeapType *)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: Boolean result, false if a file write failed (bool)
+Device input/---: none
+Device output/---: snapshot and journal files
+Dependencies: pthread_mutex_lock, getHeapEntry, encodeAddRecord, 
+              appendJournalBytes, getPatientSlot,
+              getSlotName, pthread_mutex_unlock, writeJournalFrame, fsync,
+              close, getJournalFileName, open, writeJournalBytes,
+              hashJournalBytes, rename, unlink, free
+*/
+bool snapshotJournaledHeap( JournaledHeapType *journaled );
+
+/*
+Name: syncJournal
+Process: swaps out the active buffer and writes it as one frame, then
+         syncs the journal, records from every thread since the last
+         sync share the one fsync
+Function input/parameters: journaled heap (JournaledHeapType *)
+Function output/parameters: updated journaled heap (JournaledHeapType *)
+Function output/returned: Boolean result, false if the write failed (bool)
+Device input/---: none
+Device output/---: journal file
+Dependencies: pthread_mutex_lock, pthread_mutex_unlock, writeJournalFrame,
+              fsync
+*/
+bool syncJournal( JournaledHeapType *journaled );
+
+/*
+Name: writeJournalBytes
+Process: writes all bytes to a file, retrying short writes
+Function input/parameters: file descriptor (int),
+                           bytes (const unsigned char *), count (size_t)
+Function output/parameters: none
+Function output/returned: Boolean result, false if the write failed (bool)
+Device input/---: none
+Device output/---: journal or snapshot file
+Dependencies: write
+*/
+bool writeJournalBytes( int fileDescriptor,
+                                   const unsigned char *bytes, size_t size );
+
+/*
+Name: writeJournalFrame
+Process: fills in the reserved frame header of a record buffer, writes
+         the frame, then empties the buffer, an empty buffer writes nothing
+Function input/parameters: file descriptor (int),
+                           record buffer (JournalBufferType *)
+Function output/parameters: emptied record buffer (JournalBufferType *)
+Function output/returned: Boolean result, false if the write failed (bool)
+Device input/---: none
+Device output/---: journal file
+Dependencies: hashJournalBytes, memcpy, writeJournalBytes
+*/
+bool writeJournalFrame( int fileDescriptor, JournalBufferType *buffer );
+
+
+#endif   // JOURNAL_UTILITY_H
@@ -0,0 +1,674 @@
+#include "MeldableHeapUtility.h"
+
+/*
+Name: addMeldableItem
+Process: adds patient to pairing heap, takes a node from the pool
+         and links it with the root, turns the patient away if the 
+         pool cannot grow
+Function input/parameters: pairing heap (MeldableHeapType *),
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated pairing heap (MeldableHeapType *)
+Function output/returned: stable handle of patient node, INVALID_HANDLE
+                          if memory ran out (int)
+Device input/---: none
+Device output/---: none
+Dependencies: allocateMeldableNode, setPatientFromData, makeHeapKey,
+              linkMeldableNodes
+*/
+int addMeldableItem( MeldableHeapType *heap, const char *nameSet,
+                                              int prioritySet, time_t timeSet )
+  {
+  // variables
+  NodePoolType *pool = heap->pool;
+  int node = allocateMeldableNode( pool );
+
+  if( node == INVALID_HANDLE )
+    {
+    return INVALID_HANDLE;
+    }
+
+  setPatientFromData( &pool->patients[ node ], nameSet, prioritySet,
+                                                                    timeSet );
+
+  pool->nodes[ node ].key = makeHeapKey( prioritySet, pool->nextSequence );
+  pool->nodes[ node ].child = INVALID_HANDLE;
+  pool->nodes[ node ].next = INVALID_HANDLE;
+  pool->nodes[ node ].prev = INVALID_HANDLE;
+  pool->nodes[ node ].heapId = heap->id;
+
+  pool->nextSequence++;
+
+  if( heap->root == INVALID_HANDLE )
+    {
+    heap->root = node;
+    }
+
+  else
+    {
+    heap->root = linkMeldableNodes( pool, heap->root, node );
+    }
+
+  heap->size++;
+
+  return node;
+  }
+
+/*
+Name: allocateMeldableNode
+Process: takes a node off the pool's free list, doubles the pool
+         when none are free, node indices stay the same
+Function input/parameters: node pool (NodePoolType *)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: node index, INVALID_HANDLE if memory ran out
+                          and the pool is unchanged (int)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc
+*/
+int allocateMeldableNode( NodePoolType *pool )
+  {
+  // variables
+  int node, newCapacity;
+  MeldableNodeType *newNodes;
+  PatientType *newPatients;
+
+  if( pool->freeNode == INVALID_HANDLE )
+    {
+    newCapacity = pool->capacity > 0 ? pool->capacity * 2 
+                                                   : MIN_NODE_POOL_CAPACITY;
+
+    newNodes = ( MeldableNodeType *)realloc( pool->nodes,
+                            (size_t)newCapacity * sizeof( MeldableNodeType ) );
+
+    if( newNodes == NULL )
+      {
+      return INVALID_HANDLE;
+      }
+
+    // the larger node block is kept even if the patients cannot follow,
+    // the capacity still covers only the old nodes
+    pool->nodes = newNodes;
+
+    newPatients = ( PatientType *)realloc( pool->patients,
+                                  (size_t)newCapacity * sizeof( PatientType ) );
+
+    if( newPatients == NULL )
+      {
+      return INVALID_HANDLE;
+      }
+
+    pool->patients = newPatients;
+
+    // new nodes go on the free list lowest index first
+    for( node = newCapacity - 1; node >= pool->capacity; node-- )
+      {
+      pool->nodes[ node ].next = pool->freeNode;
+      pool->nodes[ node ].prev = FREE_NODE;
+
+      pool->freeNode = node;
+      }
+
+    pool->capacity = newCapacity;
+    }
+
+  node = pool->freeNode;
+
+  pool->freeNode = pool->nodes[ node ].next;
+
+  return node;
+  }
+
+/*
+Name: allocateMeldableHeapId
+Process: takes the pool's next heap id as a new root of the heap id
+         forest, doubles the id table when full
+Function input/parameters: node pool (NodePoolType *)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: heap id, INVALID_HANDLE if memory ran out (int)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc
+*/
+int allocateMeldableHeapId( NodePoolType *pool )
+  {
+  // variables
+  int *newParents, newCapacity;
+
+  if( pool->heapCount == pool->heapCapacity )
+    {
+    newCapacity = pool->heapCapacity > 0 ? pool->heapCapacity * 2
+                                                       : MIN_HEAP_ID_CAPACITY;
+
+    newParents = ( int *)realloc( pool->heapParents,
+                                                newCapacity * sizeof( int ) );
+
+    if( newParents == NULL )
+      {
+      return INVALID_HANDLE;
+      }
+
+    pool->heapParents = newParents;
+    pool->heapCapacity = newCapacity;
+    }
+
+  // a new id is its own root until its heap is merged away
+  pool->heapParents[ pool->heapCount ] = pool->heapCount;
+
+  pool->heapCount++;
+
+  return pool->heapCount - 1;
+  }
+
+/*
+Name: clearNodePool
+Process: frees the pool's nodes, patients, and heap ids,
+         heaps on it become unusable
+Function input/parameters: node pool (NodePoolType *)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: free
+*/
+void clearNodePool( NodePoolType *pool )
+  {
+  free( pool->nodes );
+  free( pool->patients );
+  free( pool->heapParents );
+
+  pool->nodes = NULL;
+  pool->patients = NULL;
+  pool->heapParents = NULL;
+  pool->capacity = 0;
+  pool->freeNode = INVALID_HANDLE;
+  pool->heapCount = 0;
+  pool->heapCapacity = 0;
+  }
+
+/*
+Name: combineMeldableSiblings
+Process: two pass pairing of a list of siblings into one tree,
+         links neighbors left to right, then links the pairs
+         right to left into the last one
+Function input/parameters: node pool (NodePoolType *), first sibling (int)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: root of the combined tree, INVALID_HANDLE
+                          if the list is empty (int)
+Device input/---: none
+Device output/---: none
+Dependencies: linkMeldableNodes
+*/
+int combineMeldableSiblings( NodePoolType *pool, int first )
+  {
+  // variables
+  MeldableNodeType *nodes = pool->nodes;
+  int pairs = INVALID_HANDLE, one, other, root, rest;
+
+  // first pass, each pair's root is pushed onto a list through next,
+  // so the list ends up last pair first
+  while( first != INVALID_HANDLE )
+    {
+    one = first;
+    other = nodes[ one ].next;
+
+    if( other == INVALID_HANDLE )
+      {
+      first = INVALID_HANDLE;
+
+      root = one;
+      }
+
+    else
+      {
+      first = nodes[ other ].next;
+
+      nodes[ other ].next = INVALID_HANDLE;
+      nodes[ other ].prev = INVALID_HANDLE;
+      nodes[ one ].next = INVALID_HANDLE;
+      nodes[ one ].prev = INVALID_HANDLE;
+
+      root = linkMeldableNodes( pool, one, other );
+      }
+
+    nodes[ root ].prev = INVALID_HANDLE;
+    nodes[ root ].next = pairs;
+
+    pairs = root;
+    }
+
+  if( pairs == INVALID_HANDLE )
+    {
+    return INVALID_HANDLE;
+    }
+
+  // second pass, fold the pairs into the last one
+  root = pairs;
+  rest = nodes[ root ].next;
+
+  nodes[ root ].next = INVALID_HANDLE;
+
+  while( rest != INVALID_HANDLE )
+    {
+    other = rest;
+    rest = nodes[ other ].next;
+
+    nodes[ other ].next = INVALID_HANDLE;
+
+    root = linkMeldableNodes( pool, root, other );
+    }
+
+  return root;
+  }
+
+/*
+Name: detachMeldableNode
+Process: cuts a node out of its heap, its children are combined and
+         linked back into the heap so the node leaves alone
+Function input/parameters: pairing heap (MeldableHeapType *), node (int)
+Function output/parameters: updated pairing heap (MeldableHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: combineMeldableSiblings, linkMeldableNodes
+*/
+void detachMeldableNode( MeldableHeapType *heap, int node )
+  {
+  // variables
+  NodePoolType *pool = heap->pool;
+  MeldableNodeType *nodes = pool->nodes;
+  int children, prev = nodes[ node ].prev, next = nodes[ node ].next;
+
+  children = combineMeldableSiblings( pool, nodes[ node ].child );
+
+  nodes[ node ].child = INVALID_HANDLE;
+
+  // the root leaves its children as the new root
+  if( node == heap->root )
+    {
+    heap->root = children;
+
+    return;
+    }
+
+  // a first child is found through its parent, others through the sibling
+  if( nodes[ prev ].child == node )
+    {
+    nodes[ prev ].child = next;
+    }
+
+  else
+    {
+    nodes[ prev ].next = next;
+    }
+
+  if( next != INVALID_HANDLE )
+    {
+    nodes[ next ].prev = prev;
+    }
+
+  nodes[ node ].next = INVALID_HANDLE;
+  nodes[ node ].prev = INVALID_HANDLE;
+
+  if( children != INVALID_HANDLE )
+    {
+    heap->root = linkMeldableNodes( pool, heap->root, children );
+    }
+  }
+
+/*
+Name: findMeldableHeapId
+Process: follows a heap id up the pool's heap id forest to the id of the
+         heap now holding its nodes, halving the path on the way
+Function input/parameters: node pool (NodePoolType *), heap id (int)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: id of the heap now holding the nodes (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int findMeldableHeapId( NodePoolType *pool, int heapId )
+  {
+  // variables
+  int *parents = pool->heapParents;
+
+  // each id on the path skips to its grandparent
+  while( parents[ heapId ] != heapId )
+    {
+    parents[ heapId ] = parents[ parents[ heapId ] ];
+
+    heapId = parents[ heapId ];
+    }
+
+  return heapId;
+  }
+
+/*
+Name: initializeMeldableHeap
+Process: sets up an empty pairing heap on a node pool with a new heap id
+Function input/parameters: node pool (NodePoolType *)
+Function output/parameters: initialized pairing heap (MeldableHeapType *)
+Function output/returned: Boolean result, false if memory for the
+                          heap id ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: allocateMeldableHeapId
+*/
+bool initializeMeldableHeap( MeldableHeapType *heap, NodePoolType *pool )
+  {
+  heap->pool = pool;
+  heap->root = INVALID_HANDLE;
+  heap->size = 0;
+  heap->id = allocateMeldableHeapId( pool );
+
+  return heap->id != INVALID_HANDLE;
+  }
+
+/*
+Name: initializeNodePool
+Process: sets up a node pool with room for the given number of patients,
+         every node on the free list, and an empty heap id table
+Function input/parameters: capacity (int)
+Function output/parameters: initialized node pool (NodePoolType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: malloc
+*/
+void initializeNodePool( NodePoolType *pool, int capacity )
+  {
+  // variables
+  int node;
+
+  if( capacity < MIN_NODE_POOL_CAPACITY )
+    {
+    capacity = MIN_NODE_POOL_CAPACITY;
+    }
+
+  pool->nodes = ( MeldableNodeType *)malloc(
+                                      capacity * sizeof( MeldableNodeType ) );
+  pool->patients = ( PatientType *)malloc( capacity * sizeof( PatientType ) );
+  pool->capacity = capacity;
+  pool->freeNode = INVALID_HANDLE;
+  pool->nextSequence = 0;
+
+  // heap ids are handed out as heaps are set up on the pool
+  pool->heapParents = NULL;
+  pool->heapCount = 0;
+  pool->heapCapacity = 0;
+
+  // handed out lowest index first
+  for( node = capacity - 1; node >= 0; node-- )
+    {
+    pool->nodes[ node ].next = pool->freeNode;
+    pool->nodes[ node ].prev = FREE_NODE;
+
+    pool->freeNode = node;
+    }
+  }
+
+/*
+Name: isMeldableEmpty
+Process: reports if pairing heap holds no patients
+Function input/parameters: pairing heap (const MeldableHeapType *)
+Function output/parameters: none
+Function output/returned: Boolean result of test (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+bool isMeldableEmpty( const MeldableHeapType *heap )
+  {
+  return heap->size == 0;
+  }
+
+/*
+Name: isMeldableHandleIn
+Process: reports if a handle is a waiting node of this heap, not a free
+         node and not a node of another heap on the same pool
+Function input/parameters: pairing heap (MeldableHeapType *), handle (int)
+Function output/parameters: pool with shortened heap id paths
+                            (MeldableHeapType *)
+Function output/returned: Boolean result of test (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: findMeldableHeapId
+*/
+bool isMeldableHandleIn( MeldableHeapType *heap, int handle )
+  {
+  // variables
+  NodePoolType *pool = heap->pool;
+
+  // a free node's heap id is left from before it was freed
+  return handle >= 0 && handle < pool->capacity
+               && pool->nodes[ handle ].prev != FREE_NODE
+               && findMeldableHeapId( pool, pool->nodes[ handle ].heapId )
+                                                                 == heap->id;
+  }
+
+/*
+Name: linkMeldableNodes
+Process: links two tree roots, the one with the smaller key becomes
+         the first child of the other
+Function input/parameters: node pool (NodePoolType *),
+                           tree roots (int), (int)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: root of the linked tree (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int linkMeldableNodes( NodePoolType *pool, int one, int other )
+  {
+  // variables
+  MeldableNodeType *nodes = pool->nodes;
+  int parent = one, child = other;
+
+  if( nodes[ other ].key > nodes[ one ].key )
+    {
+    parent = other;
+    child = one;
+    }
+
+  nodes[ child ].prev = parent;
+  nodes[ child ].next = nodes[ parent ].child;
+
+  if( nodes[ parent ].child != INVALID_HANDLE )
+    {
+    nodes[ nodes[ parent ].child ].prev = child;
+    }
+
+  nodes[ parent ].child = child;
+
+  return parent;
+  }
+
+/*
+Name: mergeMeldableHeaps
+Process: moves every patient of the source heap into the destination
+         heap in constant time by linking their roots, points the source
+         heap id at the destination's and gives the emptied source a new
+         id, handles of moved patients stay valid
+Function input/parameters: destination heap (MeldableHeapType *),
+                           source heap (MeldableHeapType *)
+Function output/parameters: updated destination heap (MeldableHeapType *),
+                            empty source heap (MeldableHeapType *)
+Function output/returned: Boolean result, false if the heaps are on
+                          different pools or memory for the new source
+                          heap id ran out, heaps unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: allocateMeldableHeapId, linkMeldableNodes
+*/
+bool mergeMeldableHeaps( MeldableHeapType *dest, MeldableHeapType *src )
+  {
+  // variables
+  int newSourceId;
+
+  if( dest->pool != src->pool )
+    {
+    return false;
+    }
+
+  // no waiting node carries the id of an empty heap
+  if( dest == src || src->root == INVALID_HANDLE )
+    {
+    return true;
+    }
+
+  // the emptied source needs an id its old nodes do not lead to
+  newSourceId = allocateMeldableHeapId( src->pool );
+
+  if( newSourceId == INVALID_HANDLE )
+    {
+    return false;
+    }
+
+  src->pool->heapParents[ src->id ] = dest->id;
+  src->id = newSourceId;
+
+  if( dest->root == INVALID_HANDLE )
+    {
+    dest->root = src->root;
+    }
+
+  else
+    {
+    dest->root = linkMeldableNodes( dest->pool, dest->root, src->root );
+    }
+
+  dest->size += src->size;
+
+  src->root = INVALID_HANDLE;
+  src->size = 0;
+
+  return true;
+  }
+
+/*
+Name: releaseMeldableNode
+Process: copies a detached node's patient out and returns the node
+         to the pool's free list
+Function input/parameters: node pool (NodePoolType *), node (int)
+Function output/parameters: updated node pool (NodePoolType *),
+                            removed patient (PatientType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: getKeyPriority
+*/
+void releaseMeldableNode( NodePoolType *pool, int node, PatientType *removed )
+  {
+  *removed = pool->patients[ node ];
+
+  // the key holds the current priority after any update
+  removed->priority = getKeyPriority( pool->nodes[ node ].key );
+
+  pool->nodes[ node ].next = pool->freeNode;
+  pool->nodes[ node ].prev = FREE_NODE;
+
+  pool->freeNode = node;
+  }
+
+/*
+Name: removeMeldableByHandle
+Process: removes a waiting patient by handle from anywhere in the heap
+Function input/parameters: pairing heap (MeldableHeapType *), handle (int)
+Function output/parameters: updated pairing heap (MeldableHeapType *),
+                            removed patient (PatientType *)
+Function output/returned: Boolean result, false if handle is not
+                          waiting in this heap (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: isMeldableHandleIn, detachMeldableNode, releaseMeldableNode
+*/
+bool removeMeldableByHandle( MeldableHeapType *heap, int handle,
+                                                       PatientType *removed )
+  {
+  if( !isMeldableHandleIn( heap, handle ) )
+    {
+    return false;
+    }
+
+  detachMeldableNode( heap, handle );
+
+  releaseMeldableNode( heap->pool, handle, removed );
+
+  heap->size--;
+
+  return true;
+  }
+
+/*
+Name: removeMeldableItem
+Process: removes the patient at the root, the root's children are
+         combined by two pass pairing into the new root
+Function input/parameters: pairing heap (MeldableHeapType *)
+Function output/parameters: removed patient (PatientType *),
+                            updated pairing heap (MeldableHeapType *)
+Function output/returned: Boolean result, false if heap is empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: detachMeldableNode, releaseMeldableNode
+*/
+bool removeMeldableItem( PatientType *removed, MeldableHeapType *heap )
+  {
+  // variables
+  int root = heap->root;
+
+  if( root == INVALID_HANDLE )
+    {
+    return false;
+    }
+
+  detachMeldableNode( heap, root );
+
+  releaseMeldableNode( heap->pool, root, removed );
+
+  heap->size--;
+
+  return true;
+  }
+
+/*
+Name: updateMeldablePriority
+Process: gives a waiting patient a new priority with the same arrival
+         sequence, the node is detached and linked back with the root
+Function input/parameters: pairing heap (MeldableHeapType *), handle (int),
+                           new priority (int)
+Function output/parameters: updated pairing heap (MeldableHeapType *)
+Function output/returned: Boolean result, false if handle is not
+                          waiting in this heap (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: isMeldableHandleIn, detachMeldableNode, makeHeapKey,
+              getKeySequence, linkMeldableNodes
+*/
+bool updateMeldablePriority( MeldableHeapType *heap, int handle,
+                                                            int newPriority )
+  {
+  // variables
+  MeldableNodeType *nodes = heap->pool->nodes;
+
+  if( !isMeldableHandleIn( heap, handle ) )
+    {
+    return false;
+    }
+
+  detachMeldableNode( heap, handle );
+
+  nodes[ handle ].key = makeHeapKey( newPriority,
+                                       getKeySequence( nodes[ handle ].key ) );
+
+  if( heap->root == INVALID_HANDLE )
+    {
+    heap->root = handle;
+    }
+
+  else
+    {
+    heap->root = linkMeldableNodes( heap->pool, heap->root, handle );
+    }
+
+  return true;
+  }
@@ -0,0 +1,309 @@
+#ifndef MELDABLE_HEAP_UTILITY_H
+#define MELDABLE_HEAP_UTILITY_H
+
+#include "HeapUtility.c"
+
+// constants
+
+#define MIN_NODE_POOL_CAPACITY 16
+
+#define MIN_HEAP_ID_CAPACITY 4
+
+// prev of a node on the free list, no waiting node links to it
+#define FREE_NODE -2
+
+// data structures
+
+// pairing heap node, children form a list through next, prev is the
+// previous sibling or, for a first child, the parent, heap id is the id
+// of the heap the node was added to
+typedef struct MeldableNodeStruct
+   {
+    uint64_t key;
+
+    int child, next, prev;
+
+    int heapId;
+   } MeldableNodeType;
+
+// nodes and patients for any number of pairing heaps, a handle is a node
+// index and stays valid when its heap is merged into another on the
+// same pool, so a handle is passed with the heap now holding it,
+// free nodes are listed through next, heaps on one pool share its
+// arrival sequence so merged patients keep arrival order,
+// heap ids form a union find forest, a merged heap's id points at the
+// heap it went into, so a handle's heap is found in near constant time
+// while a merge stays constant time
+typedef struct NodePoolStruct
+   {
+    MeldableNodeType *nodes;
+
+    PatientType *patients;
+
+    int capacity, freeNode;
+
+    uint32_t nextSequence;
+
+    int *heapParents;
+
+    int heapCount, heapCapacity;
+   } NodePoolType;
+
+// pairing heap after Fredman et al., larger key at the root,
+// two heaps on one pool merge by linking their roots,
+// the id is always a root of the pool's heap id forest
+typedef struct MeldableHeapStruct
+   {
+    NodePoolType *pool;
+
+    int root, size, id;
+   } MeldableHeapType;
+
+// function prototypes
+
+/*
+Name: addMeldableItem
+Process: adds patient to pairing heap, takes a node from the pool
+         and links it with the root, turns the patient away if the 
+         pool cannot grow
+Function input/parameters: pairing heap (MeldableHeapType *),
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated pairing heap (MeldableHeapType *)
+Function output/returned: stable handle of patient node, INVALID_HANDLE
+                          if memory ran out (int)
+Device input/---: none
+Device output/---: none
+Dependencies: allocateMeldableNode, setPatientFromData, makeHeapKey,
+              linkMeldableNodes
+*/
+int addMeldableItem( MeldableHeapType *heap, const char *nameSet,
+                                              int prioritySet, time_t timeSet );
+
+/*
+Name: allocateMeldableNode
+Process: takes a node off the pool's free list, doubles the pool
+         when none are free, node indices stay the same
+Function input/parameters: node pool (NodePoolType *)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: node index, INVALID_HANDLE if memory ran out
+                          and the pool is unchanged (int)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc
+*/
+int allocateMeldableNode( NodePoolType *pool );
+
+/*
+Name: allocateMeldableHeapId
+Process: takes the pool's next heap id as a new root of the heap id
+         forest, doubles the id table when full
+Function input/parameters: node pool (NodePoolType *)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: heap id, INVALID_HANDLE if memory ran out (int)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc
+*/
+int allocateMeldableHeapId( NodePoolType *pool );
+
+/*
+Name: clearNodePool
+Process: frees the pool's nodes, patients, and heap ids,
+         heaps on it become unusable
+Function input/parameters: node pool (NodePoolType *)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: free
+*/
+void clearNodePool( NodePoolType *pool );
+
+/*
+Name: combineMeldableSiblings
+Process: two pass pairing of a list of siblings into one tree,
+         links neighbors left to right, then links the pairs
+         right to left into the last one
+Function input/parameters: node pool (NodePoolType *), first sibling (int)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: root of the combined tree, INVALID_HANDLE
+                          if the list is empty (int)
+Device input/---: none
+Device output/---: none
+Dependencies: linkMeldableNodes
+*/
+int combineMeldableSiblings( NodePoolType *pool, int first );
+
+/*
+Name: detachMeldableNode
+Process: cuts a node out of its heap, its children are combined and
+         linked back into the heap so the node leaves alone
+Function input/parameters: pairing heap (MeldableHeapType *), node (int)
+Function output/parameters: updated pairing heap (MeldableHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: combineMeldableSiblings, linkMeldableNodes
+*/
+void detachMeldableNode( MeldableHeapType *heap, int node );
+
+/*
+Name: findMeldableHeapId
+Process: follows a heap id up the pool's heap id forest to the id of the
+         heap now holding its nodes, halving the path on the way
+Function input/parameters: node pool (NodePoolType *), heap id (int)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: id of the heap now holding the nodes (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int findMeldableHeapId( NodePoolType *pool, int heapId );
+
+/*
+Name: initializeMeldableHeap
+Process: sets up an empty pairing heap on a node pool with a new heap id
+Function input/parameters: node pool (NodePoolType *)
+Function output/parameters: initialized pairing heap (MeldableHeapType *)
+Function output/returned: Boolean result, false if memory for the
+                          heap id ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: allocateMeldableHeapId
+*/
+bool initializeMeldableHeap( MeldableHeapType *heap, NodePoolType *pool );
+
+/*
+Name: initializeNodePool
+Process: sets up a node pool with room for the given number of patients,
+         every node on the free list, and an empty heap id table
+Function input/parameters: capacity (int)
+Function output/parameters: initialized node pool (NodePoolType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: malloc
+*/
+void initializeNodePool( NodePoolType *pool, int capacity );
+
+/*
+Name: isMeldableEmpty
+Process: reports if pairing heap holds no patients
+Function input/parameters: pairing heap (const MeldableHeapType *)
+Function output/parameters: none
+Function output/returned: Boolean result of test (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+bool isMeldableEmpty( const MeldableHeapType *heap );
+
+/*
+Name: isMeldableHandleIn
+Process: reports if a handle is a waiting node of this heap, not a free
+         node and not a node of another heap on the same pool
+Function input/parameters: pairing heap (MeldableHeapType *), handle (int)
+Function output/parameters: pool with shortened heap id paths
+                            (MeldableHeapType *)
+Function output/returned: Boolean result of test (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: findMeldableHeapId
+*/
+bool isMeldableHandleIn( MeldableHeapType *heap, int handle );
+
+/*
+Name: linkMeldableNodes
+Process: links two tree roots, the one with the smaller key becomes
+         the first child of the other
+Function input/parameters: node pool (NodePoolType *),
+                           tree roots (int), (int)
+Function output/parameters: updated node pool (NodePoolType *)
+Function output/returned: root of the linked tree (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int linkMeldableNodes( NodePoolType *pool, int one, int other );
+
+/*
+Name: mergeMeldableHeaps
+Process: moves every patient of the source heap into the destination
+         heap in constant time by linking their roots, points the source
+         heap id at the destination's and gives the emptied source a new
+         id, handles of moved patients stay valid
+Function input/parameters: destination heap (MeldableHeapType *),
+                           source heap (MeldableHeapType *)
+Function output/parameters: updated destination heap (MeldableHeapType *),
+                            empty source heap (MeldableHeapType *)
+Function output/returned: Boolean result, false if the heaps are on
+                          different pools or memory for the new source
+                          heap id ran out, heaps unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: allocateMeldableHeapId, linkMeldableNodes
+*/
+bool mergeMeldableHeaps( MeldableHeapType *dest, MeldableHeapType *src );
+
+/*
+Name: removeMeldableByHandle
+Process: removes a waiting patient by handle from anywhere in the heap
+Function input/parameters: pairing heap (MeldableHeapType *), handle (int)
+Function output/parameters: updated pairing heap (MeldableHeapType *),
+                            removed patient (PatientType *)
+Function output/returned: Boolean result, false if handle is not
+                          waiting in this heap (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: isMeldableHandleIn, detachMeldableNode, releaseMeldableNode
+*/
+bool removeMeldableByHandle( MeldableHeapType *heap, int handle,
+                                                       PatientType *removed );
+
+/*
+Name: removeMeldableItem
+Process: removes the patient at the root, the root's children are
+         combined by two pass pairing into the new root
+Function input/parameters: pairing heap (MeldableHeapType *)
+Function output/parameters: removed patient (PatientType *),
+                            updated pairing heap (MeldableHeapType *)
+Function output/returned: Boolean result, false if heap is empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: detachMeldableNode, releaseMeldableNode
+*/
+bool removeMeldableItem( PatientType *removed, MeldableHeapType *heap );
+
+/*
+Name: releaseMeldableNode
+Process: copies a detached node's patient out and returns the node
+         to the pool's free list
+Function input/parameters: node pool (NodePoolType *), node (int)
+Function output/parameters: updated node pool (NodePoolType *),
+                            removed patient (PatientType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: getKeyPriority
+*/
+void releaseMeldableNode( NodePoolType *pool, int node, PatientType *removed );
+
+/*
+Name: updateMeldablePriority
+Process: gives a waiting patient a new priority with the same arrival
+         sequence, the node is detached and linked back with the root
+Function input/parameters: pairing heap (MeldableHeapType *), handle (int),
+                           new priority (int)
+Function output/parameters: updated pairing heap (MeldableHeapType *)
+Function output/returned: Boolean result, false if handle is not
+                          waiting in this heap (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: isMeldableHandleIn, detachMeldableNode, makeHeapKey,
+              getKeySequence, linkMeldableNodes
+*/
+bool updateMeldablePriority( MeldableHeapType *heap, int handle,
+                                                            int newPriority );
+
+#endif   // MELDABLE_HEAP_UTILITY_H
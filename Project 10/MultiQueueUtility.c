@@ -0,0 +1,584 @@
+// several modules include this file, define it only once
+#ifndef MULTI_QUEUE_UTILITY_C
+#define MULTI_QUEUE_UTILITY_C
+
+#include "MultiQueueUtility.h"
+
+/*
+Name: addMultiQueueItem
+Process: adds patient to a random sub-heap whose lock is free, 
+         key uses the shared arrival sequence so keys compare across 
+         sub-heaps, republishes that sub-heap's top key, a patient 
+         turned away for lack of memory is neither counted nor recorded
+Function input/parameters: multiqueue (MultiQueueType *), 
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated multiqueue (MultiQueueType *)
+Function output/returned: Boolean result, false if memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getRandomSubHeap, pthread_mutex_trylock, addHeapItemWithKey,
+              makeHeapKey, publishTopKey, recordRankEvent, 
+              pthread_mutex_unlock
+*/
+bool addMultiQueueItem( MultiQueueType *queue, const char *nameSet,
+                                              int prioritySet, time_t timeSet )
+  {
+  // variables
+  SubHeapType *subHeap = &queue->subHeaps[ getRandomSubHeap( queue ) ];
+  uint64_t key;
+  bool addedFlag;
+
+  // keep picking until a sub-heap lock is free
+  while( pthread_mutex_trylock( &subHeap->lock ) != 0 )
+    {
+    subHeap = &queue->subHeaps[ getRandomSubHeap( queue ) ];
+    }
+
+  key = makeHeapKey( prioritySet, atomic_fetch_add( &queue->nextSequence, 1 ) );
+
+  addedFlag = addHeapItemWithKey( &subHeap->heap, nameSet, timeSet, key )
+                                                          != INVALID_HANDLE;
+
+  if( addedFlag )
+    {
+    recordRankEvent( queue, key, RANK_EVENT_ADD );
+
+    publishTopKey( subHeap );
+    }
+
+  pthread_mutex_unlock( &subHeap->lock );
+
+  // count only once the entry can be found, a patient turned away is
+  // never counted so removers do not wait for it
+  if( addedFlag )
+    {
+    atomic_fetch_add( &queue->size, 1 );
+    }
+
+  return addedFlag;
+  }
+
+/*
+Name: clearMultiQueue
+Process: clears every sub-heap, destroys locks, frees all memory,
+         must not be called while other threads use the queue
+Function input/parameters: multiqueue (MultiQueueType *)
+Function output/parameters: updated multiqueue (MultiQueueType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: clearHeap, pthread_mutex_destroy, free
+*/
+void clearMultiQueue( MultiQueueType *queue )
+  {
+  // variables
+  int index;
+
+  for( index = 0; index < queue->subHeapCount; index++ )
+    {
+    clearHeap( &queue->subHeaps[ index ].heap );
+
+    pthread_mutex_destroy( &queue->subHeaps[ index ].lock );
+    }
+
+  free( queue->subHeaps );
+  free( queue->rankEvents );
+
+  queue->subHeaps = NULL;
+  queue->rankEvents = NULL;
+  queue->subHeapCount = 0;
+  queue->maxRankEvents = 0;
+
+  atomic_store( &queue->size, 0 );
+  atomic_store( &queue->rankEventCount, 0 );
+  }
+
+/*
+Name: compareRankCounts
+Process: orders two rank counts ascending for qsort
+Function input/parameters: two rank counts (const void *)
+Function output/parameters: none
+Function output/returned: negative, zero, or positive (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int compareRankCounts( const void *one, const void *other )
+  {
+  // variables
+  long oneCount = *( const long *)one;
+  long otherCount = *( const long *)other;
+
+  return ( oneCount > otherCount ) - ( oneCount < otherCount );
+  }
+
+/*
+Name: compareRankKeys
+Process: orders two keys ascending for qsort
+Function input/parameters: two keys (const void *)
+Function output/parameters: none
+Function output/returned: negative, zero, or positive (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int compareRankKeys( const void *one, const void *other )
+  {
+  // variables
+  uint64_t oneKey = *( const uint64_t *)one;
+  uint64_t otherKey = *( const uint64_t *)other;
+
+  return ( oneKey > otherKey ) - ( oneKey < otherKey );
+  }
+
+/*
+Name: enableRankTracking
+Process: starts logging every add and remove key so rank error 
+         can be measured later, the queue must still be empty
+Function input/parameters: multiqueue (MultiQueueType *), 
+                           maximum events to log (long)
+Function output/parameters: updated multiqueue (MultiQueueType *)
+Function output/returned: Boolean result, false if queue is not empty
+                          or memory is unavailable (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc
+*/
+bool enableRankTracking( MultiQueueType *queue, long maxEvents )
+  {
+  // earlier adds would be missing from the replay
+  if( atomic_load( &queue->size ) != 0 || queue->rankEvents != NULL )
+    {
+    return false;
+    }
+
+  queue->rankEvents = ( RankEventType *)malloc( 
+                                     maxEvents * sizeof( RankEventType ) );
+
+  if( queue->rankEvents == NULL )
+    {
+    return false;
+    }
+
+  queue->maxRankEvents = maxEvents;
+
+  atomic_store( &queue->rankEventCount, 0 );
+
+  return true;
+  }
+
+/*
+Name: findRankKey
+Process: binary searches sorted unique keys for a key
+Function input/parameters: sorted keys (const uint64_t *), key count (long),
+                           key (uint64_t)
+Function output/parameters: none
+Function output/returned: index of key (long)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+long findRankKey( const uint64_t *sortedKeys, long keyCount, uint64_t key )
+  {
+  // variables
+  long low = 0, high = keyCount - 1, middle;
+
+  while( low < high )
+    {
+    middle = low + ( high - low ) / 2;
+
+    if( sortedKeys[ middle ] < key )
+      {
+      low = middle + 1;
+      }
+
+    else
+      {
+      high = middle;
+      }
+    }
+
+  return low;
+  }
+
+/*
+Name: getRandomSubHeap
+Process: picks a sub-heap index from a per thread xorshift generator
+Function input/parameters: multiqueue (const MultiQueueType *)
+Function output/parameters: none
+Function output/returned: sub-heap index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getRandomSubHeap( const MultiQueueType *queue )
+  {
+  // variables
+  static _Thread_local uint64_t state = 0;
+
+  // seed each thread differently from the address of its own state
+  if( state == 0 )
+    {
+    state = (uint64_t)(uintptr_t)&state | 1u;
+    }
+
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+
+  return (int)( state % (uint64_t)queue->subHeapCount );
+  }
+
+/*
+Name: getRankErrorStats
+Process: replays the logged events in order against a Fenwick tree
+         of keys present, the rank of each removal is the number of 
+         present keys that should have been served first
+Function input/parameters: multiqueue (const MultiQueueType *)
+Function output/parameters: rank error statistics (RankErrorStatsType *)
+Function output/returned: Boolean result, false if tracking is off (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, calloc, qsort, free, compareRankKeys, 
+              compareRankCounts, findRankKey
+*/
+bool getRankErrorStats( const MultiQueueType *queue, 
+                                                RankErrorStatsType *stats )
+  {
+  // variables
+  long eventCount, keyCount = 0, removeCount = 0, present = 0;
+  long index, position, node, greater;
+  uint64_t *keys;
+  long *tree, *ranks;
+  double rankSum = 0.0;
+
+  stats->removeCount = 0;
+  stats->meanRank = 0.0;
+  stats->maxRank = 0;
+  stats->p99Rank = 0;
+  stats->p999Rank = 0;
+
+  if( queue->rankEvents == NULL )
+    {
+    return false;
+    }
+
+  eventCount = atomic_load( &queue->rankEventCount );
+
+  if( eventCount > queue->maxRankEvents )
+    {
+    eventCount = queue->maxRankEvents;
+    }
+
+  keys = ( uint64_t *)malloc( ( eventCount + 1 ) * sizeof( uint64_t ) );
+  tree = ( long *)calloc( eventCount + 2, sizeof( long ) );
+  ranks = ( long *)malloc( ( eventCount + 1 ) * sizeof( long ) );
+
+  // sorted unique keys give each key a Fenwick position
+  for( index = 0; index < eventCount; index++ )
+    {
+    keys[ index ] = queue->rankEvents[ index ].key;
+    }
+
+  qsort( keys, eventCount, sizeof( uint64_t ), compareRankKeys );
+
+  for( index = 0; index < eventCount; index++ )
+    {
+    if( keyCount == 0 || keys[ keyCount - 1 ] != keys[ index ] )
+      {
+      keys[ keyCount ] = keys[ index ];
+
+      keyCount++;
+      }
+    }
+
+  // replay in log order
+  for( index = 0; index < eventCount; index++ )
+    {
+    position = findRankKey( keys, keyCount, 
+                                   queue->rankEvents[ index ].key ) + 1;
+
+    if( queue->rankEvents[ index ].kind == RANK_EVENT_ADD )
+      {
+      for( node = position; node <= keyCount; node += node & -node )
+        {
+        tree[ node ]++;
+        }
+
+      present++;
+      }
+
+    else
+      {
+      // present keys above this one were skipped over
+      greater = present;
+
+      for( node = position; node > 0; node -= node & -node )
+        {
+        greater -= tree[ node ];
+        }
+
+      ranks[ removeCount ] = greater;
+      rankSum += greater;
+      removeCount++;
+
+      for( node = position; node <= keyCount; node += node & -node )
+        {
+        tree[ node ]--;
+        }
+
+      present--;
+      }
+    }
+
+  if( removeCount > 0 )
+    {
+    qsort( ranks, removeCount, sizeof( long ), compareRankCounts );
+
+    stats->removeCount = removeCount;
+    stats->meanRank = rankSum / removeCount;
+    stats->maxRank = ranks[ removeCount - 1 ];
+    stats->p99Rank = ranks[ ( removeCount - 1 ) * 99 / 100 ];
+    stats->p999Rank = ranks[ ( removeCount - 1 ) * 999 / 1000 ];
+    }
+
+  free( keys );
+  free( tree );
+  free( ranks );
+
+  return true;
+  }
+
+/*
+Name: initializeMultiQueue
+Process: creates queues per thread times thread count sub-heaps, 
+         each with its own lock and an empty published top key
+Function input/parameters: multiqueue (MultiQueueType *), thread count (int),
+                           sub-heaps per thread, zero for default (int),
+                           initial capacity of each sub-heap (int)
+Function output/parameters: initialized multiqueue (MultiQueueType *)
+Function output/returned: Boolean result, false if memory ran out and
+                          the multiqueue has no sub-heaps (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: aligned_alloc, initializeHeap, pthread_mutex_init
+*/
+bool initializeMultiQueue( MultiQueueType *queue, int threadCount, 
+                                     int queuesPerThread, int initialCapacity )
+  {
+  // variables
+  int index;
+
+  if( queuesPerThread <= 0 )
+    {
+    queuesPerThread = DEFAULT_QUEUES_PER_THREAD;
+    }
+
+  if( threadCount <= 0 )
+    {
+    threadCount = 1;
+    }
+
+  queue->subHeapCount = threadCount * queuesPerThread;
+
+  // one sub-heap per cache line so lock traffic does not share lines
+  queue->subHeaps = ( SubHeapType *)aligned_alloc( CACHE_LINE_SIZE, 
+                               queue->subHeapCount * sizeof( SubHeapType ) );
+
+  // an empty multiqueue is still safe to clear
+  if( queue->subHeaps == NULL )
+    {
+    queue->subHeapCount = 0;
+    }
+
+  for( index = 0; index < queue->subHeapCount; index++ )
+    {
+    pthread_mutex_init( &queue->subHeaps[ index ].lock, NULL );
+
+    atomic_init( &queue->subHeaps[ index ].topKey, EMPTY_TOP_KEY );
+
+    initializeHeap( &queue->subHeaps[ index ].heap, initialCapacity );
+    }
+
+  atomic_init( &queue->nextSequence, 0 );
+  atomic_init( &queue->size, 0 );
+
+  queue->rankEvents = NULL;
+  queue->maxRankEvents = 0;
+
+  atomic_init( &queue->rankEventCount, 0 );
+
+  return queue->subHeaps != NULL;
+  }
+
+/*
+Name: popSubHeap
+Process: removes the root of a locked, non empty sub-heap, logs the key,
+         republishes the new top key, lowers the queue size
+Function input/parameters: multiqueue (MultiQueueType *), 
+                           sub-heap (SubHeapType *)
+Function output/parameters: updated multiqueue (MultiQueueType *),
+                            patient data removed (PatientType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: recordRankEvent, getTopHeapEntry, removeItem, publishTopKey
+*/
+void popSubHeap( MultiQueueType *queue, SubHeapType *subHeap, 
+                                                       PatientType *removed )
+  {
+  recordRankEvent( queue, getTopHeapEntry( &subHeap->heap ).key, 
+                                                        RANK_EVENT_REMOVE );
+
+  removeItem( removed, &subHeap->heap );
+
+  publishTopKey( subHeap );
+
+  atomic_fetch_sub( &queue->size, 1 );
+  }
+
+/*
+Name: publishTopKey
+Process: stores the root key of a sub-heap where samplers can read it 
+         without the lock, caller holds the sub-heap lock
+Function input/parameters: sub-heap (SubHeapType *)
+Function output/parameters: updated sub-heap (SubHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: getTopHeapEntry
+*/
+void publishTopKey( SubHeapType *subHeap )
+  {
+  // keys are never zero, so zero marks an empty sub-heap
+  if( subHeap->heap.size > 0 )
+    {
+    atomic_store_explicit( &subHeap->topKey, 
+                 getTopHeapEntry( &subHeap->heap ).key, memory_order_relaxed );
+    }
+
+  else
+    {
+    atomic_store_explicit( &subHeap->topKey, EMPTY_TOP_KEY, 
+                                                     memory_order_relaxed );
+    }
+  }
+
+/*
+Name: recordRankEvent
+Process: appends an add or remove key to the rank tracking log if enabled,
+         caller holds the lock of the sub-heap the key belongs to
+Function input/parameters: multiqueue (MultiQueueType *), key (uint64_t),
+                           event kind (int)
+Function output/parameters: updated multiqueue (MultiQueueType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+void recordRankEvent( MultiQueueType *queue, uint64_t key, int kind )
+  {
+  // variables
+  long index;
+
+  if( queue->rankEvents != NULL )
+    {
+    // add and remove of one key share a lock, so they log in order
+    index = atomic_fetch_add( &queue->rankEventCount, 1 );
+
+    if( index < queue->maxRankEvents )
+      {
+      queue->rankEvents[ index ].key = key;
+      queue->rankEvents[ index ].kind = kind;
+      }
+    }
+  }
+
+/*
+Name: removeMultiQueueItem
+Process: samples two sub-heaps, try-locks the one with the higher 
+         published top and pops its root, resamples on a busy lock or
+         an empty pick, scans every sub-heap after too many misses
+Function input/parameters: multiqueue (MultiQueueType *)
+Function output/parameters: updated multiqueue (MultiQueueType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if queue is empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getRandomSubHeap, pthread_mutex_trylock, popSubHeap,
+              pthread_mutex_lock, pthread_mutex_unlock
+*/
+bool removeMultiQueueItem( MultiQueueType *queue, PatientType *removed )
+  {
+  // variables
+  int attempts = 0, index;
+  int firstPick, secondPick;
+  uint64_t firstKey, secondKey;
+  SubHeapType *subHeap;
+  bool removedFlag = false;
+
+  while( !removedFlag && atomic_load( &queue->size ) > 0 )
+    {
+    if( attempts < MAX_REMOVE_ATTEMPTS )
+      {
+      // two choices keep the served key close to the true maximum
+      firstPick = getRandomSubHeap( queue );
+      secondPick = getRandomSubHeap( queue );
+
+      firstKey = atomic_load_explicit( &queue->subHeaps[ firstPick ].topKey,
+                                                     memory_order_relaxed );
+      secondKey = atomic_load_explicit( 
+                                    &queue->subHeaps[ secondPick ].topKey,
+                                                     memory_order_relaxed );
+
+      if( secondKey > firstKey )
+        {
+        firstPick = secondPick;
+        firstKey = secondKey;
+        }
+
+      subHeap = &queue->subHeaps[ firstPick ];
+
+      if( firstKey != EMPTY_TOP_KEY 
+                             && pthread_mutex_trylock( &subHeap->lock ) == 0 )
+        {
+        // the published key may be stale, so check under the lock
+        if( subHeap->heap.size > 0 )
+          {
+          popSubHeap( queue, subHeap, removed );
+
+          removedFlag = true;
+          }
+
+        pthread_mutex_unlock( &subHeap->lock );
+        }
+
+      attempts++;
+      }
+
+    else
+      {
+      // sampling keeps missing, so walk every sub-heap
+      for( index = 0; !removedFlag && index < queue->subHeapCount; index++ )
+        {
+        subHeap = &queue->subHeaps[ index ];
+
+        pthread_mutex_lock( &subHeap->lock );
+
+        if( subHeap->heap.size > 0 )
+          {
+          popSubHeap( queue, subHeap, removed );
+
+          removedFlag = true;
+          }
+
+        pthread_mutex_unlock( &subHeap->lock );
+        }
+      }
+    }
+
+  return removedFlag;
+  }
+
+#endif   // MULTI_QUEUE_UTILITY_C
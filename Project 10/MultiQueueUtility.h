@@ -0,0 +1,264 @@
+#ifndef MULTI_QUEUE_UTILITY_H
+#define MULTI_QUEUE_UTILITY_H
+
+#include "HeapUtility.c"
+#include <pthread.h>
+#include <stdatomic.h>
+
+// constants
+
+// published top key of an empty sub-heap, a real key of zero would need
+// the lowest int priority at the last arrival sequence
+#define EMPTY_TOP_KEY 0
+
+// sub-heaps per thread when the caller passes zero
+#define DEFAULT_QUEUES_PER_THREAD 2
+
+// failed try-locks before a remove falls back to scanning every sub-heap
+#define MAX_REMOVE_ATTEMPTS 64
+
+// rank tracking event kinds
+#define RANK_EVENT_ADD 0
+#define RANK_EVENT_REMOVE 1
+
+// data structures
+
+// one sub-heap, its lock and the key at its root published for sampling
+typedef struct SubHeapStruct
+   {
+    _Alignas( CACHE_LINE_SIZE ) pthread_mutex_t lock;
+
+    atomic_uint_fast64_t topKey;
+
+    HeapType heap;
+   } SubHeapType;
+
+// add or remove of one key, in the order taken from the event counter
+typedef struct RankEventStruct
+   {
+    uint64_t key;
+
+    int kind;
+   } RankEventType;
+
+typedef struct RankErrorStatsStruct
+   {
+    long removeCount;
+
+    double meanRank;
+
+    long maxRank, p99Rank, p999Rank;
+   } RankErrorStatsType;
+
+// relaxed priority queue of c times T sub-heaps, inserts go to a random
+// sub-heap, removes pop the better root of two sampled sub-heaps
+typedef struct MultiQueueStruct
+   {
+    SubHeapType *subHeaps;
+
+    int subHeapCount;
+
+    atomic_uint nextSequence;
+
+    atomic_long size;
+
+    RankEventType *rankEvents;
+
+    long maxRankEvents;
+
+    atomic_long rankEventCount;
+   } MultiQueueType;
+
+// function prototypes
+
+/*
+Name: addMultiQueueItem
+Process: adds patient to a random sub-heap whose lock is free, 
+         key uses the shared arrival sequence so keys compare across 
+         sub-heaps, republishes that sub-heap's top key, a patient 
+         turned away for lack of memory is neither counted nor recorded
+Function input/parameters: multiqueue (MultiQueueType *), 
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated multiqueue (MultiQueueType *)
+Function output/returned: Boolean result, false if memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getRandomSubHeap, pthread_mutex_trylock, addHeapItemWithKey,
+              makeHeapKey, publishTopKey, recordRankEvent, 
+              pthread_mutex_unlock
+*/
+bool addMultiQueueItem( MultiQueueType *queue, const char *nameSet,
+                                              int prioritySet, time_t timeSet );
+
+/*
+Name: clearMultiQueue
+Process: clears every sub-heap, destroys locks, frees all memory,
+         must not be called while other threads use the queue
+Function input/parameters: multiqueue (MultiQueueType *)
+Function output/parameters: updated multiqueue (MultiQueueType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: clearHeap, pthread_mutex_destroy, free
+*/
+void clearMultiQueue( MultiQueueType *queue );
+
+/*
+Name: compareRankCounts
+Process: orders two rank counts ascending for qsort
+Function input/parameters: two rank counts (const void *)
+Function output/parameters: none
+Function output/returned: negative, zero, or positive (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int compareRankCounts( const void *one, const void *other );
+
+/*
+Name: compareRankKeys
+Process: orders two keys ascending for qsort
+Function input/parameters: two keys (const void *)
+Function output/parameters: none
+Function output/returned: negative, zero, or positive (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int compareRankKeys( const void *one, const void *other );
+
+/*
+Name: enableRankTracking
+Process: starts logging every add and remove key so rank error 
+         can be measured later, the queue must still be empty
+Function input/parameters: multiqueue (MultiQueueType *), 
+                           maximum events to log (long)
+Function output/parameters: updated multiqueue (MultiQueueType *)
+Function output/returned: Boolean result, false if queue is not empty
+                          or memory is unavailable (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc
+*/
+bool enableRankTracking( MultiQueueType *queue, long maxEvents );
+
+/*
+Name: findRankKey
+Process: binary searches sorted unique keys for a key
+Function input/parameters: sorted keys (const uint64_t *), key count (long),
+                           key (uint64_t)
+Function output/parameters: none
+Function output/returned: index of key (long)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+long findRankKey( const uint64_t *sortedKeys, long keyCount, uint64_t key );
+
+/*
+Name: getRandomSubHeap
+Process: picks a sub-heap index from a per thread xorshift generator
+Function input/parameters: multiqueue (const MultiQueueType *)
+Function output/parameters: none
+Function output/returned: sub-heap index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getRandomSubHeap( const MultiQueueType *queue );
+
+/*
+Name: getRankErrorStats
+Process: replays the logged events in order against a Fenwick tree
+         of keys present, the rank of each removal is the number of 
+         present keys that should have been served first
+Function input/parameters: multiqueue (const MultiQueueType *)
+Function output/parameters: rank error statistics (RankErrorStatsType *)
+Function output/returned: Boolean result, false if tracking is off (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, calloc, qsort, free, compareRankKeys, 
+              compareRankCounts, findRankKey
+*/
+bool getRankErrorStats( const MultiQueueType *queue, 
+                                                RankErrorStatsType *stats );
+
+/*
+Name: initializeMultiQueue
+Process: creates queues per thread times thread count sub-heaps, 
+         each with its own lock and an empty published top key
+Function input/parameters: multiqueue (MultiQueueType *), thread count (int),
+                           sub-heaps per thread, zero for default (int),
+                           initial capacity of each sub-heap (int)
+Function output/parameters: initialized multiqueue (MultiQueueType *)
+Function output/returned: Boolean result, false if memory ran out and
+                          the multiqueue has no sub-heaps (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: aligned_alloc, initializeHeap, pthread_mutex_init
+*/
+bool initializeMultiQueue( MultiQueueType *queue, int threadCount, 
+                                    int queuesPerThread, int initialCapacity );
+
+/*
+Name: popSubHeap
+Process: removes the root of a locked, non empty sub-heap, logs the key,
+         republishes the new top key, lowers the queue size
+Function input/parameters: multiqueue (MultiQueueType *), 
+                           sub-heap (SubHeapType *)
+Function output/parameters: updated multiqueue (MultiQueueType *),
+                            patient data removed (PatientType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: recordRankEvent, getTopHeapEntry, removeItem, publishTopKey
+*/
+void popSubHeap( MultiQueueType *queue, SubHeapType *subHeap, 
+                                                      PatientType *removed );
+
+/*
+Name: publishTopKey
+Process: stores the root key of a sub-heap where samplers can read it 
+         without the lock, caller holds the sub-heap lock
+Function input/parameters: sub-heap (SubHeapType *)
+Function output/parameters: updated sub-heap (SubHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: getTopHeapEntry
+*/
+void publishTopKey( SubHeapType *subHeap );
+
+/*
+Name: recordRankEvent
+Process: appends an add or remove key to the rank tracking log if enabled,
+         caller holds the lock of the sub-heap the key belongs to
+Function input/parameters: multiqueue (MultiQueueType *), key (uint64_t),
+                           event kind (int)
+Function output/parameters: updated multiqueue (MultiQueueType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+void recordRankEvent( MultiQueueType *queue, uint64_t key, int kind );
+
+/*
+Name: removeMultiQueueItem
+Process: samples two sub-heaps, try-locks the one with the higher 
+         published top and pops its root, resamples on a busy lock or
+         an empty pick, scans every sub-heap after too many misses
+Function input/parameters: multiqueue (MultiQueueType *)
+Function output/parameters: updated multiqueue (MultiQueueType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if queue is empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: getRandomSubHeap, pthread_mutex_trylock, popSubHeap,
+              pthread_mutex_lock, pthread_mutex_unlock
+*/
+bool removeMultiQueueItem( MultiQueueType *queue, PatientType *removed );
+
+
+#endif   // MULTI_QUEUE_UTILITY_H
@@ -1,3 +1,7 @@
+// several modules include this file, define it only once
+#ifndef PATIENT_UTILITY_C
+#define PATIENT_UTILITY_C
+
 // header file
 #include "PatientUtility.h"
 
@@ -10,7 +14,37 @@ int comparePriority( const PatientType one, const PatientType other )
         return priorityDiff;
        }
   
-    return (int)( other.timeIn - one.timeIn );
+    // compare rather than subtract so large time differences cannot overflow
+    if( one.timeIn != other.timeIn )
+       {
+        return one.timeIn < other.timeIn ? 1 : -1;
+       }
+
+    return 0;
+   }
+
+/*
+Name: compareString
+Process: compares two strings character by character
+Function input/parameters: two strings (const char *)
+Function output/parameters: none
+Function output/returned: difference of first unequal characters, 
+                          zero if strings are equal (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int compareString( const char *oneStr, const char *otherStr )
+   {
+    int index = 0;
+
+    while( oneStr[ index ] != NULL_CHAR 
+                                  && oneStr[ index ] == otherStr[ index ] )
+       {
+        index++;
+       }
+
+    return (unsigned char)oneStr[ index ] - (unsigned char)otherStr[ index ];
    }
 
 void copyPatient( PatientType *destPatient, const PatientType sourcePatient )
@@ -46,6 +80,33 @@ void copyString( char *dest, const char *source )
        }
    }
 
+/*
+Name: copyStringBounded
+Process: copies string from source to destination, 
+         copies at most destination size - 1 characters,
+         destination is always terminated
+Function input/parameters: source string (const char *),
+                           destination size (int)
+Function output/parameters: destination string (char *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+void copyStringBounded( char *dest, const char *source, int destSize )
+   {
+    int index = 0;
+
+    while( index < destSize - 1 && source[ index ] != NULL_CHAR )
+       {
+        dest[ index ] = source[ index ];
+
+        index++;
+       }
+
+    dest[ index ] = NULL_CHAR;
+   }
+
 void getPatientInfo( char *patientStr, PatientType patientNode )
    {     
     char timeStr[ MIN_STR_LEN ];
@@ -69,7 +130,7 @@ void getPatientInfo( char *patientStr, PatientType patientNode )
 void setPatientFromData( PatientType *patientNode, 
                           const char *nameSet, int prioritySet, time_t timeSet )
    { 
-    copyString( patientNode->patientName, nameSet );
+    copyStringBounded( patientNode->patientName, nameSet, STD_STR_LEN );
 
     patientNode->priority = prioritySet;
 
@@ -82,4 +143,4 @@ void setPatientFromStruct( PatientType *patientNode, const PatientType source )
                                                source.priority, source.timeIn );
    }
 
-   
+#endif   // PATIENT_UTILITY_C
@@ -20,8 +20,10 @@ typedef struct PatientStruct
 
 // prototypes
 int comparePriority( const PatientType one, const PatientType other );
+int compareString( const char *oneStr, const char *otherStr );
 void copyPatient( PatientType *destPatient, const PatientType sourcePatient );
 void copyString( char *dest, const char *source );
+void copyStringBounded( char *dest, const char *source, int destSize );
 void getPatientInfo( char *patientStr, PatientType PatientType );
 void setPatientFromData( PatientType *patientNode, 
                          const char *nameSet, int prioritySet, time_t timeSet );
@@ -0,0 +1,449 @@
+#include "RadixHeapUtility.h"
+
+/*
+Name: addRadixItem
+Process: adds patient to radix heap keyed on its time in
+Function input/parameters: radix heap (RadixHeapType *),
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated radix heap (RadixHeapType *)
+Function output/returned: Boolean result, false if time in is before
+                          the last removed key or memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: addRadixItemWithKey
+*/
+bool addRadixItem( RadixHeapType *heap, const char *nameSet,
+                                              int prioritySet, time_t timeSet )
+  {
+  return addRadixItemWithKey( heap, nameSet, prioritySet, timeSet,
+                                                           (uint64_t)timeSet );
+  }
+
+/*
+Name: addRadixItemWithKey
+Process: adds patient to radix heap with a caller supplied key,
+         stores patient in a slot, appends the entry to the bucket of
+         the highest bit where the key differs from the last removed key,
+         doubles the slots when none are free, leaves the heap unchanged
+         if memory ran out
+Function input/parameters: radix heap (RadixHeapType *),
+                           patient name (const char *),
+                           patient priority (int), time in (time_t),
+                           ordering key, smallest leaves first (uint64_t)
+Function output/parameters: updated radix heap (RadixHeapType *)
+Function output/returned: Boolean result, false if key is below
+                          the last removed key or memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc, setPatientFromData, getRadixBucket,
+              pushRadixEntry
+*/
+bool addRadixItemWithKey( RadixHeapType *heap, const char *nameSet,
+                          int prioritySet, time_t timeSet, uint64_t key )
+  {
+  // variables
+  HeapEntryType entry;
+  PatientType *newSlots;
+  int *newFreeSlots;
+  int bucket, index, newCapacity;
+
+  // an earlier key would belong to a bucket that was already emptied
+  if( key < heap->lastKey )
+    {
+    return false;
+    }
+
+  // out of slots, double them and free the new handles highest first
+  if( heap->freeCount == 0 )
+    {
+    newCapacity = heap->slotCapacity * 2;
+
+    newSlots = ( PatientType *)realloc( heap->slots,
+                                          newCapacity * sizeof( PatientType ) );
+
+    if( newSlots == NULL )
+      {
+      return false;
+      }
+
+    heap->slots = newSlots;
+
+    // the stack is empty, nothing in it needs keeping
+    newFreeSlots = ( int *)realloc( heap->freeSlots,
+                                                newCapacity * sizeof( int ) );
+
+    if( newFreeSlots == NULL )
+      {
+      return false;
+      }
+
+    heap->freeSlots = newFreeSlots;
+
+    for( index = newCapacity - 1; index >= heap->slotCapacity; index-- )
+      {
+      heap->freeSlots[ heap->freeCount ] = index;
+      heap->freeCount++;
+      }
+
+    heap->slotCapacity = newCapacity;
+    }
+
+  entry.key = key;
+  entry.handle = heap->freeSlots[ heap->freeCount - 1 ];
+
+  bucket = getRadixBucket( heap->lastKey, key );
+
+  if( !pushRadixEntry( &heap->buckets[ bucket ], entry ) )
+    {
+    return false;
+    }
+
+  heap->freeCount--;
+
+  setPatientFromData( &heap->slots[ entry.handle ], nameSet, prioritySet,
+                                                                    timeSet );
+
+  if( bucket > 0 )
+    {
+    heap->occupied |= (uint64_t)1 << ( bucket - 1 );
+    }
+
+  heap->size++;
+
+  return true;
+  }
+
+/*
+Name: clearRadixHeap
+Process: frees every bucket and the patient slots
+Function input/parameters: radix heap (RadixHeapType *)
+Function output/parameters: updated radix heap (RadixHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: free
+*/
+void clearRadixHeap( RadixHeapType *heap )
+  {
+  // variables
+  int bucket;
+
+  for( bucket = 0; bucket < RADIX_BUCKET_COUNT; bucket++ )
+    {
+    free( heap->buckets[ bucket ].entries );
+
+    heap->buckets[ bucket ].entries = NULL;
+    heap->buckets[ bucket ].head = 0;
+    heap->buckets[ bucket ].count = 0;
+    heap->buckets[ bucket ].capacity = 0;
+    }
+
+  free( heap->slots );
+  free( heap->freeSlots );
+
+  heap->slots = NULL;
+  heap->freeSlots = NULL;
+  heap->freeCount = 0;
+  heap->slotCapacity = 0;
+  heap->occupied = 0;
+  heap->size = 0;
+  }
+
+/*
+Name: getRadixBucket
+Process: finds the bucket of a key, one past the highest bit where it
+         differs from the last removed key, zero if equal
+Function input/parameters: last removed key (uint64_t), key (uint64_t)
+Function output/parameters: none
+Function output/returned: bucket index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: __builtin_clzll where available
+*/
+int getRadixBucket( uint64_t lastKey, uint64_t key )
+  {
+  // variables
+  uint64_t difference = lastKey ^ key;
+  int bucket = 0;
+
+  if( difference == 0 )
+    {
+    return 0;
+    }
+
+#if defined( __GNUC__ ) || defined( __clang__ )
+  bucket = 64 - __builtin_clzll( difference );
+#else
+  while( difference != 0 )
+    {
+    difference >>= 1;
+
+    bucket++;
+    }
+#endif
+
+  return bucket;
+  }
+
+/*
+Name: initializeRadixHeap
+Process: sets up an empty radix heap with room for the given number
+         of patients, the last removed key starts at zero
+Function input/parameters: capacity (int)
+Function output/parameters: initialized radix heap (RadixHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: malloc
+*/
+void initializeRadixHeap( RadixHeapType *heap, int capacity )
+  {
+  // variables
+  int bucket, index;
+
+  if( capacity < MIN_RADIX_CAPACITY )
+    {
+    capacity = MIN_RADIX_CAPACITY;
+    }
+
+  // buckets are allocated on their first entry
+  for( bucket = 0; bucket < RADIX_BUCKET_COUNT; bucket++ )
+    {
+    heap->buckets[ bucket ].entries = NULL;
+    heap->buckets[ bucket ].head = 0;
+    heap->buckets[ bucket ].count = 0;
+    heap->buckets[ bucket ].capacity = 0;
+    }
+
+  heap->slots = ( PatientType *)malloc( capacity * sizeof( PatientType ) );
+  heap->freeSlots = ( int *)malloc( capacity * sizeof( int ) );
+
+  // handed out lowest handle first
+  for( index = 0; index < capacity; index++ )
+    {
+    heap->freeSlots[ index ] = capacity - 1 - index;
+    }
+
+  heap->freeCount = capacity;
+  heap->slotCapacity = capacity;
+  heap->occupied = 0;
+  heap->lastKey = 0;
+  heap->size = 0;
+  heap->moveCount = 0;
+  }
+
+/*
+Name: isRadixEmpty
+Process: reports if radix heap holds no patients
+Function input/parameters: radix heap (const RadixHeapType *)
+Function output/parameters: none
+Function output/returned: Boolean result of test (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+bool isRadixEmpty( const RadixHeapType *heap )
+  {
+  return heap->size == 0;
+  }
+
+/*
+Name: pushRadixEntry
+Process: appends entry to a bucket, doubles the bucket when full
+Function input/parameters: bucket (RadixBucketType *), entry (HeapEntryType)
+Function output/parameters: updated bucket (RadixBucketType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the bucket is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: reserveRadixBucket
+*/
+bool pushRadixEntry( RadixBucketType *bucket, HeapEntryType entry )
+  {
+  if( !reserveRadixBucket( bucket, bucket->count + 1 ) )
+    {
+    return false;
+    }
+
+  bucket->entries[ bucket->count ] = entry;
+  bucket->count++;
+
+  return true;
+  }
+
+/*
+Name: redistributeRadixBuckets
+Process: refills the empty bucket zero, takes the smallest key of the
+         lowest non-empty bucket as the last removed key and moves
+         that bucket's entries down relative to it in arrival order,
+         makes room in every target bucket before anything moves
+Function input/parameters: radix heap (RadixHeapType *)
+Function output/parameters: updated radix heap (RadixHeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and no entry moved (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: __builtin_ctzll where available, getRadixBucket,
+              reserveRadixBucket, pushRadixEntry
+*/
+bool redistributeRadixBuckets( RadixHeapType *heap )
+  {
+  // variables
+  RadixBucketType *source;
+  uint64_t smallest;
+  int targetCounts[ RADIX_BUCKET_COUNT ] = { 0 };
+  int bucket = 1, target, index;
+
+#if defined( __GNUC__ ) || defined( __clang__ )
+  bucket = __builtin_ctzll( heap->occupied ) + 1;
+#else
+  while( ( heap->occupied & ( (uint64_t)1 << ( bucket - 1 ) ) ) == 0 )
+    {
+    bucket++;
+    }
+#endif
+
+  source = &heap->buckets[ bucket ];
+  smallest = source->entries[ 0 ].key;
+
+  for( index = 1; index < source->count; index++ )
+    {
+    if( source->entries[ index ].key < smallest )
+      {
+      smallest = source->entries[ index ].key;
+      }
+    }
+
+  // make room in every target first, a move that stopped part way
+  // would leave entries in the wrong buckets for either last key
+  for( index = 0; index < source->count; index++ )
+    {
+    targetCounts[ getRadixBucket( smallest, source->entries[ index ].key ) ]++;
+    }
+
+  for( target = 0; target < bucket; target++ )
+    {
+    if( targetCounts[ target ] > 0
+           && !reserveRadixBucket( &heap->buckets[ target ],
+                     heap->buckets[ target ].count + targetCounts[ target ] ) )
+      {
+      return false;
+      }
+    }
+
+  // keys above this bucket share their differing bit with the new last
+  // key as well, so only this bucket's entries change buckets
+  heap->lastKey = smallest;
+
+  for( index = 0; index < source->count; index++ )
+    {
+    target = getRadixBucket( smallest, source->entries[ index ].key );
+
+    pushRadixEntry( &heap->buckets[ target ], source->entries[ index ] );
+
+    if( target > 0 )
+      {
+      heap->occupied |= (uint64_t)1 << ( target - 1 );
+      }
+    }
+
+  heap->moveCount += source->count;
+
+  source->count = 0;
+
+  heap->occupied &= ~( (uint64_t)1 << ( bucket - 1 ) );
+
+  return true;
+  }
+
+/*
+Name: removeRadixItem
+Process: removes the patient with the smallest key, refilling bucket zero
+         first if it is empty, equal keys leave in the order they arrived
+Function input/parameters: radix heap (RadixHeapType *)
+Function output/parameters: removed patient (PatientType *),
+                            updated radix heap (RadixHeapType *)
+Function output/returned: Boolean result, false if heap is empty or
+                          memory to refill bucket zero ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: redistributeRadixBuckets
+*/
+bool removeRadixItem( PatientType *removed, RadixHeapType *heap )
+  {
+  // variables
+  RadixBucketType *current = &heap->buckets[ 0 ];
+  HeapEntryType entry;
+
+  if( heap->size == 0 )
+    {
+    return false;
+    }
+
+  if( current->head == current->count )
+    {
+    current->head = 0;
+    current->count = 0;
+
+    if( !redistributeRadixBuckets( heap ) )
+      {
+      return false;
+      }
+    }
+
+  entry = current->entries[ current->head ];
+
+  current->head++;
+
+  *removed = heap->slots[ entry.handle ];
+
+  heap->freeSlots[ heap->freeCount ] = entry.handle;
+  heap->freeCount++;
+  heap->size--;
+
+  return true;
+  }
+
+/*
+Name: reserveRadixBucket
+Process: doubles a bucket until it has room for the given number of
+         entries, starting from the minimum radix capacity
+Function input/parameters: bucket (RadixBucketType *), entries needed (int)
+Function output/parameters: updated bucket (RadixBucketType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the bucket is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc
+*/
+bool reserveRadixBucket( RadixBucketType *bucket, int needed )
+  {
+  // variables
+  HeapEntryType *newEntries;
+  int newCapacity = bucket->capacity > 0 ? bucket->capacity
+                                                        : MIN_RADIX_CAPACITY;
+
+  if( needed <= bucket->capacity )
+    {
+    return true;
+    }
+
+  while( newCapacity < needed )
+    {
+    newCapacity *= 2;
+    }
+
+  newEntries = ( HeapEntryType *)realloc( bucket->entries,
+                                        newCapacity * sizeof( HeapEntryType ) );
+
+  if( newEntries == NULL )
+    {
+    return false;
+    }
+
+  bucket->entries = newEntries;
+  bucket->capacity = newCapacity;
+
+  return true;
+  }
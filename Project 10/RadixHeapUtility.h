@@ -0,0 +1,203 @@
+#ifndef RADIX_HEAP_UTILITY_H
+#define RADIX_HEAP_UTILITY_H
+
+#include "HeapUtility.c"
+
+// constants
+
+// bucket zero holds keys equal to the last removed key, bucket b holds
+// keys whose highest bit differing from it is bit b - 1
+#define RADIX_BUCKET_COUNT 65
+
+#define MIN_RADIX_CAPACITY 16
+
+// data structures
+
+// one bucket, entries in the order they arrived, head is only used by
+// bucket zero, which is read from the front so equal keys leave in order
+typedef struct RadixBucketStruct
+   {
+    HeapEntryType *entries;
+
+    int head, count, capacity;
+   } RadixBucketType;
+
+// monotone min queue after Ahuja et al., keys added may not be below the
+// last removed key, a remove that finds bucket zero empty moves the
+// lowest non-empty bucket down around its smallest key, every entry only
+// moves to lower buckets so each is moved at most 64 times
+typedef struct RadixHeapStruct
+   {
+    RadixBucketType buckets[ RADIX_BUCKET_COUNT ];
+
+    // bit b - 1 is set while bucket b holds entries
+    uint64_t occupied;
+
+    uint64_t lastKey;
+
+    int size;
+
+    // whole patients rather than the core heap's slots and name arena,
+    // buckets only move the small entries so slot size never slows a
+    // move, and a removal then reads one slot instead of a slot and
+    // an arena name, about twice as fast on the hold benchmark
+    PatientType *slots;
+
+    int *freeSlots;
+
+    int freeCount, slotCapacity;
+
+    // entries moved down by removes, reported by the benchmark
+    uint64_t moveCount;
+   } RadixHeapType;
+
+// function prototypes
+
+/*
+Name: addRadixItem
+Process: adds patient to radix heap keyed on its time in
+Function input/parameters: radix heap (RadixHeapType *),
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated radix heap (RadixHeapType *)
+Function output/returned: Boolean result, false if time in is before
+                          the last removed key or memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: addRadixItemWithKey
+*/
+bool addRadixItem( RadixHeapType *heap, const char *nameSet,
+                                              int prioritySet, time_t timeSet );
+
+/*
+Name: addRadixItemWithKey
+Process: adds patient to radix heap with a caller supplied key,
+         stores patient in a slot, appends the entry to the bucket of
+         the highest bit where the key differs from the last removed key,
+         doubles the slots when none are free, leaves the heap unchanged
+         if memory ran out
+Function input/parameters: radix heap (RadixHeapType *),
+                           patient name (const char *),
+                           patient priority (int), time in (time_t),
+                           ordering key, smallest leaves first (uint64_t)
+Function output/parameters: updated radix heap (RadixHeapType *)
+Function output/returned: Boolean result, false if key is below
+                          the last removed key or memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc, setPatientFromData, getRadixBucket,
+              pushRadixEntry
+*/
+bool addRadixItemWithKey( RadixHeapType *heap, const char *nameSet,
+                          int prioritySet, time_t timeSet, uint64_t key );
+
+/*
+Name: clearRadixHeap
+Process: frees every bucket and the patient slots
+Function input/parameters: radix heap (RadixHeapType *)
+Function output/parameters: updated radix heap (RadixHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: free
+*/
+void clearRadixHeap( RadixHeapType *heap );
+
+/*
+Name: getRadixBucket
+Process: finds the bucket of a key, one past the highest bit where it
+         differs from the last removed key, zero if equal
+Function input/parameters: last removed key (uint64_t), key (uint64_t)
+Function output/parameters: none
+Function output/returned: bucket index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: __builtin_clzll where available
+*/
+int getRadixBucket( uint64_t lastKey, uint64_t key );
+
+/*
+Name: initializeRadixHeap
+Process: sets up an empty radix heap with room for the given number
+         of patients, the last removed key starts at zero
+Function input/parameters: capacity (int)
+Function output/parameters: initialized radix heap (RadixHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: malloc
+*/
+void initializeRadixHeap( RadixHeapType *heap, int capacity );
+
+/*
+Name: isRadixEmpty
+Process: reports if radix heap holds no patients
+Function input/parameters: radix heap (const RadixHeapType *)
+Function output/parameters: none
+Function output/returned: Boolean result of test (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+bool isRadixEmpty( const RadixHeapType *heap );
+
+/*
+Name: pushRadixEntry
+Process: appends entry to a bucket, doubles the bucket when full
+Function input/parameters: bucket (RadixBucketType *), entry (HeapEntryType)
+Function output/parameters: updated bucket (RadixBucketType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the bucket is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: reserveRadixBucket
+*/
+bool pushRadixEntry( RadixBucketType *bucket, HeapEntryType entry );
+
+/*
+Name: redistributeRadixBuckets
+Process: refills the empty bucket zero, takes the smallest key of the
+         lowest non-empty bucket as the last removed key and moves
+         that bucket's entries down relative to it in arrival order,
+         makes room in every target bucket before anything moves
+Function input/parameters: radix heap (RadixHeapType *)
+Function output/parameters: updated radix heap (RadixHeapType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and no entry moved (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: __builtin_ctzll where available, getRadixBucket,
+              reserveRadixBucket, pushRadixEntry
+*/
+bool redistributeRadixBuckets( RadixHeapType *heap );
+
+/*
+Name: removeRadixItem
+Process: removes the patient with the smallest key, refilling bucket zero
+         first if it is empty, equal keys leave in the order they arrived
+Function input/parameters: radix heap (RadixHeapType *)
+Function output/parameters: removed patient (PatientType *),
+                            updated radix heap (RadixHeapType *)
+Function output/returned: Boolean result, false if heap is empty or
+                          memory to refill bucket zero ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: redistributeRadixBuckets
+*/
+bool removeRadixItem( PatientType *removed, RadixHeapType *heap );
+
+/*
+Name: reserveRadixBucket
+Process: doubles a bucket until it has room for the given number of
+         entries, starting from the minimum radix capacity
+Function input/parameters: bucket (RadixBucketType *), entries needed (int)
+Function output/parameters: updated bucket (RadixBucketType *)
+Function output/returned: Boolean result, false if memory ran out
+                          and the bucket is unchanged (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc
+*/
+bool reserveRadixBucket( RadixBucketType *bucket, int needed );
+
+#endif   // RADIX_HEAP_UTILITY_H
@@ -0,0 +1,399 @@
+#include "ShardedHeapUtility.h"
+
+/*
+Name: addShardedItem
+Process: adds patient to the calling worker's own shard with a key from
+         the shared arrival sequence, republishes the shard root,
+         a patient turned away for lack of memory is not counted
+Function input/parameters: sharded heap (ShardedHeapType *), 
+                           worker shard index (int),
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated sharded heap (ShardedHeapType *)
+Function output/returned: Boolean result, false if memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_lock, addHeapItemWithKey, makeHeapKey, 
+              publishTopKey, pthread_mutex_unlock
+*/
+bool addShardedItem( ShardedHeapType *heap, int shardIndex, 
+                      const char *nameSet, int prioritySet, time_t timeSet )
+  {
+  // variables
+  SubHeapType *shard = &heap->shards[ shardIndex ];
+  uint64_t key = makeHeapKey( prioritySet, 
+                              atomic_fetch_add( &heap->nextSequence, 1 ) );
+  bool addedFlag;
+
+  // only thieves share this lock, so it is normally uncontended
+  pthread_mutex_lock( &shard->lock );
+
+  addedFlag = addHeapItemWithKey( &shard->heap, nameSet, timeSet, key )
+                                                          != INVALID_HANDLE;
+
+  publishTopKey( shard );
+
+  pthread_mutex_unlock( &shard->lock );
+
+  // a patient turned away is never counted so removers do not wait for it
+  if( addedFlag )
+    {
+    atomic_fetch_add( &heap->size, 1 );
+    }
+
+  return addedFlag;
+  }
+
+/*
+Name: clearShardedHeap
+Process: clears every shard, destroys locks, frees all memory,
+         must not be called while workers use the heap
+Function input/parameters: sharded heap (ShardedHeapType *)
+Function output/parameters: updated sharded heap (ShardedHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: clearHeap, pthread_mutex_destroy, free
+*/
+void clearShardedHeap( ShardedHeapType *heap )
+  {
+  // variables
+  int index;
+
+  for( index = 0; index < heap->shardCount; index++ )
+    {
+    clearHeap( &heap->shards[ index ].heap );
+
+    pthread_mutex_destroy( &heap->shards[ index ].lock );
+    }
+
+  free( heap->shards );
+
+  heap->shards = NULL;
+  heap->shardCount = 0;
+
+  atomic_store( &heap->size, 0 );
+  }
+
+/*
+Name: findStealVictim
+Process: finds the remote shard with the best published root, samples
+         a few shards while the local shard has entries, scans all of 
+         them once it is empty
+Function input/parameters: sharded heap (const ShardedHeapType *), 
+                           worker shard index (int),
+                           scan every shard flag (bool)
+Function output/parameters: best remote root key (uint64_t *)
+Function output/returned: victim shard index, or INVALID_POSITION if no
+                          remote shard has entries (int)
+Device input/---: none
+Device output/---: none
+Dependencies: getRandomShard
+*/
+int findStealVictim( const ShardedHeapType *heap, int shardIndex, 
+                                      bool scanAllFlag, uint64_t *victimKey )
+  {
+  // variables
+  int victimIndex = INVALID_POSITION, candidate, count;
+  int candidateCount = STEAL_SAMPLE_COUNT;
+  uint64_t candidateKey;
+
+  *victimKey = EMPTY_TOP_KEY;
+
+  if( scanAllFlag )
+    {
+    candidateCount = heap->shardCount;
+    }
+
+  for( count = 0; count < candidateCount; count++ )
+    {
+    if( scanAllFlag )
+      {
+      candidate = count;
+      }
+
+    else
+      {
+      candidate = getRandomShard( heap );
+      }
+
+    // relaxed loads, a stale root only makes the choice less exact
+    candidateKey = atomic_load_explicit( &heap->shards[ candidate ].topKey,
+                                                      memory_order_relaxed );
+
+    if( candidate != shardIndex && candidateKey > *victimKey )
+      {
+      victimIndex = candidate;
+      *victimKey = candidateKey;
+      }
+    }
+
+  return victimIndex;
+  }
+
+/*
+Name: getRandomShard
+Process: picks a shard index from a per thread xorshift generator
+Function input/parameters: sharded heap (const ShardedHeapType *)
+Function output/parameters: none
+Function output/returned: shard index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getRandomShard( const ShardedHeapType *heap )
+  {
+  // variables
+  static _Thread_local uint64_t state = 0;
+
+  // seed each thread differently from the address of its own state
+  if( state == 0 )
+    {
+    state = (uint64_t)(uintptr_t)&state | 1u;
+    }
+
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+
+  return (int)( state % (uint64_t)heap->shardCount );
+  }
+
+/*
+Name: initializeShardedHeap
+Process: creates one shard per worker, each with its own lock and an 
+         empty published root
+Function input/parameters: sharded heap (ShardedHeapType *), 
+                           worker count (int),
+                           initial capacity of each shard (int),
+                           entries per steal, zero for default (int)
+Function output/parameters: initialized sharded heap (ShardedHeapType *)
+Function output/returned: Boolean result, false if memory ran out and
+                          the sharded heap has no shards (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: aligned_alloc, initializeHeap, pthread_mutex_init
+*/
+bool initializeShardedHeap( ShardedHeapType *heap, int workerCount,
+                                      int initialCapacity, int stealBatch )
+  {
+  // variables
+  int index;
+
+  if( workerCount <= 0 )
+    {
+    workerCount = 1;
+    }
+
+  if( stealBatch <= 0 )
+    {
+    stealBatch = DEFAULT_STEAL_BATCH;
+    }
+
+  if( stealBatch > MAX_STEAL_BATCH )
+    {
+    stealBatch = MAX_STEAL_BATCH;
+    }
+
+  heap->shardCount = workerCount;
+  heap->stealBatch = stealBatch;
+
+  // one shard per cache line so a root publish touches no other shard
+  heap->shards = ( SubHeapType *)aligned_alloc( CACHE_LINE_SIZE, 
+                                  heap->shardCount * sizeof( SubHeapType ) );
+
+  // a heap without shards is still safe to clear
+  if( heap->shards == NULL )
+    {
+    heap->shardCount = 0;
+    }
+
+  for( index = 0; index < heap->shardCount; index++ )
+    {
+    pthread_mutex_init( &heap->shards[ index ].lock, NULL );
+
+    atomic_init( &heap->shards[ index ].topKey, EMPTY_TOP_KEY );
+
+    initializeHeap( &heap->shards[ index ].heap, initialCapacity );
+    }
+
+  atomic_init( &heap->nextSequence, 0 );
+  atomic_init( &heap->size, 0 );
+  atomic_init( &heap->stealCount, 0 );
+
+  return heap->shards != NULL;
+  }
+
+/*
+Name: removeShardedItem
+Process: pops the local root while it is at least as good as the sampled
+         remote roots, otherwise steals a batch from the best remote 
+         shard, returns its best entry and keeps the rest locally
+Function input/parameters: sharded heap (ShardedHeapType *), 
+                           worker shard index (int)
+Function output/parameters: updated sharded heap (ShardedHeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if heap is empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: findStealVictim, pthread_mutex_lock, removeItem, 
+              publishTopKey, pthread_mutex_unlock, stealShardBatch
+*/
+bool removeShardedItem( ShardedHeapType *heap, int shardIndex, 
+                                                        PatientType *removed )
+  {
+  // variables
+  SubHeapType *shard = &heap->shards[ shardIndex ];
+  uint64_t localKey, victimKey;
+  int victimIndex;
+  bool removedFlag = false;
+
+  while( !removedFlag && atomic_load( &heap->size ) > 0 )
+    {
+    localKey = atomic_load_explicit( &shard->topKey, memory_order_relaxed );
+
+    victimIndex = findStealVictim( heap, shardIndex, 
+                                   localKey == EMPTY_TOP_KEY, &victimKey );
+
+    // stay core local unless a remote root is clearly better
+    if( localKey != EMPTY_TOP_KEY && localKey >= victimKey )
+      {
+      pthread_mutex_lock( &shard->lock );
+
+      // a thief may have emptied the shard since the root was read
+      if( shard->heap.size > 0 )
+        {
+        removeItem( removed, &shard->heap );
+
+        publishTopKey( shard );
+
+        removedFlag = true;
+        }
+
+      pthread_mutex_unlock( &shard->lock );
+      }
+
+    else if( victimIndex != INVALID_POSITION )
+      {
+      removedFlag = stealShardBatch( heap, shardIndex, victimIndex, 
+                                                                  removed );
+      }
+    }
+
+  if( removedFlag )
+    {
+    atomic_fetch_sub( &heap->size, 1 );
+    }
+
+  return removedFlag;
+  }
+
+/*
+Name: stealShardBatch
+Process: moves up to a batch of the best entries from a victim shard, 
+         never holding two shard locks at once, hands back the best 
+         entry and adds the rest to the thief's shard with their keys,
+         entries the thief's shard has no memory for go back to the
+         victim, any the victim cannot take either are dropped from
+         the count so removers do not wait for them
+Function input/parameters: sharded heap (ShardedHeapType *), 
+                           thief shard index (int), victim shard index (int)
+Function output/parameters: updated sharded heap (ShardedHeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if victim was empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_lock, getTopHeapEntry, removeItem, 
+              publishTopKey, pthread_mutex_unlock, addHeapItemWithKey
+*/
+bool stealShardBatch( ShardedHeapType *heap, int shardIndex, 
+                                      int victimIndex, PatientType *removed )
+  {
+  // variables
+  SubHeapType *victim = &heap->shards[ victimIndex ];
+  SubHeapType *shard = &heap->shards[ shardIndex ];
+  PatientType stolen[ MAX_STEAL_BATCH ];
+  uint64_t stolenKeys[ MAX_STEAL_BATCH ];
+  int stolenCount = 0, returnedCount = 0, lostCount = 0, batchSize, index;
+
+  pthread_mutex_lock( &victim->lock );
+
+  // take at most half so the victim is not left empty by one steal
+  batchSize = victim->heap.size / 2 + 1;
+
+  if( batchSize > heap->stealBatch )
+    {
+    batchSize = heap->stealBatch;
+    }
+
+  while( stolenCount < batchSize && victim->heap.size > 0 )
+    {
+    stolenKeys[ stolenCount ] = getTopHeapEntry( &victim->heap ).key;
+
+    removeItem( &stolen[ stolenCount ], &victim->heap );
+
+    stolenCount++;
+    }
+
+  publishTopKey( victim );
+
+  pthread_mutex_unlock( &victim->lock );
+
+  if( stolenCount > 0 )
+    {
+    *removed = stolen[ 0 ];
+
+    // keep the original keys so arrival order survives the move
+    if( stolenCount > 1 )
+      {
+      pthread_mutex_lock( &shard->lock );
+
+      // entries that do not fit are packed to the front to go back
+      for( index = 1; index < stolenCount; index++ )
+        {
+        if( addHeapItemWithKey( &shard->heap, stolen[ index ].patientName, 
+                  stolen[ index ].timeIn, stolenKeys[ index ] ) 
+                                                         == INVALID_HANDLE )
+          {
+          stolen[ returnedCount ] = stolen[ index ];
+          stolenKeys[ returnedCount ] = stolenKeys[ index ];
+
+          returnedCount++;
+          }
+        }
+
+      publishTopKey( shard );
+
+      pthread_mutex_unlock( &shard->lock );
+      }
+
+    if( returnedCount > 0 )
+      {
+      pthread_mutex_lock( &victim->lock );
+
+      for( index = 0; index < returnedCount; index++ )
+        {
+        if( addHeapItemWithKey( &victim->heap, stolen[ index ].patientName, 
+                  stolen[ index ].timeIn, stolenKeys[ index ] ) 
+                                                         == INVALID_HANDLE )
+          {
+          lostCount++;
+          }
+        }
+
+      publishTopKey( victim );
+
+      pthread_mutex_unlock( &victim->lock );
+      }
+
+    // patients neither shard could hold are no longer waiting
+    if( lostCount > 0 )
+      {
+      atomic_fetch_sub( &heap->size, lostCount );
+      }
+
+    atomic_fetch_add( &heap->stealCount, 1 );
+    }
+
+  return stolenCount > 0;
+  }
@@ -0,0 +1,156 @@
+#ifndef SHARDED_HEAP_UTILITY_H
+#define SHARDED_HEAP_UTILITY_H
+
+#include "MultiQueueUtility.c"
+
+// constants
+
+// entries moved per steal when the caller passes zero
+#define DEFAULT_STEAL_BATCH 32
+
+// upper bound on a steal batch, sizes the stack buffer of a steal
+#define MAX_STEAL_BATCH 256
+
+// remote roots compared against the local root on each pop
+#define STEAL_SAMPLE_COUNT 2
+
+// data structures
+
+// one shard per worker, each a sub-heap with a lock and published root;
+// the owner pops locally and only thieves contend for the lock
+typedef struct ShardedHeapStruct
+   {
+    SubHeapType *shards;
+
+    int shardCount, stealBatch;
+
+    atomic_uint nextSequence;
+
+    atomic_long size;
+
+    atomic_long stealCount;
+   } ShardedHeapType;
+
+// function prototypes
+
+/*
+Name: addShardedItem
+Process: adds patient to the calling worker's own shard with a key from
+         the shared arrival sequence, republishes the shard root,
+         a patient turned away for lack of memory is not counted
+Function input/parameters: sharded heap (ShardedHeapType *), 
+                           worker shard index (int),
+                           patient name (const char *),
+                           patient priority (int), time in (time_t)
+Function output/parameters: updated sharded heap (ShardedHeapType *)
+Function output/returned: Boolean result, false if memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_lock, addHeapItemWithKey, makeHeapKey, 
+              publishTopKey, pthread_mutex_unlock
+*/
+bool addShardedItem( ShardedHeapType *heap, int shardIndex, 
+                     const char *nameSet, int prioritySet, time_t timeSet );
+
+/*
+Name: clearShardedHeap
+Process: clears every shard, destroys locks, frees all memory,
+         must not be called while workers use the heap
+Function input/parameters: sharded heap (ShardedHeapType *)
+Function output/parameters: updated sharded heap (ShardedHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: clearHeap, pthread_mutex_destroy, free
+*/
+void clearShardedHeap( ShardedHeapType *heap );
+
+/*
+Name: findStealVictim
+Process: finds the remote shard with the best published root, samples
+         a few shards while the local shard has entries, scans all of 
+         them once it is empty
+Function input/parameters: sharded heap (const ShardedHeapType *), 
+                           worker shard index (int),
+                           scan every shard flag (bool)
+Function output/parameters: best remote root key (uint64_t *)
+Function output/returned: victim shard index, or INVALID_POSITION if no
+                          remote shard has entries (int)
+Device input/---: none
+Device output/---: none
+Dependencies: getRandomShard
+*/
+int findStealVictim( const ShardedHeapType *heap, int shardIndex, 
+                                     bool scanAllFlag, uint64_t *victimKey );
+
+/*
+Name: getRandomShard
+Process: picks a shard index from a per thread xorshift generator
+Function input/parameters: sharded heap (const ShardedHeapType *)
+Function output/parameters: none
+Function output/returned: shard index (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int getRandomShard( const ShardedHeapType *heap );
+
+/*
+Name: initializeShardedHeap
+Process: creates one shard per worker, each with its own lock and an 
+         empty published root
+Function input/parameters: sharded heap (ShardedHeapType *), 
+                           worker count (int),
+                           initial capacity of each shard (int),
+                           entries per steal, zero for default (int)
+Function output/parameters: initialized sharded heap (ShardedHeapType *)
+Function output/returned: Boolean result, false if memory ran out and
+                          the sharded heap has no shards (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: aligned_alloc, initializeHeap, pthread_mutex_init
+*/
+bool initializeShardedHeap( ShardedHeapType *heap, int workerCount,
+                                     int initialCapacity, int stealBatch );
+
+/*
+Name: removeShardedItem
+Process: pops the local root while it is at least as good as the sampled
+         remote roots, otherwise steals a batch from the best remote 
+         shard, returns its best entry and keeps the rest locally
+Function input/parameters: sharded heap (ShardedHeapType *), 
+                           worker shard index (int)
+Function output/parameters: updated sharded heap (ShardedHeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if heap is empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: findStealVictim, pthread_mutex_lock, removeItem, 
+              publishTopKey, pthread_mutex_unlock, stealShardBatch
+*/
+bool removeShardedItem( ShardedHeapType *heap, int shardIndex, 
+                                                       PatientType *removed );
+
+/*
+Name: stealShardBatch
+Process: moves up to a batch of the best entries from a victim shard, 
+         never holding two shard locks at once, hands back the best 
+         entry and adds the rest to the thief's shard with their keys,
+         entries the thief's shard has no memory for go back to the
+         victim, any the victim cannot take either are dropped from
+         the count so removers do not wait for them
+Function input/parameters: sharded heap (ShardedHeapType *), 
+                           thief shard index (int), victim shard index (int)
+Function output/parameters: updated sharded heap (ShardedHeapType *),
+                            patient data removed (PatientType *)
+Function output/returned: Boolean result, false if victim was empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: pthread_mutex_lock, getTopHeapEntry, removeItem, 
+              publishTopKey, pthread_mutex_unlock, addHeapItemWithKey
+*/
+bool stealShardBatch( ShardedHeapType *heap, int shardIndex, 
+                                     int victimIndex, PatientType *removed );
+
+
+#endif   // SHARDED_HEAP_UTILITY_H
@@ -0,0 +1,335 @@
+// several modules include this file, define it only once
+#ifndef TRACE_UTILITY_C
+#define TRACE_UTILITY_C
+
+#include "TraceUtility.h"
+
+/*
+Name: claimTraceEvent
+Process: returns the ring slot the next event is written into,
+         the event is not visible to readers until published
+Function input/parameters: trace ring (HeapTraceType *)
+Function output/parameters: none
+Function output/returned: slot for the next event (HeapTraceEventType *)
+Device input/---: none
+Device output/---: none
+Dependencies: atomic_load_explicit
+*/
+HeapTraceEventType *claimTraceEvent( HeapTraceType *trace )
+  {
+  // only the writer moves head, so its own read needs no ordering
+  uint64_t head = atomic_load_explicit( &trace->head, memory_order_relaxed );
+
+  return &trace->events[ head & trace->mask ];
+  }
+
+/*
+Name: createHeapTrace
+Process: allocates a trace ring of at least the given number of events,
+         rounded up to a power of two
+Function input/parameters: event capacity (int)
+Function output/parameters: none
+Function output/returned: empty trace ring (HeapTraceType *)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, atomic_init
+*/
+HeapTraceType *createHeapTrace( int capacity )
+  {
+  // variables
+  HeapTraceType *trace = ( HeapTraceType *)malloc( sizeof( HeapTraceType ) );
+  uint64_t events = 1;
+
+  // round up so an event index maps to its slot with a mask
+  while( events < (uint64_t)capacity )
+    {
+    events *= 2;
+    }
+
+  trace->events = ( HeapTraceEventType *)malloc(
+                                      events * sizeof( HeapTraceEventType ) );
+  trace->mask = events - 1;
+  trace->displayCursor = 0;
+  trace->timestamp = 0;
+
+  atomic_init( &trace->head, 0 );
+
+  return trace;
+  }
+
+/*
+Name: formatTraceEvent
+Process: writes the text display mode has always printed for an event,
+         additions, removals, bubble up and trickle down steps,
+         name, bulk patient and update events produce no text
+Function input/parameters: event (const HeapTraceEventType *),
+                           patient of the event handle (PatientType),
+                           patient it traded places with (PatientType)
+Function output/parameters: event text (char *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: getPatientInfo, sprintf
+*/
+void formatTraceEvent( char *text, const HeapTraceEventType *event,
+                                    PatientType patient, PatientType other )
+  {
+  // variables
+  char patientStr[ HUGE_STR_LEN ], otherStr[ HUGE_STR_LEN ];
+
+  text[ 0 ] = NULL_CHAR;
+
+  switch( event->op )
+    {
+    case TRACE_ADD:
+      sprintf( text, "\nAdding new patient: %s\n\n", patient.patientName );
+      break;
+
+    case TRACE_REMOVE:
+      getPatientInfo( patientStr, patient );
+      sprintf( text, "\nRemoving patient: %s\n", patientStr );
+      break;
+
+    case TRACE_BULK_ADD:
+      sprintf( text, "\nAdding %d patients in bulk\n\n",
+                                                 (int)event->data.step.key );
+      break;
+
+    // the parent moves down, the event handle is the child moving up
+    case TRACE_BUBBLE_UP:
+      getPatientInfo( patientStr, patient );
+      getPatientInfo( otherStr, other );
+
+      sprintf( text, "   - Bubble up:\n"
+                     "     - Swapping parent: %s\n"
+                     "     - with child: %s\n\n", otherStr, patientStr );
+      break;
+
+    // the event handle is the parent moving down, other is the child
+    case TRACE_TRICKLE_DOWN:
+      getPatientInfo( patientStr, patient );
+      getPatientInfo( otherStr, other );
+
+      if( event->arity == 2 )
+        {
+        sprintf( text, "   - Trickling down\n"
+                       "     - moving down parent: %s\n"
+                       "     - moving %s child: %s\n\n", patientStr,
+                 event->data.step.childOffset == 0 ? "left" : "right",
+                                                                   otherStr );
+        }
+
+      else
+        {
+        sprintf( text, "   - Trickling down\n"
+                       "     - moving down parent: %s\n"
+                       "     - moving child %d: %s\n\n", patientStr,
+                                  event->data.step.childOffset + 1, otherStr );
+        }
+      break;
+    }
+  }
+
+/*
+Name: freeHeapTrace
+Process: frees a trace ring and its events
+Function input/parameters: trace ring (HeapTraceType *)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: free
+*/
+void freeHeapTrace( HeapTraceType *trace )
+  {
+  if( trace != NULL )
+    {
+    free( trace->events );
+    free( trace );
+    }
+  }
+
+/*
+Name: publishTraceEvent
+Process: makes the claimed event visible to readers
+Function input/parameters: trace ring (HeapTraceType *)
+Function output/parameters: updated trace ring (HeapTraceType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: atomic_load_explicit, atomic_store_explicit
+*/
+void publishTraceEvent( HeapTraceType *trace )
+  {
+  uint64_t head = atomic_load_explicit( &trace->head, memory_order_relaxed );
+
+  // release orders the event's bytes before the new head
+  atomic_store_explicit( &trace->head, head + 1, memory_order_release );
+  }
+
+/*
+Name: readTraceEvents
+Process: copies published events from the cursor on, skipping any the
+         writer has overwritten, safe while the writer keeps running
+Function input/parameters: trace ring (const HeapTraceType *),
+                           cursor, next event wanted (uint64_t *),
+                           most events to copy (int)
+Function output/parameters: events oldest first (HeapTraceEventType *),
+                            cursor past the last copied event (uint64_t *)
+Function output/returned: number of events copied (int)
+Device input/---: none
+Device output/---: none
+Dependencies: atomic_load_explicit, atomic_thread_fence, memmove
+*/
+int readTraceEvents( const HeapTraceType *trace, uint64_t *cursor,
+                                     HeapTraceEventType *events, int maxCount )
+  {
+  // variables
+  uint64_t capacity = trace->mask + 1, start = *cursor, oldest, head;
+  int count, index, skipped;
+
+  head = atomic_load_explicit( ( atomic_uint_fast64_t *)&trace->head,
+                                                       memory_order_acquire );
+
+  // events more than one ring behind head are already gone
+  if( head - start > capacity )
+    {
+    start = head - capacity;
+    }
+
+  count = head - start < (uint64_t)maxCount ? (int)( head - start ) : maxCount;
+
+  for( index = 0; index < count; index++ )
+    {
+    events[ index ] = trace->events[ ( start + index ) & trace->mask ];
+    }
+
+  // the writer may have lapped the copy, the slot of the event it is
+  // writing now belonged to the event one ring before it
+  atomic_thread_fence( memory_order_acquire );
+
+  head = atomic_load_explicit( ( atomic_uint_fast64_t *)&trace->head,
+                                                       memory_order_relaxed );
+  oldest = head >= capacity ? head - capacity + 1 : 0;
+
+  if( start < oldest )
+    {
+    skipped = oldest - start < (uint64_t)count ? (int)( oldest - start )
+                                                                     : count;
+
+    count -= skipped;
+    start += skipped;
+
+    memmove( events, &events[ skipped ],
+                                      count * sizeof( HeapTraceEventType ) );
+    }
+
+  *cursor = start + count;
+
+  return count;
+  }
+
+/*
+Name: readTraceFile
+Process: reads a saved trace, checks its header
+Function input/parameters: file name (const char *)
+Function output/parameters: file header (TraceFileHeaderType *)
+Function output/returned: events to free later, NULL if the file
+                          is missing or not a trace (HeapTraceEventType *)
+Device input/---: trace file
+Device output/---: none
+Dependencies: fopen, fread, malloc, fclose, free
+*/
+HeapTraceEventType *readTraceFile( const char *fileName,
+                                               TraceFileHeaderType *header )
+  {
+  // variables
+  FILE *file = fopen( fileName, "rb" );
+  HeapTraceEventType *events = NULL;
+
+  if( file == NULL )
+    {
+    return NULL;
+    }
+
+  if( fread( header, sizeof( TraceFileHeaderType ), 1, file ) == 1
+             && header->magic == TRACE_FILE_MAGIC
+             && header->version == TRACE_FILE_VERSION
+             && header->eventSize == sizeof( HeapTraceEventType ) )
+    {
+    // one extra event so an empty trace still returns a block
+    events = ( HeapTraceEventType *)malloc(
+                     ( header->eventCount + 1 ) * sizeof( HeapTraceEventType ) );
+
+    if( events != NULL && fread( events, sizeof( HeapTraceEventType ),
+                      header->eventCount, file ) != header->eventCount )
+      {
+      free( events );
+
+      events = NULL;
+      }
+    }
+
+  fclose( file );
+
+  return events;
+  }
+
+/*
+Name: writeTraceFile
+Process: saves every event still in the ring, oldest first,
+         behind a header with the tick rate for the timestamps
+Function input/parameters: trace ring (const HeapTraceType *),
+                           file name (const char *), ticks per ns (double)
+Function output/parameters: none
+Function output/returned: Boolean result, false if not written (bool)
+Device input/---: none
+Device output/---: trace file
+Dependencies: malloc, readTraceEvents, fopen, fwrite, fclose, free
+*/
+bool writeTraceFile( const HeapTraceType *trace, const char *fileName,
+                                                          double ticksPerNs )
+  {
+  // variables
+  TraceFileHeaderType header;
+  HeapTraceEventType *events;
+  uint64_t cursor = 0;
+  FILE *file;
+  bool successFlag;
+
+  events = ( HeapTraceEventType *)malloc(
+                         ( trace->mask + 1 ) * sizeof( HeapTraceEventType ) );
+  file = fopen( fileName, "wb" );
+
+  if( events == NULL || file == NULL )
+    {
+    free( events );
+
+    if( file != NULL )
+      {
+      fclose( file );
+      }
+
+    return false;
+    }
+
+  // a zero cursor starts at the oldest event the ring still holds
+  memset( &header, 0, sizeof( TraceFileHeaderType ) );
+
+  header.magic = TRACE_FILE_MAGIC;
+  header.version = TRACE_FILE_VERSION;
+  header.eventSize = sizeof( HeapTraceEventType );
+  header.eventCount = readTraceEvents( trace, &cursor, events,
+                                                      (int)( trace->mask + 1 ) );
+  header.ticksPerNs = ticksPerNs;
+
+  successFlag = fwrite( &header, sizeof( TraceFileHeaderType ), 1, file ) == 1
+             && fwrite( events, sizeof( HeapTraceEventType ),
+                              header.eventCount, file ) == header.eventCount;
+
+  free( events );
+
+  return fclose( file ) == 0 && successFlag;
+  }
+
+#endif   // TRACE_UTILITY_C
@@ -0,0 +1,227 @@
+#ifndef TRACE_UTILITY_H
+#define TRACE_UTILITY_H
+
+#include "PatientUtility.c"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// constants
+
+// sift tracing is compiled in unless HEAP_TRACE is 0 at build time,
+// a heap records only while a ring is attached
+#ifndef HEAP_TRACE
+#define HEAP_TRACE 1
+#endif
+
+// event kinds, name events follow an add, bulk patient or remove with up
+// to TRACE_NAME_CHUNK bytes of the name each, a bulk add keeps the batch
+// size in its key and is followed by one bulk patient per patient
+#define TRACE_ADD 1
+#define TRACE_NAME 2
+#define TRACE_REMOVE 3
+#define TRACE_UPDATE 4
+#define TRACE_BULK_ADD 5
+#define TRACE_BULK_PATIENT 6
+#define TRACE_BUBBLE_UP 7
+#define TRACE_TRICKLE_DOWN 8
+
+#define TRACE_NAME_CHUNK 32
+
+// ring size when display mode attaches one, rounded to a power of two
+#define DEFAULT_TRACE_EVENTS 4096
+
+// trace file identification, "TRCE" read as little endian bytes
+#define TRACE_FILE_MAGIC 0x45435254u
+#define TRACE_FILE_VERSION 1
+
+// events copied out of the ring per read while displaying
+#define TRACE_READ_BATCH 64
+
+// longest decoded text of one event
+#define MAX_TRACE_TEXT ( 3 * HUGE_STR_LEN )
+
+// data structures
+
+// step data, the event handle and key are the entry that moved, the other
+// handle and key are the parent or child it traded places with,
+// an add or remove keeps its time in as the other key
+typedef struct TraceStepStruct
+   {
+    uint64_t key, otherKey;
+
+    int32_t index, otherIndex;
+
+    int32_t otherHandle, childOffset;
+   } TraceStepType;
+
+// one fixed size event, length is the whole name on an add or remove
+// and the bytes carried on a name event
+typedef struct HeapTraceEventStruct
+   {
+    uint64_t timestamp;
+
+    uint8_t op, length;
+
+    uint16_t arity;
+
+    int32_t handle;
+
+    union
+       {
+        TraceStepType step;
+
+        char text[ TRACE_NAME_CHUNK ];
+       } data;
+   } HeapTraceEventType;
+
+// single writer ring, events before head minus the capacity are gone,
+// readers copy then recheck head so they never need a lock
+typedef struct HeapTraceStruct
+   {
+    HeapTraceEventType *events;
+
+    uint64_t mask;
+
+    atomic_uint_fast64_t head;
+
+    // next event display mode prints, and the stamp of the current operation
+    uint64_t displayCursor, timestamp;
+   } HeapTraceType;
+
+// first bytes of a saved trace, events follow oldest first
+typedef struct TraceFileHeaderStruct
+   {
+    uint32_t magic, version, eventSize, reserved;
+
+    uint64_t eventCount;
+
+    double ticksPerNs;
+   } TraceFileHeaderType;
+
+// function prototypes
+
+/*
+Name: claimTraceEvent
+Process: returns the ring slot the next event is written into,
+         the event is not visible to readers until published
+Function input/parameters: trace ring (HeapTraceType *)
+Function output/parameters: none
+Function output/returned: slot for the next event (HeapTraceEventType *)
+Device input/---: none
+Device output/---: none
+Dependencies: atomic_load_explicit
+*/
+HeapTraceEventType *claimTraceEvent( HeapTraceType *trace );
+
+/*
+Name: createHeapTrace
+Process: allocates a trace ring of at least the given number of events,
+         rounded up to a power of two
+Function input/parameters: event capacity (int)
+Function output/parameters: none
+Function output/returned: empty trace ring (HeapTraceType *)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, atomic_init
+*/
+HeapTraceType *createHeapTrace( int capacity );
+
+/*
+Name: formatTraceEvent
+Process: writes the text display mode has always printed for an event,
+         additions, removals, bubble up and trickle down steps,
+         name, bulk patient and update events produce no text
+Function input/parameters: event (const HeapTraceEventType *),
+                           patient of the event handle (PatientType),
+                           patient it traded places with (PatientType)
+Function output/parameters: event text (char *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: getPatientInfo, sprintf
+*/
+void formatTraceEvent( char *text, const HeapTraceEventType *event,
+                                    PatientType patient, PatientType other );
+
+/*
+Name: freeHeapTrace
+Process: frees a trace ring and its events
+Function input/parameters: trace ring (HeapTraceType *)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: free
+*/
+void freeHeapTrace( HeapTraceType *trace );
+
+/*
+Name: publishTraceEvent
+Process: makes the claimed event visible to readers
+Function input/parameters: trace ring (HeapTraceType *)
+Function output/parameters: updated trace ring (HeapTraceType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: atomic_load_explicit, atomic_store_explicit
+*/
+void publishTraceEvent( HeapTraceType *trace );
+
+/*
+Name: readTraceEvents
+Process: copies published events from the cursor on, skipping any the
+         writer has overwritten, safe while the writer keeps running
+Function input/parameters: trace ring (const HeapTraceType *),
+                           cursor, next event wanted (uint64_t *),
+                           most events to copy (int)
+Function output/parameters: events oldest first (HeapTraceEventType *),
+                            cursor past the last copied event (uint64_t *)
+Function output/returned: number of events copied (int)
+Device input/---: none
+Device output/---: none
+Dependencies: atomic_load_explicit, atomic_thread_fence, memmove
+*/
+int readTraceEvents( const HeapTraceType *trace, uint64_t *cursor,
+                                     HeapTraceEventType *events, int maxCount );
+
+/*
+Name: readTraceFile
+Process: reads a saved trace, checks its header
+Function input/parameters: file name (const char *)
+Function output/parameters: file header (TraceFileHeaderType *)
+Function output/returned: events to free later, NULL if the file
+                          is missing or not a trace (HeapTraceEventType *)
+Device input/---: trace file
+Device output/---: none
+Dependencies: fopen, fread, malloc, fclose, free
+*/
+HeapTraceEventType *readTraceFile( const char *fileName,
+                                               TraceFileHeaderType *header );
+
+/*
+Name: writeTraceFile
+Process: saves every event still in the ring, oldest first,
+         behind a header with the tick rate for the timestamps
+Function input/parameters: trace ring (const HeapTraceType *),
+                           file name (const char *), ticks per ns (double)
+Function output/parameters: none
+Function output/returned: Boolean result, false if not written (bool)
+Device input/---: none
+Device output/---: trace file
+Dependencies: malloc, readTraceEvents, fopen, fwrite, fclose, free
+*/
+bool writeTraceFile( const HeapTraceType *trace, const char *fileName,
+                                                          double ticksPerNs );
+
+
+
+
+
+
+
+
+
+
+#endif   // TRACE_UTILITY_H
@@ -0,0 +1,305 @@
+#ifndef TYPED_HEAP_UTILITY_H
+#define TYPED_HEAP_UTILITY_H
+
+// header files
+#include <stdlib.h>
+#include "StandardConstants.h"
+
+// constants
+
+#define MIN_TYPED_HEAP_CAPACITY 16
+
+// heap generator, DEFINE_TYPED_HEAP( Name, ElementType, KeyType, GET_KEY,
+// IS_HIGHER, ARITY ) writes a d-ary heap of ElementType values held 
+// directly in its array, for queues that need none of HeapUtility's 
+// handles, names, files or statistics,
+// GET_KEY( element ) gives the KeyType ordering an element and
+// IS_HIGHER( one, other ) is true when key one leaves before key other,
+// both are expanded in place, so with a constant ARITY every
+// specialization compiles to a heap written by hand for its type,
+// equal keys leave in no set order, fold an arrival count into the key
+// where first come first served matters, as makeHeapKey does,
+// the functions are static inline so each file instantiating a heap
+// gets its own copy and unused ones cost nothing
+
+// data structure, for a Name of LabJob:
+//
+// typedef struct LabJobHeapStruct
+//    {
+//     ElementType *array;
+//
+//     int size, capacity;
+//    } LabJobHeapType;
+
+// generated functions, for a Name of LabJob
+
+/*
+Name: addLabJobItem
+Process: appends the element at the end of the array, doubling it 
+         when full or starting it at the minimum capacity when empty, 
+         then bubbles it up
+Function input/parameters: typed heap (LabJobHeapType *), 
+                           element (ElementType)
+Function output/parameters: updated typed heap (LabJobHeapType *)
+Function output/returned: Boolean result, false if memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: realloc, bubbleUpLabJobHeap
+*/
+
+/*
+Name: bubbleUpLabJobHeap
+Process: carries a hole up from the given index while the parent's key
+         is lower than the moving element's, then writes the element
+         once at its final index
+Function input/parameters: typed heap (LabJobHeapType *), 
+                           hole index (int), element (ElementType)
+Function output/parameters: updated typed heap (LabJobHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: GET_KEY, IS_HIGHER
+*/
+
+/*
+Name: clearLabJobHeap
+Process: frees the array, the heap may be initialized again
+Function input/parameters: typed heap (LabJobHeapType *)
+Function output/parameters: updated typed heap (LabJobHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: free
+*/
+
+/*
+Name: initializeLabJobHeap
+Process: sets up an empty heap with room for the given number of elements
+Function input/parameters: capacity (int)
+Function output/parameters: initialized typed heap (LabJobHeapType *)
+Function output/returned: Boolean result, false if memory ran out (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: malloc
+*/
+
+/*
+Name: isLabJobEmpty
+Process: reports if the heap holds no elements
+Function input/parameters: typed heap (const LabJobHeapType *)
+Function output/parameters: none
+Function output/returned: Boolean result of test (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+
+/*
+Name: peekLabJobItem
+Process: copies out the highest element without removing it
+Function input/parameters: typed heap (const LabJobHeapType *)
+Function output/parameters: highest element (ElementType *)
+Function output/returned: Boolean result, false if heap is empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+
+/*
+Name: removeLabJobItem
+Process: removes the highest element, moves the last element into the
+         root hole and trickles it down
+Function input/parameters: typed heap (LabJobHeapType *)
+Function output/parameters: removed element (ElementType *),
+                            updated typed heap (LabJobHeapType *)
+Function output/returned: Boolean result, false if heap is empty (bool)
+Device input/---: none
+Device output/---: none
+Dependencies: trickleDownLabJobHeap
+*/
+
+/*
+Name: trickleDownLabJobHeap
+Process: carries a hole down from the root, picks the highest of up to
+         ARITY children, moves it up while it is higher than the moving 
+         element, then writes the element once at its final index
+Function input/parameters: typed heap (LabJobHeapType *), 
+                           element (ElementType)
+Function output/parameters: updated typed heap (LabJobHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: GET_KEY, IS_HIGHER
+*/
+
+#define DEFINE_TYPED_HEAP( Name, ElementType, KeyType, GET_KEY, IS_HIGHER,   \
+                                                                     ARITY ) \
+                                                                             \
+typedef struct Name##HeapStruct                                              \
+   {                                                                         \
+    ElementType *array;                                                      \
+                                                                             \
+    int size, capacity;                                                      \
+   } Name##HeapType;                                                         \
+                                                                             \
+static inline void bubbleUp##Name##Heap( Name##HeapType *heap,               \
+                                        int holeIndex, ElementType moving )  \
+  {                                                                          \
+  /* variables */                                                            \
+  KeyType movingKey = GET_KEY( moving );                                     \
+  int parentIndex = ( holeIndex - 1 ) / ( ARITY );                           \
+                                                                             \
+  while( holeIndex > 0                                                       \
+          && IS_HIGHER( movingKey, GET_KEY( heap->array[ parentIndex ] ) ) ) \
+    {                                                                        \
+    heap->array[ holeIndex ] = heap->array[ parentIndex ];                   \
+                                                                             \
+    holeIndex = parentIndex;                                                 \
+    parentIndex = ( holeIndex - 1 ) / ( ARITY );                             \
+    }                                                                        \
+                                                                             \
+  heap->array[ holeIndex ] = moving;                                         \
+  }                                                                          \
+                                                                             \
+static inline void trickleDown##Name##Heap( Name##HeapType *heap,            \
+                                                        ElementType moving ) \
+  {                                                                          \
+  /* variables */                                                            \
+  KeyType movingKey = GET_KEY( moving ), higherKey, childKey;                \
+  int holeIndex = 0, firstChildIndex = 1;                                    \
+  int childIndex, endIndex, higherIndex;                                     \
+                                                                             \
+  while( firstChildIndex < heap->size )                                      \
+    {                                                                        \
+    endIndex = firstChildIndex + ( ARITY );                                  \
+                                                                             \
+    if( endIndex > heap->size )                                              \
+      {                                                                      \
+      endIndex = heap->size;                                                 \
+      }                                                                      \
+                                                                             \
+    higherIndex = firstChildIndex;                                           \
+    higherKey = GET_KEY( heap->array[ firstChildIndex ] );                   \
+                                                                             \
+    for( childIndex = firstChildIndex + 1; childIndex < endIndex;            \
+                                                              childIndex++ ) \
+      {                                                                      \
+      childKey = GET_KEY( heap->array[ childIndex ] );                       \
+                                                                             \
+      if( IS_HIGHER( childKey, higherKey ) )                                 \
+        {                                                                    \
+        higherIndex = childIndex;                                            \
+        higherKey = childKey;                                                \
+        }                                                                    \
+      }                                                                      \
+                                                                             \
+    /* the hole is where the moving element belongs */                       \
+    if( !IS_HIGHER( higherKey, movingKey ) )                                 \
+      {                                                                      \
+      break;                                                                 \
+      }                                                                      \
+                                                                             \
+    heap->array[ holeIndex ] = heap->array[ higherIndex ];                   \
+                                                                             \
+    holeIndex = higherIndex;                                                 \
+    firstChildIndex = holeIndex * ( ARITY ) + 1;                             \
+    }                                                                        \
+                                                                             \
+  heap->array[ holeIndex ] = moving;                                         \
+  }                                                                          \
+                                                                             \
+static inline bool add##Name##Item( Name##HeapType *heap,                    \
+                                                       ElementType element ) \
+  {                                                                          \
+  /* variables */                                                            \
+  ElementType *newArray;                                                     \
+  int newCapacity;                                                           \
+                                                                             \
+  if( heap->size == heap->capacity )                                         \
+    {                                                                        \
+    /* an emptied or never allocated heap starts over at the minimum */      \
+    newCapacity = heap->capacity > 0 ? 2 * heap->capacity                    \
+                                                : MIN_TYPED_HEAP_CAPACITY;   \
+    newArray = ( ElementType *)realloc( heap->array,                         \
+                         (size_t)newCapacity * sizeof( ElementType ) );      \
+                                                                             \
+    if( newArray == NULL )                                                   \
+      {                                                                      \
+      return false;                                                          \
+      }                                                                      \
+                                                                             \
+    heap->array = newArray;                                                  \
+    heap->capacity = newCapacity;                                            \
+    }                                                                        \
+                                                                             \
+  heap->size++;                                                              \
+                                                                             \
+  bubbleUp##Name##Heap( heap, heap->size - 1, element );                     \
+                                                                             \
+  return true;                                                               \
+  }                                                                          \
+                                                                             \
+static inline void clear##Name##Heap( Name##HeapType *heap )                 \
+  {                                                                          \
+  free( heap->array );                                                       \
+                                                                             \
+  heap->array = NULL;                                                        \
+  heap->size = 0;                                                            \
+  heap->capacity = 0;                                                        \
+  }                                                                          \
+                                                                             \
+static inline bool initialize##Name##Heap( Name##HeapType *heap,             \
+                                                              int capacity ) \
+  {                                                                          \
+  if( capacity < MIN_TYPED_HEAP_CAPACITY )                                   \
+    {                                                                        \
+    capacity = MIN_TYPED_HEAP_CAPACITY;                                      \
+    }                                                                        \
+                                                                             \
+  heap->array = ( ElementType *)malloc(                                      \
+                                 (size_t)capacity * sizeof( ElementType ) ); \
+  heap->size = 0;                                                            \
+  heap->capacity = heap->array != NULL ? capacity : 0;                       \
+                                                                             \
+  return heap->array != NULL;                                                \
+  }                                                                          \
+                                                                             \
+static inline bool is##Name##Empty( const Name##HeapType *heap )             \
+  {                                                                          \
+  return heap->size == 0;                                                    \
+  }                                                                          \
+                                                                             \
+static inline bool peek##Name##Item( const Name##HeapType *heap,             \
+                                                          ElementType *top ) \
+  {                                                                          \
+  if( heap->size == 0 )                                                      \
+    {                                                                        \
+    return false;                                                            \
+    }                                                                        \
+                                                                             \
+  *top = heap->array[ 0 ];                                                   \
+                                                                             \
+  return true;                                                               \
+  }                                                                          \
+                                                                             \
+static inline bool remove##Name##Item( Name##HeapType *heap,                 \
+                                                      ElementType *removed ) \
+  {                                                                          \
+  if( heap->size == 0 )                                                      \
+    {                                                                        \
+    return false;                                                            \
+    }                                                                        \
+                                                                             \
+  *removed = heap->array[ 0 ];                                               \
+                                                                             \
+  heap->size--;                                                              \
+                                                                             \
+  if( heap->size > 0 )                                                       \
+    {                                                                        \
+    trickleDown##Name##Heap( heap, heap->array[ heap->size ] );              \
+    }                                                                        \
+                                                                             \
+  return true;                                                               \
+  }
+
+#endif   // TYPED_HEAP_UTILITY_H
@@ -0,0 +1,698 @@
+// header files
+#include <time.h>
+#include <stdio.h>
+#include "HeapUtility.c"
+
+// cycle counter, time stamp counter ticks where available
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#define CYCLE_COUNTER_NAME "tsc"
+#else
+#define CYCLE_COUNTER_NAME "clock_ns"
+#endif
+
+// constants
+const int MIN_BENCH_SIZE = 1000;
+const int DEFAULT_MAX_SIZE = 1000000;
+const int MAX_BENCH_SIZE = 100000000;
+const int DEFAULT_CAPACITY = 10;
+const int HOLD_OPERATIONS = 1000000;
+const int BULK_CHUNK = 1024;
+const int MAX_LATENCY_SAMPLES = 1048576;
+const int LOWEST_PRIORITY = 1;
+const int HIGHEST_PRIORITY = 10;
+const int EQUAL_PRIORITY = 5;
+const double NANOSECONDS_PER_SECOND = 1000000000.0;
+
+// priority distributions, skewed halves the odds of each higher level
+const int UNIFORM_DISTRIBUTION = 0;
+const int SKEWED_DISTRIBUTION = 1;
+const int EQUAL_DISTRIBUTION = 2;
+const int DISTRIBUTION_COUNT = 3;
+const char *DISTRIBUTION_NAMES[] = { "uniform", "skewed", "equal" };
+
+// implementations compared, incremental is HeapUtility moving each
+// resize a step per operation, bucket is HeapUtility on level rings
+const int HEAP_UTILITY_IMPL = 0;
+const int INCREMENTAL_IMPL = 1;
+const int BUCKET_QUEUE_IMPL = 2;
+const int REFERENCE_IMPL = 3;
+const char *IMPLEMENTATION_NAMES[] = { "HeapUtility", "incremental", 
+                                       "bucket", "reference" };
+
+// workloads, bulk ones time addHeapItems and removeTopK per chunk
+const int ADD_WORKLOAD = 0;
+const int HOLD_WORKLOAD = 1;
+const int REMOVE_WORKLOAD = 2;
+const int BULK_ADD_WORKLOAD = 3;
+const int BULK_REMOVE_WORKLOAD = 4;
+const char *WORKLOAD_NAMES[] = { "add", "hold", "remove",
+                                 "bulk_add", "bulk_remove" };
+
+// data structures
+
+// textbook binary heap of ordering keys, the baseline being compared
+typedef struct ReferenceHeapStruct
+   {
+    uint64_t *keys;
+
+    int size, capacity;
+
+    uint32_t nextSequence;
+   } ReferenceHeapType;
+
+// heaps under test and the generator feeding them
+typedef struct BenchStateStruct
+   {
+    int implementation, distribution;
+
+    HeapType heap;
+
+    ReferenceHeapType reference;
+
+    PatientType *patients;
+
+    uint64_t randomState;
+   } BenchStateType;
+
+// one timed workload, latencies are per operation in nanoseconds,
+// the maximum is over every operation, not only the sampled ones,
+// comparisons and moves come from the heap's counters, zero for reference
+typedef struct BenchResultStruct
+   {
+    int implementation, workload, distribution, size;
+
+    long operations;
+
+    double nsPerOp, cyclesPerOp;
+
+    double p50, p99, p999, maxNs;
+
+    double comparisonsPerOp, movesPerOp;
+   } BenchResultType;
+
+// prototypes
+void addOne( BenchStateType *state );
+int compareSamples( const void *one, const void *other );
+double getSeconds( void );
+int nextPriority( BenchStateType *state );
+void printResult( FILE *jsonFile, const BenchResultType *result,
+                                                           bool firstFlag );
+uint64_t readCycleCounter( void );
+void referenceAdd( ReferenceHeapType *reference, int priority );
+uint64_t referenceRemove( ReferenceHeapType *reference );
+void removeOne( BenchStateType *state );
+void runWorkload( BenchStateType *state, int workload, int size,
+                           double ticksPerNs, BenchResultType *result );
+
+int main( int argc, char *argv[] )
+   {
+    BenchStateType state;
+    BenchResultType result;
+    FILE *jsonFile;
+    const char *jsonName = "benchdriver.json";
+    int maxSize = DEFAULT_MAX_SIZE, size, distribution, implementation;
+    int workload;
+    bool firstFlag = true;
+    double startTime, ticksPerNs;
+    uint64_t startTicks;
+
+    // optional largest size, up to 10^8, and json file name
+    if( argc > 1 )
+       {
+        maxSize = atoi( argv[ 1 ] );
+
+        if( maxSize > MAX_BENCH_SIZE )
+           {
+            maxSize = MAX_BENCH_SIZE;
+           }
+       }
+
+    if( argc > 2 )
+       {
+        jsonName = argv[ 2 ];
+       }
+
+    jsonFile = fopen( jsonName, "w" );
+
+    if( jsonFile == NULL )
+       {
+        printf( "\nUnable to write %s\n", jsonName );
+
+        return 1;
+       }
+
+    // counter ticks per nanosecond, measured against the clock
+    startTime = getSeconds();
+    startTicks = readCycleCounter();
+
+    while( getSeconds() - startTime < 0.05 )
+       {
+       }
+
+    ticksPerNs = ( readCycleCounter() - startTicks )
+                 / ( ( getSeconds() - startTime ) * NANOSECONDS_PER_SECOND );
+
+    // title
+    printf( "\nHeap Benchmark Suite\n" );
+    printf( "====================\n" );
+    printf( "arity %d, sizes %d to %d, %s counter at %.3f ticks/ns\n\n",
+                DEFAULT_HEAP_ARITY, MIN_BENCH_SIZE, maxSize,
+                                            CYCLE_COUNTER_NAME, ticksPerNs );
+    printf( "implementation  workload     distribution       size"
+                  "    ns/op  cycles/op   p50 ns   p99 ns  p999 ns"
+                                                          "    max ns\n" );
+
+    fprintf( jsonFile, "{\n  \"benchmark\": \"HeapUtility\",\n" );
+    fprintf( jsonFile, "  \"arity\": %d,\n", DEFAULT_HEAP_ARITY );
+    fprintf( jsonFile, "  \"cycle_counter\": \"%s\",\n", CYCLE_COUNTER_NAME );
+    fprintf( jsonFile, "  \"ticks_per_ns\": %.4f,\n", ticksPerNs );
+    fprintf( jsonFile, "  \"results\": [" );
+
+    state.patients = ( PatientType *)malloc( BULK_CHUNK
+                                                     * sizeof( PatientType ) );
+
+    for( size = MIN_BENCH_SIZE; size <= maxSize && size > 0; size *= 10 )
+       {
+        for( distribution = 0; distribution < DISTRIBUTION_COUNT;
+                                                              distribution++ )
+           {
+            state.distribution = distribution;
+
+            // one at a time, fill then hold at size then drain
+            for( implementation = HEAP_UTILITY_IMPL;
+                         implementation <= REFERENCE_IMPL; implementation++ )
+               {
+                state.implementation = implementation;
+                state.randomState = (uint64_t)size * 2654435761u
+                                                            + distribution + 1;
+
+                if( implementation == BUCKET_QUEUE_IMPL )
+                   {
+                    initializeBucketHeap( &state.heap, DEFAULT_CAPACITY,
+                                         LOWEST_PRIORITY, HIGHEST_PRIORITY );
+                   }
+
+                else
+                   {
+                    initializeHeap( &state.heap, DEFAULT_CAPACITY );
+
+                    setIncrementalResize( &state.heap,
+                                       implementation == INCREMENTAL_IMPL );
+                   }
+
+                state.reference.keys = NULL;
+                state.reference.size = 0;
+                state.reference.capacity = 0;
+                state.reference.nextSequence = 0;
+
+                for( workload = ADD_WORKLOAD; workload <= REMOVE_WORKLOAD;
+                                                                  workload++ )
+                   {
+                    runWorkload( &state, workload, size, ticksPerNs, &result );
+
+                    printResult( jsonFile, &result, firstFlag );
+
+                    firstFlag = false;
+                   }
+
+                clearHeap( &state.heap );
+
+                free( state.reference.keys );
+               }
+
+            // batches through the bulk paths of HeapUtility only
+            state.implementation = HEAP_UTILITY_IMPL;
+
+            initializeHeap( &state.heap, DEFAULT_CAPACITY );
+
+            for( workload = BULK_ADD_WORKLOAD;
+                               workload <= BULK_REMOVE_WORKLOAD; workload++ )
+               {
+                runWorkload( &state, workload, size, ticksPerNs, &result );
+
+                printResult( jsonFile, &result, firstFlag );
+               }
+
+            clearHeap( &state.heap );
+           }
+       }
+
+    fprintf( jsonFile, "\n  ]\n}\n" );
+
+    fclose( jsonFile );
+
+    free( state.patients );
+
+    printf( "\nResults written to %s\n", jsonName );
+
+    // display end program
+    printf( "\nEnd Program\n" );
+
+    // return success
+    return 0;
+   }
+
+/*
+Name: addOne
+Process: adds one patient with the next priority to the heap under test
+Function input/parameters: benchmark state (BenchStateType *)
+Function output/parameters: updated benchmark state (BenchStateType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: nextPriority, addHeapItem, referenceAdd
+*/
+void addOne( BenchStateType *state )
+   {
+    int priority = nextPriority( state );
+
+    if( state->implementation != REFERENCE_IMPL )
+       {
+        addHeapItem( &state->heap, "Bench, Patient", priority,
+                                  (time_t)state->heap.nextSequence );
+       }
+
+    else
+       {
+        referenceAdd( &state->reference, priority );
+       }
+   }
+
+/*
+Name: compareSamples
+Process: orders two latency samples for qsort
+Function input/parameters: samples (const void *), (const void *)
+Function output/parameters: none
+Function output/returned: negative, zero, or positive order (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int compareSamples( const void *one, const void *other )
+   {
+    uint64_t oneSample = *( const uint64_t *)one;
+    uint64_t otherSample = *( const uint64_t *)other;
+
+    return ( oneSample > otherSample ) - ( oneSample < otherSample );
+   }
+
+/*
+Name: getSeconds
+Process: reads the monotonic clock
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: time in seconds (double)
+Device input/---: none
+Device output/---: none
+Dependencies: clock_gettime
+*/
+double getSeconds( void )
+   {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+   }
+
+/*
+Name: nextPriority
+Process: draws the next priority from the state's distribution
+         with a xorshift generator, cheap enough not to skew timings
+Function input/parameters: benchmark state (BenchStateType *)
+Function output/parameters: updated generator state (BenchStateType *)
+Function output/returned: priority (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int nextPriority( BenchStateType *state )
+   {
+    uint64_t bits;
+    int priority = LOWEST_PRIORITY;
+
+    state->randomState ^= state->randomState << 13;
+    state->randomState ^= state->randomState >> 7;
+    state->randomState ^= state->randomState << 17;
+
+    bits = state->randomState;
+
+    if( state->distribution == UNIFORM_DISTRIBUTION )
+       {
+        return (int)( bits % HIGHEST_PRIORITY ) + LOWEST_PRIORITY;
+       }
+
+    if( state->distribution == EQUAL_DISTRIBUTION )
+       {
+        return EQUAL_PRIORITY;
+       }
+
+    // most arrivals are routine, each level up is half as likely
+    while( priority < HIGHEST_PRIORITY && ( bits & 1 ) )
+       {
+        priority++;
+        bits >>= 1;
+       }
+
+    return priority;
+   }
+
+/*
+Name: printResult
+Process: displays one result row and appends it to the json results
+Function input/parameters: json file (FILE *), result (const BenchResultType *),
+                           first result flag (bool)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/monitor: result row displayed
+Device output/file: json result object
+Dependencies: printf, fprintf
+*/
+void printResult( FILE *jsonFile, const BenchResultType *result,
+                                                             bool firstFlag )
+   {
+    printf( "%-14s  %-11s  %-12s  %9d  %7.1f  %9.1f  %7.1f  %7.1f  %7.1f"
+                                                                 "  %8.1f\n",
+             IMPLEMENTATION_NAMES[ result->implementation ],
+             WORKLOAD_NAMES[ result->workload ],
+             DISTRIBUTION_NAMES[ result->distribution ], result->size,
+             result->nsPerOp, result->cyclesPerOp,
+             result->p50, result->p99, result->p999, result->maxNs );
+
+    fprintf( jsonFile, "%s\n    { \"implementation\": \"%s\", "
+             "\"workload\": \"%s\", \"distribution\": \"%s\", "
+             "\"size\": %d, \"operations\": %ld, \"ns_per_op\": %.2f, "
+             "\"cycles_per_op\": %.2f, \"p50_ns\": %.1f, \"p99_ns\": %.1f, "
+             "\"p999_ns\": %.1f, \"max_ns\": %.1f, "
+             "\"comparisons_per_op\": %.2f, "
+             "\"moves_per_op\": %.2f }", firstFlag ? "" : ",",
+             IMPLEMENTATION_NAMES[ result->implementation ],
+             WORKLOAD_NAMES[ result->workload ],
+             DISTRIBUTION_NAMES[ result->distribution ], result->size,
+             result->operations, result->nsPerOp, result->cyclesPerOp,
+             result->p50, result->p99, result->p999, result->maxNs,
+             result->comparisonsPerOp, result->movesPerOp );
+   }
+
+/*
+Name: readCycleCounter
+Process: reads the time stamp counter, or the clock in nanoseconds
+         where there is none
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: counter ticks (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: __rdtsc or getSeconds
+*/
+uint64_t readCycleCounter( void )
+   {
+#if defined( __x86_64__ ) || defined( __i386__ )
+    return __rdtsc();
+#else
+    return (uint64_t)( getSeconds() * NANOSECONDS_PER_SECOND );
+#endif
+   }
+
+/*
+Name: referenceAdd
+Process: appends a key and sifts it up by swapping, doubling the array
+         when full
+Function input/parameters: reference heap (ReferenceHeapType *),
+                           priority (int)
+Function output/parameters: updated reference heap (ReferenceHeapType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: realloc, makeHeapKey
+*/
+void referenceAdd( ReferenceHeapType *reference, int priority )
+   {
+    int index = reference->size, parent;
+    uint64_t swapKey;
+
+    if( reference->size == reference->capacity )
+       {
+        reference->capacity = reference->capacity > 0
+                                      ? reference->capacity * 2 : DEFAULT_CAPACITY;
+
+        reference->keys = ( uint64_t *)realloc( reference->keys,
+                                    reference->capacity * sizeof( uint64_t ) );
+       }
+
+    reference->keys[ index ] = makeHeapKey( priority,
+                                                 reference->nextSequence++ );
+    reference->size++;
+
+    while( index > 0 )
+       {
+        parent = ( index - 1 ) / 2;
+
+        if( reference->keys[ parent ] >= reference->keys[ index ] )
+           {
+            break;
+           }
+
+        swapKey = reference->keys[ parent ];
+        reference->keys[ parent ] = reference->keys[ index ];
+        reference->keys[ index ] = swapKey;
+
+        index = parent;
+       }
+   }
+
+/*
+Name: referenceRemove
+Process: removes the largest key, moves the last key to the root and
+         sifts it down by swapping with the larger child
+Function input/parameters: reference heap (ReferenceHeapType *)
+Function output/parameters: updated reference heap (ReferenceHeapType *)
+Function output/returned: removed key, zero if empty (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint64_t referenceRemove( ReferenceHeapType *reference )
+   {
+    int index = 0, child;
+    uint64_t top, swapKey;
+
+    if( reference->size == 0 )
+       {
+        return 0;
+       }
+
+    top = reference->keys[ 0 ];
+
+    reference->size--;
+    reference->keys[ 0 ] = reference->keys[ reference->size ];
+
+    while( ( child = 2 * index + 1 ) < reference->size )
+       {
+        if( child + 1 < reference->size
+                   && reference->keys[ child + 1 ] > reference->keys[ child ] )
+           {
+            child++;
+           }
+
+        if( reference->keys[ index ] >= reference->keys[ child ] )
+           {
+            break;
+           }
+
+        swapKey = reference->keys[ child ];
+        reference->keys[ child ] = reference->keys[ index ];
+        reference->keys[ index ] = swapKey;
+
+        index = child;
+       }
+
+    return top;
+   }
+
+/*
+Name: removeOne
+Process: removes the highest priority patient from the heap under test
+Function input/parameters: benchmark state (BenchStateType *)
+Function output/parameters: updated benchmark state (BenchStateType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: removeItem, referenceRemove
+*/
+void removeOne( BenchStateType *state )
+   {
+    PatientType removed;
+
+    if( state->implementation != REFERENCE_IMPL )
+       {
+        removeItem( &removed, &state->heap );
+       }
+
+    else
+       {
+        referenceRemove( &state->reference );
+       }
+   }
+
+/*
+Name: runWorkload
+Process: runs one workload, timing the whole loop with the clock and
+         counter, and every operation one by one, each counter reading
+         ending one operation and starting the next, evenly spaced ones
+         are kept for the latency percentiles and the slowest for the
+         maximum, bulk workloads time each chunk call
+         and count its latency per patient
+Function input/parameters: benchmark state (BenchStateType *),
+                           workload (int), heap size (int),
+                           counter ticks per ns (double)
+Function output/parameters: updated benchmark state (BenchStateType *),
+                            result (BenchResultType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: malloc, getHeapStats, getSeconds, readCycleCounter, addOne, 
+              removeOne, nextPriority, setPatientFromData, addHeapItems, 
+              removeTopK, qsort, free
+*/
+void runWorkload( BenchStateType *state, int workload, int size,
+                            double ticksPerNs, BenchResultType *result )
+   {
+    HeapStatsType before, after;
+    uint64_t *samples;
+    uint64_t startTicks, opStart, opEnd, maxTicks = 0;
+    long operations, index, stride, sampleCount = 0, sampleIndex;
+    int chunk, member;
+    double startTime;
+
+    operations = workload == HOLD_WORKLOAD ? HOLD_OPERATIONS : size;
+
+    // bulk samples are whole chunks, the rest every stride operations
+    if( workload >= BULK_ADD_WORKLOAD )
+       {
+        stride = 1;
+       }
+
+    else
+       {
+        stride = ( operations + MAX_LATENCY_SAMPLES - 1 ) / MAX_LATENCY_SAMPLES;
+       }
+
+    samples = ( uint64_t *)malloc( ( operations / stride + 1 )
+                                                       * sizeof( uint64_t ) );
+
+    getHeapStats( &state->heap, &before );
+
+    startTime = getSeconds();
+    startTicks = readCycleCounter();
+
+    if( workload == BULK_ADD_WORKLOAD || workload == BULK_REMOVE_WORKLOAD )
+       {
+        for( index = 0; index < operations; index += chunk )
+           {
+            chunk = operations - index < BULK_CHUNK
+                                      ? (int)( operations - index ) : BULK_CHUNK;
+
+            if( workload == BULK_ADD_WORKLOAD )
+               {
+                for( member = 0; member < chunk; member++ )
+                   {
+                    setPatientFromData( &state->patients[ member ],
+                                "Bench, Patient", nextPriority( state ),
+                                                       (time_t)( index + member ) );
+                   }
+
+                opStart = readCycleCounter();
+
+                addHeapItems( &state->heap, state->patients, chunk, NULL );
+               }
+
+            else
+               {
+                opStart = readCycleCounter();
+
+                removeTopK( &state->heap, chunk, state->patients );
+               }
+
+            samples[ sampleCount ] = ( readCycleCounter() - opStart ) / chunk;
+
+            if( samples[ sampleCount ] > maxTicks )
+               {
+                maxTicks = samples[ sampleCount ];
+               }
+
+            sampleCount++;
+           }
+       }
+
+    else
+       {
+        opStart = readCycleCounter();
+
+        for( index = 0; index < operations; index++ )
+           {
+            if( workload == ADD_WORKLOAD )
+               {
+                addOne( state );
+               }
+
+            else if( workload == REMOVE_WORKLOAD )
+               {
+                removeOne( state );
+               }
+
+            // hold model, the next patient arrives as one is seen
+            else
+               {
+                removeOne( state );
+                addOne( state );
+               }
+
+            opEnd = readCycleCounter();
+
+            if( opEnd - opStart > maxTicks )
+               {
+                maxTicks = opEnd - opStart;
+               }
+
+            if( index % stride == 0 )
+               {
+                samples[ sampleCount ] = opEnd - opStart;
+                sampleCount++;
+               }
+
+            opStart = opEnd;
+           }
+       }
+
+    result->implementation = state->implementation;
+    result->workload = workload;
+    result->distribution = state->distribution;
+    result->size = size;
+    result->operations = operations;
+    result->cyclesPerOp = (double)( readCycleCounter() - startTicks )
+                                                                 / operations;
+    result->nsPerOp = ( getSeconds() - startTime ) * NANOSECONDS_PER_SECOND
+                                                                 / operations;
+
+    // the reference heap leaves these counters untouched
+    getHeapStats( &state->heap, &after );
+
+    result->comparisonsPerOp = (double)( after.counters.comparisons
+                                  - before.counters.comparisons ) / operations;
+    result->movesPerOp = (double)( after.counters.moves
+                                        - before.counters.moves ) / operations;
+
+    qsort( samples, sampleCount, sizeof( uint64_t ), compareSamples );
+
+    sampleIndex = sampleCount - 1;
+
+    result->p50 = samples[ sampleIndex * 50 / 100 ] / ticksPerNs;
+    result->p99 = samples[ sampleIndex * 99 / 100 ] / ticksPerNs;
+    result->p999 = samples[ sampleIndex * 999 / 1000 ] / ticksPerNs;
+    result->maxNs = maxTicks / ticksPerNs;
+
+    free( samples );
+   }
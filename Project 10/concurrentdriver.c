@@ -0,0 +1,418 @@
+// header files
+#include <time.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "ConcurrentHeapUtility.c"
+#include "MultiQueueUtility.c"
+#include "ShardedHeapUtility.c"
+
+// constants
+const int DEFAULT_PREFILL = 100000;
+const int DEFAULT_OPS_PER_RUN = 2000000;
+const int MAX_THREADS = 64;
+const int LOWEST_PRIORITY = 1;
+const int HIGHEST_PRIORITY = 10;
+const double NANOSECONDS_PER_SECOND = 1000000000.0;
+
+// heap kinds compared by each trial
+const int GLOBAL_MUTEX_TRIAL = 0;
+const int NODE_LOCK_TRIAL = 1;
+const int MULTI_QUEUE_TRIAL = 2;
+const int SHARDED_TRIAL = 3;
+
+// data structures
+typedef struct WorkerStruct
+   {
+    ConcurrentHeapType *concurrentHeap;
+
+    HeapType *lockedHeap;
+
+    MultiQueueType *multiQueue;
+
+    ShardedHeapType *shardedHeap;
+
+    int shardIndex;
+
+    pthread_mutex_t *globalLock;
+
+    int operations;
+
+    unsigned int seed;
+   } WorkerType;
+
+// prototypes
+double getSeconds( void );
+void *runConcurrentWorker( void *workerPtr );
+void *runLockedWorker( void *workerPtr );
+void *runMultiQueueWorker( void *workerPtr );
+void *runShardedWorker( void *workerPtr );
+double runTrial( int threadCount, int prefill, int totalOps, int trialKind,
+                                                RankErrorStatsType *stats );
+
+int main( int argc, char *argv[] )
+   {
+    int threadCount;
+    int prefill = DEFAULT_PREFILL, totalOps = DEFAULT_OPS_PER_RUN;
+    double lockedRate, concurrentRate, multiQueueRate, shardedRate;
+    RankErrorStatsType stats;
+
+    // optional prefill size and total operations per trial
+    if( argc > 1 )
+       {
+        prefill = atoi( argv[ 1 ] );
+       }
+
+    if( argc > 2 )
+       {
+        totalOps = atoi( argv[ 2 ] );
+       }
+
+    // title
+    printf( "\nConcurrent Heap Throughput\n" );
+    printf( "==========================\n" );
+    printf( "prefill %d, %d add/remove pairs per trial\n\n", 
+                                                       prefill, totalOps / 2 );
+    printf( "threads  global mutex (Mops/s)  node locks (Mops/s)"
+                     "  multiqueue (Mops/s)  sharded (Mops/s)\n" );
+
+    for( threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2 )
+       {
+        lockedRate = runTrial( threadCount, prefill, totalOps, 
+                                                 GLOBAL_MUTEX_TRIAL, NULL );
+        concurrentRate = runTrial( threadCount, prefill, totalOps, 
+                                                    NODE_LOCK_TRIAL, NULL );
+        multiQueueRate = runTrial( threadCount, prefill, totalOps, 
+                                                  MULTI_QUEUE_TRIAL, NULL );
+        shardedRate = runTrial( threadCount, prefill, totalOps, 
+                                                      SHARDED_TRIAL, NULL );
+
+        printf( "%7d  %21.3f  %19.3f  %19.3f  %16.3f\n", threadCount, 
+                   lockedRate, concurrentRate, multiQueueRate, shardedRate );
+       }
+
+    // rank error is measured in its own runs so logging does not skew rates
+    printf( "\nMultiQueue rank error (removals that skipped better keys)\n" );
+    printf( "threads  sub-heaps      mean   p99  p99.9    max\n" );
+
+    for( threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2 )
+       {
+        runTrial( threadCount, prefill, totalOps, MULTI_QUEUE_TRIAL, &stats );
+
+        printf( "%7d  %9d  %8.2f  %4ld  %5ld  %5ld\n", threadCount, 
+                        threadCount * DEFAULT_QUEUES_PER_THREAD, 
+                        stats.meanRank, stats.p99Rank, stats.p999Rank, 
+                                                           stats.maxRank );
+       }
+
+    // display end program
+    printf( "\nEnd Program\n" );
+
+    // return success
+    return 0;
+   }
+
+/*
+Name: getSeconds
+Process: reads the monotonic clock
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: time in seconds (double)
+Device input/---: none
+Device output/---: none
+Dependencies: clock_gettime
+*/
+double getSeconds( void )
+   {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+   }
+
+/*
+Name: runConcurrentWorker
+Process: runs add then remove pairs on the node locked heap
+Function input/parameters: worker data (void *)
+Function output/parameters: none
+Function output/returned: none (void *)
+Device input/---: none
+Device output/---: none
+Dependencies: addConcurrentItem, removeConcurrentItem, rand_r
+*/
+void *runConcurrentWorker( void *workerPtr )
+   {
+    WorkerType *worker = ( WorkerType *)workerPtr;
+    PatientType removed;
+    int index, priority, range = HIGHEST_PRIORITY - LOWEST_PRIORITY + 1;
+
+    for( index = 0; index < worker->operations; index += 2 )
+       {
+        priority = rand_r( &worker->seed ) % range + LOWEST_PRIORITY;
+
+        addConcurrentItem( worker->concurrentHeap, "Worker, Patient", 
+                                                           priority, 0 );
+
+        removeConcurrentItem( worker->concurrentHeap, &removed );
+       }
+
+    return NULL;
+   }
+
+/*
+Name: runLockedWorker
+Process: runs add then remove pairs on a single heap behind one mutex
+Function input/parameters: worker data (void *)
+Function output/parameters: none
+Function output/returned: none (void *)
+Device input/---: none
+Device output/---: none
+Dependencies: addHeapItem, removeItem, pthread_mutex_lock, 
+              pthread_mutex_unlock, rand_r
+*/
+void *runLockedWorker( void *workerPtr )
+   {
+    WorkerType *worker = ( WorkerType *)workerPtr;
+    PatientType removed;
+    int index, priority, range = HIGHEST_PRIORITY - LOWEST_PRIORITY + 1;
+
+    for( index = 0; index < worker->operations; index += 2 )
+       {
+        priority = rand_r( &worker->seed ) % range + LOWEST_PRIORITY;
+
+        pthread_mutex_lock( worker->globalLock );
+
+        addHeapItem( worker->lockedHeap, "Worker, Patient", priority, 0 );
+
+        pthread_mutex_unlock( worker->globalLock );
+
+        pthread_mutex_lock( worker->globalLock );
+
+        removeItem( &removed, worker->lockedHeap );
+
+        pthread_mutex_unlock( worker->globalLock );
+       }
+
+    return NULL;
+   }
+
+/*
+Name: runMultiQueueWorker
+Process: runs add then remove pairs on the relaxed multiqueue
+Function input/parameters: worker data (void *)
+Function output/parameters: none
+Function output/returned: none (void *)
+Device input/---: none
+Device output/---: none
+Dependencies: addMultiQueueItem, removeMultiQueueItem, rand_r
+*/
+void *runMultiQueueWorker( void *workerPtr )
+   {
+    WorkerType *worker = ( WorkerType *)workerPtr;
+    PatientType removed;
+    int index, priority, range = HIGHEST_PRIORITY - LOWEST_PRIORITY + 1;
+
+    for( index = 0; index < worker->operations; index += 2 )
+       {
+        priority = rand_r( &worker->seed ) % range + LOWEST_PRIORITY;
+
+        addMultiQueueItem( worker->multiQueue, "Worker, Patient", 
+                                                           priority, 0 );
+
+        removeMultiQueueItem( worker->multiQueue, &removed );
+       }
+
+    return NULL;
+   }
+
+/*
+Name: runShardedWorker
+Process: runs add then remove pairs on the worker's own shard,
+         stealing from other shards when theirs hold better entries
+Function input/parameters: worker data (void *)
+Function output/parameters: none
+Function output/returned: none (void *)
+Device input/---: none
+Device output/---: none
+Dependencies: addShardedItem, removeShardedItem, rand_r
+*/
+void *runShardedWorker( void *workerPtr )
+   {
+    WorkerType *worker = ( WorkerType *)workerPtr;
+    PatientType removed;
+    int index, priority, range = HIGHEST_PRIORITY - LOWEST_PRIORITY + 1;
+
+    for( index = 0; index < worker->operations; index += 2 )
+       {
+        priority = rand_r( &worker->seed ) % range + LOWEST_PRIORITY;
+
+        addShardedItem( worker->shardedHeap, worker->shardIndex, 
+                                    "Worker, Patient", priority, 0 );
+
+        removeShardedItem( worker->shardedHeap, worker->shardIndex, 
+                                                                 &removed );
+       }
+
+    return NULL;
+   }
+
+/*
+Name: runTrial
+Process: prefills a heap, runs the given number of threads over it,
+         reports throughput in millions of operations per second
+Function input/parameters: thread count (int), prefill size (int),
+                           total operations (int), heap kind (int),
+                           rank statistics or NULL to skip tracking 
+                           (RankErrorStatsType *)
+Function output/parameters: multiqueue rank error (RankErrorStatsType *)
+Function output/returned: throughput in Mops/s, zero if the heap could
+                          not be created (double)
+Device input/---: none
+Device output/---: none
+Dependencies: initializeConcurrentHeap, initializeHeap, initializeMultiQueue,
+              initializeShardedHeap, enableRankTracking, addConcurrentItem,
+              addHeapItem, addMultiQueueItem, addShardedItem, pthread_create,
+              pthread_join, getSeconds, getRankErrorStats
+*/
+double runTrial( int threadCount, int prefill, int totalOps, int trialKind,
+                                                 RankErrorStatsType *stats )
+   {
+    ConcurrentHeapType concurrentHeap;
+    HeapType lockedHeap;
+    MultiQueueType multiQueue;
+    ShardedHeapType shardedHeap;
+    pthread_mutex_t globalLock;
+    void *( *runWorker )( void * );
+    pthread_t threads[ MAX_THREADS ];
+    WorkerType workers[ MAX_THREADS ];
+    int index;
+    double startTime, elapsed;
+
+    // room for the prefill plus one in flight entry per thread
+    if( trialKind == NODE_LOCK_TRIAL )
+       {
+        initializeConcurrentHeap( &concurrentHeap, prefill + MAX_THREADS );
+
+        runWorker = runConcurrentWorker;
+       }
+
+    else if( trialKind == MULTI_QUEUE_TRIAL )
+       {
+        if( !initializeMultiQueue( &multiQueue, threadCount, 0, 
+                                                 prefill / threadCount + 1 ) )
+           {
+            return 0.0;
+           }
+
+        // one add and one remove event per operation and prefill entry
+        if( stats != NULL )
+           {
+            enableRankTracking( &multiQueue, 2L * prefill + totalOps );
+           }
+
+        runWorker = runMultiQueueWorker;
+       }
+
+    else if( trialKind == SHARDED_TRIAL )
+       {
+        if( !initializeShardedHeap( &shardedHeap, threadCount, 
+                                             prefill / threadCount + 1, 0 ) )
+           {
+            return 0.0;
+           }
+
+        runWorker = runShardedWorker;
+       }
+
+    else
+       {
+        initializeHeap( &lockedHeap, prefill + MAX_THREADS );
+
+        pthread_mutex_init( &globalLock, NULL );
+
+        runWorker = runLockedWorker;
+       }
+
+    srand( 1 );
+
+    for( index = 0; index < prefill; index++ )
+       {
+        if( trialKind == NODE_LOCK_TRIAL )
+           {
+            addConcurrentItem( &concurrentHeap, "Prefill, Patient", 
+                                            rand() % HIGHEST_PRIORITY + 1, 0 );
+           }
+
+        else if( trialKind == MULTI_QUEUE_TRIAL )
+           {
+            addMultiQueueItem( &multiQueue, "Prefill, Patient", 
+                                            rand() % HIGHEST_PRIORITY + 1, 0 );
+           }
+
+        // deal the prefill out so every worker starts with a full shard
+        else if( trialKind == SHARDED_TRIAL )
+           {
+            addShardedItem( &shardedHeap, index % threadCount, 
+                        "Prefill, Patient", rand() % HIGHEST_PRIORITY + 1, 0 );
+           }
+
+        else
+           {
+            addHeapItem( &lockedHeap, "Prefill, Patient", 
+                                            rand() % HIGHEST_PRIORITY + 1, 0 );
+           }
+       }
+
+    startTime = getSeconds();
+
+    for( index = 0; index < threadCount; index++ )
+       {
+        workers[ index ].concurrentHeap = &concurrentHeap;
+        workers[ index ].lockedHeap = &lockedHeap;
+        workers[ index ].multiQueue = &multiQueue;
+        workers[ index ].shardedHeap = &shardedHeap;
+        workers[ index ].shardIndex = index;
+        workers[ index ].globalLock = &globalLock;
+        workers[ index ].operations = totalOps / threadCount;
+        workers[ index ].seed = (unsigned int)index + 1;
+
+        pthread_create( &threads[ index ], NULL, runWorker, 
+                                                          &workers[ index ] );
+       }
+
+    for( index = 0; index < threadCount; index++ )
+       {
+        pthread_join( threads[ index ], NULL );
+       }
+
+    elapsed = getSeconds() - startTime;
+
+    if( trialKind == NODE_LOCK_TRIAL )
+       {
+        clearConcurrentHeap( &concurrentHeap );
+       }
+
+    else if( trialKind == MULTI_QUEUE_TRIAL )
+       {
+        if( stats != NULL )
+           {
+            getRankErrorStats( &multiQueue, stats );
+           }
+
+        clearMultiQueue( &multiQueue );
+       }
+
+    else if( trialKind == SHARDED_TRIAL )
+       {
+        clearShardedHeap( &shardedHeap );
+       }
+
+    else
+       {
+        clearHeap( &lockedHeap );
+
+        pthread_mutex_destroy( &globalLock );
+       }
+
+    return totalOps / elapsed / 1000000.0;
+   }
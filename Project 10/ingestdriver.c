@@ -0,0 +1,206 @@
+// header files
+#include <time.h>
+#include <stdio.h>
+#include "IngestUtility.c"
+
+// constants
+const int DEFAULT_RECORD_COUNT = 2000000;
+const int DEFAULT_CAPACITY = 10;
+const int LOWEST_PRIORITY = 1;
+const int HIGHEST_PRIORITY = 10;
+const double BYTES_PER_MEGABYTE = 1048576.0;
+
+// admission log names are built from these, "Last, First"
+const char *LAST_NAMES[] = { "Johnson", "Elliott", "Reyes", "Nguyen",
+                             "Okafor", "Schmidt", "Patel", "Kowalski" };
+const char *FIRST_NAMES[] = { "Robert", "Cayley", "Connor", "Mai",
+                              "Chidi", "Greta", "Anika", "Tomasz" };
+const int NAME_CHOICES = 8;
+
+// prototypes
+bool ingestAndReport( const char *label, const char *fileName );
+bool writeBinaryFile( const char *fileName, int recordCount );
+bool writeCsvFile( const char *fileName, int recordCount );
+
+int main( int argc, char *argv[] )
+   {
+    const char *csvName = "ingestdriver.csv", *binaryName = "ingestdriver.bin";
+    int recordCount = DEFAULT_RECORD_COUNT;
+
+    // title
+    printf( "\nPatient File Ingest\n" );
+    printf( "===================\n" );
+    printf( "format       records  rejected        MB   seconds"
+                                                   "  Mrecords/s     MB/s\n" );
+
+    // an existing admission log given by name is ingested as is
+    if( argc > 1 && atoi( argv[ 1 ] ) <= 0 )
+       {
+        if( !ingestAndReport( "file", argv[ 1 ] ) )
+           {
+            printf( "\nUnable to ingest %s\n", argv[ 1 ] );
+
+            return 1;
+           }
+       }
+
+    else
+       {
+        if( argc > 1 )
+           {
+            recordCount = atoi( argv[ 1 ] );
+           }
+
+        if( !writeCsvFile( csvName, recordCount )
+                               || !writeBinaryFile( binaryName, recordCount ) )
+           {
+            printf( "\nUnable to write the generated admission logs\n" );
+
+            return 1;
+           }
+
+        ingestAndReport( "csv", csvName );
+        ingestAndReport( "binary", binaryName );
+
+        remove( csvName );
+        remove( binaryName );
+       }
+
+    // display end program
+    printf( "\nEnd Program\n" );
+
+    // return success
+    return 0;
+   }
+
+/*
+Name: ingestAndReport
+Process: ingests one patient file into a fresh heap, reports the
+         counts and rates, checks the ingested heap by removing its top
+Function input/parameters: format label (const char *),
+                           file name (const char *)
+Function output/parameters: none
+Function output/returned: Boolean result, false if ingest failed (bool)
+Device input/---: patient file
+Device output/monitor: ingest results displayed
+Dependencies: initializeHeap, ingestPatientFile, printf, removeItem,
+              clearHeap
+*/
+bool ingestAndReport( const char *label, const char *fileName )
+   {
+    HeapType heap;
+    IngestStatsType stats;
+    PatientType removed;
+    bool successFlag;
+
+    initializeHeap( &heap, DEFAULT_CAPACITY );
+
+    successFlag = ingestPatientFile( &heap, fileName, &stats );
+
+    if( successFlag )
+       {
+        printf( "%-8s  %10ld  %8ld  %8.1f  %8.3f  %10.2f  %7.1f\n", label,
+                 stats.recordCount, stats.rejectCount,
+                 stats.byteCount / BYTES_PER_MEGABYTE, stats.seconds,
+                 stats.recordCount / stats.seconds / 1000000.0,
+                 stats.byteCount / BYTES_PER_MEGABYTE / stats.seconds );
+
+        if( !isEmpty( heap ) )
+           {
+            removeItem( &removed, &heap );
+
+            printf( "          first out: %s, priority %d\n",
+                                      removed.patientName, removed.priority );
+           }
+       }
+
+    clearHeap( &heap );
+
+    return successFlag;
+   }
+
+/*
+Name: writeBinaryFile
+Process: writes a generated admission log as packed binary records
+Function input/parameters: file name (const char *), record count (int)
+Function output/parameters: none
+Function output/returned: Boolean result, false if not written (bool)
+Device input/---: none
+Device output/---: patient file
+Dependencies: fopen, encodePatientFileHeader, fwrite, snprintf, rand,
+              encodeBinaryPatient, fclose
+*/
+bool writeBinaryFile( const char *fileName, int recordCount )
+   {
+    FILE *file = fopen( fileName, "wb" );
+    unsigned char record[ MAX_BINARY_RECORD_SIZE ];
+    char name[ STD_STR_LEN ];
+    const char *lastName, *firstName;
+    size_t size;
+    int index;
+
+    if( file == NULL )
+       {
+        return false;
+       }
+
+    size = encodePatientFileHeader( record, (uint64_t)recordCount );
+
+    fwrite( record, 1, size, file );
+
+    srand( 1 );
+
+    for( index = 0; index < recordCount; index++ )
+       {
+        lastName = LAST_NAMES[ rand() % NAME_CHOICES ];
+        firstName = FIRST_NAMES[ rand() % NAME_CHOICES ];
+
+        snprintf( name, STD_STR_LEN, "%s, %s", lastName, firstName );
+
+        size = encodeBinaryPatient( record, name,
+                                  rand() % HIGHEST_PRIORITY + LOWEST_PRIORITY,
+                                                                (time_t)index );
+
+        fwrite( record, 1, size, file );
+       }
+
+    return fclose( file ) == 0;
+   }
+
+/*
+Name: writeCsvFile
+Process: writes a generated admission log as csv with a header row
+Function input/parameters: file name (const char *), record count (int)
+Function output/parameters: none
+Function output/returned: Boolean result, false if not written (bool)
+Device input/---: none
+Device output/---: patient file
+Dependencies: fopen, fprintf, rand, fclose
+*/
+bool writeCsvFile( const char *fileName, int recordCount )
+   {
+    FILE *file = fopen( fileName, "w" );
+    const char *lastName, *firstName;
+    int index;
+
+    if( file == NULL )
+       {
+        return false;
+       }
+
+    fprintf( file, "name,priority,timeIn\n" );
+
+    // same draws in the same order as the binary log
+    srand( 1 );
+
+    for( index = 0; index < recordCount; index++ )
+       {
+        lastName = LAST_NAMES[ rand() % NAME_CHOICES ];
+        firstName = FIRST_NAMES[ rand() % NAME_CHOICES ];
+
+        fprintf( file, "\"%s, %s\",%d,%d\n", lastName, firstName,
+                         rand() % HIGHEST_PRIORITY + LOWEST_PRIORITY, index );
+       }
+
+    return fclose( file ) == 0;
+   }
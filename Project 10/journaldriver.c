@@ -0,0 +1,311 @@
+// header files
+#include <time.h>
+#include <stdio.h>
+#include "JournalUtility.c"
+
+// constants
+const int DEFAULT_RECORD_COUNT = 1000000;
+const int SYNC_EVERY_RECORD_COUNT = 2000;
+const int LOWEST_PRIORITY = 1;
+const int HIGHEST_PRIORITY = 10;
+const double NANOSECONDS_PER_SECOND = 1000000000.0;
+
+// group commit windows compared, zero syncs every record
+const int SYNC_INTERVALS_MS[] = { 0, 1, 5, 20 };
+const int SYNC_INTERVAL_COUNT = 4;
+
+// names given in turn, recovery must bring back each patient's own name
+const char *PATIENT_NAMES[] = { "Adams, Ruth", "Baker, Omar", "Chen, Li",
+                                "Diaz, Marta", "Evans, Tom", "Fox, Nadia",
+                                "Gray, Ian", "Hill, Priya" };
+const int PATIENT_NAME_COUNT = 8;
+
+// prototypes
+bool checkRecoveredHeap( HeapType *heap, const PatientType *waiting,
+                                                          int waitingCount );
+double getSeconds( void );
+void removeJournalFiles( const char *baseName, uint32_t generation );
+double runJournalTrial( const char *baseName, int syncIntervalMs,
+                                           int addCount, long *syncCount,
+                                    PatientType *waiting, int *waitingCount );
+
+int main( int argc, char *argv[] )
+   {
+    JournaledHeapType journaled;
+    JournalConfigType config;
+    PatientType *waiting;
+    const char *baseName = "journaldriver";
+    int recordCount = DEFAULT_RECORD_COUNT, addCount, index, waitingCount = 0;
+    long syncCount;
+    double rate, startTime, elapsed;
+    bool matchFlag;
+
+    // optional add count and journal file base name
+    if( argc > 1 )
+       {
+        recordCount = atoi( argv[ 1 ] );
+       }
+
+    if( argc > 2 )
+       {
+        baseName = argv[ 2 ];
+       }
+
+    // title
+    printf( "\nJournaled Heap Durability and Recovery\n" );
+    printf( "======================================\n" );
+    printf( "%d adds, then half removed and a quarter reprioritized\n\n",
+                                                               recordCount );
+    printf( "sync window (ms)     adds  ops (Kops/s)   fsyncs\n" );
+
+    // patients still waiting when the last trial stops, in priority order
+    waiting = ( PatientType *)malloc( recordCount * sizeof( PatientType ) );
+
+    for( index = 0; index < SYNC_INTERVAL_COUNT; index++ )
+       {
+        // one fsync per record is far slower, keep that run short
+        addCount = SYNC_INTERVALS_MS[ index ] == 0
+                                      && recordCount > SYNC_EVERY_RECORD_COUNT
+                                   ? SYNC_EVERY_RECORD_COUNT : recordCount;
+
+        rate = runJournalTrial( baseName, SYNC_INTERVALS_MS[ index ],
+                                 addCount, &syncCount, 
+                                 index == SYNC_INTERVAL_COUNT - 1 ? waiting : NULL,
+                                                               &waitingCount );
+
+        printf( "%16d  %7d  %12.1f  %7ld\n", SYNC_INTERVALS_MS[ index ],
+                                            addCount, rate / 1000.0, syncCount );
+       }
+
+    // the last trial left every record in the journal, time its replay
+    config.syncIntervalMs = DEFAULT_SYNC_INTERVAL_MS;
+    config.syncBatchBytes = DEFAULT_SYNC_BATCH_BYTES;
+    config.snapshotIntervalMs = 0;
+
+    startTime = getSeconds();
+
+    if( !openJournaledHeap( &journaled, baseName, config, 0 ) )
+       {
+        printf( "\nRecovery failed, snapshot damaged or journal not created\n" );
+
+        free( waiting );
+
+        return 1;
+       }
+
+    elapsed = getSeconds() - startTime;
+
+    printf( "\nRecovery, snapshot and journal replay then bulk heapify\n" );
+    printf( "records replayed  patients  replay (s)  Mrecords/s"
+                                                   "  open with snapshot (s)\n" );
+    printf( "%16ld  %8d  %10.3f  %10.2f  %22.3f\n", journaled.replayCount,
+                 journaled.heap.size, journaled.replaySeconds,
+                 journaled.replayCount / journaled.replaySeconds / 1000000.0,
+                                                                    elapsed );
+
+    // the recovered heap must give back the waiting patients in order
+    matchFlag = checkRecoveredHeap( &journaled.heap, waiting, waitingCount );
+
+    printf( "\nRecovered order and names %s the heap before the crash\n",
+                                        matchFlag ? "match" : "DO NOT match" );
+
+    closeJournaledHeap( &journaled );
+
+    removeJournalFiles( baseName, journaled.generation );
+
+    free( waiting );
+
+    if( !matchFlag )
+       {
+        return 1;
+       }
+
+    // display end program
+    printf( "\nEnd Program\n" );
+
+    // return success
+    return 0;
+   }
+
+/*
+Name: checkRecoveredHeap
+Process: drains the recovered heap, comparing each removal's name,
+         priority, and time in with the patient waiting at that place
+         before the crash, displays the first difference found
+Function input/parameters: recovered heap (HeapType *),
+                           patients waiting before the crash in priority
+                           order (const PatientType *), their count (int)
+Function output/parameters: empty heap data (HeapType *)
+Function output/returned: Boolean result, true if every patient
+                          matches in order (bool)
+Device input/---: none
+Device output/monitor: first difference displayed
+Dependencies: removeItem, compareString, printf
+*/
+bool checkRecoveredHeap( HeapType *heap, const PatientType *waiting,
+                                                          int waitingCount )
+   {
+    PatientType removed;
+    int index;
+
+    if( heap->size != waitingCount )
+       {
+        printf( "\n%d patients recovered, %d were waiting\n", heap->size,
+                                                               waitingCount );
+
+        return false;
+       }
+
+    for( index = 0; index < waitingCount; index++ )
+       {
+        removeItem( &removed, heap );
+
+        if( compareString( removed.patientName,
+                                        waiting[ index ].patientName ) != 0
+                         || removed.priority != waiting[ index ].priority
+                         || removed.timeIn != waiting[ index ].timeIn )
+           {
+            printf( "\nremoval %d is %s/%d/%ld, expected %s/%d/%ld\n", index,
+                      removed.patientName, removed.priority,
+                      (long)removed.timeIn, waiting[ index ].patientName,
+                      waiting[ index ].priority, (long)waiting[ index ].timeIn );
+
+            return false;
+           }
+       }
+
+    return true;
+   }
+
+/*
+Name: getSeconds
+Process: reads the monotonic clock
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: time in seconds (double)
+Device input/---: none
+Device output/---: none
+Dependencies: clock_gettime
+*/
+double getSeconds( void )
+   {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+   }
+
+/*
+Name: removeJournalFiles
+Process: removes the snapshot and the journal of the given generation
+Function input/parameters: base name (const char *), generation (uint32_t)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/---: snapshot and journal files removed
+Dependencies: snprintf, getJournalFileName, unlink
+*/
+void removeJournalFiles( const char *baseName, uint32_t generation )
+   {
+    char fileName[ MAX_JOURNAL_PATH ];
+
+    snprintf( fileName, MAX_JOURNAL_PATH, "%s.snapshot", baseName );
+
+    unlink( fileName );
+
+    getJournalFileName( fileName, baseName, generation );
+
+    unlink( fileName );
+   }
+
+/*
+Name: runJournalTrial
+Process: starts a fresh journaled heap, adds patients, removes half,
+         reprioritizes a quarter, then stops as if crashed with only
+         the files kept, reports operations per second, when asked
+         first drains the heap in memory, which is not journaled,
+         to save the patients still waiting in priority order
+Function input/parameters: base name (const char *),
+                           sync window in ms (int), add count (int),
+                           buffer for waiting patients or NULL
+                           (PatientType *)
+Function output/parameters: fsyncs issued (long *), waiting patients in
+                            priority order (PatientType *) and their 
+                            count (int *) when a buffer is given
+Function output/returned: throughput in operations per second (double)
+Device input/---: none
+Device output/---: snapshot and journal files
+Dependencies: removeJournalFiles, openJournaledHeap, journalAddItem,
+              journalUpdatePriority, journalRemoveItem, drainSorted,
+              closeJournaledHeap, getSeconds, malloc, free
+*/
+double runJournalTrial( const char *baseName, int syncIntervalMs,
+                                           int addCount, long *syncCount,
+                                    PatientType *waiting, int *waitingCount )
+   {
+    JournaledHeapType journaled;
+    JournalConfigType config;
+    PatientType removed;
+    int *handles, index, operations = 0;
+    double startTime, elapsed;
+
+    config.syncIntervalMs = syncIntervalMs;
+    config.syncBatchBytes = DEFAULT_SYNC_BATCH_BYTES;
+    config.snapshotIntervalMs = 0;
+
+    // start from an empty heap, not the last trial's files
+    removeJournalFiles( baseName, 0 );
+    removeJournalFiles( baseName, 1 );
+
+    openJournaledHeap( &journaled, baseName, config, addCount );
+
+    handles = ( int *)malloc( addCount * sizeof( int ) );
+
+    srand( 1 );
+
+    startTime = getSeconds();
+
+    for( index = 0; index < addCount; index++ )
+       {
+        handles[ index ] = journalAddItem( &journaled,
+                                 PATIENT_NAMES[ index % PATIENT_NAME_COUNT ],
+                                   rand() % HIGHEST_PRIORITY + LOWEST_PRIORITY,
+                                                             (time_t)index );
+       }
+
+    operations += addCount;
+
+    // every fourth patient changes triage level
+    for( index = 0; index < addCount; index += 4 )
+       {
+        journalUpdatePriority( &journaled, handles[ index ],
+                                 rand() % HIGHEST_PRIORITY + LOWEST_PRIORITY );
+
+        operations++;
+       }
+
+    for( index = 0; index < addCount / 2; index++ )
+       {
+        journalRemoveItem( &journaled, &removed );
+
+        operations++;
+       }
+
+    elapsed = getSeconds() - startTime;
+
+    // the heap in memory is lost in the crash, keep what it held
+    if( waiting != NULL )
+       {
+        *waitingCount = drainSorted( &journaled.heap, waiting );
+       }
+
+    // closing syncs the tail, the journal then holds every operation
+    closeJournaledHeap( &journaled );
+
+    *syncCount = journaled.syncCount;
+
+    free( handles );
+
+    return operations / elapsed;
+   }
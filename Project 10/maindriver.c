@@ -17,7 +17,7 @@ int getRandBetween( int low, int high );
 int main( int argc, char *argv[] )
    {
     HeapType heap;
-    PatientType removedPatient;
+    PatientType *removedPatients;
     int priority;
     time_t currentTime; 
 
@@ -130,12 +130,13 @@ int main( int argc, char *argv[] )
 
     
 
-    // remove patients
-    while( !isEmpty( heap ) )
-       {
-        removeItem( &removedPatient, &heap );
+    // remove patients, drained in priority order into one buffer
+    removedPatients = ( PatientType *)malloc( 
+                                        heap.size * sizeof( PatientType ) );
 
-       }
+    drainSorted( &heap, removedPatients );
+
+    free( removedPatients );
 
     
   
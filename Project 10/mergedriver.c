@@ -0,0 +1,244 @@
+// header files
+#include <time.h>
+#include <stdio.h>
+#include "MeldableHeapUtility.c"
+
+// constants
+const int MIN_MERGE_SIZE = 1000;
+const int DEFAULT_MAX_SIZE = 1000000;
+const int MAX_MERGE_SIZE = 10000000;
+const int DEFAULT_CAPACITY = 10;
+const int LOWEST_PRIORITY = 1;
+const int HIGHEST_PRIORITY = 10;
+const double MICROSECONDS_PER_SECOND = 1000000.0;
+
+// ways of folding one ward's queue into another
+const int REINSERT_METHOD = 0;
+const int ARRAY_MERGE_METHOD = 1;
+const int PAIRING_MERGE_METHOD = 2;
+const int BUCKET_MERGE_METHOD = 3;
+const int METHOD_COUNT = 4;
+const char *METHOD_NAMES[] = { "remove/add", "mergeHeaps", "pairing",
+                               "bucket merge" };
+
+// prototypes
+double getSeconds( void );
+int nextPriority( uint64_t *randomState );
+void runMerge( int method, int size );
+
+int main( int argc, char *argv[] )
+   {
+    int maxSize = DEFAULT_MAX_SIZE, size, method;
+
+    // optional largest size of each ward
+    if( argc > 1 )
+       {
+        maxSize = atoi( argv[ 1 ] );
+
+        if( maxSize > MAX_MERGE_SIZE )
+           {
+            maxSize = MAX_MERGE_SIZE;
+           }
+       }
+
+    // title
+    printf( "\nWard Merge Benchmark\n" );
+    printf( "====================\n" );
+    printf( "two wards of equal size merged, then the first patient seen\n\n" );
+    printf( "method            size   merge us  first remove us  order\n" );
+
+    for( size = MIN_MERGE_SIZE; size <= maxSize && size > 0; size *= 10 )
+       {
+        for( method = REINSERT_METHOD; method < METHOD_COUNT; method++ )
+           {
+            runMerge( method, size );
+           }
+       }
+
+    // display end program
+    printf( "\nEnd Program\n" );
+
+    // return success
+    return 0;
+   }
+
+/*
+Name: getSeconds
+Process: reads the monotonic clock
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: time in seconds (double)
+Device input/---: none
+Device output/---: none
+Dependencies: clock_gettime
+*/
+double getSeconds( void )
+   {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return now.tv_sec + now.tv_nsec / 1000000000.0;
+   }
+
+/*
+Name: nextPriority
+Process: draws a uniform priority with a xorshift generator
+Function input/parameters: generator state (uint64_t *)
+Function output/parameters: updated generator state (uint64_t *)
+Function output/returned: priority (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int nextPriority( uint64_t *randomState )
+   {
+    *randomState ^= *randomState << 13;
+    *randomState ^= *randomState >> 7;
+    *randomState ^= *randomState << 17;
+
+    return (int)( *randomState % HIGHEST_PRIORITY ) + LOWEST_PRIORITY;
+   }
+
+/*
+Name: runMerge
+Process: fills two wards of the given size, times folding the second
+         into the first and the first removal after it, a pairing heap
+         defers its work to that removal, then drains the merged ward
+         checking every patient is there in priority order, the bucket
+         merge method merges two bucket queue wards with mergeHeaps
+Function input/parameters: method (int), ward size (int)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/monitor: merge timings displayed
+Dependencies: initializeHeap, initializeBucketHeap, initializeNodePool,
+              initializeMeldableHeap,
+              nextPriority, addHeapItem, addMeldableItem, getSeconds,
+              removeItem, mergeHeaps, mergeMeldableHeaps,
+              removeMeldableItem, printf, clearHeap, clearNodePool
+*/
+void runMerge( int method, int size )
+   {
+    HeapType dest, src;
+    NodePoolType pool;
+    MeldableHeapType meldDest, meldSrc;
+    PatientType moved;
+    uint64_t randomState = (uint64_t)size * 2654435761u + 1;
+    int index, removedCount = 0, lastPriority = HIGHEST_PRIORITY;
+    double startTime, mergeTime, removeTime;
+    bool orderedFlag = true, moreFlag = true;
+
+    if( method == PAIRING_MERGE_METHOD )
+       {
+        initializeNodePool( &pool, 2 * size );
+        initializeMeldableHeap( &meldDest, &pool );
+        initializeMeldableHeap( &meldSrc, &pool );
+
+        for( index = 0; index < 2 * size; index++ )
+           {
+            addMeldableItem( index < size ? &meldDest : &meldSrc,
+                                 "Ward, Patient", nextPriority( &randomState ),
+                                                               (time_t)index );
+           }
+
+        startTime = getSeconds();
+
+        mergeMeldableHeaps( &meldDest, &meldSrc );
+
+        mergeTime = getSeconds() - startTime;
+        startTime = getSeconds();
+
+        removeMeldableItem( &moved, &meldDest );
+
+        removeTime = getSeconds() - startTime;
+       }
+
+    else
+       {
+        if( method == BUCKET_MERGE_METHOD )
+           {
+            initializeBucketHeap( &dest, DEFAULT_CAPACITY, LOWEST_PRIORITY,
+                                                           HIGHEST_PRIORITY );
+            initializeBucketHeap( &src, DEFAULT_CAPACITY, LOWEST_PRIORITY,
+                                                           HIGHEST_PRIORITY );
+           }
+
+        else
+           {
+            initializeHeap( &dest, DEFAULT_CAPACITY );
+            initializeHeap( &src, DEFAULT_CAPACITY );
+           }
+
+        for( index = 0; index < 2 * size; index++ )
+           {
+            addHeapItem( index < size ? &dest : &src, "Ward, Patient",
+                                 nextPriority( &randomState ), (time_t)index );
+           }
+
+        startTime = getSeconds();
+
+        if( method == ARRAY_MERGE_METHOD || method == BUCKET_MERGE_METHOD )
+           {
+            mergeHeaps( &dest, &src, NULL );
+           }
+
+        else
+           {
+            while( !isEmpty( src ) )
+               {
+                removeItem( &moved, &src );
+
+                addHeapItem( &dest, moved.patientName, moved.priority,
+                                                               moved.timeIn );
+               }
+           }
+
+        mergeTime = getSeconds() - startTime;
+        startTime = getSeconds();
+
+        removeItem( &moved, &dest );
+
+        removeTime = getSeconds() - startTime;
+       }
+
+    // the rest of the merged ward must follow in priority order
+    while( moreFlag )
+       {
+        removedCount++;
+
+        orderedFlag = orderedFlag && moved.priority <= lastPriority;
+        lastPriority = moved.priority;
+
+        if( method == PAIRING_MERGE_METHOD )
+           {
+            moreFlag = removeMeldableItem( &moved, &meldDest );
+           }
+
+        else
+           {
+            moreFlag = !isEmpty( dest );
+
+            if( moreFlag )
+               {
+                removeItem( &moved, &dest );
+               }
+           }
+       }
+
+    printf( "%-12s  %9d  %9.1f  %15.1f  %s\n", METHOD_NAMES[ method ], size,
+                   mergeTime * MICROSECONDS_PER_SECOND,
+                   removeTime * MICROSECONDS_PER_SECOND,
+                   orderedFlag && removedCount == 2 * size ? "ok" : "wrong" );
+
+    if( method == PAIRING_MERGE_METHOD )
+       {
+        clearNodePool( &pool );
+       }
+
+    else
+       {
+        clearHeap( &dest );
+        clearHeap( &src );
+       }
+   }
@@ -0,0 +1,394 @@
+// header files
+#include <time.h>
+#include <stdio.h>
+#include <math.h>
+#include "RadixHeapUtility.c"
+
+// constants
+const int MIN_REPLAY_SIZE = 1000;
+const int DEFAULT_MAX_SIZE = 1000000;
+const int MAX_REPLAY_SIZE = 100000000;
+const int DEFAULT_CAPACITY = 10;
+const int HOLD_OPERATIONS = 1000000;
+const double NANOSECONDS_PER_SECOND = 1000000000.0;
+
+// simulated clock in nanoseconds, events are rescheduled about a
+// millisecond ahead, logged events arrive a microsecond apart and
+// out of order by up to a millisecond
+const double MEAN_DELAY = 1000000.0;
+const long COARSE_TICK = 100000;
+const long LOG_SPACING = 1000;
+const long LOG_JITTER = 1000000;
+
+// delay distributions, coarse rounds delays to a tick so many events
+// share a time stamp
+const int UNIFORM_DELAY = 0;
+const int EXPONENTIAL_DELAY = 1;
+const int COARSE_DELAY = 2;
+const int DELAY_COUNT = 3;
+const char *DELAY_NAMES[] = { "uniform", "exponential", "coarse" };
+
+// implementations compared, HeapUtility orders by the inverted time stamp
+const int BINARY_HEAP_IMPL = 0;
+const int RADIX_HEAP_IMPL = 1;
+const char *IMPLEMENTATION_NAMES[] = { "HeapUtility", "radix" };
+
+// workloads, hold reschedules each event as it is taken, replay loads a
+// jittered event log then drains it
+const int HOLD_WORKLOAD = 0;
+const int REPLAY_WORKLOAD = 1;
+const char *WORKLOAD_NAMES[] = { "hold", "replay" };
+
+// data structures
+
+// queues under test and the generator feeding them
+typedef struct ReplayStateStruct
+   {
+    int implementation, delay;
+
+    HeapType heap;
+
+    RadixHeapType radix;
+
+    uint64_t randomState;
+   } ReplayStateType;
+
+// one timed workload, the checksum covers every time stamp taken in order
+// so both implementations must agree on it
+typedef struct ReplayResultStruct
+   {
+    long operations;
+
+    double nsPerOp, movesPerOp;
+
+    uint64_t checksum;
+
+    bool orderedFlag;
+   } ReplayResultType;
+
+// prototypes
+void addEvent( ReplayStateType *state, time_t eventTime );
+double getSeconds( void );
+long nextDelay( ReplayStateType *state );
+uint64_t nextRandom( ReplayStateType *state );
+time_t removeEvent( ReplayStateType *state );
+void runWorkload( ReplayStateType *state, int workload, int size,
+                                                   ReplayResultType *result );
+
+int main( int argc, char *argv[] )
+   {
+    ReplayStateType state;
+    ReplayResultType results[ 2 ];
+    int maxSize = DEFAULT_MAX_SIZE, size, delay, workload, implementation;
+    int delayCount;
+    uint64_t movesBefore;
+    HeapStatsType stats;
+
+    // optional largest size, up to 10^8
+    if( argc > 1 )
+       {
+        maxSize = atoi( argv[ 1 ] );
+
+        if( maxSize > MAX_REPLAY_SIZE )
+           {
+            maxSize = MAX_REPLAY_SIZE;
+           }
+       }
+
+    // title
+    printf( "\nEvent Replay Benchmark\n" );
+    printf( "======================\n" );
+    printf( "sizes %d to %d, binary HeapUtility against radix heap\n\n",
+                                                   MIN_REPLAY_SIZE, maxSize );
+    printf( "implementation  workload  delays           size"
+                                           "    ns/op   moves/op  order\n" );
+
+    for( size = MIN_REPLAY_SIZE; size <= maxSize && size > 0; size *= 10 )
+       {
+        for( workload = HOLD_WORKLOAD; workload <= REPLAY_WORKLOAD;
+                                                                  workload++ )
+           {
+            // the log replay draws jitter only, not delays
+            delayCount = workload == HOLD_WORKLOAD ? DELAY_COUNT : 1;
+
+            for( delay = 0; delay < delayCount; delay++ )
+               {
+                state.delay = delay;
+
+                for( implementation = BINARY_HEAP_IMPL;
+                        implementation <= RADIX_HEAP_IMPL; implementation++ )
+                   {
+                    // same seed, so both see the same events
+                    state.implementation = implementation;
+                    state.randomState = (uint64_t)size * 2654435761u
+                                                + workload * DELAY_COUNT
+                                                                  + delay + 1;
+
+                    if( implementation == RADIX_HEAP_IMPL )
+                       {
+                        initializeRadixHeap( &state.radix, DEFAULT_CAPACITY );
+
+                        movesBefore = 0;
+                       }
+
+                    else
+                       {
+                        initializeHeap( &state.heap, DEFAULT_CAPACITY );
+
+                        getHeapStats( &state.heap, &stats );
+
+                        movesBefore = stats.counters.moves;
+                       }
+
+                    runWorkload( &state, workload, size,
+                                                  &results[ implementation ] );
+
+                    if( implementation == RADIX_HEAP_IMPL )
+                       {
+                        results[ implementation ].movesPerOp =
+                                (double)( state.radix.moveCount - movesBefore )
+                                        / results[ implementation ].operations;
+
+                        clearRadixHeap( &state.radix );
+                       }
+
+                    else
+                       {
+                        getHeapStats( &state.heap, &stats );
+
+                        results[ implementation ].movesPerOp =
+                                (double)( stats.counters.moves - movesBefore )
+                                        / results[ implementation ].operations;
+
+                        clearHeap( &state.heap );
+                       }
+
+                    printf( "%-14s  %-8s  %-11s  %9d  %7.1f  %9.2f  %s\n",
+                        IMPLEMENTATION_NAMES[ implementation ],
+                        WORKLOAD_NAMES[ workload ],
+                        workload == HOLD_WORKLOAD ? DELAY_NAMES[ delay ]
+                                                                 : "jitter",
+                        size, results[ implementation ].nsPerOp,
+                        results[ implementation ].movesPerOp,
+                        !results[ implementation ].orderedFlag ? "unordered"
+                        : implementation == RADIX_HEAP_IMPL
+                            && results[ RADIX_HEAP_IMPL ].checksum
+                               != results[ BINARY_HEAP_IMPL ].checksum
+                                                         ? "mismatch" : "ok" );
+                   }
+               }
+           }
+       }
+
+    // display end program
+    printf( "\nEnd Program\n" );
+
+    // return success
+    return 0;
+   }
+
+/*
+Name: addEvent
+Process: schedules one event in the queue under test, the binary heap
+         pops its largest key first so it is given the inverted time
+Function input/parameters: replay state (ReplayStateType *),
+                           event time (time_t)
+Function output/parameters: updated replay state (ReplayStateType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: addRadixItem, addHeapItemWithKey
+*/
+void addEvent( ReplayStateType *state, time_t eventTime )
+   {
+    if( state->implementation == RADIX_HEAP_IMPL )
+       {
+        addRadixItem( &state->radix, "Replay, Event", 0, eventTime );
+       }
+
+    else
+       {
+        addHeapItemWithKey( &state->heap, "Replay, Event", eventTime,
+                                                     ~(uint64_t)eventTime );
+       }
+   }
+
+/*
+Name: getSeconds
+Process: reads the monotonic clock
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: time in seconds (double)
+Device input/---: none
+Device output/---: none
+Dependencies: clock_gettime
+*/
+double getSeconds( void )
+   {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+   }
+
+/*
+Name: nextDelay
+Process: draws the time until an event's next occurrence from the
+         state's delay distribution
+Function input/parameters: replay state (ReplayStateType *)
+Function output/parameters: updated generator state (ReplayStateType *)
+Function output/returned: delay in nanoseconds (long)
+Device input/---: none
+Device output/---: none
+Dependencies: nextRandom, log
+*/
+long nextDelay( ReplayStateType *state )
+   {
+    // uniform in zero to twice the mean, from the top 53 bits
+    double fraction = ( nextRandom( state ) >> 11 ) / 9007199254740992.0;
+    long delay;
+
+    if( state->delay == EXPONENTIAL_DELAY )
+       {
+        delay = (long)( -MEAN_DELAY * log( 1.0 - fraction ) );
+       }
+
+    else
+       {
+        delay = (long)( 2.0 * MEAN_DELAY * fraction );
+
+        if( state->delay == COARSE_DELAY )
+           {
+            delay -= delay % COARSE_TICK;
+           }
+       }
+
+    return delay;
+   }
+
+/*
+Name: nextRandom
+Process: advances the xorshift generator, cheap enough not to skew timings
+Function input/parameters: replay state (ReplayStateType *)
+Function output/parameters: updated generator state (ReplayStateType *)
+Function output/returned: random bits (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint64_t nextRandom( ReplayStateType *state )
+   {
+    state->randomState ^= state->randomState << 13;
+    state->randomState ^= state->randomState >> 7;
+    state->randomState ^= state->randomState << 17;
+
+    return state->randomState;
+   }
+
+/*
+Name: removeEvent
+Process: takes the earliest event from the queue under test
+Function input/parameters: replay state (ReplayStateType *)
+Function output/parameters: updated replay state (ReplayStateType *)
+Function output/returned: event time (time_t)
+Device input/---: none
+Device output/---: none
+Dependencies: removeRadixItem, removeItem
+*/
+time_t removeEvent( ReplayStateType *state )
+   {
+    PatientType removed;
+
+    if( state->implementation == RADIX_HEAP_IMPL )
+       {
+        removeRadixItem( &removed, &state->radix );
+       }
+
+    else
+       {
+        removeItem( &removed, &state->heap );
+       }
+
+    return removed.timeIn;
+   }
+
+/*
+Name: runWorkload
+Process: runs and times one workload on the queue under test,
+         hold fills the queue to size then takes the earliest event and
+         reschedules it a delay later, replay adds a log of events a fixed
+         spacing apart plus jitter then takes them all, every time taken
+         is checked against the one before and folded into a checksum
+Function input/parameters: replay state (ReplayStateType *),
+                           workload (int), size (int)
+Function output/parameters: updated replay state (ReplayStateType *),
+                            result (ReplayResultType *)
+Function output/returned: none
+Device input/---: none
+Device output/---: none
+Dependencies: nextDelay, nextRandom, addEvent, getSeconds, removeEvent
+*/
+void runWorkload( ReplayStateType *state, int workload, int size,
+                                                   ReplayResultType *result )
+   {
+    time_t eventTime, lastTime = 0;
+    long index;
+    double startTime;
+
+    result->checksum = 0;
+    result->orderedFlag = true;
+
+    // the hold queue starts with one pending occurrence per event source
+    if( workload == HOLD_WORKLOAD )
+       {
+        for( index = 0; index < size; index++ )
+           {
+            addEvent( state, (time_t)nextDelay( state ) );
+           }
+
+        result->operations = HOLD_OPERATIONS;
+       }
+
+    else
+       {
+        result->operations = 2L * size;
+       }
+
+    startTime = getSeconds();
+
+    if( workload == HOLD_WORKLOAD )
+       {
+        for( index = 0; index < HOLD_OPERATIONS; index++ )
+           {
+            eventTime = removeEvent( state );
+
+            result->orderedFlag = result->orderedFlag && eventTime >= lastTime;
+            result->checksum = result->checksum * 31 + (uint64_t)eventTime;
+            lastTime = eventTime;
+
+            addEvent( state, eventTime + nextDelay( state ) );
+           }
+       }
+
+    else
+       {
+        for( index = 0; index < size; index++ )
+           {
+            addEvent( state, (time_t)( index * LOG_SPACING
+                                  + (long)( nextRandom( state ) % LOG_JITTER ) ) );
+           }
+
+        for( index = 0; index < size; index++ )
+           {
+            eventTime = removeEvent( state );
+
+            result->orderedFlag = result->orderedFlag && eventTime >= lastTime;
+            result->checksum = result->checksum * 31 + (uint64_t)eventTime;
+            lastTime = eventTime;
+           }
+       }
+
+    result->nsPerOp = ( getSeconds() - startTime ) * NANOSECONDS_PER_SECOND
+                                                         / result->operations;
+   }
@@ -0,0 +1,169 @@
+// header files
+#include <time.h>
+#include <stdio.h>
+#include "HeapUtility.c"
+
+// constants
+const int MIN_SELECT_SIZE = 1000;
+const int DEFAULT_MAX_SIZE = 1000000;
+const int MAX_SELECT_SIZE = 10000000;
+const int MIN_WIDE_ARITY = 4;
+const int LOWEST_PRIORITY = 1;
+const int HIGHEST_PRIORITY = 1000;
+const double NANOSECONDS_PER_SECOND = 1000000000.0;
+const char *KERNEL_NAMES[] = { "scalar", "sse4.2", "avx2" };
+
+// prototypes
+double getSeconds( void );
+int nextPriority( uint64_t *randomState );
+void runSelect( int arity, int kernel, int size );
+
+int main( int argc, char *argv[] )
+   {
+    int maxSize = DEFAULT_MAX_SIZE, size, arity, kernel;
+    int bestKernel = getBestChildSelect();
+
+    // optional largest heap size
+    if( argc > 1 )
+       {
+        maxSize = atoi( argv[ 1 ] );
+
+        if( maxSize > MAX_SELECT_SIZE )
+           {
+            maxSize = MAX_SELECT_SIZE;
+           }
+       }
+
+    // title
+    printf( "\nWide Heap Child Selection Benchmark\n" );
+    printf( "===================================\n" );
+    printf( "heap filled, held at size with remove then add, then drained,\n" );
+    printf( "best kernel on this processor is %s\n\n",
+                                                 KERNEL_NAMES[ bestKernel ] );
+    printf( "arity  kernel        size  hold ns/op  drain ns/op  order\n" );
+
+    for( size = MIN_SELECT_SIZE; size <= maxSize && size > 0; size *= 10 )
+       {
+        for( arity = MIN_WIDE_ARITY; arity <= MAX_HEAP_ARITY; arity *= 2 )
+           {
+            for( kernel = CHILD_SELECT_SCALAR; kernel <= bestKernel; kernel++ )
+               {
+                runSelect( arity, kernel, size );
+               }
+           }
+       }
+
+    // display end program
+    printf( "\nEnd Program\n" );
+
+    // return success
+    return 0;
+   }
+
+/*
+Name: getSeconds
+Process: reads the monotonic clock
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: time in seconds (double)
+Device input/---: none
+Device output/---: none
+Dependencies: clock_gettime
+*/
+double getSeconds( void )
+   {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+   }
+
+/*
+Name: nextPriority
+Process: draws a uniform priority with a xorshift generator, a wide
+         range keeps most keys apart on priority alone
+Function input/parameters: generator state (uint64_t *)
+Function output/parameters: updated generator state (uint64_t *)
+Function output/returned: priority (int)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+int nextPriority( uint64_t *randomState )
+   {
+    *randomState ^= *randomState << 13;
+    *randomState ^= *randomState >> 7;
+    *randomState ^= *randomState << 17;
+
+    return (int)( *randomState % HIGHEST_PRIORITY ) + LOWEST_PRIORITY;
+   }
+
+/*
+Name: runSelect
+Process: fills a heap of the given arity using one child selection
+         kernel, times a removal heavy hold at size and the drain,
+         checking the drain comes out in priority order, every kernel
+         sees the same priorities
+Function input/parameters: arity (int), kernel (int), heap size (int)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/monitor: timings displayed
+Dependencies: initializeHeapWithArity, setChildSelect, nextPriority,
+              addHeapItem, getSeconds, removeItem, isEmpty, printf,
+              clearHeap
+*/
+void runSelect( int arity, int kernel, int size )
+   {
+    HeapType heap;
+    PatientType removed;
+    uint64_t randomState = (uint64_t)size * 2654435761u + arity;
+    int index, lastPriority = HIGHEST_PRIORITY, removedCount = 0;
+    double startTime, holdTime, drainTime;
+    bool orderedFlag = true;
+
+    initializeHeapWithArity( &heap, size, arity );
+
+    setChildSelect( &heap, kernel );
+
+    for( index = 0; index < size; index++ )
+       {
+        addHeapItem( &heap, "Wide, Patient", nextPriority( &randomState ),
+                                                               (time_t)index );
+       }
+
+    startTime = getSeconds();
+
+    // each removal sifts from the root, each arrival only climbs
+    for( index = 0; index < size; index++ )
+       {
+        removeItem( &removed, &heap );
+
+        addHeapItem( &heap, "Wide, Patient", nextPriority( &randomState ),
+                                                        (time_t)( size + index ) );
+       }
+
+    holdTime = getSeconds() - startTime;
+    startTime = getSeconds();
+
+    while( !isEmpty( heap ) )
+       {
+        removeItem( &removed, &heap );
+
+        orderedFlag = orderedFlag && removed.priority <= lastPriority;
+        lastPriority = removed.priority;
+
+        removedCount++;
+       }
+
+    drainTime = getSeconds() - startTime;
+
+    printf( "%5d  %-6s  %10d  %10.1f  %11.1f  %s\n", arity,
+                KERNEL_NAMES[ kernel ], size,
+                holdTime * NANOSECONDS_PER_SECOND / size,
+                drainTime * NANOSECONDS_PER_SECOND / size,
+                orderedFlag && removedCount == size ? "ok" : "wrong" );
+
+    clearHeap( &heap );
+   }
@@ -0,0 +1,264 @@
+// header files
+#include <stdio.h>
+#include "HeapUtility.c"
+
+// constants
+const char DEFAULT_TRACE_FILE[] = "tracedecoder.trace";
+const int DEMO_PATIENTS = 12;
+const int DEMO_ARITY = 2;
+const int LOWEST_PRIORITY = 1;
+const int HIGHEST_PRIORITY = 10;
+
+// prototypes
+void decodeTraceEvents( const HeapTraceEventType *events, uint64_t count );
+bool writeDemoTrace( const char *fileName );
+
+int main( int argc, char *argv[] )
+   {
+    const char *fileName = DEFAULT_TRACE_FILE;
+    TraceFileHeaderType header;
+    HeapTraceEventType *events;
+
+    // a trace given by name is decoded as is, otherwise a demo is recorded
+    if( argc > 1 )
+       {
+        fileName = argv[ 1 ];
+       }
+
+    else if( !writeDemoTrace( fileName ) )
+       {
+        printf( "\nUnable to write %s\n", fileName );
+
+        return 1;
+       }
+
+    events = readTraceFile( fileName, &header );
+
+    if( events == NULL )
+       {
+        printf( "\nUnable to read trace file %s\n", fileName );
+
+        return 1;
+       }
+
+    decodeTraceEvents( events, header.eventCount );
+
+    free( events );
+
+    // return success
+    return 0;
+   }
+
+/*
+Name: decodeTraceEvents
+Process: prints the display mode text of every event, oldest first,
+         names and times in come from the add events earlier in the trace,
+         a patient added before the trace began is shown by handle
+Function input/parameters: events (const HeapTraceEventType *),
+                           number of events (uint64_t)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/monitor: decoded trace displayed
+Dependencies: malloc, realloc, memset, memcpy, getKeyPriority, snprintf,
+              formatTraceEvent, printf, free
+*/
+void decodeTraceEvents( const HeapTraceEventType *events, uint64_t count )
+   {
+    PatientType *known = NULL, patient, other, pending;
+    const HeapTraceEventType *event, *operation = NULL;
+    char text[ MAX_TRACE_TEXT ];
+    int knownCount = 0, received = 0, newCount, handle;
+    uint64_t index;
+
+    for( index = 0; index < count; index++ )
+       {
+        event = &events[ index ];
+
+        // name chunks complete the add or remove in front of them
+        if( event->op == TRACE_NAME )
+           {
+            if( operation != NULL && received + event->length < STD_STR_LEN )
+               {
+                memcpy( &pending.patientName[ received ], event->data.text,
+                                                               event->length );
+               }
+
+            received += event->length;
+           }
+
+        // anything else ends the previous operation's name
+        else
+           {
+            operation = NULL;
+           }
+
+        if( event->op == TRACE_ADD || event->op == TRACE_BULK_PATIENT
+                                              || event->op == TRACE_REMOVE )
+           {
+            operation = event;
+            received = 0;
+
+            memset( pending.patientName, 0, STD_STR_LEN );
+
+            pending.priority = getKeyPriority( event->data.step.key );
+            pending.timeIn = (time_t)event->data.step.otherKey;
+           }
+
+        // the operation prints once its whole name has arrived
+        if( operation != NULL && received >= operation->length )
+           {
+            handle = operation->handle;
+
+            // remember added patients by handle for the steps that follow
+            if( operation->op != TRACE_REMOVE && handle >= 0 )
+               {
+                if( handle >= knownCount )
+                   {
+                    newCount = knownCount > 0 ? knownCount : 16;
+
+                    while( newCount <= handle )
+                       {
+                        newCount *= 2;
+                       }
+
+                    known = ( PatientType *)realloc( known,
+                                              newCount * sizeof( PatientType ) );
+
+                    memset( &known[ knownCount ], 0,
+                              ( newCount - knownCount ) * sizeof( PatientType ) );
+
+                    knownCount = newCount;
+                   }
+
+                known[ handle ] = pending;
+               }
+
+            formatTraceEvent( text, operation, pending, pending );
+
+            printf( "%s", text );
+
+            operation = NULL;
+           }
+
+        else if( event->op == TRACE_BULK_ADD )
+           {
+            formatTraceEvent( text, event, pending, pending );
+
+            printf( "%s", text );
+           }
+
+        else if( event->op == TRACE_BUBBLE_UP
+                                          || event->op == TRACE_TRICKLE_DOWN )
+           {
+            handle = event->handle;
+
+            if( handle >= 0 && handle < knownCount
+                                   && known[ handle ].patientName[ 0 ] != '\0' )
+               {
+                patient = known[ handle ];
+               }
+
+            else
+               {
+                snprintf( patient.patientName, STD_STR_LEN,
+                                                       "handle %d", handle );
+                patient.timeIn = 0;
+               }
+
+            handle = event->data.step.otherHandle;
+
+            if( handle >= 0 && handle < knownCount
+                                   && known[ handle ].patientName[ 0 ] != '\0' )
+               {
+                other = known[ handle ];
+               }
+
+            else
+               {
+                snprintf( other.patientName, STD_STR_LEN,
+                                                       "handle %d", handle );
+                other.timeIn = 0;
+               }
+
+            patient.priority = getKeyPriority( event->data.step.key );
+            other.priority = getKeyPriority( event->data.step.otherKey );
+
+            formatTraceEvent( text, event, patient, other );
+
+            printf( "%s", text );
+           }
+       }
+
+    free( known );
+   }
+
+/*
+Name: writeDemoTrace
+Process: records a small heap session in a trace ring, additions,
+         a bulk add, a priority change and removals, then saves it
+Function input/parameters: file name (const char *)
+Function output/parameters: none
+Function output/returned: Boolean result, false if not saved (bool)
+Device input/---: none
+Device output/---: trace file
+Dependencies: initializeHeapWithArity, enableHeapTrace, snprintf, rand,
+              addHeapItem, addHeapItems, updatePriority, removeItem,
+              saveHeapTrace, clearHeap
+*/
+bool writeDemoTrace( const char *fileName )
+   {
+    HeapType heap;
+    PatientType batch[ 4 ], removed;
+    char name[ STD_STR_LEN ];
+    int index, priority, firstHandle = INVALID_HANDLE, handle;
+    bool successFlag;
+
+    initializeHeapWithArity( &heap, DEMO_PATIENTS, DEMO_ARITY );
+
+    if( !enableHeapTrace( &heap, DEFAULT_TRACE_EVENTS ) )
+       {
+        clearHeap( &heap );
+
+        return false;
+       }
+
+    srand( 1 );
+
+    for( index = 0; index < DEMO_PATIENTS; index++ )
+       {
+        snprintf( name, STD_STR_LEN, "Patient %d", index + 1 );
+
+        priority = rand() % HIGHEST_PRIORITY + LOWEST_PRIORITY;
+
+        handle = addHeapItem( &heap, name, priority, (time_t)( index * 60 ) );
+
+        if( index == 0 )
+           {
+            firstHandle = handle;
+           }
+       }
+
+    for( index = 0; index < 4; index++ )
+       {
+        snprintf( batch[ index ].patientName, STD_STR_LEN,
+                                             "Walk in %d", index + 1 );
+        batch[ index ].priority = rand() % HIGHEST_PRIORITY + LOWEST_PRIORITY;
+        batch[ index ].timeIn = (time_t)( ( DEMO_PATIENTS + index ) * 60 );
+       }
+
+    addHeapItems( &heap, batch, 4, NULL );
+
+    updatePriority( &heap, firstHandle, HIGHEST_PRIORITY + 1 );
+
+    for( index = 0; index < DEMO_PATIENTS / 2; index++ )
+       {
+        removeItem( &removed, &heap );
+       }
+
+    successFlag = saveHeapTrace( &heap, fileName );
+
+    clearHeap( &heap );
+
+    return successFlag;
+   }
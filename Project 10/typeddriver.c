@@ -0,0 +1,326 @@
+// header files
+#include <time.h>
+#include <stdio.h>
+#include "HeapUtility.c"
+#include "TypedHeapUtility.h"
+
+// constants
+const int MIN_TYPED_SIZE = 1000;
+const int DEFAULT_MAX_SIZE = 1000000;
+const int MAX_TYPED_SIZE = 10000000;
+const int DEFAULT_CAPACITY = 10;
+const int LOWEST_PRIORITY = 1;
+const int HIGHEST_PRIORITY = 10;
+const int BENCH_COUNT = 12;
+const int WARD_COUNT = 8;
+const int BEDS_PER_WARD = 40;
+const double NANOSECONDS_PER_SECOND = 1000000000.0;
+
+// queues compared, patients through HeapUtility and through the
+// generated heap, then the other ward queues
+const int HEAP_UTILITY_QUEUE = 0;
+const int TYPED_PATIENT_QUEUE = 1;
+const int LAB_JOB_QUEUE = 2;
+const int BED_CLEANING_QUEUE = 3;
+const int QUEUE_COUNT = 4;
+const char *QUEUE_NAMES[] = { "patients", "patients", "lab jobs",
+                              "bed cleanings" };
+const char *IMPLEMENTATION_NAMES[] = { "HeapUtility", "typed", "typed",
+                                       "typed" };
+
+// data structures
+
+// a test waiting for a lab bench, soonest due first
+typedef struct LabJobStruct
+   {
+    char testName[ MIN_STR_LEN ];
+
+    double dueHours;
+
+    int bench;
+   } LabJobType;
+
+// a bed to be cleaned, the one ready longest first
+typedef struct BedCleaningStruct
+   {
+    int ward, bed;
+
+    time_t readyAt;
+   } BedCleaningType;
+
+// key extractors and comparators for the generated heaps,
+// a patient key is makeHeapKey with the time in as its arrival sequence
+#define PATIENT_KEY( patient ) \
+              makeHeapKey( ( patient ).priority, (uint32_t)( patient ).timeIn )
+#define LAB_JOB_KEY( job ) ( ( job ).dueHours )
+#define BED_CLEANING_KEY( cleaning ) ( ( cleaning ).readyAt )
+#define IS_LARGER( one, other ) ( ( one ) > ( other ) )
+#define IS_SMALLER( one, other ) ( ( one ) < ( other ) )
+
+DEFINE_TYPED_HEAP( Patient, PatientType, uint64_t, PATIENT_KEY, IS_LARGER,
+                                                           DEFAULT_HEAP_ARITY )
+DEFINE_TYPED_HEAP( LabJob, LabJobType, double, LAB_JOB_KEY, IS_SMALLER, 4 )
+DEFINE_TYPED_HEAP( BedCleaning, BedCleaningType, time_t, BED_CLEANING_KEY,
+                                                               IS_SMALLER, 8 )
+
+// prototypes
+double getSeconds( void );
+uint64_t nextRandom( uint64_t *randomState );
+void runQueue( int queue, int size );
+
+int main( int argc, char *argv[] )
+   {
+    int maxSize = DEFAULT_MAX_SIZE, size, queue;
+
+    // optional largest queue size
+    if( argc > 1 )
+       {
+        maxSize = atoi( argv[ 1 ] );
+
+        if( maxSize > MAX_TYPED_SIZE )
+           {
+            maxSize = MAX_TYPED_SIZE;
+           }
+       }
+
+    // title
+    printf( "\nTyped Heap Benchmark\n" );
+    printf( "====================\n" );
+    printf( "queue filled, held at size with remove then add, then drained\n\n" );
+    printf( "queue          implementation       size  add ns/op  hold ns/op"
+                                                 "  remove ns/op  order\n" );
+
+    for( size = MIN_TYPED_SIZE; size <= maxSize && size > 0; size *= 10 )
+       {
+        for( queue = HEAP_UTILITY_QUEUE; queue < QUEUE_COUNT; queue++ )
+           {
+            runQueue( queue, size );
+           }
+       }
+
+    // display end program
+    printf( "\nEnd Program\n" );
+
+    // return success
+    return 0;
+   }
+
+/*
+Name: getSeconds
+Process: reads the monotonic clock
+Function input/parameters: none
+Function output/parameters: none
+Function output/returned: time in seconds (double)
+Device input/---: none
+Device output/---: none
+Dependencies: clock_gettime
+*/
+double getSeconds( void )
+   {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+   }
+
+/*
+Name: nextRandom
+Process: steps a xorshift generator
+Function input/parameters: generator state (uint64_t *)
+Function output/parameters: updated generator state (uint64_t *)
+Function output/returned: random bits (uint64_t)
+Device input/---: none
+Device output/---: none
+Dependencies: none
+*/
+uint64_t nextRandom( uint64_t *randomState )
+   {
+    *randomState ^= *randomState << 13;
+    *randomState ^= *randomState >> 7;
+    *randomState ^= *randomState << 17;
+
+    return *randomState;
+   }
+
+/*
+Name: runQueue
+Process: fills one queue to the given size, holds it there with a
+         removal then an arrival per operation, then drains it checking
+         every removal is in the queue's order, times each phase
+Function input/parameters: queue (int), queue size (int)
+Function output/parameters: none
+Function output/returned: none
+Device input/---: none
+Device output/monitor: timings displayed
+Dependencies: initializeHeap, initializePatientHeap, initializeLabJobHeap,
+              initializeBedCleaningHeap, nextRandom, setPatientFromData,
+              addHeapItem, addPatientItem, addLabJobItem,
+              addBedCleaningItem, getSeconds, removeItem,
+              removePatientItem, removeLabJobItem, removeBedCleaningItem,
+              isEmpty, isPatientEmpty, isLabJobEmpty, isBedCleaningEmpty,
+              printf, clearHeap, clearPatientHeap, clearLabJobHeap,
+              clearBedCleaningHeap
+*/
+void runQueue( int queue, int size )
+   {
+    HeapType heap;
+    PatientHeapType patientHeap;
+    LabJobHeapType labJobHeap;
+    BedCleaningHeapType bedCleaningHeap;
+    PatientType patient, lastPatient;
+    LabJobType job, lastJob;
+    BedCleaningType cleaning, lastCleaning;
+    uint64_t randomState = (uint64_t)size * 2654435761u + queue + 1;
+    double startTime, phaseTimes[ 3 ];
+    int phase, index, operations, removedCount = 0;
+    bool orderedFlag = true, moreFlag = true;
+
+    initializeHeap( &heap, DEFAULT_CAPACITY );
+    initializePatientHeap( &patientHeap, DEFAULT_CAPACITY );
+    initializeLabJobHeap( &labJobHeap, DEFAULT_CAPACITY );
+    initializeBedCleaningHeap( &bedCleaningHeap, DEFAULT_CAPACITY );
+
+    // nothing removed may come before these
+    setPatientFromData( &lastPatient, "", HIGHEST_PRIORITY, 0 );
+    lastJob.dueHours = 0.0;
+    lastCleaning.readyAt = 0;
+
+    // fill, hold, then drain
+    for( phase = 0; phase < 3; phase++ )
+       {
+        operations = phase == 2 ? 0 : size;
+
+        startTime = getSeconds();
+
+        for( index = 0; index < operations; index++ )
+           {
+            if( phase == 1 )
+               {
+                if( queue == HEAP_UTILITY_QUEUE )
+                   {
+                    removeItem( &patient, &heap );
+                   }
+
+                else if( queue == TYPED_PATIENT_QUEUE )
+                   {
+                    removePatientItem( &patientHeap, &patient );
+                   }
+
+                else if( queue == LAB_JOB_QUEUE )
+                   {
+                    removeLabJobItem( &labJobHeap, &job );
+                   }
+
+                else
+                   {
+                    removeBedCleaningItem( &bedCleaningHeap, &cleaning );
+                   }
+               }
+
+            // arrivals keep coming later than everything already queued
+            if( queue == HEAP_UTILITY_QUEUE || queue == TYPED_PATIENT_QUEUE )
+               {
+                setPatientFromData( &patient, "Typed, Patient",
+                          (int)( nextRandom( &randomState ) % HIGHEST_PRIORITY )
+                            + LOWEST_PRIORITY, (time_t)( phase * size + index ) );
+
+                if( queue == HEAP_UTILITY_QUEUE )
+                   {
+                    addHeapItem( &heap, patient.patientName, patient.priority,
+                                                               patient.timeIn );
+                   }
+
+                else
+                   {
+                    addPatientItem( &patientHeap, patient );
+                   }
+               }
+
+            else if( queue == LAB_JOB_QUEUE )
+               {
+                copyString( job.testName, "Typed, Panel" );
+
+                job.dueHours = phase * size + index
+                                + (double)( nextRandom( &randomState ) % 1000 );
+                job.bench = index % BENCH_COUNT;
+
+                addLabJobItem( &labJobHeap, job );
+               }
+
+            else
+               {
+                cleaning.ward = index % WARD_COUNT;
+                cleaning.bed = index % BEDS_PER_WARD;
+                cleaning.readyAt = (time_t)( phase * size + index
+                                       + nextRandom( &randomState ) % 1000 );
+
+                addBedCleaningItem( &bedCleaningHeap, cleaning );
+               }
+           }
+
+        // the drain checks each removal against the one before it
+        while( phase == 2 && moreFlag )
+           {
+            if( queue == HEAP_UTILITY_QUEUE )
+               {
+                moreFlag = !isEmpty( heap );
+
+                if( moreFlag )
+                   {
+                    removeItem( &patient, &heap );
+
+                    orderedFlag = orderedFlag 
+                                 && comparePriority( lastPatient, patient ) >= 0;
+                    lastPatient = patient;
+                   }
+               }
+
+            else if( queue == TYPED_PATIENT_QUEUE )
+               {
+                moreFlag = removePatientItem( &patientHeap, &patient );
+
+                orderedFlag = orderedFlag && ( !moreFlag
+                                 || comparePriority( lastPatient, patient ) >= 0 );
+                lastPatient = patient;
+               }
+
+            else if( queue == LAB_JOB_QUEUE )
+               {
+                moreFlag = removeLabJobItem( &labJobHeap, &job );
+
+                orderedFlag = orderedFlag && ( !moreFlag
+                                          || lastJob.dueHours <= job.dueHours );
+                lastJob = job;
+               }
+
+            else
+               {
+                moreFlag = removeBedCleaningItem( &bedCleaningHeap,
+                                                                    &cleaning );
+
+                orderedFlag = orderedFlag && ( !moreFlag
+                                   || lastCleaning.readyAt <= cleaning.readyAt );
+                lastCleaning = cleaning;
+               }
+
+            if( moreFlag )
+               {
+                removedCount++;
+               }
+           }
+
+        phaseTimes[ phase ] = ( getSeconds() - startTime )
+                                               * NANOSECONDS_PER_SECOND / size;
+       }
+
+    printf( "%-13s  %-14s  %9d  %9.1f  %10.1f  %12.1f  %s\n",
+                QUEUE_NAMES[ queue ], IMPLEMENTATION_NAMES[ queue ], size,
+                phaseTimes[ 0 ], phaseTimes[ 1 ], phaseTimes[ 2 ],
+                orderedFlag && removedCount == size ? "ok" : "wrong" );
+
+    clearHeap( &heap );
+    clearPatientHeap( &patientHeap );
+    clearLabJobHeap( &labJobHeap );
+    clearBedCleaningHeap( &bedCleaningHeap );
+   }